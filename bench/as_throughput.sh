@@ -0,0 +1,35 @@
+#!/bin/bash
+# Instruction throughput of the assembler: Not a part of tests, run manually.
+#   $ ./as_throughput.sh [function-count]
+#   $ ASFLAGS=-fmem-report ./as_throughput.sh    # Allocations per phase
+#
+# Generates one large source in the shape of cc1 output (x86-64),
+# and assembles it from a file and from a pipe, as `xcc` feeds `as`.
+
+AS=${AS:-../as}
+N=${1:-20000}
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+awk -v n=$N 'BEGIN {
+  for (f = 0; f < n; ++f) {
+    printf "\n\t.text\n\t.globl f%d\n\t.type f%d, @function\nf%d:\n", f, f, f
+    printf "\tpush %%rbp\n\tmov %%rsp, %%rbp\n\tsub $32, %%rsp\n"
+    printf "\tmov %%edi, -4(%%rbp)\n\tmovq %%rsi, -16(%%rbp)\n"
+    printf ".L%d_0:\n", f
+    printf "\tmov -4(%%rbp), %%eax\n\tcmp $10, %%eax\n\tjge .L%d_1\n", f
+    printf "\tlea t%d(%%rip), %%rdi\n\tmovsx %%eax, %%rcx\n\tmov (%%rdi,%%rcx,4), %%edx\n", f
+    printf "\tadd %%edx, %%eax\n\tmov %%eax, -4(%%rbp)\n\tcall f%d\n\tjmp .L%d_0\n", (f + 1) % n, f
+    printf ".L%d_1:\n\tmov -4(%%rbp), %%eax\n\tmov %%rbp, %%rsp\n\tpop %%rbp\n\tret\n", f
+    printf "\n\t.data\n\t.p2align 2\n\t.type t%d, @object\nt%d:\t# comment\n", f, f
+    printf "\t.long 1, 2, 3, 4\n\t.quad f%d\n\t.ascii \"abc\\0\"\n", f
+  }
+}' > "$WORK/bench.s"
+
+LINES=$(wc -l < "$WORK/bench.s")
+echo "Assemble $LINES lines, from file:"
+time "$AS" $ASFLAGS -o "$WORK/a.o" "$WORK/bench.s" || exit 1
+echo "From pipe:"
+time (cat "$WORK/bench.s" | "$AS" $ASFLAGS -o "$WORK/b.o") || exit 1
+cmp "$WORK/a.o" "$WORK/b.o" || exit 1
@@ -0,0 +1,37 @@
+#!/bin/bash
+# Compile-time scaling of wcc with `-j`: Not a part of tests, run manually.
+#   $ ./compile_jobs.sh [max-jobs] [source-count]
+#
+# Each source defines functions with loops and calls into other sources,
+# so that the time is dominated by compiling, not by linking.
+
+WCC=${WCC:-../wcc}
+MAXJ=${1:-$(nproc)}
+N=${2:-32}
+FUNCS=200
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+for ((i = 0; i < N; ++i)); do
+  awk -v i=$i -v n=$N -v funcs=$FUNCS 'BEGIN {
+    printf "int g%d_0(int);\n", (i + 1) % n
+    for (f = 0; f < funcs; ++f) {
+      printf "int g%d_%d(int x) {\n", i, f
+      printf "  int s = 0;\n  for (int j = 0; j < x; ++j) {\n"
+      printf "    if (j %% 3 == 0) s += j * %d; else s ^= j << 2;\n  }\n", f + 1
+      printf "  return s + (x > 0 ? g%d_0(x - 1) : 0);\n}\n", (i + 1) % n
+    }
+  }' > "$WORK/s$i.c"
+done
+printf 'int g0_0(int);\nint main(void) { return g0_0(3) & 1; }\n' > "$WORK/main.c"
+
+echo "Compile $N sources, $((N * FUNCS)) functions:"
+for ((j = 1; j <= MAXJ; j *= 2)); do
+  echo "-j$j"
+  time "$WCC" -j$j -o "$WORK/a$j.wasm" "$WORK/main.c" "$WORK"/s*.c || exit 1
+  if [ $j -gt 1 ] && ! cmp -s "$WORK/a1.wasm" "$WORK/a$j.wasm"; then
+    echo "Output differs from -j1" >&2
+    exit 1
+  fi
+done
@@ -0,0 +1,36 @@
+#!/bin/bash
+# Link-time benchmark against a large synthetic archive: Not a part of tests, run manually.
+#   $ ./link_archive.sh [member-count]
+#
+# `main` refers to `f<i>` and `h<i>` for every i. Each `f<i>` refers to `g<i>`
+# in another member. `h<i>` are defined in the second archive, so they stay
+# unresolved while searching the first one.
+
+AS=${AS:-../as}
+LD=${LD:-../ld}
+N=${1:-2000}
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+for ((i = 0; i < N; ++i)); do
+  printf '\t.text\n\t.globl f%d\nf%d:\n\tcall g%d\n\tret\n' $i $i $i > "$WORK/f$i.s"
+  printf '\t.text\n\t.globl g%d\ng%d:\n\tret\n' $i $i > "$WORK/g$i.s"
+  printf '\t.text\n\t.globl h%d\nh%d:\n\tret\n' $i $i > "$WORK/h$i.s"
+  "$AS" -o "$WORK/f$i.o" "$WORK/f$i.s" || exit 1
+  "$AS" -o "$WORK/g$i.o" "$WORK/g$i.s" || exit 1
+  "$AS" -o "$WORK/h$i.o" "$WORK/h$i.s" || exit 1
+done
+(cd "$WORK" && ar rcs libbench1.a g*.o f*.o && ar rcs libbench2.a h*.o) || exit 1
+
+{
+  printf '\t.text\n\t.globl main\nmain:\n'
+  for ((i = 0; i < N; ++i)); do
+    printf '\tcall f%d\n\tcall h%d\n' $i $i
+  done
+  printf '\tret\n'
+} > "$WORK/main.s"
+"$AS" -o "$WORK/main.o" "$WORK/main.s" || exit 1
+
+echo "Link against $((N * 3)) members:"
+time "$LD" -e main -o "$WORK/a.out" "$WORK/main.o" "$WORK/libbench1.a" "$WORK/libbench2.a"
@@ -0,0 +1,52 @@
+#!/bin/bash
+# Link-time scaling with `--threads`: Not a part of tests, run manually.
+#   $ ./link_threads.sh [max-threads] [object-count]
+#   $ LDFLAGS=-ftime-report ./link_threads.sh    # Time per phase
+#
+# Each object defines functions which call functions in other objects,
+# and a table of their addresses, so that the output is dominated by
+# section copies and relocations.
+
+AS=${AS:-../as}
+LD=${LD:-../ld}
+MAXT=${1:-$(nproc)}
+N=${2:-200}
+FUNCS=100
+CALLS=20
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+for ((i = 0; i < N; ++i)); do
+  awk -v i=$i -v n=$N -v funcs=$FUNCS -v calls=$CALLS 'BEGIN {
+    for (f = 0; f < funcs; ++f) {
+      printf "\t.text\n\t.globl f%d_%d\nf%d_%d:\n", i, f, i, f
+      for (c = 0; c < calls; ++c)
+        printf "\tcall f%d_%d\n", (i + c + 1) % n, (f + c) % funcs
+      printf "\tret\n"
+    }
+    printf "\t.data\n\t.globl t%d\nt%d:\n", i, i
+    for (f = 0; f < funcs; ++f)
+      printf "\t.quad f%d_%d\n", i, f
+  }' > "$WORK/o$i.s"
+  "$AS" -o "$WORK/o$i.o" "$WORK/o$i.s" || exit 1
+done
+
+{
+  printf '\t.text\n\t.globl main\nmain:\n'
+  for ((i = 0; i < N; ++i)); do
+    printf '\tcall f%d_0\n\tlea t%d(%%rip), %%rax\n' $i $i
+  done
+  printf '\tret\n'
+} > "$WORK/main.s"
+"$AS" -o "$WORK/main.o" "$WORK/main.s" || exit 1
+
+echo "Link $N objects, $((N * FUNCS * (CALLS + 1))) relocations:"
+for ((t = 1; t <= MAXT; t *= 2)); do
+  echo "--threads=$t"
+  time "$LD" --threads=$t $LDFLAGS -e main -o "$WORK/a$t.out" "$WORK/main.o" "$WORK"/o*.o
+  if [ $t -gt 1 ] && ! cmp -s "$WORK/a1.out" "$WORK/a$t.out"; then
+    echo "Output differs from --threads=1" >&2
+    exit 1
+  fi
+done
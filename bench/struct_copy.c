@@ -0,0 +1,66 @@
+// Micro benchmark for struct copy and clear.
+//
+// Compares compilers by running the same program:
+//   $ make -C bench struct-copy CC=../xcc
+//   $ make -C bench struct-copy CC=gcc
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+#define DEFINE_BENCH(n) \
+  typedef struct { char buf[n]; } S##n; \
+  static S##n src##n, dst##n[4]; \
+  static double bench_copy##n(long count) { \
+    double start = now(); \
+    for (long i = 0; i < count; ++i) \
+      dst##n[i & 3] = src##n; \
+    return now() - start; \
+  } \
+  static double bench_clear##n(long count) { \
+    double start = now(); \
+    for (long i = 0; i < count; ++i) { \
+      S##n s = {0}; \
+      dst##n[i & 3] = s; \
+    } \
+    return now() - start; \
+  }
+
+DEFINE_BENCH(12)
+DEFINE_BENCH(24)
+DEFINE_BENCH(64)
+DEFINE_BENCH(100)
+DEFINE_BENCH(256)
+DEFINE_BENCH(4096)
+
+static const struct {
+  int size;
+  double (*copy)(long);
+  double (*clear)(long);
+} kBenches[] = {
+  {12, bench_copy12, bench_clear12},
+  {24, bench_copy24, bench_clear24},
+  {64, bench_copy64, bench_clear64},
+  {100, bench_copy100, bench_clear100},
+  {256, bench_copy256, bench_clear256},
+  {4096, bench_copy4096, bench_clear4096},
+};
+
+int main(int argc, char *argv[]) {
+  long total = argc > 1 ? atol(argv[1]) : 1L << 30;  // Total bytes to copy for each size.
+
+  printf("%6s  %10s  %10s\n", "size", "copy[s]", "clear[s]");
+  for (size_t i = 0; i < sizeof(kBenches) / sizeof(*kBenches); ++i) {
+    long count = total / kBenches[i].size;
+    double tcopy = (*kBenches[i].copy)(count);
+    double tclear = (*kBenches[i].clear)(count);
+    printf("%6d  %10.3f  %10.3f\n", kBenches[i].size, tcopy, tclear);
+  }
+  return 0;
+}
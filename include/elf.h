@@ -109,6 +109,8 @@ typedef uintptr_t Elf64_Off;
 #define SHF_WRITE         (1 << 0)        /* Writable */
 #define SHF_ALLOC         (1 << 1)        /* Occupies memory during execution */
 #define SHF_EXECINSTR     (1 << 2)        /* Executable */
+#define SHF_MERGE         (1 << 4)        /* Might be merged */
+#define SHF_STRINGS       (1 << 5)        /* Contains nul-terminated strings */
 #define SHF_INFO_LINK     (1 << 6)        /* `sh_info' contains SHT index */
 
 #define SHN_UNDEF         (0)
@@ -130,6 +132,7 @@ typedef struct {
 
 #define STB_LOCAL   (0)
 #define STB_GLOBAL  (1)
+#define STB_WEAK    (2)
 
 #define STT_NOTYPE   (0)
 #define STT_OBJECT   (1)
@@ -158,6 +161,7 @@ typedef struct {
 #define R_AARCH64_ADR_PREL_PG_HI21_NC  276
 #define R_AARCH64_ADD_ABS_LO12_NC      277  /* S+A */
 #define R_AARCH64_CALL26               283  /* S+A-P: Set a CALL immediate field to bits [27:2] of X; check that -2^27 <= X < 2^27 */
+#define R_AARCH64_JUMP26               282  /* S+A-P: Set a B immediate field to bits [27:2] of X; check that -2^27 <= X < 2^27 */
 #define R_AARCH64_ADR_GOT_PAGE         311
 #define R_AARCH64_LD64_GOT_LO12_NC     312
 
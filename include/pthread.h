@@ -0,0 +1,47 @@
+#pragma once
+
+// Minimal POSIX threads (wcc only, link with `-pthread`)
+//
+// Each thread runs on its own instance of the module, spawned by the host
+// through wasi-threads `thread-spawn`: Linear memory is shared, and the shadow
+// stack is allocated from the heap. Blocking functions use
+// `memory.atomic.wait32`, which the main thread of a browser cannot call.
+
+#if !defined(__WASM)
+#error pthread.h is for wcc
+#endif
+
+#include <stddef.h>  // size_t
+
+typedef struct __pthread *pthread_t;
+
+typedef struct {
+  size_t __stacksize;
+} pthread_attr_t;
+
+typedef struct {
+  int __state;  // 0=unlocked, 1=locked, 2=locked and contended
+} pthread_mutex_t;
+
+typedef struct {
+  int __dummy;
+} pthread_mutexattr_t;
+
+#define PTHREAD_MUTEX_INITIALIZER  {0}
+
+int pthread_create(pthread_t *thread, const pthread_attr_t *attr, void *(*start_routine)(void*),
+                   void *arg);
+int pthread_join(pthread_t thread, void **retval);
+pthread_t pthread_self(void);
+int pthread_equal(pthread_t t1, pthread_t t2);
+
+int pthread_attr_init(pthread_attr_t *attr);
+int pthread_attr_destroy(pthread_attr_t *attr);
+int pthread_attr_setstacksize(pthread_attr_t *attr, size_t stacksize);
+int pthread_attr_getstacksize(const pthread_attr_t *attr, size_t *stacksize);
+
+int pthread_mutex_init(pthread_mutex_t *mutex, const pthread_mutexattr_t *attr);
+int pthread_mutex_destroy(pthread_mutex_t *mutex);
+int pthread_mutex_lock(pthread_mutex_t *mutex);
+int pthread_mutex_trylock(pthread_mutex_t *mutex);
+int pthread_mutex_unlock(pthread_mutex_t *mutex);
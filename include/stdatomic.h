@@ -0,0 +1,98 @@
+#pragma once
+
+// C11 atomics (wcc only)
+//
+// Operations are lowered to wasm atomic instructions through `__atomic_*`
+// builtins. `_Atomic` qualifier is not supported: `atomic_*` types are plain
+// types, and every access which needs atomicity must go through the functions.
+// Wasm atomics are sequentially consistent, so memory orders are accepted but
+// have no effect.
+
+#if !defined(__WASM)
+#error stdatomic.h is for wcc
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>  // size_t, ptrdiff_t
+#include <stdint.h>
+
+typedef enum {
+  memory_order_relaxed = __ATOMIC_RELAXED,
+  memory_order_consume = __ATOMIC_CONSUME,
+  memory_order_acquire = __ATOMIC_ACQUIRE,
+  memory_order_release = __ATOMIC_RELEASE,
+  memory_order_acq_rel = __ATOMIC_ACQ_REL,
+  memory_order_seq_cst = __ATOMIC_SEQ_CST,
+} memory_order;
+
+#define ATOMIC_BOOL_LOCK_FREE      (2)
+#define ATOMIC_CHAR_LOCK_FREE      (2)
+#define ATOMIC_SHORT_LOCK_FREE     (2)
+#define ATOMIC_INT_LOCK_FREE       (2)
+#define ATOMIC_LONG_LOCK_FREE      (2)
+#define ATOMIC_LLONG_LOCK_FREE     (2)
+#define ATOMIC_POINTER_LOCK_FREE   (2)
+
+typedef _Bool atomic_bool;
+typedef char atomic_char;
+typedef signed char atomic_schar;
+typedef unsigned char atomic_uchar;
+typedef short atomic_short;
+typedef unsigned short atomic_ushort;
+typedef int atomic_int;
+typedef unsigned int atomic_uint;
+typedef long atomic_long;
+typedef unsigned long atomic_ulong;
+typedef long long atomic_llong;
+typedef unsigned long long atomic_ullong;
+typedef intptr_t atomic_intptr_t;
+typedef uintptr_t atomic_uintptr_t;
+typedef size_t atomic_size_t;
+typedef ptrdiff_t atomic_ptrdiff_t;
+typedef intmax_t atomic_intmax_t;
+typedef uintmax_t atomic_uintmax_t;
+
+#define ATOMIC_VAR_INIT(value)  (value)
+#define atomic_init(obj, value)  ((void)(*(obj) = (value)))
+#define kill_dependency(y)  (y)
+#define atomic_is_lock_free(obj)  (sizeof(*(obj)) <= 8)
+
+#define atomic_thread_fence(order)  __atomic_thread_fence(order)
+#define atomic_signal_fence(order)  ((void)(order))
+
+#define atomic_load_explicit(obj, order)  __atomic_load_n(obj, order)
+#define atomic_store_explicit(obj, desired, order)  __atomic_store_n(obj, desired, order)
+#define atomic_exchange_explicit(obj, desired, order)  __atomic_exchange_n(obj, desired, order)
+#define atomic_compare_exchange_strong_explicit(obj, expected, desired, succ, fail) \
+  __atomic_compare_exchange_n(obj, expected, desired, false, succ, fail)
+#define atomic_compare_exchange_weak_explicit(obj, expected, desired, succ, fail) \
+  __atomic_compare_exchange_n(obj, expected, desired, true, succ, fail)
+#define atomic_fetch_add_explicit(obj, arg, order)  __atomic_fetch_add(obj, arg, order)
+#define atomic_fetch_sub_explicit(obj, arg, order)  __atomic_fetch_sub(obj, arg, order)
+#define atomic_fetch_or_explicit(obj, arg, order)   __atomic_fetch_or(obj, arg, order)
+#define atomic_fetch_xor_explicit(obj, arg, order)  __atomic_fetch_xor(obj, arg, order)
+#define atomic_fetch_and_explicit(obj, arg, order)  __atomic_fetch_and(obj, arg, order)
+
+#define atomic_load(obj)  __atomic_load_n(obj, __ATOMIC_SEQ_CST)
+#define atomic_store(obj, desired)  __atomic_store_n(obj, desired, __ATOMIC_SEQ_CST)
+#define atomic_exchange(obj, desired)  __atomic_exchange_n(obj, desired, __ATOMIC_SEQ_CST)
+#define atomic_compare_exchange_strong(obj, expected, desired) \
+  __atomic_compare_exchange_n(obj, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+#define atomic_compare_exchange_weak(obj, expected, desired) \
+  __atomic_compare_exchange_n(obj, expected, desired, true, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+#define atomic_fetch_add(obj, arg)  __atomic_fetch_add(obj, arg, __ATOMIC_SEQ_CST)
+#define atomic_fetch_sub(obj, arg)  __atomic_fetch_sub(obj, arg, __ATOMIC_SEQ_CST)
+#define atomic_fetch_or(obj, arg)   __atomic_fetch_or(obj, arg, __ATOMIC_SEQ_CST)
+#define atomic_fetch_xor(obj, arg)  __atomic_fetch_xor(obj, arg, __ATOMIC_SEQ_CST)
+#define atomic_fetch_and(obj, arg)  __atomic_fetch_and(obj, arg, __ATOMIC_SEQ_CST)
+
+typedef struct {
+  unsigned char __v;
+} atomic_flag;
+
+#define ATOMIC_FLAG_INIT  {0}
+
+#define atomic_flag_test_and_set_explicit(obj, order)  ((bool)__atomic_exchange_n(&(obj)->__v, 1, order))
+#define atomic_flag_clear_explicit(obj, order)  __atomic_store_n(&(obj)->__v, 0, order)
+#define atomic_flag_test_and_set(obj)  atomic_flag_test_and_set_explicit(obj, __ATOMIC_SEQ_CST)
+#define atomic_flag_clear(obj)  atomic_flag_clear_explicit(obj, __ATOMIC_SEQ_CST)
@@ -26,6 +26,14 @@ typedef      unsigned long  uintptr_t;
 typedef          long long  intmax_t;
 typedef unsigned long long  uintmax_t;
 
+#define INT8_MIN     (-128)
+#define INT8_MAX     (127)
+#define UINT8_MAX    (255)
+
+#define INT16_MIN    (-32768)
+#define INT16_MAX    (32767)
+#define UINT16_MAX   (65535)
+
 #define INT32_MIN    (((int32_t)-1) << (sizeof(int32_t) * 8 - 1))
 #define INT32_MAX    ((int32_t)((((uint32_t)1) << (sizeof(int32_t) * 8 - 1)) - 1))
 #define UINT32_MAX   ((uint32_t)-1)
@@ -9,6 +9,8 @@ struct timespec {
 
 typedef enum {
   CLOCK_REALTIME = 0,
+  CLOCK_MONOTONIC = 1,
+  CLOCK_PROCESS_CPUTIME_ID = 2,
   CLOCK_REALTIME_COARSE = 5,
 } clockid_t;
 
@@ -46,6 +46,7 @@ int pipe(int *);
 int pipe2(int *pipefd, int flag);
 int isatty(int fd);
 int chdir(const char *path);
+int ftruncate(int fd, off_t length);
 
 pid_t fork(void);
 long clone3(struct clone_args *cl_args, size_t size);
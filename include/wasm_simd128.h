@@ -0,0 +1,261 @@
+#pragma once
+
+// WebAssembly SIMD128 intrinsics (wcc only)
+//
+// `v128_t` is a 16-byte struct: Each intrinsic is compiled into SIMD128
+// instructions, and nested calls keep intermediate values on the wasm stack.
+// Lane indices must be constant.
+
+#if !defined(__WASM)
+#error wasm_simd128.h is for wcc
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+  int32_t __v[4];
+} v128_t;
+
+// Memory
+v128_t wasm_v128_load(const void *mem);
+void wasm_v128_store(void *mem, v128_t a);
+v128_t wasm_v128_load8_splat(const void *mem);
+v128_t wasm_v128_load16_splat(const void *mem);
+v128_t wasm_v128_load32_splat(const void *mem);
+v128_t wasm_v128_load64_splat(const void *mem);
+v128_t wasm_i16x8_load8x8(const void *mem);
+v128_t wasm_u16x8_load8x8(const void *mem);
+v128_t wasm_i32x4_load16x4(const void *mem);
+v128_t wasm_u32x4_load16x4(const void *mem);
+v128_t wasm_i64x2_load32x2(const void *mem);
+v128_t wasm_u64x2_load32x2(const void *mem);
+v128_t wasm_v128_load32_zero(const void *mem);
+v128_t wasm_v128_load64_zero(const void *mem);
+
+// Construction
+v128_t wasm_i8x16_make(int8_t c0, int8_t c1, int8_t c2, int8_t c3, int8_t c4, int8_t c5,
+                       int8_t c6, int8_t c7, int8_t c8, int8_t c9, int8_t c10, int8_t c11,
+                       int8_t c12, int8_t c13, int8_t c14, int8_t c15);
+v128_t wasm_i16x8_make(int16_t c0, int16_t c1, int16_t c2, int16_t c3, int16_t c4, int16_t c5,
+                       int16_t c6, int16_t c7);
+v128_t wasm_i32x4_make(int32_t c0, int32_t c1, int32_t c2, int32_t c3);
+v128_t wasm_i64x2_make(int64_t c0, int64_t c1);
+v128_t wasm_f32x4_make(float c0, float c1, float c2, float c3);
+v128_t wasm_f64x2_make(double c0, double c1);
+
+v128_t wasm_i8x16_splat(int8_t a);
+v128_t wasm_u8x16_splat(uint8_t a);
+v128_t wasm_i16x8_splat(int16_t a);
+v128_t wasm_u16x8_splat(uint16_t a);
+v128_t wasm_i32x4_splat(int32_t a);
+v128_t wasm_u32x4_splat(uint32_t a);
+v128_t wasm_i64x2_splat(int64_t a);
+v128_t wasm_u64x2_splat(uint64_t a);
+v128_t wasm_f32x4_splat(float a);
+v128_t wasm_f64x2_splat(double a);
+
+// Lanes
+int8_t wasm_i8x16_extract_lane(v128_t a, int i);
+uint8_t wasm_u8x16_extract_lane(v128_t a, int i);
+int16_t wasm_i16x8_extract_lane(v128_t a, int i);
+uint16_t wasm_u16x8_extract_lane(v128_t a, int i);
+int32_t wasm_i32x4_extract_lane(v128_t a, int i);
+uint32_t wasm_u32x4_extract_lane(v128_t a, int i);
+int64_t wasm_i64x2_extract_lane(v128_t a, int i);
+uint64_t wasm_u64x2_extract_lane(v128_t a, int i);
+float wasm_f32x4_extract_lane(v128_t a, int i);
+double wasm_f64x2_extract_lane(v128_t a, int i);
+
+v128_t wasm_i8x16_replace_lane(v128_t a, int i, int8_t b);
+v128_t wasm_u8x16_replace_lane(v128_t a, int i, uint8_t b);
+v128_t wasm_i16x8_replace_lane(v128_t a, int i, int16_t b);
+v128_t wasm_u16x8_replace_lane(v128_t a, int i, uint16_t b);
+v128_t wasm_i32x4_replace_lane(v128_t a, int i, int32_t b);
+v128_t wasm_u32x4_replace_lane(v128_t a, int i, uint32_t b);
+v128_t wasm_i64x2_replace_lane(v128_t a, int i, int64_t b);
+v128_t wasm_u64x2_replace_lane(v128_t a, int i, uint64_t b);
+v128_t wasm_f32x4_replace_lane(v128_t a, int i, float b);
+v128_t wasm_f64x2_replace_lane(v128_t a, int i, double b);
+
+v128_t wasm_i8x16_shuffle(v128_t a, v128_t b, int c0, int c1, int c2, int c3, int c4, int c5,
+                          int c6, int c7, int c8, int c9, int c10, int c11, int c12, int c13,
+                          int c14, int c15);
+v128_t wasm_i8x16_swizzle(v128_t a, v128_t b);
+
+// Bitwise
+v128_t wasm_v128_not(v128_t a);
+v128_t wasm_v128_and(v128_t a, v128_t b);
+v128_t wasm_v128_or(v128_t a, v128_t b);
+v128_t wasm_v128_xor(v128_t a, v128_t b);
+v128_t wasm_v128_andnot(v128_t a, v128_t b);
+v128_t wasm_v128_bitselect(v128_t a, v128_t b, v128_t mask);
+bool wasm_v128_any_true(v128_t a);
+
+// Integer
+v128_t wasm_i8x16_eq(v128_t a, v128_t b);
+v128_t wasm_i8x16_ne(v128_t a, v128_t b);
+v128_t wasm_i8x16_lt(v128_t a, v128_t b);
+v128_t wasm_u8x16_lt(v128_t a, v128_t b);
+v128_t wasm_i8x16_gt(v128_t a, v128_t b);
+v128_t wasm_u8x16_gt(v128_t a, v128_t b);
+v128_t wasm_i8x16_le(v128_t a, v128_t b);
+v128_t wasm_u8x16_le(v128_t a, v128_t b);
+v128_t wasm_i8x16_ge(v128_t a, v128_t b);
+v128_t wasm_u8x16_ge(v128_t a, v128_t b);
+v128_t wasm_i8x16_abs(v128_t a);
+v128_t wasm_i8x16_neg(v128_t a);
+bool wasm_i8x16_all_true(v128_t a);
+uint32_t wasm_i8x16_bitmask(v128_t a);
+v128_t wasm_i8x16_narrow_i16x8(v128_t a, v128_t b);
+v128_t wasm_u8x16_narrow_i16x8(v128_t a, v128_t b);
+v128_t wasm_i8x16_shl(v128_t a, uint32_t b);
+v128_t wasm_i8x16_shr(v128_t a, uint32_t b);
+v128_t wasm_u8x16_shr(v128_t a, uint32_t b);
+v128_t wasm_i8x16_add(v128_t a, v128_t b);
+v128_t wasm_i8x16_add_sat(v128_t a, v128_t b);
+v128_t wasm_u8x16_add_sat(v128_t a, v128_t b);
+v128_t wasm_i8x16_sub(v128_t a, v128_t b);
+v128_t wasm_i8x16_sub_sat(v128_t a, v128_t b);
+v128_t wasm_u8x16_sub_sat(v128_t a, v128_t b);
+v128_t wasm_i8x16_min(v128_t a, v128_t b);
+v128_t wasm_u8x16_min(v128_t a, v128_t b);
+v128_t wasm_i8x16_max(v128_t a, v128_t b);
+v128_t wasm_u8x16_max(v128_t a, v128_t b);
+v128_t wasm_u8x16_avgr(v128_t a, v128_t b);
+
+v128_t wasm_i16x8_eq(v128_t a, v128_t b);
+v128_t wasm_i16x8_ne(v128_t a, v128_t b);
+v128_t wasm_i16x8_lt(v128_t a, v128_t b);
+v128_t wasm_u16x8_lt(v128_t a, v128_t b);
+v128_t wasm_i16x8_gt(v128_t a, v128_t b);
+v128_t wasm_u16x8_gt(v128_t a, v128_t b);
+v128_t wasm_i16x8_le(v128_t a, v128_t b);
+v128_t wasm_u16x8_le(v128_t a, v128_t b);
+v128_t wasm_i16x8_ge(v128_t a, v128_t b);
+v128_t wasm_u16x8_ge(v128_t a, v128_t b);
+v128_t wasm_i16x8_abs(v128_t a);
+v128_t wasm_i16x8_neg(v128_t a);
+bool wasm_i16x8_all_true(v128_t a);
+uint32_t wasm_i16x8_bitmask(v128_t a);
+v128_t wasm_i16x8_narrow_i32x4(v128_t a, v128_t b);
+v128_t wasm_u16x8_narrow_i32x4(v128_t a, v128_t b);
+v128_t wasm_i16x8_extend_low_i8x16(v128_t a);
+v128_t wasm_i16x8_extend_high_i8x16(v128_t a);
+v128_t wasm_u16x8_extend_low_u8x16(v128_t a);
+v128_t wasm_u16x8_extend_high_u8x16(v128_t a);
+v128_t wasm_i16x8_shl(v128_t a, uint32_t b);
+v128_t wasm_i16x8_shr(v128_t a, uint32_t b);
+v128_t wasm_u16x8_shr(v128_t a, uint32_t b);
+v128_t wasm_i16x8_add(v128_t a, v128_t b);
+v128_t wasm_i16x8_add_sat(v128_t a, v128_t b);
+v128_t wasm_u16x8_add_sat(v128_t a, v128_t b);
+v128_t wasm_i16x8_sub(v128_t a, v128_t b);
+v128_t wasm_i16x8_sub_sat(v128_t a, v128_t b);
+v128_t wasm_u16x8_sub_sat(v128_t a, v128_t b);
+v128_t wasm_i16x8_mul(v128_t a, v128_t b);
+v128_t wasm_i16x8_min(v128_t a, v128_t b);
+v128_t wasm_u16x8_min(v128_t a, v128_t b);
+v128_t wasm_i16x8_max(v128_t a, v128_t b);
+v128_t wasm_u16x8_max(v128_t a, v128_t b);
+v128_t wasm_u16x8_avgr(v128_t a, v128_t b);
+
+v128_t wasm_i32x4_eq(v128_t a, v128_t b);
+v128_t wasm_i32x4_ne(v128_t a, v128_t b);
+v128_t wasm_i32x4_lt(v128_t a, v128_t b);
+v128_t wasm_u32x4_lt(v128_t a, v128_t b);
+v128_t wasm_i32x4_gt(v128_t a, v128_t b);
+v128_t wasm_u32x4_gt(v128_t a, v128_t b);
+v128_t wasm_i32x4_le(v128_t a, v128_t b);
+v128_t wasm_u32x4_le(v128_t a, v128_t b);
+v128_t wasm_i32x4_ge(v128_t a, v128_t b);
+v128_t wasm_u32x4_ge(v128_t a, v128_t b);
+v128_t wasm_i32x4_abs(v128_t a);
+v128_t wasm_i32x4_neg(v128_t a);
+bool wasm_i32x4_all_true(v128_t a);
+uint32_t wasm_i32x4_bitmask(v128_t a);
+v128_t wasm_i32x4_extend_low_i16x8(v128_t a);
+v128_t wasm_i32x4_extend_high_i16x8(v128_t a);
+v128_t wasm_u32x4_extend_low_u16x8(v128_t a);
+v128_t wasm_u32x4_extend_high_u16x8(v128_t a);
+v128_t wasm_i32x4_shl(v128_t a, uint32_t b);
+v128_t wasm_i32x4_shr(v128_t a, uint32_t b);
+v128_t wasm_u32x4_shr(v128_t a, uint32_t b);
+v128_t wasm_i32x4_add(v128_t a, v128_t b);
+v128_t wasm_i32x4_sub(v128_t a, v128_t b);
+v128_t wasm_i32x4_mul(v128_t a, v128_t b);
+v128_t wasm_i32x4_min(v128_t a, v128_t b);
+v128_t wasm_u32x4_min(v128_t a, v128_t b);
+v128_t wasm_i32x4_max(v128_t a, v128_t b);
+v128_t wasm_u32x4_max(v128_t a, v128_t b);
+v128_t wasm_i32x4_dot_i16x8(v128_t a, v128_t b);
+v128_t wasm_i32x4_trunc_sat_f32x4(v128_t a);
+v128_t wasm_u32x4_trunc_sat_f32x4(v128_t a);
+
+v128_t wasm_i64x2_eq(v128_t a, v128_t b);
+v128_t wasm_i64x2_ne(v128_t a, v128_t b);
+v128_t wasm_i64x2_lt(v128_t a, v128_t b);
+v128_t wasm_i64x2_gt(v128_t a, v128_t b);
+v128_t wasm_i64x2_le(v128_t a, v128_t b);
+v128_t wasm_i64x2_ge(v128_t a, v128_t b);
+v128_t wasm_i64x2_abs(v128_t a);
+v128_t wasm_i64x2_neg(v128_t a);
+bool wasm_i64x2_all_true(v128_t a);
+uint32_t wasm_i64x2_bitmask(v128_t a);
+v128_t wasm_i64x2_extend_low_i32x4(v128_t a);
+v128_t wasm_i64x2_extend_high_i32x4(v128_t a);
+v128_t wasm_u64x2_extend_low_u32x4(v128_t a);
+v128_t wasm_u64x2_extend_high_u32x4(v128_t a);
+v128_t wasm_i64x2_shl(v128_t a, uint32_t b);
+v128_t wasm_i64x2_shr(v128_t a, uint32_t b);
+v128_t wasm_u64x2_shr(v128_t a, uint32_t b);
+v128_t wasm_i64x2_add(v128_t a, v128_t b);
+v128_t wasm_i64x2_sub(v128_t a, v128_t b);
+v128_t wasm_i64x2_mul(v128_t a, v128_t b);
+
+// Floating point
+v128_t wasm_f32x4_eq(v128_t a, v128_t b);
+v128_t wasm_f32x4_ne(v128_t a, v128_t b);
+v128_t wasm_f32x4_lt(v128_t a, v128_t b);
+v128_t wasm_f32x4_gt(v128_t a, v128_t b);
+v128_t wasm_f32x4_le(v128_t a, v128_t b);
+v128_t wasm_f32x4_ge(v128_t a, v128_t b);
+v128_t wasm_f32x4_abs(v128_t a);
+v128_t wasm_f32x4_neg(v128_t a);
+v128_t wasm_f32x4_sqrt(v128_t a);
+v128_t wasm_f32x4_ceil(v128_t a);
+v128_t wasm_f32x4_floor(v128_t a);
+v128_t wasm_f32x4_trunc(v128_t a);
+v128_t wasm_f32x4_nearest(v128_t a);
+v128_t wasm_f32x4_add(v128_t a, v128_t b);
+v128_t wasm_f32x4_sub(v128_t a, v128_t b);
+v128_t wasm_f32x4_mul(v128_t a, v128_t b);
+v128_t wasm_f32x4_div(v128_t a, v128_t b);
+v128_t wasm_f32x4_min(v128_t a, v128_t b);
+v128_t wasm_f32x4_max(v128_t a, v128_t b);
+v128_t wasm_f32x4_convert_i32x4(v128_t a);
+v128_t wasm_f32x4_convert_u32x4(v128_t a);
+v128_t wasm_f32x4_demote_f64x2_zero(v128_t a);
+
+v128_t wasm_f64x2_eq(v128_t a, v128_t b);
+v128_t wasm_f64x2_ne(v128_t a, v128_t b);
+v128_t wasm_f64x2_lt(v128_t a, v128_t b);
+v128_t wasm_f64x2_gt(v128_t a, v128_t b);
+v128_t wasm_f64x2_le(v128_t a, v128_t b);
+v128_t wasm_f64x2_ge(v128_t a, v128_t b);
+v128_t wasm_f64x2_abs(v128_t a);
+v128_t wasm_f64x2_neg(v128_t a);
+v128_t wasm_f64x2_sqrt(v128_t a);
+v128_t wasm_f64x2_ceil(v128_t a);
+v128_t wasm_f64x2_floor(v128_t a);
+v128_t wasm_f64x2_trunc(v128_t a);
+v128_t wasm_f64x2_nearest(v128_t a);
+v128_t wasm_f64x2_add(v128_t a, v128_t b);
+v128_t wasm_f64x2_sub(v128_t a, v128_t b);
+v128_t wasm_f64x2_mul(v128_t a, v128_t b);
+v128_t wasm_f64x2_div(v128_t a, v128_t b);
+v128_t wasm_f64x2_min(v128_t a, v128_t b);
+v128_t wasm_f64x2_max(v128_t a, v128_t b);
+v128_t wasm_f64x2_convert_low_i32x4(v128_t a);
+v128_t wasm_f64x2_convert_low_u32x4(v128_t a);
+v128_t wasm_f64x2_promote_low_f32x4(v128_t a);
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "pthread.h"
+
+#define DEFAULT_THREAD_STACK_SIZE  (64 * 1024)
+
+struct __pthread {
+  void *(*start_routine)(void*);
+  void *arg;
+  void *retval;
+  void *stack;
+  void *stack_top;
+  int done;  // Set to 1 when the thread finishes, and notified.
+};
+
+// Wasm globals, which are local to each instance (= thread).
+extern void *__stack_pointer;
+extern void *__tls_base;  // Running thread, NULL for the main thread.
+
+// Hooks in malloc, set when the first thread is created.
+extern void (*__malloc_lock)(void);
+extern void (*__malloc_unlock)(void);
@@ -0,0 +1,24 @@
+#include "pthread.h"
+#include "errno.h"
+
+int pthread_attr_init(pthread_attr_t *attr) {
+  attr->__stacksize = 0;
+  return 0;
+}
+
+int pthread_attr_destroy(pthread_attr_t *attr) {
+  (void)attr;
+  return 0;
+}
+
+int pthread_attr_setstacksize(pthread_attr_t *attr, size_t stacksize) {
+  if (stacksize == 0)
+    return EINVAL;
+  attr->__stacksize = stacksize;
+  return 0;
+}
+
+int pthread_attr_getstacksize(const pthread_attr_t *attr, size_t *stacksize) {
+  *stacksize = attr->__stacksize;
+  return 0;
+}
@@ -0,0 +1,63 @@
+#include "pthread.h"
+#include "errno.h"
+#include "stdlib.h"  // malloc, free
+
+#include "../wasi.h"
+#include "_pthread.h"
+
+static pthread_mutex_t malloc_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void malloc_lock(void) {
+  pthread_mutex_lock(&malloc_mutex);
+}
+
+static void malloc_unlock(void) {
+  pthread_mutex_unlock(&malloc_mutex);
+}
+
+static void thread_main(struct __pthread *thread) {
+  thread->retval = thread->start_routine(thread->arg);
+  __atomic_store_n(&thread->done, 1, __ATOMIC_SEQ_CST);
+  __builtin_wasm_memory_atomic_notify(&thread->done, -1);
+}
+
+// Entry point of a spawned thread, called by the host on a new instance.
+// Shadow stack is not available until it is set, so this function must not use it.
+void wasi_thread_start(int tid, void *arg) {
+  (void)tid;
+  struct __pthread *thread = arg;
+  __stack_pointer = thread->stack_top;
+  __tls_base = thread;
+  thread_main(thread);
+}
+
+int pthread_create(pthread_t *pthread, const pthread_attr_t *attr, void *(*start_routine)(void*),
+                   void *arg) {
+  // Only the main thread exists until the first spawn, so no race here.
+  __malloc_lock = malloc_lock;
+  __malloc_unlock = malloc_unlock;
+
+  size_t stack_size = DEFAULT_THREAD_STACK_SIZE;
+  if (attr != NULL && attr->__stacksize > 0)
+    stack_size = (attr->__stacksize + 15) & -16;
+
+  struct __pthread *thread = calloc(1, sizeof(*thread));
+  void *stack = malloc(stack_size);
+  if (thread == NULL || stack == NULL) {
+    free(thread);
+    free(stack);
+    return EAGAIN;
+  }
+  thread->start_routine = start_routine;
+  thread->arg = arg;
+  thread->stack = stack;
+  thread->stack_top = (char*)stack + stack_size;
+
+  if (thread_spawn(thread) < 0) {
+    free(stack);
+    free(thread);
+    return EAGAIN;
+  }
+  *pthread = thread;
+  return 0;
+}
@@ -0,0 +1,15 @@
+#include "pthread.h"
+#include "stdlib.h"  // free
+
+#include "_pthread.h"
+
+int pthread_join(pthread_t thread, void **retval) {
+  while (__atomic_load_n(&thread->done, __ATOMIC_SEQ_CST) == 0)
+    __builtin_wasm_memory_atomic_wait32(&thread->done, 0, -1);
+
+  if (retval != NULL)
+    *retval = thread->retval;
+  free(thread->stack);
+  free(thread);
+  return 0;
+}
@@ -0,0 +1,44 @@
+#include "pthread.h"
+#include "errno.h"
+#include "stdbool.h"
+
+// Mutex on `memory.atomic.wait32/notify`, by Ulrich Drepper's "Futexes Are Tricky".
+
+int pthread_mutex_init(pthread_mutex_t *mutex, const pthread_mutexattr_t *attr) {
+  (void)attr;
+  mutex->__state = 0;
+  return 0;
+}
+
+int pthread_mutex_destroy(pthread_mutex_t *mutex) {
+  return mutex->__state != 0 ? EBUSY : 0;
+}
+
+int pthread_mutex_lock(pthread_mutex_t *mutex) {
+  int c = 0;
+  if (__atomic_compare_exchange_n(&mutex->__state, &c, 1, false, __ATOMIC_SEQ_CST,
+                                  __ATOMIC_SEQ_CST))
+    return 0;
+
+  if (c != 2)
+    c = __atomic_exchange_n(&mutex->__state, 2, __ATOMIC_SEQ_CST);
+  while (c != 0) {
+    __builtin_wasm_memory_atomic_wait32(&mutex->__state, 2, -1);
+    c = __atomic_exchange_n(&mutex->__state, 2, __ATOMIC_SEQ_CST);
+  }
+  return 0;
+}
+
+int pthread_mutex_trylock(pthread_mutex_t *mutex) {
+  int c = 0;
+  return __atomic_compare_exchange_n(&mutex->__state, &c, 1, false, __ATOMIC_SEQ_CST,
+                                     __ATOMIC_SEQ_CST) ? 0 : EBUSY;
+}
+
+int pthread_mutex_unlock(pthread_mutex_t *mutex) {
+  if (__atomic_fetch_sub(&mutex->__state, 1, __ATOMIC_SEQ_CST) != 1) {
+    __atomic_store_n(&mutex->__state, 0, __ATOMIC_SEQ_CST);
+    __builtin_wasm_memory_atomic_notify(&mutex->__state, 1);
+  }
+  return 0;
+}
@@ -0,0 +1,14 @@
+#include "pthread.h"
+
+#include "_pthread.h"
+
+static struct __pthread main_thread;
+
+pthread_t pthread_self(void) {
+  struct __pthread *thread = __tls_base;
+  return thread != NULL ? thread : &main_thread;
+}
+
+int pthread_equal(pthread_t t1, pthread_t t2) {
+  return t1 == t2;
+}
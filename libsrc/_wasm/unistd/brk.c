@@ -2,7 +2,11 @@
 #include "stdio.h"  // EOF
 
 extern void *__curbrk;
-#define CURBRK  __curbrk
+
+// `__curbrk` is a global of each instance, and its initial value is stale for
+// threads: Keep the break address in linear memory, which is shared.
+static void *curbrk;
+#define CURBRK  (curbrk != NULL ? curbrk : (curbrk = __curbrk))
 
 #define HEAP_ALIGN  (8)
 #define MEMORY_PAGE_BIT  (16)
@@ -17,10 +21,10 @@ static void _growTo(void *ptr) {
 }
 
 int brk(void *addr) {
-  if (addr <= __curbrk)
+  if (addr <= CURBRK)
     return EOF;
   void *p = (void*)((((intptr_t)addr) + (HEAP_ALIGN - 1)) & -HEAP_ALIGN);
-  __curbrk = p;
+  curbrk = p;
   _growTo(p);
   return 0;
 }
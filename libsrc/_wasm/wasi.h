@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 #define WASI_MODULE  __attribute__((import_module("wasi_snapshot_preview1")))
+#define WASI_THREADS_MODULE  __attribute__((import_module("wasi")))
 
 // Fdflags
 #define FDFLAGS_APPEND           (1 << 0)
@@ -121,3 +122,6 @@ WASI_MODULE int fd_filestat_get(int fd, Filestat *out);
 WASI_MODULE int clock_time_get(int clockid, uint64_t precision, uint64_t *out);
 
 WASI_MODULE int random_get(void *buf, size_t buf_len);
+
+// wasi-threads: The host calls exported `wasi_thread_start(tid, start_arg)` on a new instance.
+WASI_THREADS_MODULE __attribute__((import_name("thread-spawn"))) int thread_spawn(void *start_arg);
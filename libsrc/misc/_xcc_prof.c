@@ -0,0 +1,38 @@
+// Runtime for `-fprofile-generate`: Dump basic block counters at exit.
+
+#if defined(__linux__)
+#include "stdio.h"
+#include "stdlib.h"  // atexit
+
+#define PROFILE_FILENAME  "xcc.prof"
+
+// Records are laid out in `.xcc_prof` section by the compiler:
+//   {const char *name; long count; long counters[count];}
+extern long __xcc_prof_start[];
+extern long __xcc_prof_end[];
+
+static void dump_profile(void) {
+  FILE *fp = fopen(PROFILE_FILENAME, "w");
+  if (fp == NULL)
+    return;
+  for (long *p = __xcc_prof_start; p < __xcc_prof_end; ) {
+    const char *name = (const char*)p[0];
+    long count = p[1];
+    fprintf(fp, "%s %ld", name, count);
+    for (long i = 0; i < count; ++i)
+      fprintf(fp, " %ld", p[2 + i]);
+    fputc('\n', fp);
+    p += 2 + count;
+  }
+  fclose(fp);
+}
+
+// Called from `.init_array` of each instrumented unit.
+void __xcc_prof_init(void) {
+  static int registered;
+  if (!registered) {
+    registered = 1;
+    atexit(dump_profile);
+  }
+}
+#endif
@@ -10,13 +10,21 @@
 static Header base = {.s={.ptr=&base, .size=0}};
 static Header *freep = &base;
 
-void free(void *ap) {
-  Header *bp, *p;
+#if defined(__WASM)
+// Set by pthread runtime (`-pthread`) before spawning a thread, so that a
+// single threaded program doesn't use atomic instructions.
+void (*__malloc_lock)(void);
+void (*__malloc_unlock)(void);
+#define lock()    do { if (__malloc_lock != NULL) (*__malloc_lock)(); } while (0)
+#define unlock()  do { if (__malloc_unlock != NULL) (*__malloc_unlock)(); } while (0)
+#else
+#define lock()
+#define unlock()
+#endif
 
-  if (ap == 0)
-    return;
+static void free_block(Header *bp) {
+  Header *p;
 
-  bp = (Header*)ap - 1;
   for (p = freep; !(bp > p && bp < p->s.ptr); p = p->s.ptr)
     if (p >= p->s.ptr && (bp > p || bp < p->s.ptr))
       break;
@@ -33,6 +41,15 @@ void free(void *ap) {
   freep = p;
 }
 
+void free(void *ap) {
+  if (ap == 0)
+    return;
+
+  lock();
+  free_block((Header*)ap - 1);
+  unlock();
+}
+
 static Header *morecore(size_t nu) {
   size_t size;
   char *p;
@@ -44,7 +61,7 @@ static Header *morecore(size_t nu) {
     return 0;
   hp = (Header*)p;
   hp->s.size = size / sizeof(Header);
-  free((void*)(hp + 1));
+  free_block(hp);
   return freep;
 }
 
@@ -53,6 +70,7 @@ void *malloc(size_t nbytes) {
   size_t nunits;
 
   nunits = (nbytes + sizeof(Header) - 1) / sizeof(Header) + 1;
+  lock();
   prevp = freep;
   for (p = prevp->s.ptr; ; prevp = p, p = p->s.ptr) {
     if (p->s.size >= nunits) {
@@ -64,10 +82,13 @@ void *malloc(size_t nbytes) {
         p->s.size = nunits;
       }
       freep = prevp;
+      unlock();
       return (void*)(p + 1);
     }
     if (p == freep)
-      if ((p = morecore(nunits)) == 0)
+      if ((p = morecore(nunits)) == 0) {
+        unlock();
         return 0;
+      }
   }
 }
@@ -21,6 +21,8 @@
 #define __NR_fstat   5
 #define __NR_lstat   6
 #define __NR_lseek   8
+#define __NR_mmap    9
+#define __NR_munmap  11
 #define __NR_brk     12
 #define __NR_ioctl   16
 #define __NR_pipe    22
@@ -30,6 +32,7 @@
 #define __NR_exit    60
 #define __NR_wait4   61
 #define __NR_kill    62
+#define __NR_ftruncate  77
 #define __NR_getcwd  79
 #define __NR_chdir   80
 #define __NR_unlink  87
@@ -59,6 +62,8 @@
 #define __NR_fstat   80
 #define __NR_lseek   62
 #define __NR_brk     214
+#define __NR_munmap  215
+#define __NR_mmap    222
 //#define __NR_ioctl   16
 #define __NR_pipe2    59
 #define __NR_dup     23
@@ -71,6 +76,7 @@
 #define __NR_kill    129
 #define __NR_getcwd  17
 #define __NR_chdir   49
+#define __NR_ftruncate  46
 #define __NR_unlinkat  35
 #define __NR_fchmodat   53
 #define __NR_clock_gettime  113
@@ -92,6 +98,7 @@
 #define __NR_getcwd  17
 #define __NR_dup     23
 #define __NR_chdir   49
+#define __NR_ftruncate  46
 #define __NR_openat  56
 #define __NR_close   57
 #define __NR_lseek   62
@@ -100,7 +107,9 @@
 #define __NR_exit    93
 #define __NR_kill    129
 #define __NR_brk     214
+#define __NR_munmap  215
 #define __NR_execve  221
+#define __NR_mmap    222
 #define __NR_wait4   260
 #define __NR_fstat   80
 
@@ -0,0 +1,19 @@
+#if !defined(__APPLE__)
+#include "unistd.h"
+#include "_syscall.h"
+#include "errno.h"
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+
+int ftruncate(int fd, off_t length) {
+  int ret;
+  SYSCALL_RET(__NR_ftruncate, ret);
+  if (ret < 0) {
+    errno = -ret;
+    ret = -1;
+  }
+  return ret;
+}
+#endif
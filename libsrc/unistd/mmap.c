@@ -0,0 +1,22 @@
+#if !defined(__APPLE__)
+#include "sys/mman.h"
+#include "_syscall.h"
+#include "errno.h"
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+
+void *mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset) {
+  long ret;
+#if defined(__x86_64__)
+  __asm("mov %rcx, %r10");  // 4th parameter for syscall is `%r10`. `%r10` is caller save so no need to save/restore
+#endif
+  SYSCALL_RET(__NR_mmap, ret);
+  if (ret < 0 && ret >= -4095) {
+    errno = -ret;
+    return MAP_FAILED;
+  }
+  return (void*)ret;
+}
+#endif
@@ -37,7 +37,7 @@ static void dump_vreg(FILE *fp, VReg *vreg) {
 
 static void dump_ir(FILE *fp, IR *ir) {
   static char *kOps[] = {
-    "BOFS", "IOFS", "SOFS", "LOAD", "LOAD_S", "STORE", "STORE_S",
+    "BOFS", "IOFS", "SOFS", "LOAD", "LOAD_S", "STORE", "STORE_S", "MEMCPY", "CLEAR",
     "ADD", "SUB", "MUL", "DIV", "MOD", "BITAND", "BITOR", "BITXOR", "LSHIFT", "RSHIFT",
     "NEG", "BITNOT", "COND", "JMP", "TJMP",
     "PRECALL", "PUSHARG", "CALL", "RESULT", "SUBSP",
@@ -68,6 +68,8 @@ static void dump_ir(FILE *fp, IR *ir) {
   case IR_LOAD_S: dump_vreg(fp, ir->dst); fprintf(fp, " = [v%d]\n", ir->opr1->virt); break;
   case IR_STORE:  fprintf(fp, "["); dump_vreg(fp, ir->opr2); fprintf(fp, "] = "); dump_vreg(fp, ir->opr1); fprintf(fp, "\n"); break;
   case IR_STORE_S:fprintf(fp, "[v%d] = ", ir->opr2->virt); dump_vreg(fp, ir->opr1); fprintf(fp, "\n"); break;
+  case IR_MEMCPY: fprintf(fp, "["); dump_vreg(fp, ir->opr2); fprintf(fp, "] = ["); dump_vreg(fp, ir->opr1); fprintf(fp, "], %zu\n", ir->memop.size); break;
+  case IR_CLEAR:  fprintf(fp, "["); dump_vreg(fp, ir->opr1); fprintf(fp, "] = 0, %zu\n", ir->memop.size); break;
   case IR_ADD:    dump_vreg(fp, ir->dst); fprintf(fp, " = "); dump_vreg(fp, ir->opr1); fprintf(fp, " + "); dump_vreg(fp, ir->opr2); fprintf(fp, "\n"); break;
   case IR_SUB:    dump_vreg(fp, ir->dst); fprintf(fp, " = "); dump_vreg(fp, ir->opr1); fprintf(fp, " - "); dump_vreg(fp, ir->opr2); fprintf(fp, "\n"); break;
   case IR_MUL:    dump_vreg(fp, ir->dst); fprintf(fp, " = "); dump_vreg(fp, ir->opr1); fprintf(fp, " * "); dump_vreg(fp, ir->opr2); fprintf(fp, "\n"); break;
@@ -21,6 +21,8 @@ int main(int argc, char *argv[]) {
   const char *ofn = "a.wasm";
   const char *entry_point = "_start";
   uint32_t stack_size = DEFAULT_STACK_SIZE;
+  bool compress_relocations = false;
+  bool gc_sections = false;
 
   init();
 
@@ -28,12 +30,16 @@ int main(int argc, char *argv[]) {
     OPT_VERBOSE = 256,
     OPT_ENTRY_POINT,
     OPT_STACK_SIZE,
+    OPT_COMPRESS_RELOCATIONS,
+    OPT_GC_SECTIONS,
   };
   static const struct option kOptions[] = {
     {"o", required_argument},  // Specify output filename
     {"-verbose", no_argument, OPT_VERBOSE},
     {"-entry-point", required_argument, OPT_ENTRY_POINT},
     {"-stack-size", required_argument, OPT_STACK_SIZE},
+    {"-compress-relocations", no_argument, OPT_COMPRESS_RELOCATIONS},
+    {"-gc-sections", no_argument, OPT_GC_SECTIONS},
 
     {NULL},
   };
@@ -60,6 +66,12 @@ int main(int argc, char *argv[]) {
         stack_size = size;
       }
       break;
+    case OPT_COMPRESS_RELOCATIONS:
+      compress_relocations = true;
+      break;
+    case OPT_GC_SECTIONS:
+      gc_sections = true;
+      break;
     case '?':
       fprintf(stderr, "Warning: unknown option: %s\n", argv[optind - 1]);
       break;
@@ -70,6 +82,8 @@ int main(int argc, char *argv[]) {
   WasmLinker linker_body;
   WasmLinker *linker = &linker_body;
   linker_init(linker);
+  linker->compress_relocations = compress_relocations;
+  linker->gc_sections = gc_sections;
 
   bool result = true;
   for (int i = iarg; i < argc; ++i) {
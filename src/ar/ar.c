@@ -0,0 +1,548 @@
+// Archiver
+
+#include "../config.h"
+
+#include <ar.h>
+#include <fcntl.h>
+#include <libgen.h>  // basename, dirname
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>  // close, ftruncate, getcwd, unlink, write
+
+#if !defined(__XCC)
+#define AR_USE_THREADS
+#include <pthread.h>
+#include <stdatomic.h>
+#endif
+
+#include "archive.h"
+#include "elfutil.h"
+#include "util.h"
+
+#define THINMAG  "!<thin>\n"
+#define MAX_SHORT_NAME  (15)  // Name and '/' fit in `ar_name`.
+
+typedef struct {
+  const char *name;  // Member name in the archive.
+  const char *path;  // Source file, or NULL if the content is taken from the existing archive.
+  const unsigned char *content;
+  size_t size;
+  // Set on worker threads:
+  const Elf64_Sym *syms;
+  size_t sym_count;
+  const char *strtab;
+  size_t strtab_size;
+  const char *error;
+  // Layout:
+  uint32_t header_offset;
+  uint32_t name_offset;  // Offset in the long name table, or -1.
+} Member;
+
+typedef struct {
+  const char *archive;
+  Vector *members;  // <Member*>
+  bool thin;
+  int nthreads;
+  unsigned char *out;
+} Archiver;
+
+// Runs on worker threads: Must not allocate, nor print; errors are kept in the member.
+static void map_member(Member *member) {
+  if (member->path != NULL) {
+    int fd = open(member->path, O_RDONLY);
+    if (fd < 0) {
+      member->error = "cannot open";
+      return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      member->error = "cannot stat";
+      return;
+    }
+    member->size = st.st_size;
+    if (st.st_size > 0) {
+      void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+        close(fd);
+        member->error = "cannot map";
+        return;
+      }
+      member->content = p;
+    }
+    close(fd);
+  }
+
+  const Elf64_Shdr *symtab = member->content != NULL ?
+      find_elf_symtab(member->content, member->size) : NULL;
+  if (symtab == NULL)
+    return;  // Not an object: No symbols.
+  const Elf64_Shdr *shdrs = (const Elf64_Shdr*)(member->content +
+                                                ((const Elf64_Ehdr*)member->content)->e_shoff);
+  const Elf64_Shdr *strtab = &shdrs[symtab->sh_link];
+  if (strtab->sh_offset > member->size || member->size - strtab->sh_offset < strtab->sh_size) {
+    member->error = "illegal strtab";
+    return;
+  }
+  member->syms = (const Elf64_Sym*)(member->content + symtab->sh_offset);
+  member->sym_count = symtab->sh_size / sizeof(Elf64_Sym);
+  member->strtab = (const char*)(member->content + strtab->sh_offset);
+  member->strtab_size = strtab->sh_size;
+}
+
+static void copy_member(Archiver *arc, Member *member) {
+  if (member->size > 0)
+    memcpy(arc->out + member->header_offset + sizeof(struct ar_hdr), member->content,
+           member->size);
+  if ((member->size & 1) != 0)
+    arc->out[member->header_offset + sizeof(struct ar_hdr) + member->size] = '\n';
+}
+
+typedef void (*MemberTaskFunc)(Archiver*, Member*);
+
+#ifdef AR_USE_THREADS
+typedef struct {
+  Archiver *arc;
+  MemberTaskFunc func;
+  atomic_int next;
+} MemberTaskQueue;
+
+static void *member_task_worker(void *arg) {
+  MemberTaskQueue *queue = arg;
+  Vector *members = queue->arc->members;
+  for (;;) {
+    int i = atomic_fetch_add(&queue->next, 1);
+    if (i >= members->len)
+      break;
+    (*queue->func)(queue->arc, members->data[i]);
+  }
+  return NULL;
+}
+#endif
+
+// Call `func` for every member, on `arc->nthreads` threads.
+static void run_member_tasks(Archiver *arc, MemberTaskFunc func) {
+  Vector *members = arc->members;
+#ifdef AR_USE_THREADS
+  int nthreads = arc->nthreads < members->len ? arc->nthreads : members->len;
+  if (nthreads > 1) {
+    MemberTaskQueue queue = {.arc = arc, .func = func};
+    atomic_init(&queue.next, 0);
+    pthread_t *threads = malloc_or_die(sizeof(*threads) * (nthreads - 1));
+    int nstarted = 0;
+    for (; nstarted < nthreads - 1; ++nstarted) {
+      if (pthread_create(&threads[nstarted], NULL, member_task_worker, &queue) != 0)
+        break;  // Continue with the threads available.
+    }
+    member_task_worker(&queue);
+    for (int i = 0; i < nstarted; ++i)
+      pthread_join(threads[i], NULL);
+    free(threads);
+    return;
+  }
+#endif
+  for (int i = 0; i < members->len; ++i)
+    (*func)(arc, members->data[i]);
+}
+
+static void map_member_task(Archiver *arc, Member *member) {
+  UNUSED(arc);
+  map_member(member);
+}
+
+// Path of `path` relative to the directory `dir`: Both are absolute and normalized.
+static char *relative_path(const char *dir, const char *path) {
+  size_t common = 0;
+  for (size_t i = 0; ; ++i) {
+    char c = dir[i];
+    if ((c == '\0' || c == '/') && path[i] == '/')
+      common = i;
+    if (c == '\0' || c != path[i])
+      break;
+  }
+
+  int ups = 0;
+  for (const char *p = &dir[common]; *p != '\0'; ) {
+    while (*p == '/')
+      ++p;
+    if (*p == '\0')
+      break;
+    ++ups;
+    while (*p != '\0' && *p != '/')
+      ++p;
+  }
+
+  const char *rest = &path[common + 1];
+  size_t len = strlen(rest);
+  char *buf = malloc_or_die(ups * 3 + len + 1);
+  char *q = buf;
+  for (int i = 0; i < ups; ++i, q += 3)
+    memcpy(q, "../", 3);
+  memcpy(q, rest, len + 1);
+  return buf;
+}
+
+static char *absolute_path(const char *path) {
+  if (is_fullpath(path))
+    return JOIN_PATHS(path);
+  char cwd[4096];
+  if (getcwd(cwd, sizeof(cwd)) == NULL)
+    error("getcwd failed");
+  return JOIN_PATHS(cwd, path);
+}
+
+// Regular archive keeps the base name, and thin archive keeps the path from the archive
+// (absolute path is kept as is).
+static const char *member_name_for(Archiver *arc, const char *path) {
+  if (!arc->thin)
+    return basename(strdup(path));
+  if (is_fullpath(path))
+    return path;
+  char *archive_dir = dirname(absolute_path(arc->archive));
+  return relative_path(archive_dir, absolute_path(path));
+}
+
+static Member *new_member(const char *name, const char *path) {
+  Member *member = calloc_or_die(sizeof(*member));
+  member->name = name;
+  member->path = path;
+  return member;
+}
+
+static void *load_existing_member(Archive *ar, size_t offset, const char *name, size_t size) {
+  Member *member;
+  if (ar->thin) {
+    member = new_member(NULL, name);
+    member->size = size;
+  } else {
+    member = new_member(name, NULL);
+    member->content = read_or_die(ar->fp, NULL, offset, size, "Read member failed");
+    member->size = size;
+  }
+  return member;
+}
+
+static Vector *read_existing_members(Archiver *arc) {
+  if (!is_file(arc->archive))
+    return NULL;
+  Archive *ar = load_archive(arc->archive);
+  if (ar == NULL)
+    error("cannot open: %s", arc->archive);
+  if (arc->thin && !ar->thin)
+    error("%s: cannot convert existing archive to thin archive", arc->archive);
+  arc->thin = ar->thin;
+
+  Vector *contents = load_archive_members(ar, load_existing_member);
+  Vector *members = new_vector();
+  for (int i = 0; i < contents->len; ++i) {
+    ArContent *content = contents->data[i];
+    Member *member = content->obj;
+    if (member->name == NULL)
+      member->name = member_name_for(arc, member->path);
+    vec_push(members, member);
+  }
+  fclose(ar->fp);
+  return members;
+}
+
+static int find_member(Vector *members, const char *name) {
+  for (int i = 0; i < members->len; ++i) {
+    Member *member = members->data[i];
+    if (strcmp(member->name, name) == 0)
+      return i;
+  }
+  return -1;
+}
+
+// Symbol index lists defined global symbols of each member, in the member order.
+static bool is_index_symbol(const Elf64_Sym *sym) {
+  int bind = ELF64_ST_BIND(sym->st_info);
+  return (bind == STB_GLOBAL || bind == STB_WEAK) && sym->st_shndx != SHN_UNDEF &&
+      sym->st_name != 0;
+}
+
+static void put_header(unsigned char *p, const char *name, const char *date, const char *uid,
+                       const char *gid, const char *mode, size_t size) {
+  char buf[128];  // Fields never overflow.
+  snprintf(buf, sizeof(buf), "%-16s%-12s%-6s%-6s%-8s%-10lu" ARFMAG, name, date, uid, gid, mode,
+           (unsigned long)size);
+  memcpy(p, buf, sizeof(struct ar_hdr));
+}
+
+static void put4be(unsigned char *p, uint32_t x) {
+  p[0] = x >> 24;
+  p[1] = x >> 16;
+  p[2] = x >> 8;
+  p[3] = x;
+}
+
+static bool write_archive(Archiver *arc) {
+  Vector *members = arc->members;
+
+  // Symbol index.
+  uint32_t symbol_count = 0;
+  size_t symbol_names_size = 0;
+  for (int i = 0; i < members->len; ++i) {
+    Member *member = members->data[i];
+    for (size_t j = 0; j < member->sym_count; ++j) {
+      const Elf64_Sym *sym = &member->syms[j];
+      if (!is_index_symbol(sym))
+        continue;
+      if (sym->st_name >= member->strtab_size)
+        error("%s: illegal symbol name", member->name);
+      ++symbol_count;
+      symbol_names_size += strnlen(&member->strtab[sym->st_name],
+                                   member->strtab_size - sym->st_name) + 1;
+    }
+  }
+  size_t index_size = symbol_count > 0 ? ALIGN(4 + symbol_count * 4 + symbol_names_size, 2) : 0;
+
+  // Long name table: `name/\n` entries.
+  size_t long_names_used = 0;
+  for (int i = 0; i < members->len; ++i) {
+    Member *member = members->data[i];
+    size_t len = strlen(member->name);
+    if (arc->thin || len > MAX_SHORT_NAME) {
+      member->name_offset = long_names_used;
+      long_names_used += len + 2;
+    } else {
+      member->name_offset = (uint32_t)-1;
+    }
+  }
+  size_t long_names_size = ALIGN(long_names_used, 2);
+
+  size_t offset = SARMAG;
+  if (index_size > 0)
+    offset += sizeof(struct ar_hdr) + index_size;
+  if (long_names_size > 0)
+    offset += sizeof(struct ar_hdr) + long_names_size;
+  for (int i = 0; i < members->len; ++i) {
+    Member *member = members->data[i];
+    member->header_offset = offset;
+    offset += sizeof(struct ar_hdr);
+    if (!arc->thin)
+      offset += ALIGN(member->size, 2);
+  }
+  if (offset > UINT32_MAX)
+    error("%s: archive too large", arc->archive);
+  size_t total_size = offset;
+
+  // Map the output file, to fill member contents on threads.
+  unlink(arc->archive);
+  int fd = open(arc->archive, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    fprintf(stderr, "cannot open output file: %s\n", arc->archive);
+    return false;
+  }
+  unsigned char *out = MAP_FAILED;
+  if (ftruncate(fd, total_size) == 0)
+    out = mmap(NULL, total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  bool mapped = out != MAP_FAILED;
+  if (!mapped)
+    out = malloc_or_die(total_size);
+  arc->out = out;
+
+  memcpy(out, arc->thin ? THINMAG : ARMAG, SARMAG);
+  unsigned char *p = out + SARMAG;
+  if (index_size > 0) {
+    put_header(p, "/", "0", "0", "0", "0", index_size);
+    p += sizeof(struct ar_hdr);
+    put4be(p, symbol_count);
+    unsigned char *q = p + 4;
+    char *names = (char*)&p[4 + symbol_count * 4];
+    for (int i = 0; i < members->len; ++i) {
+      Member *member = members->data[i];
+      for (size_t j = 0; j < member->sym_count; ++j) {
+        const Elf64_Sym *sym = &member->syms[j];
+        if (!is_index_symbol(sym))
+          continue;
+        put4be(q, member->header_offset);
+        q += 4;
+        const char *name = &member->strtab[sym->st_name];
+        size_t len = strnlen(name, member->strtab_size - sym->st_name);
+        memcpy(names, name, len);
+        names[len] = '\0';
+        names += len + 1;
+      }
+    }
+    if ((char*)&p[index_size] > names)
+      *names = '\0';
+    p += index_size;
+  }
+  if (long_names_size > 0) {
+    put_header(p, "//", "", "", "", "", long_names_size);
+    p += sizeof(struct ar_hdr);
+    for (int i = 0; i < members->len; ++i) {
+      Member *member = members->data[i];
+      if (member->name_offset == (uint32_t)-1)
+        continue;
+      size_t len = strlen(member->name);
+      memcpy(&p[member->name_offset], member->name, len);
+      memcpy(&p[member->name_offset + len], "/\n", 2);
+    }
+    if (long_names_used < long_names_size)
+      p[long_names_used] = '\n';
+    p += long_names_size;
+  }
+  for (int i = 0; i < members->len; ++i) {
+    Member *member = members->data[i];
+    char name[sizeof(struct ar_hdr)];
+    if (member->name_offset == (uint32_t)-1)
+      snprintf(name, sizeof(name), "%s/", member->name);
+    else
+      snprintf(name, sizeof(name), "/%lu", (unsigned long)member->name_offset);
+    put_header(&out[member->header_offset], name, "0", "0", "0", "644", member->size);
+  }
+  if (!arc->thin)
+    run_member_tasks(arc, copy_member);
+
+  bool result = true;
+  if (mapped) {
+    munmap(out, total_size);
+  } else {
+    for (size_t written = 0; written < total_size; ) {
+      ssize_t n = write(fd, out + written, total_size - written);
+      if (n <= 0) {
+        result = false;
+        break;
+      }
+      written += n;
+    }
+    free(out);
+  }
+  close(fd);
+  return result;
+}
+
+static void list_members(Archiver *arc, bool verbose) {
+  Vector *members = read_existing_members(arc);
+  if (members == NULL)
+    error("%s: no such file", arc->archive);
+  for (int i = 0; i < members->len; ++i) {
+    Member *member = members->data[i];
+    if (verbose)
+      printf("%8lu %s\n", (unsigned long)member->size, member->name);
+    else
+      printf("%s\n", member->name);
+  }
+}
+
+static void usage(FILE *fp) {
+  fprintf(fp,
+      "Usage: xcc-ar [options] [-]{q|r|t}[csTv] archive [files...]\n"
+      "Operations:\n"
+      "  q     Append files\n"
+      "  r     Insert files, replacing the members of the same name\n"
+      "  t     List members\n"
+      "Modifiers:\n"
+      "  c     Create the archive silently\n"
+      "  s     Write the symbol index (always written)\n"
+      "  T     Make a thin archive, which refers files by path\n"
+      "  v     Verbose\n"
+      "Options:\n"
+      "  --threads=<n>  Number of threads to read and copy members\n"
+      "  --version      Show version\n"
+  );
+}
+
+int main(int argc, char *argv[]) {
+  Archiver arc = {.nthreads = 1};
+  int iarg = 1;
+  for (; iarg < argc && strncmp(argv[iarg], "--", 2) == 0; ++iarg) {
+    const char *arg = argv[iarg];
+    if (strcmp(arg, "--version") == 0) {
+      show_version("xcc-ar");
+      return 0;
+    } else if (strcmp(arg, "--help") == 0) {
+      usage(stdout);
+      return 0;
+    } else if (strncmp(arg, "--threads=", 10) == 0) {
+      char *end;
+      long n = strtol(arg + 10, &end, 10);
+      if (*end != '\0' || n < 1)
+        error("Illegal thread count: %s", arg + 10);
+      arc.nthreads = n;
+    } else {
+      error("unknown option: %s", arg);
+    }
+  }
+  if (iarg + 1 >= argc) {
+    usage(stderr);
+    return 1;
+  }
+
+  char operation = '\0';
+  bool create = false, verbose = false;
+  for (const char *p = argv[iarg++]; *p != '\0'; ++p) {
+    switch (*p) {
+    case '-':
+      break;
+    case 'q': case 'r': case 't':
+      if (operation != '\0')
+        error("Only one operation is allowed");
+      operation = *p;
+      break;
+    case 'c':  create = true; break;
+    case 's':  break;
+    case 'T':  arc.thin = true; break;
+    case 'v':  verbose = true; break;
+    default:
+      error("Unknown modifier: %c", *p);
+    }
+  }
+  arc.archive = argv[iarg++];
+
+  switch (operation) {
+  case 't':
+    list_members(&arc, verbose);
+    return 0;
+  case 'q': case 'r':
+    break;
+  default:
+    usage(stderr);
+    return 1;
+  }
+
+  Vector *members = read_existing_members(&arc);
+  if (members == NULL) {
+    if (!create)
+      fprintf(stderr, "xcc-ar: creating %s\n", arc.archive);
+    members = new_vector();
+  }
+  for (; iarg < argc; ++iarg) {
+    const char *path = argv[iarg];
+    if (!is_file(path))
+      error("%s: No such file", path);
+    Member *member = new_member(member_name_for(&arc, path), path);
+    int index = operation == 'r' ? find_member(members, member->name) : -1;
+    if (index >= 0) {
+      members->data[index] = member;
+      if (verbose)
+        printf("r - %s\n", member->name);
+    } else {
+      vec_push(members, member);
+      if (verbose)
+        printf("a - %s\n", member->name);
+    }
+  }
+  arc.members = members;
+
+  run_member_tasks(&arc, map_member_task);
+  int error_count = 0;
+  for (int i = 0; i < members->len; ++i) {
+    Member *member = members->data[i];
+    if (member->error != NULL) {
+      fprintf(stderr, "%s: %s\n", member->path != NULL ? member->path : member->name,
+              member->error);
+      ++error_count;
+    }
+  }
+  if (error_count > 0)
+    return 1;
+
+  return write_archive(&arc) ? 0 : 1;
+}
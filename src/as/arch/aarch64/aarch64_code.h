@@ -97,3 +97,22 @@
 #define FCVT(dsz, rt, rn)                          MAKE_CODE32(inst, code, 0x1e224000 | ((1 - (dsz)) << 22) | ((dsz) << 15) | ((rn) << 5) | (rt))
 #define FCVTZS(dsz, rt, ssz, rn)                   MAKE_CODE32(inst, code, 0x1e380000 | ((dsz) << 31) | ((ssz) << 22) | ((rn) << 5) | (rt))
 #define FCVTZU(dsz, rt, ssz, rn)                   MAKE_CODE32(inst, code, 0x1e390000 | ((dsz) << 31) | ((ssz) << 22) | ((rn) << 5) | (rt))
+
+// SIMD instructions.
+
+#define Q_LDUR(rt, ofs, base)                      MAKE_CODE32(inst, code, 0x3cc00000U | ((((ofs) & ((1U << 9) - 1))) << 12) | ((base) << 5) | (rt))
+#define Q_LDR_UIMM(rt, ofs, base)                  MAKE_CODE32(inst, code, 0x3dc00000U | ((((ofs) & ((1U << 12) - 1))) << 10) | ((base) << 5) | (rt))
+#define Q_STUR(rt, ofs, base)                      MAKE_CODE32(inst, code, 0x3c800000U | ((((ofs) & ((1U << 9) - 1))) << 12) | ((base) << 5) | (rt))
+#define Q_STR_UIMM(rt, ofs, base)                  MAKE_CODE32(inst, code, 0x3d800000U | ((((ofs) & ((1U << 12) - 1))) << 10) | ((base) << 5) | (rt))
+#define Q_LDR_R(rt, base, rm, s2, option)          MAKE_CODE32(inst, code, 0x3ce00800U | ((rm) << 16) | ((option) << 13) | ((s2) << 12) | ((base) << 5) | (rt))
+#define Q_STR_R(rt, base, rm, s2, option)          MAKE_CODE32(inst, code, 0x3ca00800U | ((rm) << 16) | ((option) << 13) | ((s2) << 12) | ((base) << 5) | (rt))
+
+#define V_ORR(rd, rn, rm)                          MAKE_CODE32(inst, code, 0x4ea01c00U | ((rm) << 16) | ((rn) << 5) | (rd))
+#define V_ADD(size, rd, rn, rm)                    MAKE_CODE32(inst, code, 0x4e208400U | ((size) << 22) | ((rm) << 16) | ((rn) << 5) | (rd))
+#define V_SUB(size, rd, rn, rm)                    MAKE_CODE32(inst, code, 0x6e208400U | ((size) << 22) | ((rm) << 16) | ((rn) << 5) | (rd))
+#define V_FADD(sz, rd, rn, rm)                     MAKE_CODE32(inst, code, 0x4e20d400U | ((sz) << 22) | ((rm) << 16) | ((rn) << 5) | (rd))
+#define V_FSUB(sz, rd, rn, rm)                     MAKE_CODE32(inst, code, 0x4ea0d400U | ((sz) << 22) | ((rm) << 16) | ((rn) << 5) | (rd))
+#define V_FMUL(sz, rd, rn, rm)                     MAKE_CODE32(inst, code, 0x6e20dc00U | ((sz) << 22) | ((rm) << 16) | ((rn) << 5) | (rd))
+#define V_FDIV(sz, rd, rn, rm)                     MAKE_CODE32(inst, code, 0x6e20fc00U | ((sz) << 22) | ((rm) << 16) | ((rn) << 5) | (rd))
+#define V_DUP_E(rd, rn, imm5)                      MAKE_CODE32(inst, code, 0x4e000400U | ((imm5) << 16) | ((rn) << 5) | (rd))
+#define V_DUP_G(rd, rn, imm5)                      MAKE_CODE32(inst, code, 0x4e000c00U | ((imm5) << 16) | ((rn) << 5) | (rd))
@@ -265,7 +265,7 @@ static unsigned char *asm_ldrstr(Inst *inst, Code *code) {
         b |= sz;
         if (opr2->indirect.prepost == 0) {
           if (offset >= 0)
-            W_LDR_UIMM(b, s, opr1->reg.no, offset >> (2 + sz), base);
+            W_LDR_UIMM(b, s, opr1->reg.no, offset >> b, base);
           else
             W_LDUR(b, s, opr1->reg.no, offset, base);
         } else {
@@ -276,7 +276,7 @@ static unsigned char *asm_ldrstr(Inst *inst, Code *code) {
     case STRB: case STRH: case STR:
       if (opr2->indirect.prepost == 0) {
         if (offset >= 0)
-          W_STR_UIMM((inst->op - STRB) | sz, opr1->reg.no, offset >> (2 + sz), base);
+          W_STR_UIMM((inst->op - STRB) | sz, opr1->reg.no, offset >> ((inst->op - STRB) | sz), base);
         else
           W_STUR((inst->op - STRB) | sz, opr1->reg.no, offset, base);
       } else {
@@ -426,9 +426,45 @@ static unsigned char *asm_svc(Inst *inst, Code *code) {
 
 // FP instructions.
 
+// ldr/str for q register: Supports only non pre/post indexed form.
+static unsigned char *asm_q_ldrstr(Inst *inst, Code *code) {
+  Operand *opr1 = &inst->opr[0];
+  Operand *opr2 = &inst->opr[1];
+  if (opr2->type == INDIRECT) {
+    assert(opr2->indirect.reg.size == REG64);
+    ExprWithFlag *offset_expr = &opr2->indirect.offset;
+    int64_t offset = offset_expr->expr != NULL && offset_expr->expr->kind == EX_FIXNUM ? offset_expr->expr->fixnum : 0;
+    uint32_t base = opr2->indirect.reg.no;
+    if (opr2->indirect.prepost != 0)
+      return NULL;
+
+    if (offset >= 0 && (offset & 15) == 0 && offset < (1 << (12 + 4))) {
+      if (inst->op == F_LDR)  Q_LDR_UIMM(opr1->reg.no, offset >> 4, base);
+      else                    Q_STR_UIMM(opr1->reg.no, offset >> 4, base);
+    } else if (offset < (1 << 8) && offset >= -(1 << 8)) {
+      if (inst->op == F_LDR)  Q_LDUR(opr1->reg.no, offset, base);
+      else                    Q_STUR(opr1->reg.no, offset, base);
+    } else {
+      return NULL;
+    }
+    return code->buf;
+  } else {
+    assert(opr2->type == REGISTER_OFFSET);
+    static const uint32_t opts[] = {3, 6, 2, 3, 3};
+    uint32_t opt = opts[opr2->register_offset.extend];
+    uint32_t s = opr2->register_offset.extend > 0 ? 1 : 0;
+    if (inst->op == F_LDR)  Q_LDR_R(opr1->reg.no, opr2->register_offset.base_reg.no, opr2->register_offset.index_reg.no, s, opt);
+    else                    Q_STR_R(opr1->reg.no, opr2->register_offset.base_reg.no, opr2->register_offset.index_reg.no, s, opt);
+    return code->buf;
+  }
+}
+
 static unsigned char *asm_f_ldrstr(Inst *inst, Code *code) {
   Operand *opr1 = &inst->opr[0];
   Operand *opr2 = &inst->opr[1];
+  if (opr1->reg.size == REG128)
+    return asm_q_ldrstr(inst, code);
+
   uint32_t sz = opr1->reg.size == REG64 ? 1 : 0;
   if (opr2->type == INDIRECT) {
     assert(opr2->indirect.reg.size == REG64);
@@ -539,6 +575,63 @@ static unsigned char *asm_f_2r(Inst *inst, Code *code) {
   return code->buf;
 }
 
+// SIMD instructions.
+
+static unsigned char *asm_v_mov(Inst *inst, Code *code) {
+  Operand *opr1 = &inst->opr[0];
+  Operand *opr2 = &inst->opr[1];
+  if (opr1->vreg.size != 0 || opr2->vreg.size != 0)  // Only 16b
+    return NULL;
+  V_ORR(opr1->vreg.no, opr2->vreg.no, opr2->vreg.no);
+  return code->buf;
+}
+
+static unsigned char *asm_v_3r(Inst *inst, Code *code) {
+  Operand *opr1 = &inst->opr[0];
+  Operand *opr2 = &inst->opr[1];
+  Operand *opr3 = &inst->opr[2];
+  uint32_t size = opr1->vreg.size;
+  if (opr2->vreg.size != (char)size || opr3->vreg.size != (char)size)
+    return NULL;
+
+  uint32_t rd = opr1->vreg.no, rn = opr2->vreg.no, rm = opr3->vreg.no;
+  switch (inst->op) {
+  case ADD_V:  V_ADD(size, rd, rn, rm); return code->buf;
+  case SUB_V:  V_SUB(size, rd, rn, rm); return code->buf;
+  default: break;
+  }
+
+  // Floating point: 4s or 2d only.
+  if (size < 2)
+    return NULL;
+  uint32_t sz = size - 2;
+  switch (inst->op) {
+  case FADD_V:  V_FADD(sz, rd, rn, rm); break;
+  case FSUB_V:  V_FSUB(sz, rd, rn, rm); break;
+  case FMUL_V:  V_FMUL(sz, rd, rn, rm); break;
+  case FDIV_V:  V_FDIV(sz, rd, rn, rm); break;
+  default: assert(false); break;
+  }
+  return code->buf;
+}
+
+static unsigned char *asm_v_dup(Inst *inst, Code *code) {
+  Operand *opr1 = &inst->opr[0];
+  Operand *opr2 = &inst->opr[1];
+  uint32_t size = opr1->vreg.size;
+  uint32_t imm5 = 1U << size;
+  if (inst->op == DUP_E) {
+    if (opr2->vreg.size != (char)size)
+      return NULL;
+    V_DUP_E(opr1->vreg.no, opr2->vreg.no, imm5 | (opr2->vreg.index << (size + 1)));
+  } else {
+    if ((opr2->reg.size == REG64) != (size == 3))
+      return NULL;
+    V_DUP_G(opr1->vreg.no, opr2->reg.no, imm5);
+  }
+  return code->buf;
+}
+
 ////////////////////////////////////////////////
 
 typedef unsigned char *(*AsmInstFunc)(Inst *inst, Code *code);
@@ -586,6 +679,11 @@ static const AsmInstFunc table[] = {
   [FSQRT] = asm_f_2r,
   [SCVTF] = asm_f_2r, [UCVTF] = asm_f_2r,
   [FCVT] = asm_f_2r, [FCVTZS] = asm_f_2r, [FCVTZU] = asm_f_2r,
+
+  [MOV_V] = asm_v_mov,
+  [ADD_V] = asm_v_3r, [SUB_V] = asm_v_3r,
+  [FADD_V] = asm_v_3r, [FSUB_V] = asm_v_3r, [FMUL_V] = asm_v_3r, [FDIV_V] = asm_v_3r,
+  [DUP_E] = asm_v_dup, [DUP_G] = asm_v_dup,
 };
 
 void assemble_inst(Inst *inst, ParseInfo *info, Code *code) {
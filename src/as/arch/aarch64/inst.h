@@ -39,11 +39,18 @@ enum Opcode {
   FSQRT,
   SCVTF, UCVTF,
   FCVT, FCVTZS, FCVTZU,
+
+  // SIMD
+  MOV_V,
+  ADD_V, SUB_V,
+  FADD_V, FSUB_V, FMUL_V, FDIV_V,
+  DUP_E, DUP_G,
 };
 
 enum RegSize {
   REG32,
   REG64,
+  REG128,  // q0~q31
 };
 
 typedef struct {
@@ -71,6 +78,7 @@ enum OperandType {
   SHIFT,
   EXTEND,
   FREG,       // freg
+  VREG,       // v0.4s, v0.s[1]
 };
 
 #define LF_PAGE     (1 << 0)
@@ -106,6 +114,11 @@ typedef struct {
       int option;
       int imm;
     } extend;
+    struct {
+      char no;     // 0~31
+      char size;   // Element size: 0=b, 1=h, 2=s, 3=d
+      char index;  // Element index, -1 for whole register
+    } vreg;
   };
 } Operand;
 
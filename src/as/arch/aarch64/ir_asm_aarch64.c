@@ -90,6 +90,26 @@ bool calc_label_address(uintptr_t start_address, Vector *sections, Table *label_
   return settle;
 }
 
+// Branches are fixed length: No relaxation.
+const Name *short_branch_target(IR *ir, Table *label_table, int64_t *poffset) {
+  UNUSED(ir);
+  UNUSED(label_table);
+  UNUSED(poffset);
+  return NULL;
+}
+
+bool is_branch_reachable(IR *ir, uintptr_t address, uintptr_t target) {
+  UNUSED(ir);
+  UNUSED(address);
+  UNUSED(target);
+  return true;
+}
+
+bool make_branch_long(IR *ir) {
+  UNUSED(ir);
+  return false;
+}
+
 bool resolve_relative_address(Vector *sections, Table *label_table, Vector *unresolved) {
   assert(unresolved != NULL);
   vec_clear(unresolved);
@@ -200,6 +220,17 @@ bool resolve_relative_address(Vector *sections, Table *label_table, Vector *unre
                   vec_push(unresolved, info);
                   break;*/
                   assert(false);
+                } else if (label_info->section != section) {
+                  // Branch to other section (e.g. -ffunction-sections): Let the linker resolve.
+                  assert(inst->op == B);
+                  UnresolvedInfo *info = malloc_or_die(sizeof(*info));
+                  info->kind = UNRES_CALL;
+                  info->label = value.label;
+                  info->src_section = section;
+                  info->offset = address - start_address;
+                  info->add = value.offset;
+                  vec_push(unresolved, info);
+                  break;
                 } else {
                   value.offset += label_info->address;
                 }
@@ -37,6 +37,7 @@ enum RawOpcode {
   R_FSQRT,
   R_SCVTF, R_UCVTF,
   R_FCVT, R_FCVTZS, R_FCVTZU,
+  R_DUP,
 };
 
 const char *kRawOpTable[] = {
@@ -66,6 +67,7 @@ const char *kRawOpTable[] = {
   "fsqrt",
   "scvtf", "ucvtf",
   "fcvt", "fcvtzs", "fcvtzu",
+  "dup",
   NULL,
 };
 
@@ -146,7 +148,7 @@ static const RegisterTable kFRegisters64[] = {
   {"d28", D28},  {"d29", D29},  {"d30", D30},  {"d31", D31},
 };
 
-static const char kCondTable[][3] = {
+static const char *kCondTable[] = {
   "eq", "ne", "hs", "lo", "mi", "pl", "vs", "vc",
   "hi", "ls", "ge", "lt", "gt", "le", "al", "nv",
 };
@@ -180,39 +182,106 @@ inline bool is_freg64(enum RegType reg) {
 #define CND  (1 << 10)
 #define SFT  (1 << 11)  // lsl #nn
 #define EXT  (1 << 12)  // UXTB, UXTH, UXTW, UXTX, SXTB, SXTH, SXTW, SXTX, LSL, LSR, ASR
+#define F128 (1 << 13)  // q0~q31
+#define VEC  (1 << 14)  // v0.16b, v0.8h, v0.4s, v0.2d
+#define VEL  (1 << 15)  // v0.b[0], v0.h[0], v0.s[0], v0.d[0]
 
 static enum RegType find_register(const char **pp, unsigned int flag) {
-  const char *p = *pp;
   static const RegisterTable *kRegisters[] = { kRegisters32, kRegisters64, kFRegisters32, kFRegisters64 };
   static const int kRegistersCount[] = { ARRAY_SIZE(kRegisters32), ARRAY_SIZE(kRegisters64), ARRAY_SIZE(kFRegisters32), ARRAY_SIZE(kFRegisters64) };
+  static PerfectHash hashes[ARRAY_SIZE(kRegisters)];
   for (int i = 0; i < (int)ARRAY_SIZE(kRegisters); ++i) {
     if ((flag & (R32 << i)) == 0)
       continue;
 
     const RegisterTable *regs = kRegisters[i];
-    for (int j = 0, n = kRegistersCount[i]; j < n; ++j) {
-      const char *name = regs[j].name;
-      size_t n = strlen(name);
-      if (strncasecmp(p, name, n) == 0 && !is_label_chr(p[n])) {
-        *pp = p + n;
-        return regs[j].reg;
-      }
-    }
+    PerfectHash *hash = &hashes[i];
+    if (hash->names == NULL)
+      perfect_hash_init(hash, &regs[0].name, kRegistersCount[i], sizeof(regs[0]));
+    int index = perfect_hash_find_word(hash, pp);
+    if (index >= 0)
+      return regs[index].reg;
   }
   return NOREG;
 }
 
-static enum CondType find_cond(const char **pp) {
+// Parse register number for q and v registers: 0~31
+static int parse_vector_regno(const char **pp) {
   const char *p = *pp;
-  for (int i = 0; i < (int)ARRAY_SIZE(kCondTable); ++i) {
-    const char *name = kCondTable[i];
-    size_t n = strlen(name);
-    if (strncasecmp(p, name, n) == 0 && !is_label_chr(p[n])) {
-      *pp = p + n;
-      return i;
+  if (!isdigit(*p))
+    return -1;
+  int no = 0;
+  for (; isdigit(*p); ++p)
+    no = no * 10 + (*p - '0');
+  if (no >= 32)
+    return -1;
+  *pp = p;
+  return no;
+}
+
+static unsigned int parse_vector_register(ParseInfo *info, unsigned int opr_flag, Operand *operand) {
+  static const char kElemSizes[] = "bhsd";
+  static const char kArrangements[][4] = {"16b", "8h", "4s", "2d"};
+
+  const char *p = info->p;
+  int c = tolower(*p);
+  if (c == 'q' && (opr_flag & F128)) {
+    ++p;
+    int no = parse_vector_regno(&p);
+    if (no < 0 || is_label_chr(*p))
+      return 0;
+    info->p = p;
+    operand->type = FREG;
+    operand->reg.size = REG128;
+    operand->reg.no = no;
+    operand->reg.sp = 0;
+    return F128;
+  }
+
+  if (c != 'v' || !(opr_flag & (VEC | VEL)))
+    return 0;
+  ++p;
+  int no = parse_vector_regno(&p);
+  if (no < 0 || *p != '.')
+    return 0;
+  ++p;
+  if (opr_flag & VEC) {
+    for (int i = 0; i < (int)ARRAY_SIZE(kArrangements); ++i) {
+      size_t n = strlen(kArrangements[i]);
+      if (strncasecmp(p, kArrangements[i], n) == 0 && !is_label_chr(p[n])) {
+        info->p = p + n;
+        operand->type = VREG;
+        operand->vreg.no = no;
+        operand->vreg.size = i;
+        operand->vreg.index = -1;
+        return VEC;
+      }
     }
   }
-  return NOCOND;
+  if (opr_flag & VEL) {
+    const char *q = strchr(kElemSizes, tolower(*p));
+    if (q != NULL && *q != '\0' && p[1] == '[' && isdigit(p[2]) && p[3] == ']') {
+      int size = q - kElemSizes;
+      int index = p[2] - '0';
+      if (index < (16 >> size)) {
+        info->p = p + 4;
+        operand->type = VREG;
+        operand->vreg.no = no;
+        operand->vreg.size = size;
+        operand->vreg.index = index;
+        return VEL;
+      }
+    }
+  }
+  return 0;
+}
+
+static enum CondType find_cond(const char **pp) {
+  static PerfectHash hash;
+  if (hash.names == NULL)
+    perfect_hash_init(&hash, kCondTable, ARRAY_SIZE(kCondTable), sizeof(*kCondTable));
+  int index = perfect_hash_find_word(&hash, pp);
+  return index >= 0 ? (enum CondType)index : NOCOND;
 }
 
 #if XCC_TARGET_PLATFORM == XCC_PLATFORM_APPLE
@@ -463,6 +532,12 @@ unsigned int parse_operand(ParseInfo *info, unsigned int opr_flag, Operand *oper
     }
   }
 
+  if (opr_flag & (F128 | VEC | VEL)) {
+    unsigned int result = parse_vector_register(info, opr_flag, operand);
+    if (result != 0)
+      return result;
+  }
+
   if (opr_flag & (R32 | R64 | F32 | F64)) {
     enum RegType reg = find_register(&info->p, opr_flag);
     if (reg != NOREG) {
@@ -544,15 +619,16 @@ unsigned int parse_operand(ParseInfo *info, unsigned int opr_flag, Operand *oper
 }
 
 const ParseInstTable kParseInstTable[] = {
-  [R_MOV] = { 3, (const ParseOpArray*[]){
+  [R_MOV] = { 4, (const ParseOpArray*[]){
     &(ParseOpArray){MOV, {R32, R32}},
     &(ParseOpArray){MOV, {R64 | RSP, R64 | RSP}},
     &(ParseOpArray){MOV, {R32 | R64, IMM}},
+    &(ParseOpArray){MOV_V, {VEC, VEC}},
   } },
   [R_MOVK] = { 1, (const ParseOpArray*[]){
     &(ParseOpArray){MOVK, {R32 | R64, IMM, SFT}},
   } },
-  [R_ADD] = { 9, (const ParseOpArray*[]){
+  [R_ADD] = { 10, (const ParseOpArray*[]){
     &(ParseOpArray){ADD_R, {R32, R32, R32}},
     &(ParseOpArray){ADD_R, {R32, R32, R32, EXT}},
     &(ParseOpArray){ADD_I, {R32, R32, IMM}},
@@ -562,8 +638,9 @@ const ParseInstTable kParseInstTable[] = {
     &(ParseOpArray){ADD_R, {R64 | RSP, R64 | RSP, R64}},
     &(ParseOpArray){ADD_I, {R64 | RSP, R64 | RSP, IMM}},
     &(ParseOpArray){ADD_I, {R64 | RSP, R64 | RSP, EXP}},
+    &(ParseOpArray){ADD_V, {VEC, VEC, VEC}},
   } },
-  [R_SUB] = { 9, (const ParseOpArray*[]){
+  [R_SUB] = { 10, (const ParseOpArray*[]){
     &(ParseOpArray){SUB_R, {R32, R32, R32}},
     &(ParseOpArray){SUB_R, {R32, R32, R32, EXT}},
     &(ParseOpArray){SUB_I, {R32, R32, IMM}},
@@ -573,6 +650,7 @@ const ParseInstTable kParseInstTable[] = {
     &(ParseOpArray){SUB_R, {R64 | RSP, R64 | RSP, R64}},
     &(ParseOpArray){SUB_I, {R64 | RSP, R64 | RSP, IMM}},
     &(ParseOpArray){SUB_I, {R64 | RSP, R64 | RSP, EXP}},
+    &(ParseOpArray){SUB_V, {VEC, VEC, VEC}},
   } },
   [R_MUL] = { 2, (const ParseOpArray*[]){ &(ParseOpArray){MUL, {R32, R32, R32}}, &(ParseOpArray){MUL, {R64, R64, R64}} } },
   [R_SDIV] = { 2, (const ParseOpArray*[]){ &(ParseOpArray){SDIV, {R32, R32, R32}}, &(ParseOpArray){SDIV, {R64, R64, R64}} } },
@@ -621,7 +699,7 @@ const ParseInstTable kParseInstTable[] = {
   [R_LDRH] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){LDRH, {R32 | R64, IND | ROI}} } },
   [R_LDR] = { 2, (const ParseOpArray*[]){
     &(ParseOpArray){LDR, {R32 | R64, IND | ROI}},
-    &(ParseOpArray){F_LDR, {F32 | F64, IND | ROI}},
+    &(ParseOpArray){F_LDR, {F32 | F64 | F128, IND | ROI}},
   } },
   [R_LDRSB] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){LDRSB, {R32 | R64, IND | ROI}} } },
   [R_LDRSH] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){LDRSH, {R32 | R64, IND | ROI}} } },
@@ -629,7 +707,7 @@ const ParseInstTable kParseInstTable[] = {
   [R_STRH] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){STRH, {R32, IND | ROI}} } },
   [R_STR] = { 2, (const ParseOpArray*[]){
     &(ParseOpArray){STR, {R32 | R64, IND | ROI}},
-    &(ParseOpArray){F_STR, {F32 | F64, IND | ROI}},
+    &(ParseOpArray){F_STR, {F32 | F64 | F128, IND | ROI}},
   } },
   [R_LDP] = { 4, (const ParseOpArray*[]){
     &(ParseOpArray){LDP, {R32, R32, IND}},
@@ -672,21 +750,25 @@ const ParseInstTable kParseInstTable[] = {
     &(ParseOpArray){FMOV, {F32, F32}},
     &(ParseOpArray){FMOV, {F64, F64}},
   } },
-  [R_FADD] = { 2, (const ParseOpArray*[]){
+  [R_FADD] = { 3, (const ParseOpArray*[]){
     &(ParseOpArray){FADD, {F32, F32, F32}},
     &(ParseOpArray){FADD, {F64, F64, F64}},
+    &(ParseOpArray){FADD_V, {VEC, VEC, VEC}},
   } },
-  [R_FSUB] = { 2, (const ParseOpArray*[]){
+  [R_FSUB] = { 3, (const ParseOpArray*[]){
     &(ParseOpArray){FSUB, {F32, F32, F32}},
     &(ParseOpArray){FSUB, {F64, F64, F64}},
+    &(ParseOpArray){FSUB_V, {VEC, VEC, VEC}},
   } },
-  [R_FMUL] = { 2, (const ParseOpArray*[]){
+  [R_FMUL] = { 3, (const ParseOpArray*[]){
     &(ParseOpArray){FMUL, {F32, F32, F32}},
     &(ParseOpArray){FMUL, {F64, F64, F64}},
+    &(ParseOpArray){FMUL_V, {VEC, VEC, VEC}},
   } },
-  [R_FDIV] = { 2, (const ParseOpArray*[]){
+  [R_FDIV] = { 3, (const ParseOpArray*[]){
     &(ParseOpArray){FDIV, {F32, F32, F32}},
     &(ParseOpArray){FDIV, {F64, F64, F64}},
+    &(ParseOpArray){FDIV_V, {VEC, VEC, VEC}},
   } },
   [R_FCMP] = { 2, (const ParseOpArray*[]){
     &(ParseOpArray){FCMP, {F32, F32}},
@@ -708,4 +790,8 @@ const ParseInstTable kParseInstTable[] = {
   } },
   [R_FCVTZS] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){FCVTZS, {R32 | R64, F32 | F64}} } },
   [R_FCVTZU] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){FCVTZU, {R32 | R64, F32 | F64}} } },
+  [R_DUP] = { 2, (const ParseOpArray*[]){
+    &(ParseOpArray){DUP_E, {VEC, VEL}},
+    &(ParseOpArray){DUP_G, {VEC, R32 | R64}},
+  } },
 };
@@ -129,6 +129,42 @@ static bool make_jmp_long(IR *ir) {
   return true;
 }
 
+const Name *short_branch_target(IR *ir, Table *label_table, int64_t *poffset) {
+  if (ir->code.flag & INST_LONG_OFFSET)
+    return NULL;
+
+  Inst *inst = ir->code.inst;
+  const Expr *expr;
+  switch (inst->op) {
+  case J:
+    if (inst->opr[0].type != DIRECT)
+      return NULL;
+    expr = inst->opr[0].direct.expr;
+    break;
+  case BEQ: case BNE:
+    if (inst->opr[2].type != DIRECT || ir->code.len != 2)
+      return NULL;
+    expr = inst->opr[2].direct.expr;
+    break;
+  default:
+    return NULL;
+  }
+
+  Value value = calc_expr(label_table, expr);
+  *poffset = value.offset;
+  return value.label;
+}
+
+bool is_branch_reachable(IR *ir, uintptr_t address, uintptr_t target) {
+  int64_t offset = target - address;
+  int bits = ir->code.inst->op == J ? 11 : 7;
+  return offset < (1 << bits) && offset >= -(1 << bits);
+}
+
+bool make_branch_long(IR *ir) {
+  return ir->code.inst->op == J ? make_jmp_long(ir) : make_bxx_long(ir);
+}
+
 bool resolve_relative_address(Vector *sections, Table *label_table, Vector *unresolved) {
   assert(unresolved != NULL);
   vec_clear(unresolved);
@@ -259,42 +259,27 @@ static const struct {
 #define RND  (1 << 10)
 
 static enum RegType find_register(const char **pp) {
-  const char *p = *pp;
-  for (int i = 0; i < (int)ARRAY_SIZE(kRegisters); ++i) {
-    const char *name = kRegisters[i].name;
-    size_t n = strlen(name);
-    if (strncasecmp(p, name, n) == 0 && !is_label_chr(p[n])) {
-      *pp = p + n;
-      return kRegisters[i].reg;
-    }
-  }
-  return NOREG;
+  static PerfectHash hash;
+  if (hash.names == NULL)
+    perfect_hash_init(&hash, &kRegisters[0].name, ARRAY_SIZE(kRegisters), sizeof(kRegisters[0]));
+  int index = perfect_hash_find_word(&hash, pp);
+  return index >= 0 ? kRegisters[index].reg : NOREG;
 }
 
 static enum FRegType find_fregister(const char **pp) {
-  const char *p = *pp;
-  for (int i = 0; i < (int)ARRAY_SIZE(kFRegisters); ++i) {
-    const char *name = kFRegisters[i].name;
-    size_t n = strlen(name);
-    if (strncasecmp(p, name, n) == 0 && !is_label_chr(p[n])) {
-      *pp = p + n;
-      return kFRegisters[i].reg;
-    }
-  }
-  return NOFREG;
+  static PerfectHash hash;
+  if (hash.names == NULL)
+    perfect_hash_init(&hash, &kFRegisters[0].name, ARRAY_SIZE(kFRegisters), sizeof(kFRegisters[0]));
+  int index = perfect_hash_find_word(&hash, pp);
+  return index >= 0 ? kFRegisters[index].reg : NOFREG;
 }
 
 static enum RoundMode find_round_mode(const char **pp) {
-  const char *p = *pp;
-  for (int i = 0; i < (int)ARRAY_SIZE(kRoundModes); ++i) {
-    const char *name = kRoundModes[i].name;
-    size_t n = strlen(name);
-    if (strncasecmp(p, name, n) == 0 && !is_label_chr(p[n])) {
-      *pp = p + n;
-      return kRoundModes[i].mode;
-    }
-  }
-  return NOROUND;
+  static PerfectHash hash;
+  if (hash.names == NULL)
+    perfect_hash_init(&hash, &kRoundModes[0].name, ARRAY_SIZE(kRoundModes), sizeof(kRoundModes[0]));
+  int index = perfect_hash_find_word(&hash, pp);
+  return index >= 0 ? kRoundModes[index].mode : NOROUND;
 }
 
 static bool parse_indirect_register(ParseInfo *info, Expr *offset, Operand *operand) {
@@ -447,12 +447,12 @@ static unsigned char *asm_movsds_xx(Inst *inst, Code *code, bool single) {
 static unsigned char *asm_movsd_xx(Inst *inst, Code *code) { return asm_movsds_xx(inst, code, false); }
 static unsigned char *asm_movss_xx(Inst *inst, Code *code) { return asm_movsds_xx(inst, code, true); }
 
-static unsigned char *asm_movsds_ix(Inst *inst, Code *code, bool single) {
+// Load xmm register from memory: `prefix 0f 10 /r` (prefix: f2=movsd, f3=movss, none=movups).
+static unsigned char *asm_movsds_ix(Inst *inst, Code *code, short prefix) {
   long offset;
   if (inst->opr[0].indirect.offset.expr->kind == EX_FIXNUM &&
       (offset = inst->opr[0].indirect.offset.expr->fixnum, is_im32(offset))) {
     if (inst->opr[0].indirect.reg.no != RIP) {
-      unsigned char prefix = single ? 0xf3 : 0xf2;
       unsigned char sno = opr_regno(&inst->opr[0].indirect.reg);
       unsigned char dno = inst->opr[1].regxmm - XMM0;
       int d = dno & 7;
@@ -485,15 +485,16 @@ static unsigned char *asm_movsds_ix(Inst *inst, Code *code, bool single) {
   }
   return NULL;
 }
-static unsigned char *asm_movsd_ix(Inst *inst, Code *code) { return asm_movsds_ix(inst, code, false); }
-static unsigned char *asm_movss_ix(Inst *inst, Code *code) { return asm_movsds_ix(inst, code, true); }
+static unsigned char *asm_movsd_ix(Inst *inst, Code *code) { return asm_movsds_ix(inst, code, 0xf2); }
+static unsigned char *asm_movss_ix(Inst *inst, Code *code) { return asm_movsds_ix(inst, code, 0xf3); }
+static unsigned char *asm_movups_ix(Inst *inst, Code *code) { return asm_movsds_ix(inst, code, -1); }
 
-static unsigned char *asm_movsds_xi(Inst *inst, Code *code, bool single) {
+// Store xmm register to memory: `prefix 0f 11 /r`.
+static unsigned char *asm_movsds_xi(Inst *inst, Code *code, short prefix) {
   long offset;
   if (inst->opr[1].indirect.offset.expr->kind == EX_FIXNUM &&
       (offset = inst->opr[1].indirect.offset.expr->fixnum, is_im32(offset))) {
     if (inst->opr[1].indirect.reg.no != RIP) {
-      unsigned char prefix = single ? 0xf3 : 0xf2;
       unsigned char sno = inst->opr[0].regxmm - XMM0;
       unsigned char dno = opr_regno(&inst->opr[1].indirect.reg);
       int d = dno & 7;
@@ -526,8 +527,9 @@ static unsigned char *asm_movsds_xi(Inst *inst, Code *code, bool single) {
   }
   return NULL;
 }
-static unsigned char *asm_movsd_xi(Inst *inst, Code *code) { return asm_movsds_xi(inst, code, false); }
-static unsigned char *asm_movss_xi(Inst *inst, Code *code) { return asm_movsds_xi(inst, code, true); }
+static unsigned char *asm_movsd_xi(Inst *inst, Code *code) { return asm_movsds_xi(inst, code, 0xf2); }
+static unsigned char *asm_movss_xi(Inst *inst, Code *code) { return asm_movsds_xi(inst, code, 0xf3); }
+static unsigned char *asm_movups_xi(Inst *inst, Code *code) { return asm_movsds_xi(inst, code, -1); }
 
 static unsigned char *assemble_bop_sd(Inst *inst, Code *code, bool single, unsigned char op) {
   unsigned char *p = code->buf;
@@ -580,6 +582,59 @@ static unsigned char *assemble_xorpd_xx(Inst *inst, Code *code, bool single) {
 static unsigned char *asm_xorpd_xx(Inst *inst, Code *code) { return assemble_xorpd_xx(inst, code, false); }
 static unsigned char *asm_xorps_xx(Inst *inst, Code *code) { return assemble_xorpd_xx(inst, code, true); }
 
+// Packed operation between xmm registers: [66] 0F op
+static unsigned char *assemble_packed_xx(Inst *inst, Code *code, short prefix, unsigned char op) {
+  unsigned char *p = code->buf;
+  if (inst->opr[0].type == REG_XMM && inst->opr[1].type == REG_XMM) {
+    unsigned char sno = inst->opr[0].regxmm - XMM0;
+    unsigned char dno = inst->opr[1].regxmm - XMM0;
+    short buf[] = {
+      prefix,
+      sno >= 8 || dno >= 8 ? (unsigned char)0x40 | ((sno & 8) >> 3) | ((dno & 8) >> 1) : -1,
+      0x0f,
+      op,
+      (unsigned char)0xc0 | ((dno & 7) << 3) | (sno & 7),
+    };
+    p = put_code_filtered(p, buf, ARRAY_SIZE(buf));
+  }
+  return p;
+}
+static unsigned char *asm_movaps_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, -1, 0x28); }
+static unsigned char *asm_addps_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, -1, 0x58); }
+static unsigned char *asm_addpd_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, 0x66, 0x58); }
+static unsigned char *asm_subps_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, -1, 0x5c); }
+static unsigned char *asm_subpd_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, 0x66, 0x5c); }
+static unsigned char *asm_mulps_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, -1, 0x59); }
+static unsigned char *asm_mulpd_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, 0x66, 0x59); }
+static unsigned char *asm_divps_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, -1, 0x5e); }
+static unsigned char *asm_divpd_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, 0x66, 0x5e); }
+static unsigned char *asm_paddd_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, 0x66, 0xfe); }
+static unsigned char *asm_paddq_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, 0x66, 0xd4); }
+static unsigned char *asm_psubd_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, 0x66, 0xfa); }
+static unsigned char *asm_psubq_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, 0x66, 0xfb); }
+static unsigned char *asm_unpcklps_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, -1, 0x14); }
+static unsigned char *asm_unpcklpd_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, 0x66, 0x14); }
+static unsigned char *asm_movlhps_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, -1, 0x16); }
+static unsigned char *asm_punpckldq_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, 0x66, 0x62); }
+static unsigned char *asm_punpcklqdq_xx(Inst *inst, Code *code) { return assemble_packed_xx(inst, code, 0x66, 0x6c); }
+
+// movd/movq general register to xmm: 66 [REX] 0F 6E
+static unsigned char *asm_movdq_rx(Inst *inst, Code *code) {
+  unsigned char *p = code->buf;
+  unsigned char sno = opr_regno(&inst->opr[0].reg);
+  unsigned char dno = inst->opr[1].regxmm - XMM0;
+  bool b64 = inst->opr[0].reg.size == REG64;
+  short buf[] = {
+    0x66,
+    sno >= 8 || dno >= 8 || b64 ? (unsigned char)0x40 | ((sno & 8) >> 3) | ((dno & 8) >> 1) | (b64 ? 8 : 0) : -1,
+    0x0f,
+    0x6e,
+    (unsigned char)0xc0 | ((dno & 7) << 3) | (sno & 7),
+  };
+  p = put_code_filtered(p, buf, ARRAY_SIZE(buf));
+  return p;
+}
+
 static unsigned char *assemble_ucomisd(Inst *inst, Code *code, unsigned char opc, bool single) {
   unsigned char *p = code->buf;
   if (inst->opr[0].type == REG_XMM && inst->opr[1].type == REG_XMM) {
@@ -1502,6 +1557,21 @@ static unsigned char *asm_syscall(Inst *inst, Code *code) {
   return code->buf;
 }
 
+static unsigned char *asm_rep(Inst *inst, Code *code) {
+  MAKE_CODE(inst, code, 0xf3);
+  return code->buf;
+}
+
+static unsigned char *asm_movsb(Inst *inst, Code *code) {
+  MAKE_CODE(inst, code, 0xa4);
+  return code->buf;
+}
+
+static unsigned char *asm_stosb(Inst *inst, Code *code) {
+  MAKE_CODE(inst, code, 0xaa);
+  return code->buf;
+}
+
 ////////////////////////////////////////////////
 
 typedef unsigned char *(*AsmInstFunc)(Inst *inst, Code *code);
@@ -1584,6 +1654,9 @@ static const AsmInstFunc table[] = {
   [POP] = asm_pop_r,
   [INT] = asm_int_im,
   [SYSCALL] = asm_syscall,
+  [REP] = asm_rep,
+  [MOVSB] = asm_movsb,
+  [STOSB] = asm_stosb,
 
   [MOVSD_XX] = asm_movsd_xx,
   [MOVSD_IX] = asm_movsd_ix,
@@ -1605,6 +1678,20 @@ static const AsmInstFunc table[] = {
   [CVTSD2SS] = asm_cvtsd2ss_xx,
   [CVTSS2SD] = asm_cvtss2sd_xx,
   [SQRTSD] = asm_sqrtsd_xx,
+
+  [MOVUPS_IX] = asm_movups_ix,
+  [MOVUPS_XI] = asm_movups_xi,
+  [MOVAPS] = asm_movaps_xx,
+  [MOVD_RX] = asm_movdq_rx, [MOVQ_RX] = asm_movdq_rx,
+  [ADDPS] = asm_addps_xx, [ADDPD] = asm_addpd_xx,
+  [SUBPS] = asm_subps_xx, [SUBPD] = asm_subpd_xx,
+  [MULPS] = asm_mulps_xx, [MULPD] = asm_mulpd_xx,
+  [DIVPS] = asm_divps_xx, [DIVPD] = asm_divpd_xx,
+  [PADDD] = asm_paddd_xx, [PADDQ] = asm_paddq_xx,
+  [PSUBD] = asm_psubd_xx, [PSUBQ] = asm_psubq_xx,
+  [UNPCKLPS] = asm_unpcklps_xx, [UNPCKLPD] = asm_unpcklpd_xx,
+  [MOVLHPS] = asm_movlhps_xx,
+  [PUNPCKLDQ] = asm_punpckldq_xx, [PUNPCKLQDQ] = asm_punpcklqdq_xx,
 };
 
 void assemble_inst(Inst *inst, ParseInfo *info, Code *code) {
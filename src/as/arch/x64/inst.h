@@ -45,6 +45,7 @@ enum Opcode {
   PUSH_R, PUSH_IM, POP,
 
   INT, SYSCALL,
+  REP, MOVSB, STOSB,
 
   MOVSD_XX, MOVSD_IX, MOVSD_XI,
   ADDSD, SUBSD, MULSD, DIVSD, XORPD,
@@ -57,6 +58,12 @@ enum Opcode {
   COMISS, UCOMISS,
   CVTSI2SS, CVTTSS2SI,
   CVTSD2SS, CVTSS2SD,
+
+  MOVUPS_IX, MOVUPS_XI,
+  MOVAPS, MOVD_RX, MOVQ_RX,
+  ADDPS, ADDPD, SUBPS, SUBPD, MULPS, MULPD, DIVPS, DIVPD,
+  PADDD, PADDQ, PSUBD, PSUBQ,
+  UNPCKLPS, UNPCKLPD, MOVLHPS, PUNPCKLDQ, PUNPCKLQDQ,
 };
 
 enum RegType {
@@ -113,6 +113,44 @@ static bool make_jmp_long(IR *ir) {
   return true;
 }
 
+const Name *short_branch_target(IR *ir, Table *label_table, int64_t *poffset) {
+  if (ir->code.flag & INST_LONG_OFFSET)
+    return NULL;
+
+  Inst *inst = ir->code.inst;
+  switch (inst->op) {
+  case JMP_D:
+  case JO: case JNO: case JB:  case JAE:
+  case JE: case JNE: case JBE: case JA:
+  case JS: case JNS: case JP:  case JNP:
+  case JL: case JGE: case JLE: case JG:
+    if (inst->opr[0].type == DIRECT) {
+      Value value = calc_expr(label_table, inst->opr[0].direct.expr);
+      if (value.label != NULL) {
+        if (table_get(label_table, value.label) == NULL) {
+          // Jump to unresolved label is always long.
+          make_jmp_long(ir);
+          return NULL;
+        }
+        *poffset = value.offset;
+        return value.label;
+      }
+    }
+    break;
+  default: break;
+  }
+  return NULL;
+}
+
+bool is_branch_reachable(IR *ir, uintptr_t address, uintptr_t target) {
+  intptr_t offset = target - (address + ir->code.len);
+  return is_im8(offset);
+}
+
+bool make_branch_long(IR *ir) {
+  return make_jmp_long(ir);
+}
+
 bool resolve_relative_address(Vector *sections, Table *label_table, Vector *unresolved) {
   assert(unresolved != NULL);
   vec_clear(unresolved);
@@ -198,7 +236,7 @@ bool resolve_relative_address(Vector *sections, Table *label_table, Vector *unre
               Value value = calc_expr(label_table, inst->opr[0].direct.expr);
               if (value.label != NULL) {
                 LabelInfo *label_info = table_get(label_table, value.label);
-                if (label_info == NULL) {
+                if (label_info == NULL || label_info->section != section) {
                   // Make unresolved label jmp to long.
                   size_upgraded |= make_jmp_long(ir);
 
@@ -206,7 +244,7 @@ bool resolve_relative_address(Vector *sections, Table *label_table, Vector *unre
                   info->kind = UNRES_EXTERN;
                   info->label = value.label;
                   info->src_section = section;
-                  info->offset = address + 1 - start_address;
+                  info->offset = address + (inst->op == JMP_D ? 1 : 2) - start_address;
                   info->add = value.offset - 4;
                   vec_push(unresolved, info);
                   break;
@@ -237,7 +275,8 @@ bool resolve_relative_address(Vector *sections, Table *label_table, Vector *unre
               Value value = calc_expr(label_table, inst->opr[0].direct.expr);
               if (value.label != NULL) {
                 LabelInfo *label_info = table_get(label_table, value.label);
-                if (label_info == NULL) {
+                // Function in other section (-ffunction-sections) might be placed anywhere.
+                if (label_info == NULL || label_info->section != section) {
                   UnresolvedInfo *info = malloc_or_die(sizeof(*info));
                   info->kind = UNRES_EXTERN;
                   info->label = value.label;
@@ -245,8 +284,7 @@ bool resolve_relative_address(Vector *sections, Table *label_table, Vector *unre
                   info->offset = address + 1 - start_address;
                   info->add = value.offset - 4;
                   vec_push(unresolved, info);
-                  if (label_info == NULL)
-                    break;
+                  break;
                 }
                 value.offset += label_info->address;
               }
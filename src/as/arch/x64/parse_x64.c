@@ -40,6 +40,7 @@ enum RawOpcode {
   R_PUSH, R_POP,
 
   R_INT, R_SYSCALL,
+  R_REP, R_MOVSB, R_STOSB,
 
   R_MOVSD, R_ADDSD, R_SUBSD, R_MULSD, R_DIVSD, R_XORPD,
   R_COMISD, R_UCOMISD,
@@ -51,6 +52,11 @@ enum RawOpcode {
   R_CVTSI2SS, R_CVTTSS2SI,
 
   R_CVTSD2SS, R_CVTSS2SD,
+
+  R_MOVUPS, R_MOVAPS, R_MOVD,
+  R_ADDPS, R_ADDPD, R_SUBPS, R_SUBPD, R_MULPS, R_MULPD, R_DIVPS, R_DIVPD,
+  R_PADDD, R_PADDQ, R_PSUBD, R_PSUBQ,
+  R_UNPCKLPS, R_UNPCKLPD, R_MOVLHPS, R_PUNPCKLDQ, R_PUNPCKLQDQ,
 };
 
 const char *kRawOpTable[] = {
@@ -83,6 +89,7 @@ const char *kRawOpTable[] = {
   "push",  "pop",
 
   "int", "syscall",
+  "rep", "movsb", "stosb",
 
   "movsd", "addsd", "subsd", "mulsd", "divsd", "xorpd",
   "comisd", "ucomisd",
@@ -93,6 +100,11 @@ const char *kRawOpTable[] = {
   "comiss", "ucomiss",
   "cvtsi2ss",  "cvttss2si",
   "cvtsd2ss",  "cvtss2sd",
+
+  "movups", "movaps", "movd",
+  "addps", "addpd", "subps", "subpd", "mulps", "mulpd", "divps", "divpd",
+  "paddd", "paddq", "psubd", "psubq",
+  "unpcklps", "unpcklpd", "movlhps", "punpckldq", "punpcklqdq",
   NULL,
 };
 
@@ -130,7 +142,7 @@ static const struct {
   {"cs", CS}, {"ds", DS}, {"es", ES}, {"fs", FS}, {"gs", GS}, {"ss", SS},
 };
 
-static const char kXmmRegisters[][6] = {
+static const char *kXmmRegisters[] = {
   "xmm0",  "xmm1",  "xmm2",  "xmm3",  "xmm4",  "xmm5",  "xmm6",  "xmm7",
   "xmm8",  "xmm9", "xmm10", "xmm11", "xmm12", "xmm13", "xmm14", "xmm15",
 };
@@ -171,34 +183,26 @@ inline bool is_segment(enum RegType reg) {
 #define SEG   (1 << 13)
 
 static enum RegType find_register(const char **pp) {
-  const char *p = *pp;
-  for (int i = 0; i < (int)ARRAY_SIZE(kRegisters); ++i) {
-    const char *name = kRegisters[i].name;
-    size_t n = strlen(name);
-    if (strncasecmp(p, name, n) == 0 && !is_label_chr(p[n])) {
-      *pp = p + n;
-      return kRegisters[i].reg;
-    }
-  }
-  return NOREG;
+  static PerfectHash hash;
+  if (hash.names == NULL)
+    perfect_hash_init(&hash, &kRegisters[0].name, ARRAY_SIZE(kRegisters), sizeof(kRegisters[0]));
+  int index = perfect_hash_find_word(&hash, pp);
+  return index >= 0 ? kRegisters[index].reg : NOREG;
 }
 
 static enum RegXmmType find_xmm_register(const char **pp) {
+  static PerfectHash hash;
+  if (hash.names == NULL)
+    perfect_hash_init(&hash, kXmmRegisters, ARRAY_SIZE(kXmmRegisters), sizeof(*kXmmRegisters));
   const char *p = *pp;
   const char *q;
   for (q = p; isalnum(*q); ++q)
     ;
-  size_t l = q - p;
-
-  for (int i = 0; i < (int)ARRAY_SIZE(kXmmRegisters); ++i) {
-    const char *name = kXmmRegisters[i];
-    size_t n = strlen(name);
-    if (l == n && strncasecmp(p, name, n) == 0) {
-      *pp = p + n;
-      return i + XMM0;
-    }
-  }
-  return NOREGXMM;
+  int index = perfect_hash_find(&hash, p, q - p);
+  if (index < 0)
+    return NOREGXMM;
+  *pp = q;
+  return index + XMM0;
 }
 
 static unsigned int parse_direct_register(ParseInfo *info, Operand *operand) {
@@ -473,8 +477,7 @@ unsigned int parse_operand(ParseInfo *info, unsigned int opr_flag, Operand *oper
     if (info->p[1] == '%') {
       info->p += 2;
       if (expr_with_flag.expr == NULL) {
-        Expr *expr = calloc_or_die(sizeof(*expr));
-        expr->kind = EX_FIXNUM;
+        Expr *expr = new_expr(EX_FIXNUM);
         expr->fixnum = 0;
         expr_with_flag.expr = expr;
       }
@@ -509,9 +512,10 @@ const ParseInstTable kParseInstTable[] = {
     &(ParseOpArray){MOVL_IMI, {IMM, IND}},
     &(ParseOpArray){MOVL_IMD, {IMM, EXP}},
   } },
-  [R_MOVQ] = { 2, (const ParseOpArray*[]){
+  [R_MOVQ] = { 3, (const ParseOpArray*[]){
     &(ParseOpArray){MOVQ_IMI, {IMM, IND}},
     &(ParseOpArray){MOVQ_IMD, {IMM, EXP}},
+    &(ParseOpArray){MOVQ_RX, {R64, XMM}},
   } },
   [R_MOVSX] = { 6, (const ParseOpArray*[]){
     &(ParseOpArray){MOVSX, {R8, R16}},
@@ -653,6 +657,9 @@ const ParseInstTable kParseInstTable[] = {
   [R_POP] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){POP, {R64}} } },
   [R_INT] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){INT, {IMM}} } },
   [R_SYSCALL] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){SYSCALL} } },
+  [R_REP] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){REP} } },
+  [R_MOVSB] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){MOVSB} } },
+  [R_STOSB] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){STOSB} } },
 
   [R_MOVSD] = { 3, (const ParseOpArray*[]){
     &(ParseOpArray){MOVSD_XX, {XMM, XMM}},
@@ -685,4 +692,28 @@ const ParseInstTable kParseInstTable[] = {
   [R_CVTSD2SS] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){CVTSD2SS, {XMM, XMM}}, } },
   [R_CVTSS2SD] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){CVTSS2SD, {XMM, XMM}}, } },
   [R_SQRTSD] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){SQRTSD, {XMM, XMM}}, } },
+
+  [R_MOVUPS] = { 2, (const ParseOpArray*[]){
+    &(ParseOpArray){MOVUPS_IX, {IND, XMM}},
+    &(ParseOpArray){MOVUPS_XI, {XMM, IND}},
+  } },
+  [R_MOVAPS] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){MOVAPS, {XMM, XMM}}, } },
+  [R_MOVD] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){MOVD_RX, {R32, XMM}}, } },
+  [R_ADDPS] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){ADDPS, {XMM, XMM}}, } },
+  [R_ADDPD] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){ADDPD, {XMM, XMM}}, } },
+  [R_SUBPS] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){SUBPS, {XMM, XMM}}, } },
+  [R_SUBPD] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){SUBPD, {XMM, XMM}}, } },
+  [R_MULPS] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){MULPS, {XMM, XMM}}, } },
+  [R_MULPD] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){MULPD, {XMM, XMM}}, } },
+  [R_DIVPS] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){DIVPS, {XMM, XMM}}, } },
+  [R_DIVPD] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){DIVPD, {XMM, XMM}}, } },
+  [R_PADDD] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){PADDD, {XMM, XMM}}, } },
+  [R_PADDQ] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){PADDQ, {XMM, XMM}}, } },
+  [R_PSUBD] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){PSUBD, {XMM, XMM}}, } },
+  [R_PSUBQ] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){PSUBQ, {XMM, XMM}}, } },
+  [R_UNPCKLPS] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){UNPCKLPS, {XMM, XMM}}, } },
+  [R_UNPCKLPD] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){UNPCKLPD, {XMM, XMM}}, } },
+  [R_MOVLHPS] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){MOVLHPS, {XMM, XMM}}, } },
+  [R_PUNPCKLDQ] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){PUNPCKLDQ, {XMM, XMM}}, } },
+  [R_PUNPCKLQDQ] = { 1, (const ParseOpArray*[]){ &(ParseOpArray){PUNPCKLQDQ, {XMM, XMM}}, } },
 };
@@ -3,6 +3,8 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>  // qsort
+#include <string.h>  // strchr
+#include <sys/stat.h>
 #include <unistd.h>  // isatty
 
 #include "ir_asm.h"
@@ -15,18 +17,49 @@
 #define LOAD_ADDRESS    START_ADDRESS
 #define DATA_ALIGN      (0x1000)
 
+// Read whole input into one buffer, terminated with '\0'.
+// The buffer is never freed: Names point into it.
+static char *read_input(FILE *fp) {
+  size_t capa = 64 * 1024;
+  struct stat st;
+  if (fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    capa = st.st_size + 1;  // Exact size: Single read.
+  char *buf = malloc_or_die(capa);
+  size_t size = 0;
+  for (;;) {
+    if (size >= capa) {
+      capa <<= 1;
+      buf = realloc_or_die(buf, capa);
+    }
+    size_t n = fread(buf + size, 1, capa - size, fp);
+    if (n == 0)
+      break;
+    size += n;
+  }
+  buf[size] = '\0';  // size < capa here.
+  return buf;
+}
+
 static void parse_file(FILE *fp, ParseInfo *info) {
   info->lineno = 1;
   info->rawline = info->p = NULL;
   info->prefetched = NULL;
   set_current_section(info, kSecText, kSegText, SF_EXECUTABLE);
 
-  for (;; ++info->lineno) {
-    char *rawline = NULL;
-    size_t capa = 0;
-    ssize_t len = getline_chomp(&rawline, &capa, fp);
-    if (len == -1)
-      break;
+  char *next = read_input(fp);
+  bool report = time_report || mem_report;
+  for (; *next != '\0'; ++info->lineno) {
+    // Cut out a line in place: Chomp CR(\r), LF(\n), CR+LF
+    char *rawline = next;
+    char *eol = strchr(rawline, '\n');
+    if (eol != NULL) {
+      next = eol + 1;
+    } else {
+      eol = next = rawline + strlen(rawline);
+    }
+    if (eol > rawline && eol[-1] == '\r')
+      --eol;
+    *eol = '\0';
     info->rawline = rawline;
 
     SectionInfo *section = info->current_section;
@@ -44,7 +77,11 @@ static void parse_file(FILE *fp, ParseInfo *info) {
 
     if (line->dir == NODIRECTIVE) {
       Code code;
+      if (report)
+        report_phase_begin("encode");
       assemble_inst(&line->inst, info, &code);
+      if (report)
+        report_phase_end();
       if (code.len > 0)
         vec_push(irs, new_ir_code(&code));
     } else {
@@ -97,7 +134,7 @@ inline int section_key(const SectionInfo *p) {
   // return 2;
 
   // .text(0), .rodata(1), .data(2), .bss(6)
-  return flag /*& (SF_BSS | SF_WRITABLE | SF_EXECUTABLE)*/ ^ SF_EXECUTABLE;
+  return (flag & (SF_BSS | SF_WRITABLE | SF_EXECUTABLE)) ^ SF_EXECUTABLE;
 }
 
 static int cmp_section(const void *pa, const void *pb) {
@@ -125,6 +162,7 @@ int main(int argc, char *argv[]) {
   const char *ofn = NULL;
   static const struct option options[] = {
     {"o", required_argument},  // Specify output filename
+    {"f", required_argument},  // -ftime-report, -fmem-report
     {"-version", no_argument, 'V'},
     {NULL},
   };
@@ -137,6 +175,9 @@ int main(int argc, char *argv[]) {
     case 'o':
       ofn = optarg;
       break;
+    case 'f':
+      parse_report_option(optarg);  // Others are silently ignored.
+      break;
     }
   }
   int iarg = optind;
@@ -154,6 +195,7 @@ int main(int argc, char *argv[]) {
   info.section_infos = &section_infos;
   info.label_table = &label_table;
 
+  report_phase_begin("parse");  // "encode" is nested.
   if (iarg < argc) {
     for (int i = iarg; i < argc; ++i) {
       const char *filename = argv[i];
@@ -171,6 +213,7 @@ int main(int argc, char *argv[]) {
     info.filename = "*stdin*";
     parse_file(stdin, &info);
   }
+  report_phase_end();
 
   if (info.error_count != 0) {
     return 1;
@@ -179,16 +222,20 @@ int main(int argc, char *argv[]) {
   Vector *sections = sort_sections(&section_infos);
   Vector *unresolved = new_vector();
   bool settle1, settle2;
+  report_phase_begin("relax");
+  relax_branches(LOAD_ADDRESS, sections, &label_table);
   do {
     settle1 = calc_label_address(LOAD_ADDRESS, sections, &label_table);
     settle2 = resolve_relative_address(sections, &label_table, unresolved);
   } while (!(settle1 && settle2));
+  report_phase_end();
 
   for (int i = 0; i < unresolved->len; ++i) {
     UnresolvedInfo *u = unresolved->data[i];
     make_label_referred(&label_table, u->label, true);
   }
 
+  report_phase_begin("emit");
   emit_irs(sections);
 
   fix_section_size(sections, LOAD_ADDRESS);
@@ -201,6 +248,8 @@ int main(int argc, char *argv[]) {
   #define EMIT_OBJ  emit_elf_obj
 #endif
   int result = EMIT_OBJ(ofn, sections, &label_table, unresolved);
+  report_phase_end();
+  dump_report("as");
   if (result != 0) {
     if (ofn == NULL && !isatty(STDIN_FILENO))
       drop_all(stdin);
@@ -1,8 +1,6 @@
 #include "../config.h"
 #include "as_util.h"
 
-#ifndef ELF_NOT_SUPPORTED
-
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>  // realloc
@@ -10,6 +8,26 @@
 
 #include "util.h"
 
+#define ARENA_CHUNK_SIZE  (64 * 1024)
+#define ARENA_ALIGN       (16)
+
+static unsigned char *arena_ptr, *arena_end;
+
+void *arena_alloc(size_t size) {
+  size = ALIGN(size, ARENA_ALIGN);
+  if (size > (size_t)(arena_end - arena_ptr)) {
+    if (size > ARENA_CHUNK_SIZE / 4)
+      return calloc_or_die(size);  // Large one: Allocate independently, keep current chunk.
+    arena_ptr = calloc_or_die(ARENA_CHUNK_SIZE);
+    arena_end = arena_ptr + ARENA_CHUNK_SIZE;
+  }
+  void *p = arena_ptr;
+  arena_ptr += size;
+  return p;
+}
+
+#ifndef ELF_NOT_SUPPORTED
+
 void strtab_init(Strtab *strtab) {
   table_init(&strtab->offsets);
   strtab->size = 0;
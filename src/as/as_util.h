@@ -4,6 +4,10 @@
 
 #include "table.h"
 
+// Bump allocator: Returns zero-cleared memory which is never freed,
+// for objects (Line, Expr, IR, ...) living until the end of assembly.
+void *arena_alloc(size_t size);
+
 // String table.
 typedef struct {
   Table offsets;
@@ -184,10 +184,18 @@ static void construct_relas(Vector *unresolved, Symtab *symtab, Table *label_tab
       {
         LabelInfo *label = table_get(label_table, u->label);
         assert(label != NULL);
-        int secidx = label->section->index;
         rela->r_offset = u->offset;
-        rela->r_info = ELF64_R_INFO(secidx, R_X86_64_PC32);
-        rela->r_addend = u->add;
+        if (label->section->flag & SF_MERGE_STRINGS) {
+          // Strings are moved by the linker: Refer the label, not the offset in the section.
+          int symidx = symtab_find(symtab, u->label);
+          assert(symidx >= 0);
+          rela->r_info = ELF64_R_INFO(symidx, R_X86_64_PC32);
+          rela->r_addend = u->add - (label->address - label->section->start_address);
+        } else {
+          int secidx = label->section->index;
+          rela->r_info = ELF64_R_INFO(secidx, R_X86_64_PC32);
+          rela->r_addend = u->add;
+        }
       }
       break;
 
@@ -377,6 +385,8 @@ int emit_elf_obj(const char *ofn, Vector *sections, Table *label_table, Vector *
       flags |= SHF_EXECINSTR;
     if (section->flag & SF_WRITABLE)
       flags |= SHF_WRITE;
+    if (section->flag & SF_MERGE_STRINGS)
+      flags |= SHF_MERGE | SHF_STRINGS;
 
     Elf64_Word type;
     if (section->flag & SF_BSS)
@@ -395,6 +405,7 @@ int emit_elf_obj(const char *ofn, Vector *sections, Table *label_table, Vector *
       .sh_offset = section->offset,
       .sh_size = size,
       .sh_addralign = section->align,
+      .sh_entsize = section->flag & SF_MERGE_STRINGS ? 1 : 0,
     };
     data_append(&section_headers, &shdr, sizeof(shdr));
   }
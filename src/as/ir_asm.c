@@ -1,24 +1,29 @@
 #include "../config.h"
 #include "ir_asm.h"
 
+#include <stdlib.h>  // free
+
+#include "as_util.h"
+#include "parse_asm.h"
+#include "table.h"
 #include "util.h"
 
 IR *new_ir_label(const Name *label) {
-  IR *ir = calloc_or_die(sizeof(*ir));
+  IR *ir = arena_alloc(sizeof(*ir));
   ir->kind = IR_LABEL;
   ir->label = label;
   return ir;
 }
 
 IR *new_ir_code(const Code *code) {
-  IR *ir = calloc_or_die(sizeof(*ir));
+  IR *ir = arena_alloc(sizeof(*ir));
   ir->kind = IR_CODE;
   ir->code = *code;
   return ir;
 }
 
 IR *new_ir_data(const void *data, size_t size) {
-  IR *ir = calloc_or_die(sizeof(*ir));
+  IR *ir = arena_alloc(sizeof(*ir));
   ir->kind = IR_DATA;
   ir->data.len = size;
   ir->data.buf = (unsigned char*)data;
@@ -26,23 +31,148 @@ IR *new_ir_data(const void *data, size_t size) {
 }
 
 IR *new_ir_bss(size_t size) {
-  IR *ir = calloc_or_die(sizeof(*ir));
+  IR *ir = arena_alloc(sizeof(*ir));
   ir->kind = IR_BSS;
   ir->bss = size;
   return ir;
 }
 
 IR *new_ir_align(int align) {
-  IR *ir = calloc_or_die(sizeof(*ir));
+  IR *ir = arena_alloc(sizeof(*ir));
   ir->kind = IR_ALIGN;
   ir->align = align;
   return ir;
 }
 
 IR *new_ir_expr(enum IrKind kind, const Expr *expr) {
-  IR *ir = calloc_or_die(sizeof(*ir));
+  IR *ir = arena_alloc(sizeof(*ir));
   ir->kind = kind;
   ir->expr.expr = expr;
   ir->expr.addend = 0;
   return ir;
 }
+
+// Branch relaxation
+//
+// Every branch starts in its short form (optimistic sizing). Only the branches which can
+// still be extended are tracked as fragments, and the growth of each fragment is kept in
+// a Fenwick tree, so the shifted address of any instruction or label is a prefix sum over
+// the fragments placed before it. Fragments are rescanned until none of them grows,
+// without walking the whole IR list. Growth can change alignment paddings which prefix
+// sums do not model, so the result is verified against the real layout and the whole
+// process repeats in the rare case that it is not settled.
+
+typedef struct {
+  IR *ir;
+  LabelInfo *target;
+  int64_t offset;
+  int target_index;  // Number of fragments placed before the target.
+} BranchFragment;
+
+static void fenwick_add(int *tree, int n, int i, int value) {
+  for (++i; i <= n; i += i & -i)
+    tree[i - 1] += value;
+}
+
+// Sum of [0, i)
+static int fenwick_sum(const int *tree, int i) {
+  int sum = 0;
+  for (; i > 0; i -= i & -i)
+    sum += tree[i - 1];
+  return sum;
+}
+
+static int count_fragments_before(const BranchFragment *frags, int n, uintptr_t address) {
+  int lo = 0, hi = n;
+  while (lo < hi) {
+    int mid = lo + ((hi - lo) >> 1);
+    if (frags[mid].ir->address < address)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+// Returns -1 if some branch is extended while collecting (e.g. jump to an external label).
+static int collect_branch_fragments(Vector *sections, Table *label_table, BranchFragment **pfrags) {
+  BranchFragment *frags = NULL;
+  bool resized = false;
+  int n = 0, capa = 0;
+  for (int sec = 0; sec < sections->len; ++sec) {
+    SectionInfo *section = sections->data[sec];
+    Vector *irs = section->irs;
+    for (int i = 0, len = irs->len; i < len; ++i) {
+      IR *ir = irs->data[i];
+      if (ir->kind != IR_CODE)
+        continue;
+      int64_t offset;
+      int old_len = ir->code.len;
+      const Name *label = short_branch_target(ir, label_table, &offset);
+      resized |= ir->code.len != old_len;
+      LabelInfo *label_info;
+      if (label == NULL || (label_info = table_get(label_table, label)) == NULL ||
+          !(label_info->flag & LF_DEFINED))
+        continue;
+      if (label_info->section != section) {
+        // Distance to other section is unknown until link time.
+        resized |= make_branch_long(ir);
+        continue;
+      }
+
+      if (n >= capa) {
+        capa = capa > 0 ? capa << 1 : 64;
+        frags = realloc_or_die(frags, sizeof(*frags) * capa);
+      }
+      frags[n++] = (BranchFragment){.ir = ir, .target = label_info, .offset = offset};
+    }
+  }
+
+  if (resized) {
+    free(frags);
+    return -1;
+  }
+
+  for (int i = 0; i < n; ++i)
+    frags[i].target_index = count_fragments_before(frags, n, frags[i].target->address);
+  *pfrags = frags;
+  return n;
+}
+
+void relax_branches(uintptr_t start_address, Vector *sections, Table *label_table) {
+  for (;;) {
+    if (!calc_label_address(start_address, sections, label_table))
+      continue;
+
+    BranchFragment *frags;
+    int n = collect_branch_fragments(sections, label_table, &frags);
+    if (n < 0)
+      continue;
+    int *growth = calloc_or_die(sizeof(*growth) * (n + 1));
+    bool grown = false;
+    for (bool changed = true; changed; ) {
+      changed = false;
+      for (int i = 0; i < n; ++i) {
+        BranchFragment *frag = &frags[i];
+        IR *ir = frag->ir;
+        if (ir->code.flag & INST_LONG_OFFSET)
+          continue;
+        uintptr_t address = ir->address + fenwick_sum(growth, i);
+        uintptr_t target = frag->target->address + frag->offset +
+                           fenwick_sum(growth, frag->target_index);
+        if (is_branch_reachable(ir, address, target))
+          continue;
+
+        int old_len = ir->code.len;
+        if (make_branch_long(ir)) {
+          fenwick_add(growth, n, i, ir->code.len - old_len);
+          changed = grown = true;
+        }
+      }
+    }
+    free(growth);
+    free(frags);
+    if (!grown)
+      break;
+  }
+}
@@ -88,5 +88,13 @@ IR *new_ir_align(int align);
 IR *new_ir_expr(enum IrKind kind, const Expr *expr);
 
 bool calc_label_address(uintptr_t start_address, Vector *sections, Table *label_table);
+void relax_branches(uintptr_t start_address, Vector *sections, Table *label_table);
 bool resolve_relative_address(Vector *sections, Table *label_table, Vector *unresolved);
 void emit_irs(Vector *sections);
+
+// Branch relaxation hooks, implemented for each architecture.
+//   `short_branch_target` returns the target label of a branch which is still in short form,
+//   or NULL if the instruction is not subject to relaxation.
+const Name *short_branch_target(IR *ir, Table *label_table, int64_t *poffset);
+bool is_branch_reachable(IR *ir, uintptr_t address, uintptr_t target);
+bool make_branch_long(IR *ir);
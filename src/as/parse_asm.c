@@ -12,6 +12,7 @@
 #include <alloca.h>
 #endif
 
+#include "as_util.h"
 #include "ir_asm.h"
 #include "table.h"
 #include "util.h"
@@ -127,14 +128,10 @@ void parse_error(ParseInfo *info, const char *message) {
 }
 
 static enum DirectiveType find_directive(const char *p, size_t n) {
-  const char **table = kDirectiveTable;
-  for (size_t i = 0; i < ARRAY_SIZE(kDirectiveTable); ++i) {
-    const char *name = table[i];
-    if (strncasecmp(p, name, n) == 0 && name[n] == '\0') {
-      return i + 1;
-    }
-  }
-  return NODIRECTIVE;
+  static PerfectHash hash;
+  if (hash.names == NULL)
+    perfect_hash_init(&hash, kDirectiveTable, ARRAY_SIZE(kDirectiveTable), sizeof(*kDirectiveTable));
+  return perfect_hash_find(&hash, p, n) + 1;  // NODIRECTIVE if not found.
 }
 
 bool immediate(const char **pp, int64_t *value) {
@@ -178,6 +175,152 @@ bool is_label_chr(char c) {
   return is_label_first_chr(c) || isdigit(c);
 }
 
+// Perfect hash (hash and displace): A key goes into the bucket by its hash, and the
+// displacement of the bucket is chosen so that its keys fall into free slots.
+
+static uint32_t hash_keyword(const char *p, size_t n) {
+  uint32_t h = 2166136261U;  // FNV-1a
+  for (size_t i = 0; i < n; ++i) {
+    h ^= (unsigned char)tolower((unsigned char)p[i]);
+    h *= 16777619U;
+  }
+  return h;
+}
+
+static uint32_t displace_hash(uint32_t h, uint32_t d) {
+  h ^= d * 0x9e3779b9U;
+  h ^= h >> 16;
+  h *= 0x85ebca6bU;
+  h ^= h >> 13;
+  return h;
+}
+
+typedef struct {
+  uint32_t bucket;
+  int count;
+} HashBucket;
+
+static int compare_bucket(const void *pa, const void *pb) {
+  const HashBucket *a = pa, *b = pb;
+  if (a->count != b->count)
+    return a->count > b->count ? -1 : 1;
+  return a->bucket < b->bucket ? -1 : a->bucket > b->bucket ? 1 : 0;
+}
+
+// Duplicated names are skipped: The first one is found, as linear search.
+static bool place_buckets(PerfectHash *ph, const uint32_t *hashes, const bool *dups, int count) {
+  uint32_t bucket_count = ph->bucket_mask + 1;
+  uint32_t slot_count = ph->slot_mask + 1;
+  HashBucket *buckets = calloc_or_die(sizeof(*buckets) * bucket_count);
+  for (uint32_t i = 0; i < bucket_count; ++i)
+    buckets[i].bucket = i;
+  for (int i = 0; i < count; ++i) {
+    if (!dups[i])
+      ++buckets[hashes[i] & ph->bucket_mask].count;
+  }
+  // Place larger buckets first, while there are many free slots.
+  qsort(buckets, bucket_count, sizeof(*buckets), compare_bucket);
+
+  for (uint32_t i = 0; i < slot_count; ++i)
+    ph->slots[i] = -1;
+  int *keys = malloc_or_die(sizeof(*keys) * count);
+  uint32_t *placed = malloc_or_die(sizeof(*placed) * count);
+  bool ok = true;
+  for (uint32_t ib = 0; ib < bucket_count && ok; ++ib) {
+    const HashBucket *bucket = &buckets[ib];
+    if (bucket->count == 0)
+      break;
+    int n = 0;
+    for (int i = 0; i < count; ++i) {
+      if (!dups[i] && (hashes[i] & ph->bucket_mask) == bucket->bucket)
+        keys[n++] = i;
+    }
+
+    ok = false;
+    for (uint32_t d = 0; d <= UINT16_MAX && !ok; ++d) {
+      int j;
+      for (j = 0; j < n; ++j) {
+        uint32_t slot = displace_hash(hashes[keys[j]], d) & ph->slot_mask;
+        if (ph->slots[slot] >= 0)
+          break;
+        ph->slots[slot] = keys[j];
+        placed[j] = slot;
+      }
+      if (j >= n) {
+        ph->displacements[bucket->bucket] = d;
+        ok = true;
+      } else {
+        while (--j >= 0)
+          ph->slots[placed[j]] = -1;
+      }
+    }
+  }
+  free(placed);
+  free(keys);
+  free(buckets);
+  return ok;
+}
+
+void perfect_hash_init(PerfectHash *ph, const char *const *names, int count, size_t stride) {
+  ph->names = malloc_or_die(sizeof(*ph->names) * count);
+  uint32_t *hashes = malloc_or_die(sizeof(*hashes) * count);
+  bool *dups = calloc_or_die(sizeof(*dups) * count);
+  for (int i = 0; i < count; ++i) {
+    const char *name = *(const char *const*)((const char*)names + stride * i);
+    ph->names[i] = name;
+    hashes[i] = hash_keyword(name, strlen(name));
+    for (int j = 0; j < i; ++j) {
+      if (hashes[j] == hashes[i] && strcasecmp(ph->names[j], name) == 0) {
+        dups[i] = true;
+        break;
+      }
+    }
+  }
+
+  uint32_t bucket_count = 1, slot_count = 2;
+  while (bucket_count < (uint32_t)count)
+    bucket_count <<= 1;
+  while (slot_count < (uint32_t)count * 2)
+    slot_count <<= 1;
+  for (;; slot_count <<= 1) {
+    ph->bucket_mask = bucket_count - 1;
+    ph->slot_mask = slot_count - 1;
+    ph->slots = malloc_or_die(sizeof(*ph->slots) * slot_count);
+    ph->displacements = calloc_or_die(sizeof(*ph->displacements) * bucket_count);
+    if (place_buckets(ph, hashes, dups, count))
+      break;
+    free(ph->slots);
+    free(ph->displacements);
+    if (slot_count >= (1U << 15))
+      error("Cannot build keyword table");
+  }
+  free(dups);
+  free(hashes);
+}
+
+int perfect_hash_find(const PerfectHash *ph, const char *p, size_t n) {
+  uint32_t h = hash_keyword(p, n);
+  uint32_t d = ph->displacements[h & ph->bucket_mask];
+  int index = ph->slots[displace_hash(h, d) & ph->slot_mask];
+  if (index >= 0) {
+    const char *name = ph->names[index];
+    if (strncasecmp(p, name, n) == 0 && name[n] == '\0')
+      return index;
+  }
+  return -1;
+}
+
+int perfect_hash_find_word(const PerfectHash *ph, const char **pp) {
+  const char *p = *pp;
+  const char *q = p;
+  while (is_label_chr(*q))
+    ++q;
+  int index = perfect_hash_find(ph, p, q - p);
+  if (index >= 0)
+    *pp = q;
+  return index;
+}
+
 static const char *get_label_end(ParseInfo *info) {
   const char *start = info->p;
   const char *p = start;
@@ -193,14 +336,16 @@ static const char *get_label_end(ParseInfo *info) {
       ++p;
       if (c == '"')
         break;
-      if (c == '\\')
+      if (c == '\\' && *p != '\0')
         ++p;
     }
-    start += 2;
+    if (p <= start + 2)
+      parse_error(info, "Empty label");
   } else {
     const unsigned char *q = (const unsigned char*)p;
     int ucc = 0;
-    for (;;) {
+    // Never step over the terminator: Next line follows in the input buffer.
+    while (*q != '\0') {
       int uc = *++q;
       if (ucc > 0) {
         if (!isutf8follow(uc)) {
@@ -217,8 +362,6 @@ static const char *get_label_end(ParseInfo *info) {
     }
     p = (const char*)q;
   }
-  if (p <= start)
-    parse_error(info, "Empty label");
   return p;
 }
 
@@ -281,7 +424,7 @@ typedef struct Token {
 } Token;
 
 static Token *new_token(enum TokenKind kind) {
-  Token *token = calloc_or_die(sizeof(*token));
+  Token *token = arena_alloc(sizeof(*token));
   token->kind = kind;
   return token;
 }
@@ -414,7 +557,7 @@ static const Token *match(ParseInfo *info, enum TokenKind kind) {
 }
 
 Expr *new_expr(enum ExprKind kind) {
-  Expr *expr = malloc_or_die(sizeof(*expr));
+  Expr *expr = arena_alloc(sizeof(*expr));
   expr->kind = kind;
   return expr;
 }
@@ -585,16 +728,17 @@ static /*enum RawOpcode*/int find_raw_opcode(ParseInfo *info) {
   while (isalnum(*p) || *p == '.')
     ++p;
   if (*p == '\0' || isspace(*p)) {
-    size_t n = p - start;
-    for (int i = 0; ; ++i) {
-      const char *name = kRawOpTable[i];
-      if (name == NULL)
-        break;
-      size_t len = strlen(name);
-      if (n == len && strncasecmp(start, name, n) == 0) {
-        info->p = skip_whitespaces(p);
-        return i + 1;
-      }
+    static PerfectHash hash;
+    if (hash.names == NULL) {
+      int count = 0;
+      while (kRawOpTable[count] != NULL)
+        ++count;
+      perfect_hash_init(&hash, kRawOpTable, count, sizeof(*kRawOpTable));
+    }
+    int index = perfect_hash_find(&hash, start, p - start);
+    if (index >= 0) {
+      info->p = skip_whitespaces(p);
+      return index + 1;
     }
   }
   return R_NOOP;
@@ -679,7 +823,7 @@ void parse_inst(ParseInfo *info, Line *line) {
 }
 
 Line *parse_line(ParseInfo *info) {
-  Line *line = calloc_or_die(sizeof(*line));
+  Line *line = arena_alloc(sizeof(*line));
   line->label = NULL;
   line->inst.op = NOOP;
   line->dir = NODIRECTIVE;
@@ -789,6 +933,7 @@ static char *parse_string(ParseInfo *info) {
 
 static uint32_t parse_section_flag(ParseInfo *info) {
   uint32_t flag = 0;
+  bool merge = false, strings = false;
   char *flag_str = parse_string(info);
   if (flag_str == NULL) {
     parse_error(info, ".section: flag string expected");
@@ -798,12 +943,36 @@ static uint32_t parse_section_flag(ParseInfo *info) {
       case 'a':  /*ignore*/ break;
       case 'w':  flag |= SF_WRITABLE; break;
       case 'x':  flag |= SF_EXECUTABLE; break;
+      case 'M':  merge = true; break;
+      case 'S':  strings = true; break;
       default:
         parse_error(info, ".section: illegal flag character");
         break;
       }
     }
   }
+
+  // Type and entry size follow: `,@progbits,1`
+  const char *p = skip_whitespaces(info->p);
+  if (*p == ',') {
+    p = skip_whitespaces(p + 1);
+    if (*p == '@' || *p == '%') {
+      do {
+        ++p;
+      } while (isalnum_(*p));
+    }
+    p = skip_whitespaces(p);
+    int64_t entsize = 0;
+    if (*p == ',') {
+      p = skip_whitespaces(p + 1);
+      if (!immediate(&p, &entsize))
+        parse_error(info, ".section: entry size expected");
+    }
+    info->p = p;
+    // Only strings of `char` are merged, others are kept as is.
+    if (merge && strings && entsize == 1 && !(flag & (SF_WRITABLE | SF_EXECUTABLE)))
+      flag |= SF_MERGE_STRINGS;
+  }
   return flag;
 }
 #endif
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>  // size_t
 #include <stdint.h>  // int64_t
 
 #include "inst.h"  // Inst
@@ -38,6 +39,7 @@ enum DirectiveType {
 #define SF_EXECUTABLE  (1 << 0)
 #define SF_WRITABLE    (1 << 1)
 #define SF_BSS         (1 << 2)
+#define SF_MERGE_STRINGS  (1 << 3)  // SHF_MERGE | SHF_STRINGS, entry size 1
 
 typedef struct SectionInfo {
   const Name *name;
@@ -168,6 +170,23 @@ Value calc_expr(Table *label_table, const Expr *expr);
 bool is_label_first_chr(char c);
 bool is_label_chr(char c);
 
+// Perfect hash for keywords (mnemonics, directives and register names): Built from the name
+// table at the first use, then a lookup takes one hash and one string comparison.
+typedef struct {
+  const char **names;
+  int16_t *slots;  // Index of the name, or -1.
+  uint16_t *displacements;  // For each bucket.
+  uint32_t bucket_mask;
+  uint32_t slot_mask;
+} PerfectHash;
+
+// `names` points the first name, and the following names are placed at `stride` bytes.
+void perfect_hash_init(PerfectHash *ph, const char *const *names, int count, size_t stride);
+// Returns the index of the name [p, p + n) in case insensitive, or -1.
+int perfect_hash_find(const PerfectHash *ph, const char *p, size_t n);
+// Find the name at `*pp` which is not followed by a label character, and advances `*pp`.
+int perfect_hash_find_word(const PerfectHash *ph, const char **pp);
+
 #define LF_GLOBAL    (1 << 0)
 #define LF_DEFINED   (1 << 1)
 #define LF_REFERRED  (1 << 2)
@@ -251,4 +251,6 @@
 #define FCVTZS(o1, o2)     EMIT_ASM("fcvtzs", o1, o2)  // int <- float
 #define FCVTZU(o1, o2)     EMIT_ASM("fcvtzu", o1, o2)  // unsigned int <- float
 
+#define DUP(o1, o2)        EMIT_ASM("dup", o1, o2)
+
 void mov_immediate(const char *dst, int64_t value, bool b64, bool is_unsigned);
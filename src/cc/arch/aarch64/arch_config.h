@@ -11,3 +11,9 @@
 #define PHYSICAL_FREG_MAX        (PHYSICAL_FREG_TEMPORARY + 24)
 
 #define GET_FPREG_INDEX()  21
+
+// Block copy/clear up to this size is unrolled with ldp/stp, otherwise looped.
+#define MEMOP_INLINE_MAX  (128)
+
+// Counted loops are vectorized with NEON registers in this byte width.
+#define VECTOR_REG_SIZE  (16)
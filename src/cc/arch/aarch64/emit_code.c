@@ -167,7 +167,7 @@ void emit_defun(Function *func) {
     return;
 
   emit_comment(NULL);
-  _TEXT();
+  emit_text(func->name);
 
   bool global = true;
   const VarInfo *varinfo = scope_find(global_scope, func->name, NULL);
@@ -53,6 +53,7 @@ static const char *kTmpRegTable[] = {W17, W17, W17, X17};
 
 #define SZ_FLOAT   VRegSize4
 #define SZ_DOUBLE  VRegSize8
+#define SZ_VECTOR  VRegSize16
 const char *kFReg32s[PHYSICAL_FREG_MAX] = {
    S0,  S1,  S2,  S3,  S4,  S5,  S6,  S7,
    S8,  S9, S10, S11, S12, S13, S14, S15,
@@ -74,9 +75,15 @@ static const int kCalleeSaveFRegs[] = {8, 9, 10, 11, 12, 13, 14, 15};
 #define CALLER_SAVE_FREG_COUNT  ((int)ARRAY_SIZE(kCallerSaveFRegs))
 static const int kCallerSaveFRegs[] = {16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31};
 
-static unsigned long detect_extra_occupied(RegAlloc *ra, IR *ir) {
+static unsigned long detect_extra_occupied(RegAlloc *ra, IR *ir, unsigned long *pfoccupy) {
+  UNUSED(pfoccupy);
   unsigned long ioccupy = 0;
   switch (ir->kind) {
+  case IR_MEMCPY:
+    // Copy 16 bytes at once with x16 and x17 pair.
+    if (ir->memop.size >= 16)
+      ioccupy = 1UL << GET_X16_INDEX();
+    break;
   case IR_CALL:
     // X16 and X17 are IP0 and IP1, intra-procedure-call temporary registers. These can be used by
     // call veneers and similar code, or as temporary registers for intermediate values between
@@ -219,6 +226,7 @@ static void ei_load(IR *ir) {
     switch (ir->dst->vsize) {
     case SZ_FLOAT:   dst = kFReg32s[ir->dst->phys]; break;
     case SZ_DOUBLE:  dst = kFReg64s[ir->dst->phys]; break;
+    case SZ_VECTOR:  dst = fmt("q%d", ir->dst->phys); break;
     default: assert(false); break;
     }
     LDR(dst, src);
@@ -268,6 +276,7 @@ static void ei_store(IR *ir) {
     default: assert(false); // Fallthrough
     case SZ_FLOAT:   src = kFReg32s[ir->opr1->phys]; break;
     case SZ_DOUBLE:  src = kFReg64s[ir->opr1->phys]; break;
+    case SZ_VECTOR:  src = fmt("q%d", ir->opr1->phys); break;
     }
   } else if (ir->opr1->flag & VRF_CONST) {
     if (ir->opr1->fixnum == 0)
@@ -281,11 +290,60 @@ static void ei_store(IR *ir) {
   switch (pow) {
   case 0:          STRB(src, target); break;
   case 1:          STRH(src, target); break;
-  case 2: case 3:  STR(src, target); break;
+  case 2: case 3: case 4:  STR(src, target); break;
   default: assert(false); break;
   }
 }
 
+static void ei_memcpy(IR *ir) {
+  assert(!(ir->opr1->flag & VRF_CONST) && !(ir->opr2->flag & VRF_CONST));
+  const char *src = kReg64s[ir->opr1->phys];
+  const char *dst = kReg64s[ir->opr2->phys];
+  size_t size = ir->memop.size, ofs = 0;
+  for (; size - ofs >= 16; ofs += 16) {
+    LDP(X16, X17, IMMEDIATE_OFFSET(src, ofs));
+    STP(X16, X17, IMMEDIATE_OFFSET(dst, ofs));
+  }
+  // Remainder: Offsets are kept aligned to the access size.
+  for (int pow = 3; pow >= 0; --pow) {
+    size_t n = 1 << pow;
+    if (size - ofs < n)
+      continue;
+    const char *tmp = kTmpRegTable[pow];
+    const char *s = IMMEDIATE_OFFSET(src, ofs);
+    const char *d = IMMEDIATE_OFFSET(dst, ofs);
+    switch (pow) {
+    case 0:          LDRB(tmp, s); STRB(tmp, d); break;
+    case 1:          LDRH(tmp, s); STRH(tmp, d); break;
+    case 2: case 3:  LDR(tmp, s); STR(tmp, d); break;
+    default: assert(false); break;
+    }
+    ofs += n;
+  }
+}
+
+static void ei_clear(IR *ir) {
+  assert(!(ir->opr1->flag & VRF_CONST));
+  const char *dst = kReg64s[ir->opr1->phys];
+  size_t size = ir->memop.size, ofs = 0;
+  for (; size - ofs >= 16; ofs += 16)
+    STP(XZR, XZR, IMMEDIATE_OFFSET(dst, ofs));
+  for (int pow = 3; pow >= 0; --pow) {
+    size_t n = 1 << pow;
+    if (size - ofs < n)
+      continue;
+    const char *zero = kZeroRegTable[pow];
+    const char *d = IMMEDIATE_OFFSET(dst, ofs);
+    switch (pow) {
+    case 0:          STRB(zero, d); break;
+    case 1:          STRH(zero, d); break;
+    case 2: case 3:  STR(zero, d); break;
+    default: assert(false); break;
+    }
+    ofs += n;
+  }
+}
+
 static void ei_add(IR *ir) {
   if (ir->dst->flag & VRF_FLONUM) {
     const char **regs;
@@ -482,6 +540,9 @@ static void ei_mov(IR *ir) {
       default: assert(false); // Fallthrough
       case SZ_FLOAT:   dst = kFReg32s[ir->dst->phys]; src = kFReg32s[ir->opr1->phys]; break;
       case SZ_DOUBLE:  dst = kFReg64s[ir->dst->phys]; src = kFReg64s[ir->opr1->phys]; break;
+      case SZ_VECTOR:
+        MOV(fmt("v%d.16b", ir->dst->phys), fmt("v%d.16b", ir->opr1->phys));
+        return;
       }
       FMOV(dst, src);
     }
@@ -503,6 +564,40 @@ static void ei_keep(IR *ir) {
   UNUSED(ir);
 }
 
+static const char *vreg_arrangement(IR *ir, VReg *vreg) {
+  return fmt("v%d.%s", vreg->phys, ir->vec.elem == VRegSize8 ? "2d" : "4s");
+}
+
+static void ei_vbop(IR *ir) {
+  const char *dst = vreg_arrangement(ir, ir->dst);
+  const char *opr1 = vreg_arrangement(ir, ir->opr1);
+  const char *opr2 = vreg_arrangement(ir, ir->opr2);
+  switch (ir->kind) {
+  case IR_VADD:
+    if (ir->vec.flonum)  FADD(dst, opr1, opr2);
+    else                 ADD(dst, opr1, opr2);
+    break;
+  case IR_VSUB:
+    if (ir->vec.flonum)  FSUB(dst, opr1, opr2);
+    else                 SUB(dst, opr1, opr2);
+    break;
+  case IR_VMUL:  assert(ir->vec.flonum); FMUL(dst, opr1, opr2); break;
+  case IR_VDIV:  assert(ir->vec.flonum); FDIV(dst, opr1, opr2); break;
+  default: assert(false); break;
+  }
+}
+
+static void ei_vsplat(IR *ir) {
+  assert(!(ir->opr1->flag & VRF_CONST));
+  bool b64 = ir->vec.elem == VRegSize8;
+  const char *src;
+  if (ir->vec.flonum)
+    src = fmt("v%d.%s", ir->opr1->phys, b64 ? "d[0]" : "s[0]");
+  else
+    src = kRegSizeTable[ir->vec.elem][ir->opr1->phys];
+  DUP(vreg_arrangement(ir, ir->dst), src);
+}
+
 static void cmp_vregs(VReg *opr1, VReg *opr2) {
   assert(opr1 != NULL && opr2 != NULL);
   if (opr1->flag & VRF_FLONUM) {
@@ -959,6 +1054,7 @@ void emit_bb_irs(BBContainer *bbcon) {
   static const EmitIrFunc table[] = {
     [IR_BOFS] = ei_bofs, [IR_IOFS] = ei_iofs, [IR_SOFS] = ei_sofs,
     [IR_LOAD] = ei_load, [IR_LOAD_S] = ei_load_s, [IR_STORE] = ei_store, [IR_STORE_S] = ei_store_s,
+    [IR_MEMCPY] = ei_memcpy, [IR_CLEAR] = ei_clear,
     [IR_ADD] = ei_add, [IR_SUB] = ei_sub, [IR_MUL] = ei_mul, [IR_DIV] = ei_div,
     [IR_MOD] = ei_mod, [IR_BITAND] = ei_bitand, [IR_BITOR] = ei_bitor,
     [IR_BITXOR] = ei_bitxor, [IR_LSHIFT] = ei_lshift, [IR_RSHIFT] = ei_rshift,
@@ -967,6 +1063,8 @@ void emit_bb_irs(BBContainer *bbcon) {
     [IR_PRECALL] = ei_precall, [IR_PUSHARG] = ei_pusharg, [IR_CALL] = ei_call,
     [IR_RESULT] = ei_result, [IR_SUBSP] = ei_subsp, [IR_CAST] = ei_cast,
     [IR_MOV] = ei_mov, [IR_KEEP] = ei_keep, [IR_ASM] = ei_asm,
+    [IR_VADD] = ei_vbop, [IR_VSUB] = ei_vbop, [IR_VMUL] = ei_vbop, [IR_VDIV] = ei_vbop,
+    [IR_VSPLAT] = ei_vsplat,
   };
 
   for (int i = 0; i < bbcon->bbs->len; ++i) {
@@ -1030,6 +1128,13 @@ void tweak_irs(FuncBackend *fnbe) {
           insert_const_mov(&ir->opr2, ra, irs, j++);
         }
         break;
+      case IR_MEMCPY:
+      case IR_CLEAR:
+        if (ir->opr1->flag & VRF_CONST)
+          insert_const_mov(&ir->opr1, ra, irs, j++);
+        if (ir->opr2 != NULL && (ir->opr2->flag & VRF_CONST))
+          insert_const_mov(&ir->opr2, ra, irs, j++);
+        break;
       case IR_ADD:
         assert(!(ir->opr1->flag & VRF_CONST) || !(ir->opr2->flag & VRF_CONST));
         if (ir->opr1->flag & VRF_CONST)
@@ -1112,6 +1217,10 @@ void tweak_irs(FuncBackend *fnbe) {
           insert_const_mov(&ir->opr1, ra, irs, j++);
         }
         break;
+      case IR_VSPLAT:
+        if (ir->opr1->flag & VRF_CONST)
+          insert_const_mov(&ir->opr1, ra, irs, j++);
+        break;
 
       default: break;
       }
@@ -11,3 +11,6 @@
 #define PHYSICAL_FREG_MAX        (PHYSICAL_FREG_TEMPORARY + 24)
 
 #define GET_FPREG_INDEX()  18
+
+// Block copy/clear up to this size is unrolled, otherwise looped.
+#define MEMOP_INLINE_MAX  (64)
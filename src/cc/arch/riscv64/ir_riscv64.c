@@ -54,8 +54,9 @@ static const int kCalleeSaveFRegs[] = {8, 9, 10, 11, 12, 13, 14, 15, 17, 18, 19}
 #define CALLER_SAVE_FREG_COUNT  ((int)ARRAY_SIZE(kCallerSaveFRegs))
 static const int kCallerSaveFRegs[] = {20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31};
 
-static unsigned long detect_extra_occupied(RegAlloc *ra, IR *ir) {
+static unsigned long detect_extra_occupied(RegAlloc *ra, IR *ir, unsigned long *pfoccupy) {
   UNUSED(ir);
+  UNUSED(pfoccupy);
   unsigned long ioccupy = 0;
   if (ra->flag & RAF_STACK_FRAME)
     ioccupy |= 1UL << GET_FPREG_INDEX();
@@ -213,6 +214,43 @@ static void ei_store(IR *ir) {
   }
 }
 
+static void ei_memcpy(IR *ir) {
+  assert(!(ir->opr1->flag & VRF_CONST) && !(ir->opr2->flag & VRF_CONST));
+  const char *src = kReg64s[ir->opr1->phys];
+  const char *dst = kReg64s[ir->opr2->phys];
+  // Misaligned access might trap, so move in the unit of alignment.
+  int align = ir->memop.align;
+  assert(IS_POWER_OF_2(align) && align <= 8 && ir->memop.size % align == 0);
+  for (size_t ofs = 0; ofs < ir->memop.size; ofs += align) {
+    const char *s = IMMEDIATE_OFFSET(ofs, src);
+    const char *d = IMMEDIATE_OFFSET(ofs, dst);
+    switch (align) {
+    case 1:  LB(kTmpReg, s); SB(kTmpReg, d); break;
+    case 2:  LH(kTmpReg, s); SH(kTmpReg, d); break;
+    case 4:  LW(kTmpReg, s); SW(kTmpReg, d); break;
+    case 8:  LD(kTmpReg, s); SD(kTmpReg, d); break;
+    default: assert(false); break;
+    }
+  }
+}
+
+static void ei_clear(IR *ir) {
+  assert(!(ir->opr1->flag & VRF_CONST));
+  const char *dst = kReg64s[ir->opr1->phys];
+  int align = ir->memop.align;
+  assert(IS_POWER_OF_2(align) && align <= 8 && ir->memop.size % align == 0);
+  for (size_t ofs = 0; ofs < ir->memop.size; ofs += align) {
+    const char *d = IMMEDIATE_OFFSET(ofs, dst);
+    switch (align) {
+    case 1:  SB(ZERO, d); break;
+    case 2:  SH(ZERO, d); break;
+    case 4:  SW(ZERO, d); break;
+    case 8:  SD(ZERO, d); break;
+    default: assert(false); break;
+    }
+  }
+}
+
 static void ei_add(IR *ir) {
   if (ir->dst->flag & VRF_FLONUM) {
     switch (ir->dst->vsize) {
@@ -935,6 +973,7 @@ void emit_bb_irs(BBContainer *bbcon) {
   static const EmitIrFunc table[] = {
     [IR_BOFS] = ei_bofs, [IR_IOFS] = ei_iofs, [IR_SOFS] = ei_sofs,
     [IR_LOAD] = ei_load, [IR_LOAD_S] = ei_load_s, [IR_STORE] = ei_store, [IR_STORE_S] = ei_store_s,
+    [IR_MEMCPY] = ei_memcpy, [IR_CLEAR] = ei_clear,
     [IR_ADD] = ei_add, [IR_SUB] = ei_sub, [IR_MUL] = ei_mul, [IR_DIV] = ei_div,
     [IR_MOD] = ei_mod, [IR_BITAND] = ei_bitand, [IR_BITOR] = ei_bitor,
     [IR_BITXOR] = ei_bitxor, [IR_LSHIFT] = ei_lshift, [IR_RSHIFT] = ei_rshift,
@@ -1008,6 +1047,13 @@ void tweak_irs(FuncBackend *fnbe) {
           insert_const_mov(&ir->opr2, ra, irs, j++);
         }
         break;
+      case IR_MEMCPY:
+      case IR_CLEAR:
+        if (ir->opr1->flag & VRF_CONST)
+          insert_const_mov(&ir->opr1, ra, irs, j++);
+        if (ir->opr2 != NULL && (ir->opr2->flag & VRF_CONST))
+          insert_const_mov(&ir->opr2, ra, irs, j++);
+        break;
       case IR_ADD:
         assert(!(ir->opr1->flag & VRF_CONST) || !(ir->opr2->flag & VRF_CONST));
         if (ir->opr1->flag & VRF_CONST)
@@ -9,3 +9,6 @@
 #define PHYSICAL_REG_MAX         (PHYSICAL_REG_TEMPORARY + 8)
 #define PHYSICAL_FREG_TEMPORARY  (8)
 #define PHYSICAL_FREG_MAX        (PHYSICAL_FREG_TEMPORARY + 8)
+
+// Counted loops are vectorized with SSE2 registers in this byte width.
+#define VECTOR_REG_SIZE  (16)
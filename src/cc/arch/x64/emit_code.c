@@ -156,7 +156,7 @@ void emit_defun(Function *func) {
   assert(stackpos == 8);
 
   emit_comment(NULL);
-  _TEXT();
+  emit_text(func->name);
 
   bool global = true;
   const VarInfo *varinfo = scope_find(global_scope, func->name, NULL);
@@ -30,6 +30,8 @@ const char *kRegSizeTable[][PHYSICAL_REG_MAX] = {
 // Return index of %rcx register.
 // Detect the index using the fact that %rcx is 4th parameter on calling convention.
 #define GET_AREG_INDEX()  0
+#define GET_DIREG_INDEX() 1  // ArchRegParamMapping[0]
+#define GET_SIREG_INDEX() 2  // ArchRegParamMapping[1]
 #define GET_CREG_INDEX()  4  // ArchRegParamMapping[3]
 #define GET_DREG_INDEX()  3  // ArchRegParamMapping[2]
 #define GET_BPREG_INDEX() 12
@@ -48,18 +50,33 @@ const int ArchRegParamMapping[] = {1, 2, 3, 4, 5, 6};
 
 #define SZ_FLOAT   VRegSize4
 #define SZ_DOUBLE  VRegSize8
+#define SZ_VECTOR  VRegSize16
 const char *kFReg64s[PHYSICAL_FREG_MAX] = {
   XMM0, XMM1, XMM2, XMM3, XMM4, XMM5, XMM6, XMM7,
   XMM8, XMM9, XMM10, XMM11, XMM12, XMM13, XMM14, XMM15};
 
 #define GET_XMM0_INDEX()   0
+#define GET_XMM15_INDEX()  15  // Used in block copy/clear.
+
+// Block copy/clear larger than this size is done with `rep movsb/stosb`, otherwise unrolled.
+#define MEMOP_UNROLL_MAX  (128)
 
 #define CALLER_SAVE_FREG_COUNT  ((int)ARRAY_SIZE(kCallerSaveFRegs))
 static const int kCallerSaveFRegs[] = {8, 9, 10, 11, 12, 13, 14, 15};
 
-static unsigned long detect_extra_occupied(RegAlloc *ra, IR *ir) {
+static unsigned long detect_extra_occupied(RegAlloc *ra, IR *ir, unsigned long *pfoccupy) {
   unsigned long ioccupy = 0;
   switch (ir->kind) {
+  case IR_MEMCPY: case IR_CLEAR:
+    if (ir->memop.size > MEMOP_UNROLL_MAX) {
+      ioccupy = (1UL << GET_DIREG_INDEX()) | (1UL << GET_CREG_INDEX());
+      ioccupy |= ir->kind == IR_MEMCPY ? 1UL << GET_SIREG_INDEX() : 1UL << GET_AREG_INDEX();
+    } else if (ir->memop.size >= 16) {
+      *pfoccupy = 1UL << GET_XMM15_INDEX();
+    } else if (ir->kind == IR_MEMCPY) {
+      ioccupy = 1UL << GET_CREG_INDEX();
+    }
+    break;
   case IR_MUL: case IR_DIV: case IR_MOD:
     if (!(ir->dst->flag & VRF_FLONUM))
       ioccupy = (1UL << GET_DREG_INDEX()) | (1UL << GET_AREG_INDEX());
@@ -146,6 +163,7 @@ static void ei_load(IR *ir) {
     switch (ir->dst->vsize) {
     case SZ_FLOAT:  MOVSS(src, kFReg64s[ir->dst->phys]); break;
     case SZ_DOUBLE: MOVSD(src, kFReg64s[ir->dst->phys]); break;
+    case SZ_VECTOR: MOVUPS(src, kFReg64s[ir->dst->phys]); break;
     default: assert(false); break;
     }
   } else {
@@ -176,6 +194,7 @@ static void ei_store(IR *ir) {
     switch (ir->opr1->vsize) {
     case SZ_FLOAT:  MOVSS(kFReg64s[ir->opr1->phys], target); break;
     case SZ_DOUBLE: MOVSD(kFReg64s[ir->opr1->phys], target); break;
+    case SZ_VECTOR: MOVUPS(kFReg64s[ir->opr1->phys], target); break;
     default: assert(false); break;
     }
   } else {
@@ -196,6 +215,77 @@ static void ei_store(IR *ir) {
   }
 }
 
+static void ei_memcpy(IR *ir) {
+  assert(!(ir->opr1->flag & VRF_CONST) && !(ir->opr2->flag & VRF_CONST));
+  const char *src = kReg64s[ir->opr1->phys];
+  const char *dst = kReg64s[ir->opr2->phys];
+  size_t size = ir->memop.size;
+  if (size > MEMOP_UNROLL_MAX) {
+    // %rdi, %rsi and %rcx are kept free by detect_extra_occupied.
+    MOV(src, RSI);
+    MOV(dst, RDI);
+    MOV(IM(size), RCX);
+    REP();
+    MOVSB();
+  } else if (size >= 16) {
+    for (size_t ofs = 0; ofs < size; ofs += 16) {
+      // Copy the last chunk overlapped with the previous one, instead of splitting the remainder.
+      if (ofs + 16 > size)
+        ofs = size - 16;
+      MOVUPS(OFFSET_INDIRECT(ofs, src, NULL, 1), XMM15);
+      MOVUPS(XMM15, OFFSET_INDIRECT(ofs, dst, NULL, 1));
+    }
+  } else {
+    size_t ofs = 0;
+    for (int pow = 3; pow >= 0; --pow) {
+      size_t n = 1 << pow;
+      if (size - ofs >= n) {
+        const char *tmp = kRegSizeTable[pow][GET_CREG_INDEX()];
+        MOV(OFFSET_INDIRECT(ofs, src, NULL, 1), tmp);
+        MOV(tmp, OFFSET_INDIRECT(ofs, dst, NULL, 1));
+        ofs += n;
+      }
+    }
+  }
+}
+
+static void ei_clear(IR *ir) {
+  assert(!(ir->opr1->flag & VRF_CONST));
+  const char *dst = kReg64s[ir->opr1->phys];
+  size_t size = ir->memop.size;
+  if (size > MEMOP_UNROLL_MAX) {
+    // %rdi, %rax and %rcx are kept free by detect_extra_occupied.
+    MOV(dst, RDI);
+    XOR(EAX, EAX);
+    MOV(IM(size), RCX);
+    REP();
+    STOSB();
+  } else if (size >= 16) {
+    XORPS(XMM15, XMM15);
+    for (size_t ofs = 0; ofs < size; ofs += 16) {
+      if (ofs + 16 > size)
+        ofs = size - 16;
+      MOVUPS(XMM15, OFFSET_INDIRECT(ofs, dst, NULL, 1));
+    }
+  } else {
+    size_t ofs = 0;
+    for (int pow = 3; pow >= 0; --pow) {
+      size_t n = 1 << pow;
+      if (size - ofs >= n) {
+        const char *target = OFFSET_INDIRECT(ofs, dst, NULL, 1);
+        switch (pow) {
+        case 0: MOVB(IM(0), target); break;
+        case 1: MOVW(IM(0), target); break;
+        case 2: MOVL(IM(0), target); break;
+        case 3: MOVQ(IM(0), target); break;
+        default: assert(false); break;
+        }
+        ofs += n;
+      }
+    }
+  }
+}
+
 static void ei_add(IR *ir) {
   assert(ir->dst->phys == ir->opr1->phys);
   if (ir->dst->flag & VRF_FLONUM) {
@@ -951,6 +1041,7 @@ static void ei_mov(IR *ir) {
       switch (ir->dst->vsize) {
       case SZ_FLOAT: MOVSS(kFReg64s[ir->opr1->phys], kFReg64s[ir->dst->phys]); break;
       case SZ_DOUBLE: MOVSD(kFReg64s[ir->opr1->phys], kFReg64s[ir->dst->phys]); break;
+      case SZ_VECTOR: MOVAPS(kFReg64s[ir->opr1->phys], kFReg64s[ir->dst->phys]); break;
       default: assert(false); break;
       }
     }
@@ -972,6 +1063,55 @@ static void ei_keep(IR *ir) {
   UNUSED(ir);
 }
 
+static void ei_vbop(IR *ir) {
+  assert(ir->dst->phys == ir->opr1->phys);
+  const char *src = kFReg64s[ir->opr2->phys], *dst = kFReg64s[ir->dst->phys];
+  bool b64 = ir->vec.elem == VRegSize8;
+  switch (ir->kind) {
+  case IR_VADD:
+    if (ir->vec.flonum)  { if (b64) ADDPD(src, dst); else ADDPS(src, dst); }
+    else                 { if (b64) PADDQ(src, dst); else PADDD(src, dst); }
+    break;
+  case IR_VSUB:
+    if (ir->vec.flonum)  { if (b64) SUBPD(src, dst); else SUBPS(src, dst); }
+    else                 { if (b64) PSUBQ(src, dst); else PSUBD(src, dst); }
+    break;
+  case IR_VMUL:
+    assert(ir->vec.flonum);
+    if (b64) MULPD(src, dst); else MULPS(src, dst);
+    break;
+  case IR_VDIV:
+    assert(ir->vec.flonum);
+    if (b64) DIVPD(src, dst); else DIVPS(src, dst);
+    break;
+  default: assert(false); break;
+  }
+}
+
+static void ei_vsplat(IR *ir) {
+  assert(!(ir->opr1->flag & VRF_CONST));
+  const char *dst = kFReg64s[ir->dst->phys];
+  bool b64 = ir->vec.elem == VRegSize8;
+  if (ir->vec.flonum) {
+    if (ir->opr1->phys != ir->dst->phys)
+      MOVAPS(kFReg64s[ir->opr1->phys], dst);
+    if (b64) {
+      UNPCKLPD(dst, dst);
+    } else {
+      UNPCKLPS(dst, dst);
+      MOVLHPS(dst, dst);
+    }
+  } else {
+    if (b64) {
+      MOVQ(kReg64s[ir->opr1->phys], dst);
+    } else {
+      MOVD(kReg32s[ir->opr1->phys], dst);
+      PUNPCKLDQ(dst, dst);
+    }
+    PUNPCKLQDQ(dst, dst);
+  }
+}
+
 static void ei_asm(IR *ir) {
   EMIT_ASM(ir->asm_.str);
   if (ir->dst != NULL) {
@@ -1101,6 +1241,7 @@ void emit_bb_irs(BBContainer *bbcon) {
   static const EmitIrFunc table[] = {
     [IR_BOFS] = ei_bofs, [IR_IOFS] = ei_iofs, [IR_SOFS] = ei_sofs,
     [IR_LOAD] = ei_load, [IR_LOAD_S] = ei_load_s, [IR_STORE] = ei_store, [IR_STORE_S] = ei_store_s,
+    [IR_MEMCPY] = ei_memcpy, [IR_CLEAR] = ei_clear,
     [IR_ADD] = ei_add, [IR_SUB] = ei_sub, [IR_MUL] = ei_mul, [IR_DIV] = ei_div,
     [IR_MOD] = ei_mod, [IR_BITAND] = ei_bitand, [IR_BITOR] = ei_bitor,
     [IR_BITXOR] = ei_bitxor, [IR_LSHIFT] = ei_lshift, [IR_RSHIFT] = ei_rshift,
@@ -1109,6 +1250,8 @@ void emit_bb_irs(BBContainer *bbcon) {
     [IR_PRECALL] = ei_precall, [IR_PUSHARG] = ei_pusharg, [IR_CALL] = ei_call,
     [IR_RESULT] = ei_result, [IR_SUBSP] = ei_subsp, [IR_CAST] = ei_cast,
     [IR_MOV] = ei_mov, [IR_KEEP] = ei_keep, [IR_ASM] = ei_asm,
+    [IR_VADD] = ei_vbop, [IR_VSUB] = ei_vbop, [IR_VMUL] = ei_vbop, [IR_VDIV] = ei_vbop,
+    [IR_VSPLAT] = ei_vsplat,
   };
 
   for (int i = 0; i < bbcon->bbs->len; ++i) {
@@ -1178,6 +1321,10 @@ static void convert_3to2(FuncBackend *fnbe) {
       case IR_LSHIFT:
       case IR_RSHIFT:
       case IR_BITNOT:
+      case IR_VADD:
+      case IR_VSUB:
+      case IR_VMUL:
+      case IR_VDIV:
         {
           assert(!(ir->dst->flag & VRF_CONST));
           IR *mov = new_ir_mov(ir->dst, ir->opr1, ir->flag);
@@ -1221,6 +1368,15 @@ void tweak_irs(FuncBackend *fnbe) {
           insert_const_mov(&ir->opr2, ra, irs, j++);
         break;
 
+      case IR_MEMCPY:
+      case IR_CLEAR:
+        // Block operations take addresses in registers.
+        if (ir->opr1->flag & VRF_CONST)
+          insert_const_mov(&ir->opr1, ra, irs, j++);
+        if (ir->opr2 != NULL && (ir->opr2->flag & VRF_CONST))
+          insert_const_mov(&ir->opr2, ra, irs, j++);
+        break;
+
       case IR_TJMP:
         {
           // Allocate temporary register to use calculation.
@@ -1238,6 +1394,10 @@ void tweak_irs(FuncBackend *fnbe) {
           insert_const_mov(&ir->opr1, ra, irs, j++);
         }
         break;
+      case IR_VSPLAT:
+        if (ir->opr1->flag & VRF_CONST)
+          insert_const_mov(&ir->opr1, ra, irs, j++);
+        break;
 
       default: break;
       }
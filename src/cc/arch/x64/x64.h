@@ -177,6 +177,9 @@
 #define CWTL()         EMIT_ASM("cwtl")
 #define CLTD()         EMIT_ASM("cltd")
 #define CQTO()         EMIT_ASM("cqto")
+#define REP()          EMIT_ASM("rep")
+#define MOVSB()        EMIT_ASM("movsb")
+#define STOSB()        EMIT_ASM("stosb")
 
 
 // SIMD
@@ -204,3 +207,26 @@
 
 #define CVTSD2SS(o1, o2)   EMIT_ASM("cvtsd2ss", o1, o2)  // double->single
 #define CVTSS2SD(o1, o2)   EMIT_ASM("cvtss2sd", o1, o2)  // single->double
+
+#define MOVUPS(o1, o2)     EMIT_ASM("movups", o1, o2)
+#define MOVAPS(o1, o2)     EMIT_ASM("movaps", o1, o2)
+#define MOVD(o1, o2)       EMIT_ASM("movd", o1, o2)
+
+// Packed
+#define ADDPS(o1, o2)      EMIT_ASM("addps", o1, o2)
+#define ADDPD(o1, o2)      EMIT_ASM("addpd", o1, o2)
+#define SUBPS(o1, o2)      EMIT_ASM("subps", o1, o2)
+#define SUBPD(o1, o2)      EMIT_ASM("subpd", o1, o2)
+#define MULPS(o1, o2)      EMIT_ASM("mulps", o1, o2)
+#define MULPD(o1, o2)      EMIT_ASM("mulpd", o1, o2)
+#define DIVPS(o1, o2)      EMIT_ASM("divps", o1, o2)
+#define DIVPD(o1, o2)      EMIT_ASM("divpd", o1, o2)
+#define PADDD(o1, o2)      EMIT_ASM("paddd", o1, o2)
+#define PADDQ(o1, o2)      EMIT_ASM("paddq", o1, o2)
+#define PSUBD(o1, o2)      EMIT_ASM("psubd", o1, o2)
+#define PSUBQ(o1, o2)      EMIT_ASM("psubq", o1, o2)
+#define UNPCKLPS(o1, o2)   EMIT_ASM("unpcklps", o1, o2)
+#define UNPCKLPD(o1, o2)   EMIT_ASM("unpcklpd", o1, o2)
+#define MOVLHPS(o1, o2)    EMIT_ASM("movlhps", o1, o2)
+#define PUNPCKLDQ(o1, o2)  EMIT_ASM("punpckldq", o1, o2)
+#define PUNPCKLQDQ(o1, o2) EMIT_ASM("punpcklqdq", o1, o2)
@@ -13,6 +13,7 @@
 #include "fe_misc.h"  // curfunc, curscope
 #include "ir.h"
 #include "optimize.h"
+#include "profile.h"
 #include "regalloc.h"
 #include "table.h"
 #include "type.h"
@@ -202,6 +203,16 @@ static enum VRegSize get_elem_vtype(const Type *type) {
   return most_significant_bit(s);
 }
 
+// Whether the backend expands block copy/clear of the size by itself.
+static bool is_inline_memop(size_t size) {
+#if defined(MEMOP_INLINE_MAX)
+  return size <= MEMOP_INLINE_MAX;
+#else
+  UNUSED(size);
+  return true;
+#endif
+}
+
 void gen_memcpy(const Type *type, VReg *dst, VReg *src) {
   size_t size = type_size(type);
   if (size == 0)
@@ -212,6 +223,8 @@ void gen_memcpy(const Type *type, VReg *dst, VReg *src) {
   if (count == 1) {
     VReg *tmp = new_ir_load(src, elem_vsize, to_vflag(type), 0);
     new_ir_store(dst, tmp, 0);
+  } else if (is_inline_memop(size)) {
+    new_ir_memcpy(dst, src, size, 1 << elem_vsize);
   } else {
     VReg *srcp = add_new_vreg(&tyVoidPtr);
     new_ir_mov(srcp, src, IRF_UNSIGNED);
@@ -246,6 +259,8 @@ static void gen_clear(const Type *type, VReg *dst) {
   VReg *vzero = new_const_vreg(0, elem_vtype);
   if (count == 1) {
     new_ir_store(dst, vzero, 0);
+  } else if (is_inline_memop(size)) {
+    new_ir_clear(dst, size, 1 << elem_vtype);
   } else {
     VReg *dstp = add_new_vreg(&tyVoidPtr);
     new_ir_mov(dstp, dst, IRF_UNSIGNED);
@@ -558,6 +573,8 @@ static void gen_for(Stmt *stmt) {
   if (stmt->for_.pre != NULL)
     gen_expr_stmt(stmt->for_.pre);
 
+  // Vectorized loop runs first if possible, then the scalar one handles the rest.
+  gen_vectorized_loop(stmt);
   new_ir_jmp(cond_bb);
 
   set_curbb(loop_bb);
@@ -927,13 +944,20 @@ extern inline void gen_defun_after(Function *func) {
   FuncBackend *fnbe = func->extra;
   curfunc = func;
 
+  report_phase_begin("optimize");
   optimize(fnbe->ra, fnbe->bbcon);
+  report_phase_end();
+  apply_profile(func);
 
   prepare_register_allocation(func);
+  report_phase_begin("tweak_irs");
   tweak_irs(fnbe);
+  report_phase_end();
   analyze_reg_flow(fnbe->bbcon);
 
+  report_phase_begin("alloc_physical_registers");
   alloc_physical_registers(fnbe->ra, fnbe->bbcon);
+  report_phase_end();
   map_virtual_to_physical_registers(fnbe->ra);
   detect_living_registers(fnbe->ra, fnbe->bbcon);
 
@@ -950,8 +974,12 @@ static void gen_decl(Declaration *decl) {
   case DCL_DEFUN:
     {
       Function *func = decl->defun.func;
-      if (gen_defun(func))
+      double start = time_report ? report_clock() : 0;
+      if (gen_defun(func)) {
         gen_defun_after(func);
+        if (time_report)
+          ((FuncBackend*)func->extra)->time = report_clock() - start;
+      }
     }
     break;
   case DCL_VARDECL:
@@ -20,6 +20,8 @@ typedef struct Vector Vector;
 
 // Public
 
+extern bool vectorize_loops;  // -fvectorize (default for -O2 and above), -fno-vectorize
+
 void gen(Vector *decls);
 
 // Private
@@ -44,6 +46,7 @@ void add_builtin_function(const char *str, Type *type, BuiltinFunctionProc *proc
                           bool add_to_scope);
 
 void gen_clear_local_var(const VarInfo *varinfo);
+void gen_vectorized_loop(Stmt *stmt);
 void gen_memcpy(const Type *type, VReg *dst, VReg *src);
 
 typedef struct {
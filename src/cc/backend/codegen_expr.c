@@ -525,42 +525,52 @@ static VReg *gen_funcall(Expr *expr) {
   int total_arg_count = arg_count + (ret_varinfo != NULL ? 1 : 0);
   VReg **arg_vregs = total_arg_count == 0 ? NULL : calloc_or_die(total_arg_count * sizeof(*arg_vregs));
 
+  {
+    // Stack arguments: Store them before setting register arguments,
+    // because block copy might break parameter registers.
+    for (int i = arg_count; --i >= 0; ) {
+      const ArgInfo *p = &arg_infos[i];
+      if (p->offset < 0)
+        continue;
+      Expr *arg = args->data[i];
+      VReg *vreg = gen_expr(arg);
+      enum VRegSize offset_type = 2;  //{.size = 4, .align = 4};  // TODO:
+      VReg *dst = new_ir_sofs(new_const_vreg(p->offset, offset_type));
+      if (is_stack_param(arg->type)) {
+        gen_memcpy(arg->type, dst, vreg);
+      } else {
+        int flag = is_unsigned(arg->type) ? IRF_UNSIGNED : 0;
+        new_ir_store(dst, vreg, flag);
+      }
+      arg_vregs[i + arg_start] = vreg;
+    }
+  }
   {
     // Register arguments.
     int iregarg = 0;
     int fregarg = 0;
     for (int i = arg_count; --i >= 0; ) {
+      const ArgInfo *p = &arg_infos[i];
+      if (p->offset >= 0)
+        continue;
       Expr *arg = args->data[i];
       VReg *vreg = gen_expr(arg);
-      const ArgInfo *p = &arg_infos[i];
-      if (p->offset < 0) {
-        if (p->is_flo) {
-          ++fregarg;
-          int index = freg_arg_count - fregarg;
-          assert(index < MAX_FREG_ARGS);
-          new_ir_pusharg(vreg, index);
-        } else {
-          ++iregarg;
-          int index = reg_arg_count - iregarg + arg_start;
-          assert(index < MAX_REG_ARGS);
-          IR *ir = new_ir_pusharg(vreg, index);
+      if (p->is_flo) {
+        ++fregarg;
+        int index = freg_arg_count - fregarg;
+        assert(index < MAX_FREG_ARGS);
+        new_ir_pusharg(vreg, index);
+      } else {
+        ++iregarg;
+        int index = reg_arg_count - iregarg + arg_start;
+        assert(index < MAX_REG_ARGS);
+        IR *ir = new_ir_pusharg(vreg, index);
 #if !VAARG_FP_AS_GP
-          UNUSED(ir);
+        UNUSED(ir);
 #else
-          if (p->fp_as_gp)
-            ir->pusharg.fp_as_gp = true;
+        if (p->fp_as_gp)
+          ir->pusharg.fp_as_gp = true;
 #endif
-        }
-      } else {
-        enum VRegSize offset_type = 2;  //{.size = 4, .align = 4};  // TODO:
-        int ofs = p->offset;
-        VReg *dst = new_ir_sofs(new_const_vreg(ofs, offset_type));
-        if (is_stack_param(arg->type)) {
-          gen_memcpy(arg->type, dst, vreg);
-        } else {
-          int flag = is_unsigned(arg->type) ? IRF_UNSIGNED : 0;
-          new_ir_store(dst, vreg, flag);
-        }
       }
       arg_vregs[i + arg_start] = vreg;
     }
@@ -6,11 +6,13 @@
 #include <stdarg.h>
 #include <stdint.h>  // int64_t
 #include <stdlib.h>  // realloc
+#include <string.h>  // memchr
 
 #include "ast.h"
 #include "cc_misc.h"
 #include "fe_misc.h"
 #include "ir.h"
+#include "profile.h"
 #include "table.h"
 #include "type.h"
 #include "util.h"
@@ -18,6 +20,9 @@
 
 static FILE *emit_fp;
 
+bool function_sections;
+bool data_sections;
+
 char *fmt(const char *fm, ...) {
 #define N  8
 #define MIN_SIZE  16
@@ -148,6 +153,25 @@ void emit_bss(const char *label, size_t size, size_t align) {
   fprintf(emit_fp, "\t.comm %s, %zu, %zu\n", label, size, align);
 }
 
+// Switch to the text section.
+// With -ffunction-sections, each function gets its own section `.text.<name>`
+// so that the linker can drop unreferenced ones. `funcname` is NULL to go back
+// to the section of the function being emitted.
+void emit_text(const Name *funcname) {
+#if XCC_TARGET_PLATFORM != XCC_PLATFORM_APPLE
+  static const Name *current_funcname;
+  if (funcname != NULL)
+    current_funcname = funcname;
+  if (function_sections && current_funcname != NULL) {
+    _SECTION(fmt(".text.%.*s,\"ax\"", NAMES(current_funcname)));
+    return;
+  }
+#else
+  UNUSED(funcname);
+#endif
+  EMIT_ASM(".text");
+}
+
 void init_emit(FILE *fp) {
   emit_fp = fp;
 }
@@ -231,6 +255,38 @@ static void emit_string(void *ud, Expr *str, size_t size) {
     _ASCII(escaped);
 }
 
+// With -fdata-sections, each initialized variable gets its own section.
+// Uninitialized ones are still emitted as `.comm` (they occupy no file space).
+static void emit_data_section(const Name *name, bool readonly) {
+#if XCC_TARGET_PLATFORM != XCC_PLATFORM_APPLE
+  if (data_sections) {
+    _SECTION(fmt("%s.%.*s,\"%s\"", readonly ? ".rodata" : ".data", NAMES(name),
+                 readonly ? "a" : "aw"));
+    return;
+  }
+#else
+  UNUSED(name);
+#endif
+  if (readonly)
+    _RODATA();
+  else
+    _DATA();
+}
+
+#if XCC_TARGET_PLATFORM != XCC_PLATFORM_APPLE
+// String literal without nul in the middle can be shared with the same one, or with the tail of
+// the longer one, in other units: The linker merges them in a `SHF_MERGE|SHF_STRINGS` section.
+static bool is_mergeable_string(const VarInfo *varinfo, const Initializer *init) {
+  if (!(varinfo->type->qualifier & TQ_FORSTRLITERAL) || init->kind != IK_SINGLE ||
+      init->single->kind != EX_STR)
+    return false;
+  const Expr *str = init->single;
+  size_t len = str->str.len;
+  return type_size(str->type->pa.ptrof) == 1 && len > 0 && len == type_size(varinfo->type) &&
+         memchr(str->str.buf, '\0', len) == &str->str.buf[len - 1];
+}
+#endif
+
 static void emit_varinfo(const VarInfo *varinfo, const Initializer *init) {
   static const ConstructInitialValueVTable kVtable = {
     .emit_align = emit_align,
@@ -240,10 +296,12 @@ static void emit_varinfo(const VarInfo *varinfo, const Initializer *init) {
 
   const Name *name = varinfo->name;
   if (init != NULL) {
-    if (varinfo->type->qualifier & TQ_CONST)
-      _RODATA();
+#if XCC_TARGET_PLATFORM != XCC_PLATFORM_APPLE
+    if (is_mergeable_string(varinfo, init))
+      _SECTION(".rodata.str1.1,\"aMS\",@progbits,1");
     else
-      _DATA();
+#endif
+      emit_data_section(name, varinfo->type->qualifier & TQ_CONST);
   }
 
   char *label = fmt_name(name);
@@ -361,6 +419,41 @@ static void emit_decls_ctor_dtor(Vector *decls) {
 #endif
 }
 
+static void emit_profile_counters(void) {
+  if (profile_counters == NULL || profile_counters->len <= 0)
+    return;
+
+  Vector *name_labels = new_vector();
+  emit_comment(NULL);
+  _RODATA();
+  for (int i = 0; i < profile_counters->len; ++i) {
+    ProfileCounters *pc = profile_counters->data[i];
+    const Name *label = alloc_label();
+    vec_push(name_labels, label);
+    EMIT_LABEL(fmt_name(label));
+    _STRING(fmt("\"%.*s\"", NAMES(pc->funcname)));
+  }
+
+  // Counters are gathered by the linker between `__xcc_prof_start` and `__xcc_prof_end`.
+  emit_comment(NULL);
+  _SECTION(".xcc_prof,\"aw\"");
+  EMIT_ALIGN(8);
+  for (int i = 0; i < profile_counters->len; ++i) {
+    ProfileCounters *pc = profile_counters->data[i];
+    _QUAD(fmt_name(name_labels->data[i]));
+    _QUAD(num(pc->count));
+    EMIT_LABEL(fmt_name(pc->label));
+    for (int j = 0; j < pc->count; ++j)
+      _QUAD("0");
+  }
+
+  // Runtime registers the dump function to `atexit`.
+  emit_comment(NULL);
+  _SECTION(".init_array");
+  EMIT_ALIGN(8);
+  _QUAD(quote_label(MANGLE("__xcc_prof_init")));
+}
+
 void emit_code(Vector *decls) {
   for (int i = 0, len = decls->len; i < len; ++i) {
     Declaration *decl = decls->data[i];
@@ -369,7 +462,14 @@ void emit_code(Vector *decls) {
 
     switch (decl->kind) {
     case DCL_DEFUN:
-      emit_defun(decl->defun.func);
+      {
+        Function *func = decl->defun.func;
+        double start = time_report ? report_clock() : 0;
+        emit_defun(func);
+        FuncBackend *fnbe = func->extra;
+        if (time_report && fnbe != NULL)
+          report_function(func->name, fnbe->time + report_clock() - start);
+      }
       break;
     case DCL_VARDECL:
       break;
@@ -380,6 +480,7 @@ void emit_code(Vector *decls) {
   }
 
   emit_decls_ctor_dtor(decls);
+  emit_profile_counters();
 
   emit_comment(NULL);
   for (int i = 0; i < global_scope->vars->len; ++i) {
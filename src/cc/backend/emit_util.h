@@ -44,6 +44,10 @@ void emit_asm4(const char *op, const char *a1, const char *a2, const char *a3, c
 void emit_align_p2(int align);
 void emit_comment(const char *comment, ...);
 void emit_bss(const char *label, size_t size, size_t align);
+void emit_text(const Name *funcname);
+
+extern bool function_sections;  // -ffunction-sections
+extern bool data_sections;  // -fdata-sections
 
 bool function_not_returned(FuncBackend *fnbe);
 
@@ -57,7 +61,7 @@ bool function_not_returned(FuncBackend *fnbe);
 #define _ASCII(x)      EMIT_ASM(".ascii", x)
 #define _STRING(x)     EMIT_ASM(".string", x)
 #define _SECTION(x)    EMIT_ASM(".section", x)
-#define _TEXT()        EMIT_ASM(".text")
+#define _TEXT()        emit_text(NULL)
 #define _DATA()        EMIT_ASM(".data")
 
 #define EMIT_ALIGN(x)  emit_align_p2(x)
@@ -223,6 +223,21 @@ void new_ir_store(VReg *dst, VReg *src, int flag) {
   ir->flag = flag;
 }
 
+void new_ir_memcpy(VReg *dst, VReg *src, size_t size, int align) {
+  IR *ir = new_ir(IR_MEMCPY);
+  ir->opr1 = src;
+  ir->opr2 = dst;  // `dst` is used by indirect, so it is not actually `dst`.
+  ir->memop.size = size;
+  ir->memop.align = align;
+}
+
+void new_ir_clear(VReg *dst, size_t size, int align) {
+  IR *ir = new_ir(IR_CLEAR);
+  ir->opr1 = dst;
+  ir->memop.size = size;
+  ir->memop.align = align;
+}
+
 VReg *new_ir_cond(VReg *opr1, VReg *opr2, enum ConditionKind cond) {
   IR *ir = new_ir(IR_COND);
   ir->opr1 = opr1;
@@ -333,6 +348,25 @@ void new_ir_asm(const char *asm_, VReg *dst) {
   ir->dst = dst;
 }
 
+VReg *new_ir_vbop(enum IrKind kind, VReg *opr1, VReg *opr2, enum VRegSize elem, bool flonum) {
+  assert(IR_VADD <= kind && kind <= IR_VDIV);
+  assert(opr1->vsize == VRegSize16 && opr2->vsize == VRegSize16);
+  IR *ir = new_ir(kind);
+  ir->opr1 = opr1;
+  ir->opr2 = opr2;
+  ir->vec.elem = elem;
+  ir->vec.flonum = flonum;
+  return ir->dst = reg_alloc_spawn(curra, VRegSize16, VRF_FLONUM);
+}
+
+VReg *new_ir_vsplat(VReg *opr, enum VRegSize elem) {
+  IR *ir = new_ir(IR_VSPLAT);
+  ir->opr1 = opr;
+  ir->vec.elem = elem;
+  ir->vec.flonum = (opr->flag & VRF_FLONUM) != 0;
+  return ir->dst = reg_alloc_spawn(curra, VRegSize16, VRF_FLONUM);
+}
+
 IR *new_ir_load_spilled(VReg *vreg, VReg *src, int flag) {
   IR *ir = new_ir(IR_LOAD_S);
   ir->dst = vreg;
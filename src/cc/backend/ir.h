@@ -23,6 +23,7 @@ enum VRegSize {
   VRegSize2,
   VRegSize4,
   VRegSize8,
+  VRegSize16,  // 128-bit vector, lives in floating-point register.
 };
 
 #define VRF_PARAM     (1 << 0)  // Function parameter
@@ -65,6 +66,8 @@ enum IrKind {
   IR_LOAD_S,  // dst = [opr1(spilled)]
   IR_STORE,   // [opr2] = opr1
   IR_STORE_S, // [opr2(spilled)] = opr1
+  IR_MEMCPY,  // [opr2] = [opr1], memop.size bytes
+  IR_CLEAR,   // [opr1] = 0, memop.size bytes
   IR_ADD,     // dst = opr1 + opr2
   IR_SUB,
   IR_MUL,
@@ -89,6 +92,11 @@ enum IrKind {
   IR_MOV,     // dst = opr1
   IR_KEEP,    // To keep live vregs.
   IR_ASM,     // assembler code
+  IR_VADD,    // dst = opr1 + opr2, for each lane (vec.elem)
+  IR_VSUB,
+  IR_VMUL,
+  IR_VDIV,
+  IR_VSPLAT,  // dst = {opr1, opr1, ...}
 };
 
 // ConditionKind occupies lower bits and bitOR-ed with COND_UNSIGNED or COND_FLONUM.
@@ -168,9 +176,17 @@ typedef struct IR {
       int vaarg_start;
       bool global;
     } call;
+    struct {
+      size_t size;
+      int align;
+    } memop;
     struct {
       const char *str;
     } asm_;
+    struct {
+      enum VRegSize elem;
+      bool flonum;
+    } vec;
   };
 } IR;
 
@@ -184,6 +200,8 @@ VReg *new_ir_bofs(FrameInfo *fi);
 VReg *new_ir_iofs(const Name *label, bool global);
 VReg *new_ir_sofs(VReg *src);
 void new_ir_store(VReg *dst, VReg *src, int flag);
+void new_ir_memcpy(VReg *dst, VReg *src, size_t size, int align);
+void new_ir_clear(VReg *dst, size_t size, int align);
 VReg *new_ir_cond(VReg *opr1, VReg *opr2, enum ConditionKind cond);
 void new_ir_jmp(BB *bb);  // Non-conditional jump
 void new_ir_cjmp(VReg *opr1, VReg *opr2, enum ConditionKind cond, BB *bb);  // Conditional jump
@@ -198,6 +216,8 @@ void new_ir_subsp(VReg *value, VReg *dst);
 IR *new_ir_cast(VReg *vreg, enum VRegSize dstsize, int vflag);
 IR *new_ir_keep(VReg *dst, VReg *opr1, VReg *opr2);
 void new_ir_asm(const char *asm_, VReg *dst);
+VReg *new_ir_vbop(enum IrKind kind, VReg *opr1, VReg *opr2, enum VRegSize elem, bool flonum);
+VReg *new_ir_vsplat(VReg *opr, enum VRegSize elem);
 
 IR *new_ir_load_spilled(VReg *vreg, VReg *src, int flag);
 IR *new_ir_store_spilled(VReg *dst, VReg *vreg);
@@ -247,6 +267,7 @@ typedef struct FuncBackend {
   VReg *result_dst;
   size_t frame_size;
   FrameInfo vaarg_frame_info;  // Used for va_start.
+  double time;  // Backend time in seconds, for -ftime-report.
 } FuncBackend;
 
 //
@@ -2,6 +2,7 @@
 #include "optimize.h"
 
 #include <assert.h>
+#include <stdint.h>  // intptr_t
 #include <stdlib.h>  // free
 
 #include "ir.h"
@@ -136,6 +137,120 @@ static void remove_unnecessary_bb(BBContainer *bbcon) {
 
 //
 
+// Returns the block which `bb` falls into without jump.
+static BB *fallthrough_bb(BB *bb) {
+  int len = bb->irs->len;
+  if (len > 0) {
+    IR *ir = bb->irs->data[len - 1];
+    if ((ir->kind == IR_JMP && ir->jmp.cond == COND_ANY) || ir->kind == IR_TJMP)
+      return NULL;
+  }
+  return bb->next;
+}
+
+static int pick_hot_successor(BB *bb, Table *indices, const int64_t *counts, const bool *placed) {
+  BB *succs[2] = {fallthrough_bb(bb), NULL};
+  IR *ir = is_last_jmp(bb);
+  if (ir != NULL)
+    succs[1] = ir->jmp.bb;
+
+  int best = -1;
+  for (int i = 0; i < 2; ++i) {  // Fallthrough one wins a tie.
+    void *p;
+    if (succs[i] == NULL || !table_try_get(indices, succs[i]->label, &p))
+      continue;
+    int index = (intptr_t)p;
+    if (!placed[index] && counts[index] > 0 && (best < 0 || counts[index] > counts[best]))
+      best = index;
+  }
+  return best;
+}
+
+// Reorder basic blocks using execution counts, so that hot paths fall through
+// and never executed blocks go to the end of the function.
+// Entry and last (return) block stay in place.
+void reorder_bbs(BBContainer *bbcon, const int64_t *counts) {
+  Vector *bbs = bbcon->bbs;
+  int n = bbs->len;
+  if (n <= 2 || counts[0] <= 0)
+    return;
+
+  Table indices;
+  table_init(&indices);
+  BB **fallthroughs = malloc_or_die(sizeof(*fallthroughs) * n);
+  for (int i = 0; i < n; ++i) {
+    BB *bb = bbs->data[i];
+    table_put(&indices, bb->label, (void*)(intptr_t)i);
+    fallthroughs[i] = fallthrough_bb(bb);
+  }
+
+  // Greedy chaining: Follow the hottest successor, or restart from the first hot one.
+  bool *placed = calloc_or_die(sizeof(*placed) * n);
+  Vector *order = new_vector();
+  placed[n - 1] = true;
+  for (int cur = 0; cur >= 0; ) {
+    placed[cur] = true;
+    vec_push(order, bbs->data[cur]);
+
+    int next = pick_hot_successor(bbs->data[cur], &indices, counts, placed);
+    if (next < 0) {
+      for (int i = 1; i < n; ++i) {
+        if (!placed[i] && counts[i] > 0) {
+          next = i;
+          break;
+        }
+      }
+    }
+    cur = next;
+  }
+  for (int i = 1; i < n; ++i) {  // Cold blocks, including the last one.
+    if (!placed[i] || i == n - 1)
+      vec_push(order, bbs->data[i]);
+  }
+  assert(order->len == n);
+
+  // Fix up control flow for new order.
+  BB *save_curbb = curbb;
+  for (int i = 0; i < order->len; ++i) {
+    BB *bb = order->data[i];
+    BB *next = i + 1 < order->len ? order->data[i + 1] : NULL;
+    BB *fall = NULL;
+    void *p;
+    if (table_try_get(&indices, bb->label, &p))
+      fall = fallthroughs[(intptr_t)p];
+
+    IR *ir = is_last_jmp(bb);
+    if (ir != NULL && ir->jmp.cond == COND_ANY) {
+      if (ir->jmp.bb == next)
+        vec_pop(bb->irs);
+    } else if (fall != NULL && fall != next) {
+      if (ir != NULL && ir->jmp.bb == next && !(ir->jmp.cond & COND_FLONUM)) {
+        ir->jmp.cond = invert_cond(ir->jmp.cond);
+        ir->jmp.bb = fall;
+      } else {
+        BB *jbb = bb;
+        if (ir != NULL) {
+          // Conditional jump must be at the bottom, so put new jump into trampoline block.
+          jbb = new_bb();
+          vec_insert(order, i + 1, jbb);
+          next = jbb;
+        }
+        curbb = jbb;
+        new_ir_jmp(fall);
+      }
+    }
+    bb->next = next;
+  }
+  curbb = save_curbb;
+
+  bbcon->bbs = order;
+  free(placed);
+  free(fallthroughs);
+  detect_from_bbs(bbcon);
+}
+
+//
+
 static void remove_unused_vregs(RegAlloc *ra, BBContainer *bbcon) {
   int vreg_count = ra->vregs->len;
   unsigned char *vreg_read = malloc_or_die(vreg_count);
@@ -1,6 +1,13 @@
 #pragma once
 
+#include <stdint.h>  // int64_t
+
+#include "ir.h"  // enum ConditionKind
+
 typedef struct BBContainer BBContainer;
 typedef struct RegAlloc RegAlloc;
 
+enum ConditionKind invert_cond(enum ConditionKind cond);
+
 void optimize(RegAlloc *ra, BBContainer *bbcon);
+void reorder_bbs(BBContainer *bbcon, const int64_t *counts);
@@ -0,0 +1,128 @@
+#include "../../config.h"
+#include "profile.h"
+
+#include <assert.h>
+#include <stdint.h>  // int64_t
+#include <stdio.h>
+#include <stdlib.h>  // strtoll
+#include <string.h>
+
+#include "ast.h"
+#include "ir.h"
+#include "optimize.h"
+#include "regalloc.h"
+#include "table.h"
+#include "util.h"
+
+bool profile_generate;
+Vector *profile_counters;
+
+typedef struct {
+  int count;
+  int64_t *counters;
+} FuncProfile;
+
+static Table *profile_table;  // <FuncProfile*>
+
+// Profile file is a text, each line holds counters for a function:
+//   name count c0 c1 ...
+void load_profile(const char *filename) {
+  FILE *fp = fopen(filename, "r");
+  if (fp == NULL)
+    error("Cannot open profile: %s", filename);
+
+  if (profile_table == NULL)
+    profile_table = alloc_table();
+
+  char *line = NULL;
+  size_t capa = 0;
+  while (getline(&line, &capa, fp) != -1) {
+    if (*line == '#' || *line == '\n')
+      continue;
+    char *p = strchr(line, ' ');
+    if (p == NULL)
+      error("Broken profile: %s", filename);
+    const Name *name = alloc_name(line, p, true);
+    char *q;
+    long count = strtol(p, &q, 10);
+    if (q == p || count <= 0)
+      error("Broken profile: %s", filename);
+
+    int64_t *counters = calloc_or_die(sizeof(*counters) * count);
+    for (long i = 0; i < count; ++i) {
+      p = q;
+      counters[i] = strtoll(p, &q, 10);
+      if (q == p)
+        error("Broken profile: %s", filename);
+    }
+
+    // Same name might appear for static functions in other units: Accumulate if possible.
+    FuncProfile *prof = table_get(profile_table, name);
+    if (prof == NULL) {
+      prof = malloc_or_die(sizeof(*prof));
+      prof->count = count;
+      prof->counters = counters;
+      table_put(profile_table, name, prof);
+    } else if (prof->count == count) {
+      for (long i = 0; i < count; ++i)
+        prof->counters[i] += counters[i];
+      free(counters);
+    }
+  }
+  free(line);
+  fclose(fp);
+}
+
+// Insert `++counters[i]` at the top of each basic block.
+// Last (return) block is not counted: It might hold the result in the physical register.
+static void insert_bb_counters(Function *func) {
+  FuncBackend *fnbe = func->extra;
+  BBContainer *bbcon = fnbe->bbcon;
+
+  ProfileCounters *pc = malloc_or_die(sizeof(*pc));
+  pc->funcname = func->name;
+  pc->label = alloc_label();
+  pc->count = bbcon->bbs->len;
+  if (profile_counters == NULL)
+    profile_counters = new_vector();
+  vec_push(profile_counters, pc);
+
+  BB *save_curbb = curbb;
+  RegAlloc *save_curra = curra;
+  curra = fnbe->ra;
+  for (int i = 0; i < bbcon->bbs->len - 1; ++i) {
+    BB *bb = bbcon->bbs->data[i];
+    Vector *irs = bb->irs;
+    bb->irs = new_vector();
+    curbb = bb;
+
+    VReg *adr = new_ir_iofs(pc->label, false);
+    ((IR*)bb->irs->data[bb->irs->len - 1])->iofs.offset = i * (int)sizeof(int64_t);
+    VReg *val = new_ir_load(adr, VRegSize8, 0, 0);
+    VReg *inc = new_ir_bop(IR_ADD, val, new_const_vreg(1, VRegSize8), VRegSize8, 0);
+    new_ir_store(adr, inc, 0);
+
+    for (int j = 0; j < irs->len; ++j)
+      vec_push(bb->irs, irs->data[j]);
+  }
+  curbb = save_curbb;
+  curra = save_curra;
+}
+
+void apply_profile(Function *func) {
+  if (profile_generate) {
+    insert_bb_counters(func);
+    return;
+  }
+
+  FuncProfile *prof;
+  if (profile_table == NULL || (prof = table_get(profile_table, func->name)) == NULL)
+    return;
+
+  BBContainer *bbcon = ((FuncBackend*)func->extra)->bbcon;
+  if (prof->count != bbcon->bbs->len) {
+    fprintf(stderr, "Warning: profile mismatch, ignored: %.*s\n", NAMES(func->name));
+    return;
+  }
+  reorder_bbs(bbcon, prof->counters);
+}
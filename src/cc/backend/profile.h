@@ -0,0 +1,23 @@
+// Profile guided optimization
+
+#pragma once
+
+#include <stdbool.h>
+
+typedef struct Function Function;
+typedef struct Name Name;
+typedef struct Vector Vector;
+
+// Basic block counters of an instrumented function.
+//   Emitted into `.xcc_prof` section as: {const char *name; long count; long counters[count];}
+typedef struct {
+  const Name *funcname;
+  const Name *label;  // Points to `counters`.
+  int count;
+} ProfileCounters;
+
+extern bool profile_generate;      // -fprofile-generate
+extern Vector *profile_counters;  // <ProfileCounters*>
+
+void load_profile(const char *filename);  // -fprofile-use=FILE
+void apply_profile(Function *func);
@@ -213,9 +213,10 @@ static void detect_live_interval_flags(RegAlloc *ra, BBContainer *bbcon, int vre
     for (int j = 0; j < bb->irs->len; ++j, ++nip) {
       IR *ir = bb->irs->data[j];
       if (settings->detect_extra_occupied != NULL) {
-        unsigned long ioccupy = (*settings->detect_extra_occupied)(ra, ir);
-        if (ioccupy != 0)
-          occupy_regs(ra, actives, ioccupy, 0);
+        unsigned long foccupy = 0;
+        unsigned long ioccupy = (*settings->detect_extra_occupied)(ra, ir, &foccupy);
+        if (ioccupy != 0 || foccupy != 0)
+          occupy_regs(ra, actives, ioccupy, foccupy);
       }
 
       if (iargset != 0 || fargset != 0)
@@ -374,9 +375,12 @@ static int insert_load_store_spilled_irs(RegAlloc *ra, BBContainer *bbcon) {
     [IR_MUL]     = D12, [IR_DIV]     = D12, [IR_MOD]     = D12, [IR_BITAND]  = D12,
     [IR_BITOR]   = D12, [IR_BITXOR]  = D12, [IR_LSHIFT]  = D12, [IR_RSHIFT]  = D12,
     [IR_NEG]     = D12, [IR_BITNOT]  = D12, [IR_COND]    = D12,
+    [IR_MEMCPY]  = D12, [IR_CLEAR]   = D12,
     [IR_JMP]     = D12, [IR_TJMP]    = D12, [IR_PRECALL] = D12, [IR_PUSHARG] = D12,
     [IR_CALL]    = D12, [IR_RESULT]  = D12, [IR_SUBSP]   = D12, [IR_CAST]    = D12,
     [IR_MOV]     = D12, [IR_KEEP]    = D12, [IR_ASM]     = D12,
+    [IR_VADD]    = D12, [IR_VSUB]    = D12, [IR_VMUL]    = D12, [IR_VDIV]    = D12,
+    [IR_VSPLAT]  = D12,
 
     [IR_BOFS]    = D__, [IR_IOFS]    = D__, [IR_SOFS]    = D__,
 
@@ -28,7 +28,8 @@ typedef struct LiveInterval {
 } LiveInterval;
 
 typedef struct RegAllocSettings {
-  unsigned long (*detect_extra_occupied)(RegAlloc *ra, IR *ir);
+  // Returns occupied integer registers, and floating-point ones through `pfoccupy`.
+  unsigned long (*detect_extra_occupied)(RegAlloc *ra, IR *ir, unsigned long *pfoccupy);
   const int *reg_param_mapping;
   int phys_max;              // Max physical register count.
   int phys_temporary_count;  // Temporary register count (= start index for saved registers)
@@ -0,0 +1,328 @@
+// Loop vectorizer
+//
+// Counted loops with unit stride, like
+//
+//   for (i = init; i < n; ++i)
+//     a[i] = b[i] * k + c[i];
+//
+// are emitted as a SIMD loop processing `VECTOR_REG_SIZE` bytes at once, followed by the
+// original scalar loop which handles the remaining iterations (and the whole loop when the
+// arrays overlap at run time).
+
+#include "../../config.h"
+#include "codegen.h"
+
+#include <assert.h>
+#include <stdlib.h>  // malloc
+
+#include "arch_config.h"
+#include "ast.h"
+#include "ir.h"
+#include "regalloc.h"
+#include "type.h"
+#include "util.h"
+#include "var.h"
+
+bool vectorize_loops;
+
+#if defined(VECTOR_REG_SIZE) && !defined(__NO_FLONUM)
+
+#define MAX_VEXPR_DEPTH  (8)
+
+typedef struct {
+  const VarInfo *index;     // Loop counter.
+  const Type *elem_type;
+  Expr *dst_addr;           // Address of the stored element.
+  const VarInfo *dst_tmp;   // Temporary which holds `dst_addr` for compound assignment.
+  Vector *bases;            // <Expr*>  Arrays read in the loop.
+  Vector *invariants;       // <Expr*>  Loop invariant scalars, broadcast to all lanes.
+  Vector *splats;           // <VReg*>  Corresponds to `invariants`.
+} VecLoop;
+
+static const VarInfo *find_var(Expr *expr) {
+  assert(expr->kind == EX_VAR);
+  return scope_find(expr->var.scope, expr->var.name, NULL);
+}
+
+// Local variable held in a register: Never modified through memory stores in the loop.
+static const VarInfo *register_var(Expr *expr) {
+  if (expr->kind != EX_VAR || is_global_scope(expr->var.scope))
+    return NULL;
+  const VarInfo *varinfo = find_var(expr);
+  if (varinfo == NULL || !is_local_storage(varinfo) || (varinfo->storage & VS_REF_TAKEN) ||
+      !is_prim_type(varinfo->type) || (varinfo->type->qualifier & TQ_VOLATILE))
+    return NULL;
+  return varinfo;
+}
+
+static bool is_vector_elem_type(const Type *type) {
+  if (type->qualifier & TQ_VOLATILE)
+    return false;
+  if (!is_fixnum(type->kind) && !is_flonum(type))
+    return false;
+  size_t size = type_size(type);
+  return size == 4 || size == 8;
+}
+
+static bool is_index_var(VecLoop *vl, Expr *expr) {
+  return expr->kind == EX_VAR && register_var(expr) == vl->index;
+}
+
+// `base + (size_t)i * sizeof(*base)`
+static Expr *element_base(VecLoop *vl, Expr *addr) {
+  if (addr->kind != EX_ADD || addr->type->kind != TY_PTR ||
+      !same_type_without_qualifier(addr->type->pa.ptrof, vl->elem_type, true))
+    return NULL;
+
+  Expr *idx = addr->bop.rhs;
+  if (idx->kind != EX_MUL || idx->bop.rhs->kind != EX_FIXNUM ||
+      idx->bop.rhs->fixnum != (Fixnum)type_size(vl->elem_type))
+    return NULL;
+  idx = idx->bop.lhs;
+  if (idx->kind == EX_CAST)
+    idx = idx->unary.sub;
+  if (!is_index_var(vl, idx))
+    return NULL;
+
+  Expr *base = addr->bop.lhs;
+  if (base->kind != EX_VAR)
+    return NULL;
+  if (base->type->kind == TY_ARRAY)
+    return base;
+  if (base->type->kind == TY_PTR && register_var(base) != NULL)
+    return base;
+  return NULL;
+}
+
+static Expr *element_addr(VecLoop *vl, Expr *deref) {
+  assert(deref->kind == EX_DEREF);
+  Expr *addr = deref->unary.sub;
+  if (vl->dst_tmp != NULL && addr->kind == EX_VAR && register_var(addr) == vl->dst_tmp)
+    return vl->dst_addr;
+  return addr;
+}
+
+static bool match_vexpr(VecLoop *vl, Expr *expr, int depth) {
+  if (depth > MAX_VEXPR_DEPTH ||
+      !same_type_without_qualifier(expr->type, vl->elem_type, true))
+    return false;
+
+  switch (expr->kind) {
+  case EX_FIXNUM:
+  case EX_FLONUM:
+    vec_push(vl->invariants, expr);
+    return true;
+  case EX_CAST:
+    // Only qualifier is dropped, e.g. `const T` to `T`.
+    return same_type_without_qualifier(expr->unary.sub->type, expr->type, true) &&
+        match_vexpr(vl, expr->unary.sub, depth + 1);
+  case EX_VAR:
+    if (register_var(expr) == NULL || is_index_var(vl, expr) ||
+        (vl->dst_tmp != NULL && register_var(expr) == vl->dst_tmp))
+      return false;
+    vec_push(vl->invariants, expr);
+    return true;
+  case EX_DEREF:
+    {
+      Expr *addr = element_addr(vl, expr);
+      if (addr == vl->dst_addr)
+        return true;
+      Expr *base = element_base(vl, addr);
+      if (base == NULL)
+        return false;
+      vec_push(vl->bases, base);
+    }
+    return true;
+  case EX_MUL:
+  case EX_DIV:
+    // No packed integer multiplication in SSE2.
+    if (!is_flonum(expr->type))
+      return false;
+    // Fallthrough
+  case EX_ADD:
+  case EX_SUB:
+    return match_vexpr(vl, expr->bop.lhs, depth + 1) && match_vexpr(vl, expr->bop.rhs, depth + 1);
+  default:
+    return false;
+  }
+}
+
+// `i < n`, `n` is a constant or a register variable.
+static Expr *match_cond(Expr *cond, Expr **pindex) {
+  Expr *index, *bound;
+  if (cond == NULL)
+    return NULL;
+  switch (cond->kind) {
+  case EX_LT:  index = cond->bop.lhs; bound = cond->bop.rhs; break;
+  case EX_GT:  index = cond->bop.rhs; bound = cond->bop.lhs; break;
+  default:  return NULL;
+  }
+  if (register_var(index) == NULL || !is_fixnum(index->type->kind) ||
+      !same_type(index->type, bound->type))
+    return NULL;
+  if (bound->kind != EX_FIXNUM && (register_var(bound) == NULL || find_var(bound) == find_var(index)))
+    return NULL;
+  *pindex = index;
+  return bound;
+}
+
+// `++i`, `i++` or `i += 1`
+static bool match_post(VecLoop *vl, Expr *post) {
+  if (post == NULL)
+    return false;
+  switch (post->kind) {
+  case EX_PREINC:
+  case EX_POSTINC:
+    return is_index_var(vl, post->unary.sub);
+  case EX_ASSIGN:
+    {
+      Expr *rhs = post->bop.rhs;
+      return is_index_var(vl, post->bop.lhs) && rhs->kind == EX_ADD &&
+             is_index_var(vl, rhs->bop.lhs) && rhs->bop.rhs->kind == EX_FIXNUM &&
+             rhs->bop.rhs->fixnum == 1;
+    }
+  default:
+    return false;
+  }
+}
+
+// `a[i] = expr` or `a[i] op= expr`. Returns the stored value.
+static Expr *match_body(VecLoop *vl, Stmt *body) {
+  if (body->kind == ST_BLOCK) {
+    if (body->block.stmts->len != 1)
+      return NULL;
+    body = body->block.stmts->data[0];
+  }
+  if (body->kind != ST_EXPR)
+    return NULL;
+
+  Expr *expr = body->expr;
+  if (expr->kind == EX_COMMA) {
+    // Compound assignment: `(tmp = &a[i], *tmp = *tmp op expr)`
+    Expr *lhs = expr->bop.lhs;
+    if (lhs->kind != EX_ASSIGN || (vl->dst_tmp = register_var(lhs->bop.lhs)) == NULL)
+      return NULL;
+    vl->dst_addr = lhs->bop.rhs;
+    expr = expr->bop.rhs;
+    if (expr->kind != EX_ASSIGN || expr->bop.lhs->kind != EX_DEREF ||
+        register_var(expr->bop.lhs->unary.sub) != vl->dst_tmp)
+      return NULL;
+  } else {
+    if (expr->kind != EX_ASSIGN || expr->bop.lhs->kind != EX_DEREF)
+      return NULL;
+    vl->dst_addr = expr->bop.lhs->unary.sub;
+  }
+
+  if (!is_vector_elem_type(expr->type))
+    return NULL;
+  vl->elem_type = expr->type;
+  if (element_base(vl, vl->dst_addr) == NULL)
+    return NULL;
+  return expr->bop.rhs;
+}
+
+static bool same_base(Expr *base1, Expr *base2) {
+  return find_var(base1) == find_var(base2);
+}
+
+static VReg *gen_vexpr(VecLoop *vl, Expr *expr) {
+  switch (expr->kind) {
+  case EX_CAST:
+    return gen_vexpr(vl, expr->unary.sub);
+  case EX_DEREF:
+    return new_ir_load(gen_expr(element_addr(vl, expr)), VRegSize16, VRF_FLONUM, 0);
+  case EX_ADD:
+  case EX_SUB:
+  case EX_MUL:
+  case EX_DIV:
+    {
+      VReg *lhs = gen_vexpr(vl, expr->bop.lhs);
+      VReg *rhs = gen_vexpr(vl, expr->bop.rhs);
+      return new_ir_vbop(expr->kind + (IR_VADD - EX_ADD), lhs, rhs, to_vsize(vl->elem_type),
+                         is_flonum(vl->elem_type));
+    }
+  default:
+    for (int i = 0; i < vl->invariants->len; ++i) {
+      if (vl->invariants->data[i] == expr)
+        return vl->splats->data[i];
+    }
+    assert(false);
+    return NULL;
+  }
+}
+
+// Emits the vectorized loop in front of the scalar one, if possible.
+// Loop counter is advanced so that the scalar loop continues from the remaining element.
+void gen_vectorized_loop(Stmt *stmt) {
+  assert(stmt->kind == ST_FOR);
+  if (!vectorize_loops)
+    return;
+
+  Expr *index;
+  Expr *bound = match_cond(stmt->for_.cond, &index);
+  if (bound == NULL)
+    return;
+
+  VecLoop vl = {
+    .index = find_var(index),
+    .bases = new_vector(),
+    .invariants = new_vector(),
+    .splats = new_vector(),
+  };
+  Expr *value;
+  if (!match_post(&vl, stmt->for_.post) || (value = match_body(&vl, stmt->for_.body)) == NULL ||
+      !match_vexpr(&vl, value, 0))
+    return;
+
+  const int lanes = VECTOR_REG_SIZE / type_size(vl.elem_type);
+  enum VRegSize elem = to_vsize(vl.elem_type);
+  Expr *dst_base = element_base(&vl, vl.dst_addr);
+  BB *vloop_bb = new_bb();
+  BB *vcond_bb = new_bb();
+  BB *scalar_bb = new_bb();
+
+  // Fall back to the scalar loop if a store would be read in a later lane:
+  //   0 < dst - src < VECTOR_REG_SIZE
+  for (int i = 0; i < vl.bases->len; ++i) {
+    Expr *base = vl.bases->data[i];
+    if (same_base(base, dst_base) ||
+        (base->type->kind == TY_ARRAY && dst_base->type->kind == TY_ARRAY))
+      continue;
+    VReg *diff = new_ir_bop(IR_SUB, gen_expr(dst_base), gen_expr(base), VRegSize8, IRF_UNSIGNED);
+    diff = new_ir_bop(IR_SUB, diff, new_const_vreg(1, VRegSize8), VRegSize8, IRF_UNSIGNED);
+    new_ir_cjmp(diff, new_const_vreg(VECTOR_REG_SIZE - 1, VRegSize8), COND_LT | COND_UNSIGNED,
+                scalar_bb);
+    set_curbb(new_bb());
+  }
+
+  // Broadcast loop invariants.
+  for (int i = 0; i < vl.invariants->len; ++i)
+    vec_push(vl.splats, new_ir_vsplat(gen_expr(vl.invariants->data[i]), elem));
+  new_ir_jmp(vcond_bb);
+
+  VReg *ireg = vl.index->local.vreg;
+  int iflag = index->type->fixnum.is_unsigned ? IRF_UNSIGNED : 0;
+
+  set_curbb(vloop_bb);
+  new_ir_store(gen_expr(vl.dst_addr), gen_vexpr(&vl, value), 0);
+  new_ir_mov(ireg, new_ir_bop(IR_ADD, ireg, new_const_vreg(lanes, ireg->vsize), ireg->vsize, iflag),
+             iflag);
+
+  // Continue while `lanes` elements remain: `i < n && n - i >= lanes`, without overflow.
+  set_curbb(vcond_bb);
+  VReg *nreg = gen_expr(bound);
+  new_ir_cjmp(ireg, nreg, COND_GE | (iflag ? COND_UNSIGNED : 0), scalar_bb);
+  set_curbb(new_bb());
+  VReg *rest = new_ir_bop(IR_SUB, nreg, ireg, ireg->vsize, IRF_UNSIGNED);
+  new_ir_cjmp(rest, new_const_vreg(lanes, ireg->vsize), COND_GE | COND_UNSIGNED, vloop_bb);
+
+  set_curbb(scalar_bb);
+}
+
+#else
+
+void gen_vectorized_loop(Stmt *stmt) {
+  UNUSED(stmt);
+}
+
+#endif
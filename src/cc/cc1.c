@@ -1,6 +1,7 @@
 #include "../config.h"
 
 #include <assert.h>
+#include <ctype.h>  // isdigit
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,6 +12,7 @@
 #include "fe_misc.h"
 #include "lexer.h"
 #include "parser.h"
+#include "profile.h"
 #include "type.h"
 #include "util.h"
 #include "var.h"
@@ -52,15 +54,23 @@ int main(int argc, char *argv[]) {
 
   static const struct option options[] = {
     {"W", required_argument, OPT_WARNING},
+    {"O", optional_argument},
+    {"f", required_argument, 'f'},
     {"-version", no_argument, 'V'},
     {NULL},
   };
+  int optimize_level = 0;
+  int vectorize = -1;  // -1: Decided by the optimization level.
   int opt;
   while ((opt = optparse(argc, argv, options)) != -1) {
     switch (opt) {
     case 'V':
       show_version("cc1");
       return 0;
+    case 'O':
+      // -O => 1, -O<n> => n, -Os, -Ofast... => 2
+      optimize_level = optarg == NULL ? 1 : isdigit(*optarg) ? atoi(optarg) : 2;
+      break;
     case OPT_WARNING:
       if (strcmp(optarg, "error") == 0) {
         error_warning = true;
@@ -69,16 +79,39 @@ int main(int argc, char *argv[]) {
         // fprintf(stderr, "Warning: unknown option for -W: %s\n", optarg);
       }
       break;
+    case 'f':
+      if (strcmp(optarg, "profile-generate") == 0) {
+#if XCC_TARGET_PLATFORM == XCC_PLATFORM_APPLE
+        error("-fprofile-generate is not supported on this platform");
+#else
+        profile_generate = true;
+#endif
+      } else if (strncmp(optarg, "profile-use=", 12) == 0) {
+        load_profile(optarg + 12);
+      } else if (strcmp(optarg, "vectorize") == 0 || strcmp(optarg, "no-vectorize") == 0) {
+        vectorize = *optarg != 'n';
+      } else if (strcmp(optarg, "function-sections") == 0) {
+        function_sections = true;
+      } else if (strcmp(optarg, "data-sections") == 0) {
+        data_sections = true;
+      } else if (parse_report_option(optarg)) {
+        // -ftime-report, -fmem-report
+      } else {
+        // Silently ignored.
+      }
+      break;
     default:
       fprintf(stderr, "Warning: unknown option: %s\n", argv[optind - 1]);
       break;
     }
   }
+  vectorize_loops = vectorize >= 0 ? vectorize : optimize_level >= 2;
 
   // Compile.
   init_compiler(stdout);
 
   Vector *toplevel = new_vector();
+  report_phase_begin("parse");
   int iarg = optind;
   if (iarg < argc) {
     for (int i = iarg; i < argc; ++i) {
@@ -92,13 +125,19 @@ int main(int argc, char *argv[]) {
   } else {
     compile1(stdin, "*stdin*", toplevel);
   }
+  report_phase_end();
   if (compile_error_count != 0)
     exit(1);
   if (error_warning && compile_warning_count != 0)
     exit(2);
 
+  report_phase_begin("gen");
   gen(toplevel);
+  report_phase_end();
+  report_phase_begin("emit_code");
   emit_code(toplevel);
+  report_phase_end();
 
+  dump_report("cc1");
   return 0;
 }
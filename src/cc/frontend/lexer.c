@@ -322,7 +322,7 @@ static int scan_linemarker(const char *line, long *pnum, char **pfn, int *pflag)
   return n;
 }
 
-static bool read_next_line(void) {
+static bool read_line(void) {
   if (lexer.fp == NULL || feof(lexer.fp))
     return lex_eof_continue();
 
@@ -360,6 +360,17 @@ static bool read_next_line(void) {
   return true;
 }
 
+// Tokens are fetched one by one on demand, which is too frequent to be timed: Line refills
+// are timed instead, as the "lex" phase nested in the caller's.
+static bool read_next_line(void) {
+  if (!time_report && !mem_report)
+    return read_line();
+  report_phase_begin("lex");
+  bool result = read_line();
+  report_phase_end();
+  return result;
+}
+
 static const char *skip_block_comment(const char *p) {
   for (;;) {
     p = block_comment_end(p);
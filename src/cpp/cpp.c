@@ -35,6 +35,7 @@ int main(int argc, char *argv[]) {
     {"isystem", required_argument, OPT_ISYSTEM},  // Add system include path
     {"idirafter", required_argument, OPT_IDIRAFTER},  // Add include path (after)
     {"D", required_argument},  // Define macro
+    {"f", required_argument},  // -ftime-report, -fmem-report
     {"-version", no_argument, 'V'},
     {0},
   };
@@ -56,10 +57,14 @@ int main(int argc, char *argv[]) {
     case 'D':
       define_macro(optarg);
       break;
+    case 'f':
+      parse_report_option(optarg);  // Others are silently ignored.
+      break;
     }
   }
 
   int iarg = optind;
+  report_phase_begin("preprocess");
   if (iarg < argc) {
     for (int i = iarg; i < argc; ++i) {
       const char *filename = argv[i];
@@ -72,5 +77,7 @@ int main(int argc, char *argv[]) {
   } else {
     preprocess(stdin, "*stdin*");
   }
+  report_phase_end();
+  dump_report("cpp");
   return 0;
 }
@@ -8,16 +8,42 @@
 #include "table.h"
 #include "util.h"
 
-static Elf64_Shdr *read_all_section_headers(FILE *fp, size_t start_offset, Elf64_Ehdr *ehdr) {
+void *elfobj_data(ElfObj *elfobj, size_t offset, size_t size, size_t align, const char *msg) {
+  if (elfobj->image != NULL) {
+    const unsigned char *p = elfobj->image + offset;
+    if (((uintptr_t)p & (align - 1)) == 0)
+      return (void*)p;
+    // Members in an archive are only 2-byte aligned: Copy to access the fields.
+    void *buf = malloc_or_die(size);
+    memcpy(buf, p, size);
+    return buf;
+  }
+  return read_or_die(elfobj->fp, NULL, offset + elfobj->start_offset, size, msg);
+}
+
+void elfobj_free_data(ElfObj *elfobj, const void *data, size_t offset) {
+  if (elfobj->image == NULL || (const unsigned char*)data != elfobj->image + offset)
+    free((void*)data);
+}
+
+void elfobj_read(ElfObj *elfobj, void *buf, size_t offset, size_t size, const char *msg) {
+  if (elfobj->image != NULL)
+    memcpy(buf, elfobj->image + offset, size);
+  else
+    read_or_die(elfobj->fp, buf, offset + elfobj->start_offset, size, msg);
+}
+
+static Elf64_Shdr *read_all_section_headers(ElfObj *elfobj) {
+  Elf64_Ehdr *ehdr = &elfobj->ehdr;
   if (ehdr->e_shnum <= 0)
     return NULL;
-  return read_or_die(fp, NULL, ehdr->e_shoff + start_offset,
-                     ehdr->e_shnum * sizeof(Elf64_Shdr), "read section header failed");
+  return elfobj_data(elfobj, ehdr->e_shoff, ehdr->e_shnum * sizeof(Elf64_Shdr),
+                     _Alignof(Elf64_Shdr), "read section header failed");
 }
 
-static char *read_strtab(FILE *fp, size_t start_offset, Elf64_Shdr *sec) {
+static char *read_strtab(ElfObj *elfobj, Elf64_Shdr *sec) {
   assert(sec->sh_type == SHT_STRTAB);
-  return read_or_die(fp, NULL, sec->sh_offset + start_offset, sec->sh_size, "read strtab failed");
+  return elfobj_data(elfobj, sec->sh_offset, sec->sh_size, 1, "read strtab failed");
 }
 
 static void load_symtab(ElfObj *elfobj) {
@@ -30,8 +56,8 @@ static void load_symtab(ElfObj *elfobj) {
     if (shdr->sh_size % sizeof(Elf64_Sym) != 0)
       error("illega symtab size");
 
-    Elf64_Sym *symbols = read_or_die(elfobj->fp, NULL, shdr->sh_offset + elfobj->start_offset,
-                                     shdr->sh_size, "read symtab failed");
+    Elf64_Sym *symbols = elfobj_data(elfobj, shdr->sh_offset, shdr->sh_size, _Alignof(Elf64_Sym),
+                                     "read symtab failed");
 
     ElfSectionInfo *p = &elfobj->section_infos[sec];
     p->symtab.syms = symbols;
@@ -44,7 +70,7 @@ static void load_symtab(ElfObj *elfobj) {
     if (strtab_sec->sh_type != SHT_STRTAB)
       error("malformed symtab");
 
-    const char *strbuf = read_strtab(elfobj->fp, elfobj->start_offset, strtab_sec);
+    const char *strbuf = read_strtab(elfobj, strtab_sec);
     if (strbuf == NULL)
       error("read strtab failed");
     elfobj->section_infos[shdr->sh_link].strtab.buf = strbuf;
@@ -65,11 +91,42 @@ static void load_symtab(ElfObj *elfobj) {
     error("no symtab");
 }
 
+static ElfObj *read_elf_sections(ElfObj *elfobj, const char *fn);
+
 ElfObj *read_elf(FILE *fp, const char *fn) {
   long start_offset = ftell(fp);
   Elf64_Ehdr ehdr;
-  ssize_t size = fread(&ehdr, sizeof(ehdr), 1, fp);
-  if (size != 1 || ehdr.e_ident[0] != ELFMAG0 || ehdr.e_ident[1] != ELFMAG1 ||
+  if (fread(&ehdr, sizeof(ehdr), 1, fp) != 1) {
+    fprintf(stderr, "no elf file: %s\n", fn);
+    return NULL;
+  }
+
+  ElfObj *elfobj = calloc_or_die(sizeof(*elfobj));
+  elfobj->fp = fp;
+  elfobj->image = NULL;
+  elfobj->start_offset = start_offset;
+  elfobj->ehdr = ehdr;
+  return read_elf_sections(elfobj, fn);
+}
+
+// Sections, symbols and strings point into `image` directly, so it must be kept mapped.
+ElfObj *read_elf_image(const unsigned char *image, size_t size, const char *fn) {
+  if (size < sizeof(Elf64_Ehdr)) {
+    fprintf(stderr, "no elf file: %s\n", fn);
+    return NULL;
+  }
+
+  ElfObj *elfobj = calloc_or_die(sizeof(*elfobj));
+  elfobj->fp = NULL;
+  elfobj->image = image;
+  elfobj->start_offset = 0;
+  memcpy(&elfobj->ehdr, image, sizeof(elfobj->ehdr));
+  return read_elf_sections(elfobj, fn);
+}
+
+static ElfObj *read_elf_sections(ElfObj *elfobj, const char *fn) {
+  Elf64_Ehdr ehdr = elfobj->ehdr;
+  if (ehdr.e_ident[0] != ELFMAG0 || ehdr.e_ident[1] != ELFMAG1 ||
       ehdr.e_ident[2] != ELFMAG2 || ehdr.e_ident[3] != ELFMAG3) {
     fprintf(stderr, "no elf file: %s\n", fn);
     return NULL;
@@ -81,14 +138,10 @@ ElfObj *read_elf(FILE *fp, const char *fn) {
     fprintf(stderr, "illegal elf: %s\n", fn);
     return NULL;
   }
-  Elf64_Shdr *shdrs = read_all_section_headers(fp, start_offset, &ehdr);
+  Elf64_Shdr *shdrs = read_all_section_headers(elfobj);
   if (shdrs == NULL)
     return NULL;
 
-  ElfObj *elfobj = calloc_or_die(sizeof(*elfobj));
-  elfobj->fp = fp;
-  elfobj->start_offset = start_offset;
-  elfobj->ehdr = ehdr;
   elfobj->shdrs = shdrs;
   elfobj->symbol_table = NULL;
   elfobj->symtab_section = NULL;
@@ -116,6 +169,12 @@ ElfObj *read_elf(FILE *fp, const char *fn) {
   }
   elfobj->prog_sections = prog_sections;
 
+  for (unsigned short i = 0; i < ehdr.e_shnum; ++i) {
+    Elf64_Shdr *shdr = &shdrs[i];
+    if (shdr->sh_type == SHT_RELA && shdr->sh_info < ehdr.e_shnum)
+      section_infos[shdr->sh_info].progbits.rela = &section_infos[i];
+  }
+
   load_symtab(elfobj);
 
   {
@@ -125,7 +184,7 @@ ElfObj *read_elf(FILE *fp, const char *fn) {
       return NULL;
     }
     if (shstrtab->strtab.buf == NULL) {
-      const char *buf = read_strtab(elfobj->fp, elfobj->start_offset, shstrtab->shdr);
+      const char *buf = read_strtab(elfobj, shstrtab->shdr);
       if (buf == NULL)
         error("read shstrtab failed");
       shstrtab->strtab.buf = buf;
@@ -21,6 +21,10 @@ typedef struct ElfSectionInfo {
     struct {
       uintptr_t address;
       unsigned char *content;
+      struct ElfSectionInfo *rela;  // Relocations applied to this section, or NULL.
+      bool live;  // Reachable from the roots, for --gc-sections.
+      struct MergedStrings *merged;  // Strings are moved into the merged section, or NULL.
+      struct ElfSectionInfo *folded;  // Identical section placed instead of this (--icf), or NULL.
     } progbits;
     struct {
       const char *buf;
@@ -34,6 +38,7 @@ typedef struct ElfSectionInfo {
 
 typedef struct ElfObj {
   FILE *fp;
+  const unsigned char *image;  // Mapped file content, or NULL to read through `fp`.
   size_t start_offset;
   Elf64_Ehdr ehdr;
   Elf64_Shdr *shdrs;
@@ -45,5 +50,11 @@ typedef struct ElfObj {
 } ElfObj;
 
 ElfObj *read_elf(FILE *fp, const char *fn);
+ElfObj *read_elf_image(const unsigned char *image, size_t size, const char *fn);
 void close_elf(ElfObj *elfobj);
 Elf64_Sym *elfobj_find_symbol(ElfObj *elfobj, const Name *name);
+// Returns pointer into the mapped image if it is aligned, otherwise reads into a new buffer.
+void *elfobj_data(ElfObj *elfobj, size_t offset, size_t size, size_t align, const char *msg);
+// Releases `data` from `elfobj_data` at the offset, if it is not in the image.
+void elfobj_free_data(ElfObj *elfobj, const void *data, size_t offset);
+void elfobj_read(ElfObj *elfobj, void *buf, size_t offset, size_t size, const char *msg);
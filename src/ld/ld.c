@@ -9,7 +9,15 @@
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>  // close, ftruncate, write
+
+#if !defined(__XCC)
+#define LD_USE_THREADS
+#include <pthread.h>
+#include <stdatomic.h>
+#endif
 
 #include "archive.h"
 #include "elfobj.h"
@@ -74,15 +82,29 @@ static LinkElem *new_link_elem(enum LinkElemKind kind) {
 typedef struct {
   size_t align;
   uintptr_t start_address;
-  DataStorage *ds;
+  size_t file_offset;
+  size_t filesz;
   size_t bss_size;
 } SectionGroup;
 
+// Output section to be filled: Sections are independent of each other once the addresses
+// are fixed, so they are processed in parallel.
+typedef struct {
+  ElfSectionInfo *section;
+  const Elf64_Rela *relas;  // Applied to `section`, or NULL.
+  int error_count;
+  uint32_t error_type;  // First unhandled relocation type.
+} SectionTask;
+
 typedef struct {
   File *files;
   int nfiles;
   Table *symbol_table;  // <ElfObj*>
   Table *generated_symbol_table;  // <LinkElem*>
+  Vector *unresolved_queue;  // <const Name*>, in the order of appearance
+  Vector *section_tasks;  // <SectionTask*>, in the order of the output
+  int nthreads;
+  bool gc_sections;
 } LinkEditor;
 
 void ld_init(LinkEditor *ld, int nfiles) {
@@ -92,6 +114,45 @@ void ld_init(LinkEditor *ld, int nfiles) {
   assert(ld->symbol_table != NULL);
   ld->generated_symbol_table = alloc_table();
   assert(ld->generated_symbol_table != NULL);
+  ld->unresolved_queue = new_vector();
+  ld->section_tasks = new_vector();
+  ld->nthreads = 1;
+  ld->gc_sections = false;
+}
+
+// Map whole input file read-only, to refer sections and symbols without copying.
+// Returns NULL if it cannot be mapped; then the caller reads it through FILE.
+static const unsigned char *map_input_file(const char *filename, size_t *psize) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  void *p = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0)
+    p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED)
+    return NULL;
+  *psize = st.st_size;
+  return p;
+}
+
+// Also used for members of a thin archive.
+static ElfObj *load_elf_file(const char *filename) {
+  if (!is_file(filename)) {
+    fprintf(stderr, "cannot open: %s\n", filename);
+    return NULL;
+  }
+  size_t size;
+  const unsigned char *image = map_input_file(filename, &size);
+  if (image != NULL)
+    return read_elf_image(image, size, filename);
+  FILE *fp = fopen(filename, "rb");
+  if (fp == NULL) {
+    fprintf(stderr, "cannot open: %s\n", filename);
+    return NULL;
+  }
+  return read_elf(fp, filename);
 }
 
 void ld_load(LinkEditor *ld, int i, const char *filename) {
@@ -99,21 +160,23 @@ void ld_load(LinkEditor *ld, int i, const char *filename) {
   File *file = &ld->files[i];
   file->filename = filename;
   if (strcasecmp(ext, "o") == 0) {
-    FILE *fp;
-    if (!is_file(filename) || (fp = fopen(filename, "rb")) == NULL) {
+    if (!is_file(filename)) {
       fprintf(stderr, "cannot open: %s\n", filename);
-    } else {
-      ElfObj *elfobj = read_elf(fp, filename);
-      if (elfobj == NULL)
-        exit(1);
-      file->kind = FK_ELFOBJ;
-      file->elfobj = elfobj;
+      return;
     }
+    ElfObj *elfobj = load_elf_file(filename);
+    if (elfobj == NULL)
+      exit(1);
+    file->kind = FK_ELFOBJ;
+    file->elfobj = elfobj;
   } else if (strcasecmp(ext, "a") == 0) {
     Archive *archive = load_archive(filename);
     if (archive == NULL) {
       error("load failed: %s\n", filename);
     }
+    size_t size;
+    if (!archive->thin)
+      archive->image = map_input_file(filename, &size);
     file->kind = FK_ARCHIVE;
     file->archive = archive;
   } else {
@@ -121,6 +184,45 @@ void ld_load(LinkEditor *ld, int i, const char *filename) {
   }
 }
 
+// Strings in `SHF_MERGE|SHF_STRINGS` sections are moved into the merged section.
+typedef struct MergedStrings {
+  const ElfSectionInfo *output;
+  const char *content;
+  int count;
+  Elf64_Xword *offsets;  // Start of each string in the input section, ascending.
+  Elf64_Xword *merged_offsets;  // Where the string is placed in `output`.
+  bool *live;  // Referred strings on --gc-sections, or NULL if all are kept.
+} MergedStrings;
+
+// Index of the string which holds `offset`.
+static int merged_string_index(const MergedStrings *merged, Elf64_Xword offset) {
+  int lo = 0, hi = merged->count;
+  while (hi - lo > 1) {
+    int m = (lo + hi) / 2;
+    if (merged->offsets[m] <= offset)
+      lo = m;
+    else
+      hi = m;
+  }
+  return lo;
+}
+
+// Offset in the merged section.
+static Elf64_Xword merged_string_offset(const ElfSectionInfo *section, Elf64_Xword offset) {
+  const MergedStrings *merged = section->progbits.merged;
+  int i = merged_string_index(merged, offset);
+  return merged->merged_offsets[i] + (offset - merged->offsets[i]);
+}
+
+static uintptr_t merged_string_address(const ElfSectionInfo *section, Elf64_Xword offset) {
+  return section->progbits.merged->output->progbits.address + merged_string_offset(section, offset);
+}
+
+// Section which is placed in the output instead of `section` (--icf).
+static const ElfSectionInfo *placed_section(const ElfSectionInfo *section) {
+  return section->progbits.folded != NULL ? section->progbits.folded : section;
+}
+
 static uintptr_t ld_symbol_address(LinkEditor *ld, const Name *name) {
   ElfObj *elfobj = table_get(ld->symbol_table, name);
   if (elfobj != NULL) {
@@ -131,7 +233,10 @@ static uintptr_t ld_symbol_address(LinkEditor *ld, const Name *name) {
       const Elf64_Shdr *tshdr = &elfobj->shdrs[sym->st_shndx];
       assert(tshdr->sh_type == SHT_PROGBITS || tshdr->sh_type == SHT_NOBITS);
 #endif
-      return elfobj->section_infos[sym->st_shndx].progbits.address + sym->st_value;
+      const ElfSectionInfo *s = &elfobj->section_infos[sym->st_shndx];
+      if (s->progbits.merged != NULL)
+        return merged_string_address(s, sym->st_value);
+      return placed_section(s)->progbits.address + sym->st_value;
     }
 
     switch (sym->st_shndx) {
@@ -184,10 +289,16 @@ static uintptr_t calc_rela_sym_address(LinkEditor *ld, ElfObj *elfobj, const Elf
     if (ELF64_ST_TYPE(sym->st_info) == STT_SECTION) {
       assert(ELF64_R_SYM(rela->r_info) < elfobj->ehdr.e_shnum);
       const ElfSectionInfo *s = &elfobj->section_infos[ELF64_R_SYM(rela->r_info)];
-      address = s->progbits.address;
+      // Addend is taken as the offset in the merged strings (PC relative one must refer a label).
+      if (s->progbits.merged != NULL)
+        return merged_string_address(s, rela->r_addend);
+      address = placed_section(s)->progbits.address;
     } else {
-      uintptr_t sectop = elfobj->section_infos[sym->st_shndx].progbits.address;
-      address = sectop + sym->st_value;
+      const ElfSectionInfo *s = &elfobj->section_infos[sym->st_shndx];
+      if (s->progbits.merged != NULL)
+        address = merged_string_address(s, sym->st_value);
+      else
+        address = placed_section(s)->progbits.address + sym->st_value;
     }
     break;
   case STB_GLOBAL:
@@ -203,183 +314,209 @@ static uintptr_t calc_rela_sym_address(LinkEditor *ld, ElfObj *elfobj, const Elf
   return address + rela->r_addend;
 }
 
-static int resolve_rela_elfobj(LinkEditor *ld, ElfObj *elfobj) {
-  int error_count = 0;
-  for (Elf64_Half sec = 0; sec < elfobj->ehdr.e_shnum; ++sec) {
-    Elf64_Shdr *shdr = &elfobj->shdrs[sec];
-    if (shdr->sh_type != SHT_RELA || shdr->sh_size <= 0)
-      continue;
-    const Elf64_Rela *relas = read_or_die(elfobj->fp, NULL, shdr->sh_offset + elfobj->start_offset,
-                                          shdr->sh_size, "read error");
-    const Elf64_Shdr *symhdr = &elfobj->shdrs[shdr->sh_link];
-    const ElfSectionInfo *symhdrinfo = &elfobj->section_infos[shdr->sh_link];
-    const ElfSectionInfo *strinfo = &elfobj->section_infos[symhdr->sh_link];
-    const ElfSectionInfo *dst_info = &elfobj->section_infos[shdr->sh_info];
-    assert(dst_info->shdr->sh_type == SHT_PROGBITS || dst_info->shdr->sh_type == SHT_INIT_ARRAY ||
-           dst_info->shdr->sh_type == SHT_FINI_ARRAY || dst_info->shdr->sh_type == SHT_PREINIT_ARRAY);
-    if (dst_info->progbits.content == NULL) {
-      // Target section is not collected, so skip relocation.
-      continue;
-    }
-
-    size_t symbol_count = elfobj->symtab_section->shdr->sh_size / sizeof(Elf64_Sym);
-    for (size_t j = 0, n = shdr->sh_size / sizeof(Elf64_Rela); j < n; ++j) {
-      const Elf64_Rela *rela = &relas[j];
-      assert(ELF64_R_SYM(rela->r_info) < symbol_count);
-      const Elf64_Sym *sym = &symhdrinfo->symtab.syms[ELF64_R_SYM(rela->r_info)];
-      uintptr_t address = calc_rela_sym_address(ld, elfobj, rela, sym, strinfo);
-
-      void *p = dst_info->progbits.content + rela->r_offset;
-      uintptr_t pc = elfobj->section_infos[shdr->sh_info].progbits.address + rela->r_offset;
-      switch (ELF64_R_TYPE(rela->r_info)) {
+// Returns false if the relocation type is not supported.
+static bool apply_rela(uint32_t type, void *p, uintptr_t address, uintptr_t pc) {
+  switch (type) {
 #if XCC_TARGET_ARCH == XCC_ARCH_X64
-      case R_X86_64_64:
-        *(uint64_t*)p = address;
-        break;
-      case R_X86_64_PC32:
-      case R_X86_64_PLT32:
-        *(uint32_t*)p = address - pc;
-        break;
+  case R_X86_64_64:
+    *(uint64_t*)p = address;
+    break;
+  case R_X86_64_PC32:
+  case R_X86_64_PLT32:
+    *(uint32_t*)p = address - pc;
+    break;
 
 #elif XCC_TARGET_ARCH == XCC_ARCH_AARCH64
-      case R_AARCH64_ABS64:
-        *(uint64_t*)p = address;
-        break;
-      case R_AARCH64_ADR_PREL_PG_HI21:  // Page(S+A)-Page(P)
-        {
-          const int PAGE = 12;
-          const uint32_t MASK = ~0x60ffffe0;
-          uint32_t d = (address >> PAGE) - (pc >> PAGE);
-          *(uint32_t*)p = (*(uint32_t*)p & MASK) | ((d & 0x03) << 29) | ((d & 0x1ffffc) << 3);
-        }
-        break;
-      case R_AARCH64_ADD_ABS_LO12_NC:  // S + A
-        {
-          const uint32_t MASK = ~(((1U << 12) - 1) << 10);
-          *(uint32_t*)p = (*(uint32_t*)p & MASK) | ((address << 10) & ~MASK);
-        }
-        break;
-      case R_AARCH64_CALL26:  // S+A-P
-        {
-          const uint32_t MASK = -(1U << 26);
-          *(uint32_t*)p = (*(uint32_t*)p & MASK) | (((address - pc) >> 2) & ~MASK);
-        }
-        break;
+  case R_AARCH64_ABS64:
+    *(uint64_t*)p = address;
+    break;
+  case R_AARCH64_ADR_PREL_PG_HI21:  // Page(S+A)-Page(P)
+    {
+      const int PAGE = 12;
+      const uint32_t MASK = ~0x60ffffe0;
+      uint32_t d = (address >> PAGE) - (pc >> PAGE);
+      *(uint32_t*)p = (*(uint32_t*)p & MASK) | ((d & 0x03) << 29) | ((d & 0x1ffffc) << 3);
+    }
+    break;
+  case R_AARCH64_ADD_ABS_LO12_NC:  // S + A
+    {
+      const uint32_t MASK = ~(((1U << 12) - 1) << 10);
+      *(uint32_t*)p = (*(uint32_t*)p & MASK) | ((address << 10) & ~MASK);
+    }
+    break;
+  case R_AARCH64_CALL26:  // S+A-P
+    {
+      const uint32_t MASK = -(1U << 26);
+      *(uint32_t*)p = (*(uint32_t*)p & MASK) | (((address - pc) >> 2) & ~MASK);
+    }
+    break;
 
-      case R_AARCH64_ADR_GOT_PAGE:
-      case R_AARCH64_LD64_GOT_LO12_NC:
-        assert(!"TODO: Implement");
-        break;
+  case R_AARCH64_ADR_GOT_PAGE:
+  case R_AARCH64_LD64_GOT_LO12_NC:
+    assert(!"TODO: Implement");
+    break;
 
 #elif XCC_TARGET_ARCH == XCC_ARCH_RISCV64
-      case R_RISCV_64:
-        *(uint64_t*)p = address;
-        break;
+  case R_RISCV_64:
+    *(uint64_t*)p = address;
+    break;
+  case R_RISCV_CALL:
+    {
+      int64_t offset = address - pc;
+      assert(offset < (1L << 19) && offset >= -(1L << 19));  // TODO
+      *(uint32_t*)p = W_JAL(RA, offset);
+    }
+    break;
+  case R_RISCV_PCREL_HI20:
+  case R_RISCV_HI20:
+    {
+      int64_t offset = address - (type == R_RISCV_PCREL_HI20 ? pc : 0);
+      assert(offset < (1L << 31) && offset >= -(1L << 31));
+      // const uint32_t MASK20 = (1U << 20) - 1;
+      const uint32_t MASK12 = (1U << 12) - 1;
+      if ((offset & MASK12) >= (1U << 11))
+        offset += 1U << 12;
+      *(uint32_t*)p = (*(uint32_t*)p & MASK12) | ((uint32_t)offset & ~MASK12);
+    }
+    break;
+  case R_RISCV_PCREL_LO12_I:
+  case R_RISCV_LO12_I:
+    {
+      // `address` and `pc` are taken from the corresponding HI20.
+      int64_t offset = address - (type == R_RISCV_PCREL_LO12_I ? pc : 0);
+      assert(offset < (1L << 31) && offset >= -(1L << 31));
+      const uint32_t MASK20 = (1U << 20) - 1;
+      const uint32_t MASK12 = (1U << 12) - 1;
+      *(uint32_t*)p = (*(uint32_t*)p & MASK20) | (((uint32_t)offset & MASK12) << 20);
+    }
+    break;
+  case R_RISCV_RVC_JUMP:
+    {
+      int64_t offset = address - pc;
+      assert(offset < (1L << 11) && offset >= -(1L << 11));
+
+      uint16_t *q = (uint16_t*)p;
+      assert((*q & 0xe003) == 0xa001);  // c.j
+      *q = (*q & 0xe003) | SWIZZLE_C_J(offset);
+    }
+    break;
+  case R_RISCV_JAL:
+    {
+      int64_t offset = address - pc;
+      assert(offset < (1L << 19) && offset >= -(1L << 19));
+
+      uint32_t *q = (uint32_t*)p;
+      assert((*q & 0x0000007f) == 0x6f);  // jal
+      *q = (*q & 0x0000007f) | SWIZZLE_JAL(offset);
+    }
+    break;
+  case R_RISCV_BRANCH:
+  case R_RISCV_RVC_BRANCH:
+    {
+      int64_t offset = address - pc;
+
+      if (type == R_RISCV_RVC_BRANCH) {
+        assert(offset < (1 << 7) && offset >= -(1 << 7));
+        // c.beqz, c.bnez
+        uint16_t *q = (uint16_t*)p;
+        assert((*q & 0xc003) == 0xc001);
+        *q = (*q & 0xe383) | SWIZZLE_C_BXX(offset);
+      } else {
+        assert(offset < (1 << 11) && offset >= -(1 << 11));
+        uint32_t *q = (uint32_t*)p;
+        *q = (*q & 0x01fff07f) | SWIZZLE_BXX(offset);
+      }
+    }
+    break;
+#endif
+
+  default:
+    return false;
+  }
+  return true;
+}
+
+// Relocation which gives the symbol and the pc for `relas[j]`.
+static const Elf64_Rela *rela_symbol_source(const Elf64_Rela *relas, size_t j) {
+  const Elf64_Rela *rela = &relas[j];
+#if XCC_TARGET_ARCH == XCC_ARCH_RISCV64
+  uint32_t type = ELF64_R_TYPE(rela->r_info);
+  if (type == R_RISCV_PCREL_LO12_I || type == R_RISCV_LO12_I) {
+    // Get corresponding HI20 rela, and calculate the offset.
+    // Assume [..., [j-2]=PCREL_HI20, [j-1]=RELAX, [j]=PCREL_LO12_I, ...]
+    assert(j >= 2);
+    const Elf64_Rela *hirela = &relas[j - 2];
+    assert((type == R_RISCV_PCREL_LO12_I && ELF64_R_TYPE(hirela->r_info) == R_RISCV_PCREL_HI20) ||
+           (type == R_RISCV_LO12_I && ELF64_R_TYPE(hirela->r_info) == R_RISCV_HI20));
+    return hirela;
+  }
+#endif
+  return rela;
+}
+
+// Apply relocations to the section in the output image.
+// Runs on worker threads: Must not allocate, nor print; errors are kept in the task.
+// Global names are all interned while loading the symbol tables, so `alloc_name` only looks up.
+static void resolve_rela_section(LinkEditor *ld, SectionTask *task) {
+  const ElfSectionInfo *dst_info = task->section;
+  ElfObj *elfobj = dst_info->elfobj;
+  const Elf64_Rela *relas = task->relas;
+  if (relas == NULL)
+    return;
+
+  const Elf64_Shdr *shdr = dst_info->progbits.rela->shdr;
+  const Elf64_Shdr *symhdr = &elfobj->shdrs[shdr->sh_link];
+  const ElfSectionInfo *symhdrinfo = &elfobj->section_infos[shdr->sh_link];
+  const ElfSectionInfo *strinfo = &elfobj->section_infos[symhdr->sh_link];
+  assert(dst_info->shdr->sh_type == SHT_PROGBITS || dst_info->shdr->sh_type == SHT_INIT_ARRAY ||
+         dst_info->shdr->sh_type == SHT_FINI_ARRAY || dst_info->shdr->sh_type == SHT_PREINIT_ARRAY);
+  assert(dst_info->progbits.content != NULL);
+
+  size_t symbol_count = elfobj->symtab_section->shdr->sh_size / sizeof(Elf64_Sym);
+  for (size_t j = 0, n = shdr->sh_size / sizeof(Elf64_Rela); j < n; ++j) {
+    const Elf64_Rela *rela = &relas[j];
+    assert(ELF64_R_SYM(rela->r_info) < symbol_count);
+    const Elf64_Sym *sym = &symhdrinfo->symtab.syms[ELF64_R_SYM(rela->r_info)];
+    uint32_t type = ELF64_R_TYPE(rela->r_info);
+    void *p = dst_info->progbits.content + rela->r_offset;
+    uintptr_t pc = dst_info->progbits.address + rela->r_offset;
+#if XCC_TARGET_ARCH == XCC_ARCH_RISCV64
+    if (type == R_RISCV_RELAX) {
+      // TODO: Check
+      assert(j > 0);
+      const Elf64_Rela *rela0 = &relas[j - 1];
+      switch (ELF64_R_TYPE(rela0->r_info)) {
       case R_RISCV_CALL:
-        {
-          int64_t offset = address - pc;
-          assert(offset < (1L << 19) && offset >= -(1L << 19));  // TODO
-          *(uint32_t*)p = W_JAL(RA, offset);
-        }
-        break;
-      case R_RISCV_RELAX:
-        {
-          // TODO: Check
-          assert(j > 0);
-          const Elf64_Rela *rela0 = &relas[j - 1];
-          switch (ELF64_R_TYPE(rela0->r_info)) {
-          case R_RISCV_CALL:
-            ((uint32_t*)p)[1] = P_NOP();
-            break;
-          case R_RISCV_PCREL_HI20:
-          case R_RISCV_PCREL_LO12_I:
-          case R_RISCV_HI20:
-          case R_RISCV_LO12_I:
-            break;
-          default: assert(false); break;
-          }
-        }
+        ((uint32_t*)p)[1] = P_NOP();
         break;
       case R_RISCV_PCREL_HI20:
-      case R_RISCV_HI20:
-        {
-          int64_t offset = address - (ELF64_R_TYPE(rela->r_info) == R_RISCV_PCREL_HI20 ? pc : 0);
-          assert(offset < (1L << 31) && offset >= -(1L << 31));
-          // const uint32_t MASK20 = (1U << 20) - 1;
-          const uint32_t MASK12 = (1U << 12) - 1;
-          if ((offset & MASK12) >= (1U << 11))
-            offset += 1U << 12;
-          *(uint32_t*)p = (*(uint32_t*)p & MASK12) | ((uint32_t)offset & ~MASK12);
-        }
-        break;
       case R_RISCV_PCREL_LO12_I:
+      case R_RISCV_HI20:
       case R_RISCV_LO12_I:
-        {
-          // Get corresponding HI20 rela, and calculate the offset.
-          // Assume [..., [j-2]=PCREL_HI20, [j-1]=RELAX, [j]=PCREL_LO12_I, ...]
-          assert(j >= 2);
-          const Elf64_Rela *hirela = &relas[j - 2];
-          assert((ELF64_R_TYPE(rela->r_info) == R_RISCV_PCREL_LO12_I && ELF64_R_TYPE(hirela->r_info) == R_RISCV_PCREL_HI20) ||
-                 (ELF64_R_TYPE(rela->r_info) == R_RISCV_LO12_I && ELF64_R_TYPE(hirela->r_info) == R_RISCV_HI20));
-          const Elf64_Sym *hisym = &symhdrinfo->symtab.syms[ELF64_R_SYM(hirela->r_info)];
-          uintptr_t hiaddress = calc_rela_sym_address(ld, elfobj, hirela, hisym, strinfo);
-          uintptr_t hipc = elfobj->section_infos[shdr->sh_info].progbits.address + hirela->r_offset;
-
-          int64_t offset = hiaddress - (ELF64_R_TYPE(rela->r_info) == R_RISCV_PCREL_LO12_I ? hipc : 0);
-          assert(offset < (1L << 31) && offset >= -(1L << 31));
-          const uint32_t MASK20 = (1U << 20) - 1;
-          const uint32_t MASK12 = (1U << 12) - 1;
-          *(uint32_t*)p = (*(uint32_t*)p & MASK20) | (((uint32_t)offset & MASK12) << 20);
-        }
-        break;
-      case R_RISCV_RVC_JUMP:
-        {
-          int64_t offset = address - pc;
-          assert(offset < (1L << 11) && offset >= -(1L << 11));
-
-          uint16_t *q = (uint16_t*)p;
-          assert((*q & 0xe003) == 0xa001);  // c.j
-          *q = (*q & 0xe003) | SWIZZLE_C_J(offset);
-        }
-        break;
-      case R_RISCV_JAL:
-        {
-          int64_t offset = address - pc;
-          assert(offset < (1L << 19) && offset >= -(1L << 19));
-
-          uint32_t *q = (uint32_t*)p;
-          assert((*q & 0x0000007f) == 0x6f);  // jal
-          *q = (*q & 0x0000007f) | SWIZZLE_JAL(offset);
-        }
-        break;
-      case R_RISCV_BRANCH:
-      case R_RISCV_RVC_BRANCH:
-        {
-          int64_t offset = address - pc;
-
-          if (ELF64_R_TYPE(rela->r_info) == R_RISCV_RVC_BRANCH) {
-            assert(offset < (1 << 7) && offset >= -(1 << 7));
-            // c.beqz, c.bnez
-            uint16_t *q = (uint16_t*)p;
-            assert((*q & 0xc003) == 0xc001);
-            *q = (*q & 0xe383) | SWIZZLE_C_BXX(offset);
-          } else {
-            assert(offset < (1 << 11) && offset >= -(1 << 11));
-            uint32_t *q = (uint32_t*)p;
-            *q = (*q & 0x01fff07f) | SWIZZLE_BXX(offset);
-          }
-        }
-        break;
-#endif
-
-      default:
-        fprintf(stderr, "Unhandled rela type: %" PRIx32 "\n", (uint32_t)ELF64_R_TYPE(rela->r_info));
-        ++error_count;
         break;
+      default: assert(false); break;
       }
+      continue;
+    }
+#endif
+    const Elf64_Rela *src = rela_symbol_source(relas, j);
+    if (src != rela) {
+      sym = &symhdrinfo->symtab.syms[ELF64_R_SYM(src->r_info)];
+      pc = dst_info->progbits.address + src->r_offset;
+    }
+    uintptr_t address = calc_rela_sym_address(ld, elfobj, src, sym, strinfo);
+    if (!apply_rela(type, p, address, pc)) {
+      if (task->error_count++ == 0)
+        task->error_type = type;
     }
   }
-  return error_count;
+}
+
+static void add_unresolved(LinkEditor *ld, Table *unresolved, const Name *name) {
+  if (!table_try_get(unresolved, name, NULL)) {
+    table_put(unresolved, name, (void*)name);
+    vec_push(ld->unresolved_queue, name);
+  }
 }
 
 static void resolve_symbols_elfobj(LinkEditor *ld, ElfObj *elfobj, Table *unresolved) {
@@ -404,7 +541,7 @@ static void resolve_symbols_elfobj(LinkEditor *ld, ElfObj *elfobj, Table *unreso
       }
     } else {
       if (sym->st_shndx == SHN_UNDEF) {
-        table_put(unresolved, name, (void*)name);
+        add_unresolved(ld, unresolved, name);
       } else {
         table_delete(unresolved, name);
         table_put(defined, name, elfobj);
@@ -413,8 +550,13 @@ static void resolve_symbols_elfobj(LinkEditor *ld, ElfObj *elfobj, Table *unreso
   }
 }
 
+// `name` also matches its subsections, e.g. `.text.foo` for `.text`.
+static bool match_section_name(const char *s, const char *name) {
+  size_t len = strlen(name);
+  return strncmp(s, name, len) == 0 && (s[len] == '\0' || s[len] == '.');
+}
+
 static void collect_sections_elfobj(LinkEditor *ld, ElfObj *elfobj, const char *name, Vector *seclist) {
-  UNUSED(ld);
   ElfSectionInfo *shsymtab = &elfobj->section_infos[elfobj->ehdr.e_shstrndx];
   assert(shsymtab->shdr->sh_type == SHT_STRTAB);
   const char *strbuf = shsymtab->strtab.buf;
@@ -428,37 +570,38 @@ static void collect_sections_elfobj(LinkEditor *ld, ElfObj *elfobj, const char *
     assert(shdr->sh_size > 0);
 
     const char *s = &strbuf[shdr->sh_name];
-    if (strcmp(s, name) == 0) {  // TODO: Wild card
+    if (match_section_name(s, name)) {
+      if (ld->gc_sections && !section->progbits.live)
+        continue;
       vec_push(seclist, section);
       elfobj->prog_sections->data[i] = NULL;
     }
   }
 }
 
-static void *load_elfobj(FILE *fp, const char *fn, size_t size) {
-  UNUSED(size);
-  return read_elf(fp, fn);
+static void *load_elfobj(Archive *ar, size_t offset, const char *fn, size_t size) {
+  if (ar->thin)
+    return load_elf_file(fn);
+  if (ar->image != NULL)
+    return read_elf_image(ar->image + offset, size, fn);
+  fseek(ar->fp, offset, SEEK_SET);
+  return read_elf(ar->fp, fn);
 }
 
+// Search the archive for names in the unresolved queue: Names queued by the files before it,
+// and by the members loaded in this loop.
 static void resolve_symbols_archive(LinkEditor *ld, Archive *ar, Table *unresolved) {
-  Table *table = &ar->symbol_table;
-  for (;;) {
-    bool retry = false;
-    const Name *name;
-    for (int it = 0; (it = table_iterate(unresolved, it, &name, NULL)) != -1;) {
-      ArSymbol *symbol;
-      if (!table_try_get(table, name, (void**)&symbol))
-        continue;
+  Vector *queue = ld->unresolved_queue;
+  for (int pos = 0; pos < queue->len; ++pos) {
+    const Name *name = queue->data[pos];
+    ArSymbol *symbol;
+    if (!table_try_get(unresolved, name, NULL) ||
+        !table_try_get(&ar->symbol_table, name, (void**)&symbol))
+      continue;
 
-      ElfObj *elfobj = load_archive_content(ar, symbol, load_elfobj);
-      if (elfobj != NULL) {
-        resolve_symbols_elfobj(ld, elfobj, unresolved);
-        retry = true;
-        break;
-      }
-    }
-    if (!retry)
-      break;
+    ElfObj *elfobj = load_archive_content(ar, symbol, load_elfobj);
+    if (elfobj != NULL)
+      resolve_symbols_elfobj(ld, elfobj, unresolved);
   }
 }
 
@@ -472,73 +615,729 @@ static void collect_sections_archive(LinkEditor *ld, Archive *ar, const char *na
   }
 }
 
-static int resolve_rela_archive(LinkEditor *ld, Archive *ar) {
-  int error_count = 0;
-  FOREACH_FILE_ARCONTENT(ar, content, {
-    error_count += resolve_rela_elfobj(ld, content->obj);
-  });
-  return error_count;
-}
-
-static int ld_resolve_relas(LinkEditor *ld) {
-  int error_count = 0;
+static void ld_resolve_symbols(LinkEditor *ld, Table *unresolved) {
   for (int i = 0; i < ld->nfiles; ++i) {
     File *file = &ld->files[i];
     switch (file->kind) {
     case FK_ELFOBJ:
-      error_count += resolve_rela_elfobj(ld, file->elfobj);
+      resolve_symbols_elfobj(ld, file->elfobj, unresolved);
       break;
     case FK_ARCHIVE:
-      error_count += resolve_rela_archive(ld, file->archive);
+      resolve_symbols_archive(ld, file->archive, unresolved);
       break;
     }
   }
-  return error_count;
 }
 
-static void add_elf_section(SectionGroup section_groups[SECTION_COUNT], const ElfSectionInfo *p, int secno) {
-  Elf64_Shdr *shdr = p->shdr;
-  if (shdr->sh_type == SHT_NOBITS)
-    return;
-  Elf64_Xword align = shdr->sh_addralign;
-  SectionGroup *secgroup = &section_groups[secno];
-  assert(align <= secgroup->align);
-  assert(secgroup->ds != NULL);
-  data_align(secgroup->ds, align);
-  void *content = p->progbits.content;
-  assert(content != NULL);
-  data_append(secgroup->ds, content, shdr->sh_size);
-}
-
-static void ld_resolve_symbols(LinkEditor *ld, Table *unresolved) {
+static void ld_collect_sections(LinkEditor *ld, const char *name, Vector *seclist) {
   for (int i = 0; i < ld->nfiles; ++i) {
     File *file = &ld->files[i];
     switch (file->kind) {
     case FK_ELFOBJ:
-      resolve_symbols_elfobj(ld, file->elfobj, unresolved);
+      collect_sections_elfobj(ld, file->elfobj, name, seclist);
       break;
     case FK_ARCHIVE:
-      resolve_symbols_archive(ld, file->archive, unresolved);
+      collect_sections_archive(ld, file->archive, name, seclist);
       break;
     }
   }
 }
 
-static void ld_collect_sections(LinkEditor *ld, const char *name, Vector *seclist) {
+static const char *section_name(const ElfSectionInfo *section) {
+  const ElfObj *elfobj = section->elfobj;
+  const ElfSectionInfo *shstrtab = &elfobj->section_infos[elfobj->ehdr.e_shstrndx];
+  return &shstrtab->strtab.buf[section->shdr->sh_name];
+}
+
+// String merging: Sections flagged `SHF_MERGE|SHF_STRINGS` hold nul-terminated strings which
+// can be shared. They are gathered into one section, where the same strings are put only once,
+// and a string which is the tail of another one points into it.
+
+typedef struct MergeString {
+  const Name *str;  // Without the terminating nul.
+  struct MergeString *host;  // Longer string which holds this one as its tail, or NULL.
+  Elf64_Xword offset;
+} MergeString;
+
+static bool is_mergeable_section(const ElfSectionInfo *section) {
+  const Elf64_Shdr *shdr = section->shdr;
+  return shdr->sh_type == SHT_PROGBITS &&
+         (shdr->sh_flags & (SHF_MERGE | SHF_STRINGS | SHF_WRITE)) == (SHF_MERGE | SHF_STRINGS) &&
+         shdr->sh_entsize == 1 && shdr->sh_addralign <= 1;
+}
+
+// Returns NULL if the section is not terminated with nul: Then it is kept as is.
+static MergedStrings *split_merge_strings(ElfSectionInfo *section) {
+  const Elf64_Shdr *shdr = section->shdr;
+  const char *content = elfobj_data(section->elfobj, shdr->sh_offset, shdr->sh_size, 1, "read error");
+  const char *end = content + shdr->sh_size;
+  if (end[-1] != '\0') {
+    elfobj_free_data(section->elfobj, content, shdr->sh_offset);
+    return NULL;
+  }
+
+  int count = 0;
+  for (const char *p = content; p < end; p += strlen(p) + 1)
+    ++count;
+
+  MergedStrings *merged = calloc_or_die(sizeof(*merged));
+  merged->content = content;
+  merged->count = count;
+  merged->offsets = malloc_or_die(sizeof(*merged->offsets) * count);
+  merged->merged_offsets = calloc_or_die(sizeof(*merged->merged_offsets) * count);
+  int i = 0;
+  for (const char *p = content; p < end; p += strlen(p) + 1)
+    merged->offsets[i++] = p - content;
+  section->progbits.merged = merged;
+  return merged;
+}
+
+// Returns the unique strings for each string in the section (NULL if it is not referred).
+static MergeString **register_merge_strings(const MergedStrings *merged, Table *string_table, Vector *strings) {
+  MergeString **section_strings = calloc_or_die(sizeof(*section_strings) * merged->count);
+  for (int i = 0; i < merged->count; ++i) {
+    if (merged->live != NULL && !merged->live[i])
+      continue;
+    const char *p = merged->content + merged->offsets[i];
+    const Name *str = alloc_name(p, p + strlen(p), false);
+    MergeString *ms = table_get(string_table, str);
+    if (ms == NULL) {
+      ms = calloc_or_die(sizeof(*ms));
+      ms->str = str;
+      table_put(string_table, str, ms);
+      vec_push(strings, ms);
+    }
+    section_strings[i] = ms;
+  }
+  return section_strings;
+}
+
+// Compare from the tail, to make a string adjacent to the ones which have it as their tail.
+static int cmp_reversed_string(const void *pa, const void *pb) {
+  const Name *a = (*(const MergeString**)pa)->str;
+  const Name *b = (*(const MergeString**)pb)->str;
+  for (int i = a->bytes, j = b->bytes; ; ) {
+    if (i <= 0)
+      return j <= 0 ? 0 : -1;
+    if (j <= 0)
+      return 1;
+    int d = (unsigned char)a->chars[--i] - (unsigned char)b->chars[--j];
+    if (d != 0)
+      return d;
+  }
+}
+
+static bool is_tail_string(const Name *str, const Name *tail) {
+  return tail->bytes <= str->bytes &&
+         memcmp(str->chars + (str->bytes - tail->bytes), tail->chars, tail->bytes) == 0;
+}
+
+static ElfSectionInfo *new_merged_section(const char *name, const unsigned char *content, size_t size) {
+  size_t namelen = strlen(name);
+  char *shstrtab = calloc_or_die(namelen + 2);
+  memcpy(shstrtab + 1, name, namelen);
+
+  ElfObj *elfobj = calloc_or_die(sizeof(*elfobj));
+  elfobj->image = content;
+  elfobj->ehdr.e_shnum = 2;
+  elfobj->ehdr.e_shstrndx = 1;
+  elfobj->shdrs = calloc_or_die(sizeof(*elfobj->shdrs) * 2);
+  elfobj->shdrs[0] = (Elf64_Shdr){
+    .sh_name = 1,
+    .sh_type = SHT_PROGBITS,
+    .sh_flags = SHF_ALLOC | SHF_MERGE | SHF_STRINGS,
+    .sh_offset = 0,
+    .sh_size = size,
+    .sh_addralign = 1,
+    .sh_entsize = 1,
+  };
+  elfobj->shdrs[1].sh_type = SHT_STRTAB;
+  elfobj->prog_sections = new_vector();
+  elfobj->section_infos = calloc_or_die(sizeof(*elfobj->section_infos) * 2);
+  for (int i = 0; i < 2; ++i) {
+    elfobj->section_infos[i].elfobj = elfobj;
+    elfobj->section_infos[i].shdr = &elfobj->shdrs[i];
+  }
+  elfobj->section_infos[1].strtab.buf = shstrtab;
+  return &elfobj->section_infos[0];
+}
+
+// Replace the mergeable sections in the lists with the merged one, put at the first one's place.
+static void ld_merge_strings(Vector *section_lists[SECTION_COUNT]) {
+  Table string_table;  // <MergeString*>
+  table_init(&string_table);
+  Vector *strings = new_vector();  // <MergeString*>, in the order of appearance.
+  Vector *merged_sections = new_vector();  // <ElfSectionInfo*>
+  Vector *section_strings = new_vector();  // <MergeString**>, for each merged section.
+  Vector *place = NULL;
+  int place_index = 0;
+  for (int secno = 0; secno < SECTION_COUNT; ++secno) {
+    Vector *seclist = section_lists[secno];
+    for (int i = 0; i < seclist->len; ++i) {
+      LinkElem *elem = seclist->data[i];
+      if (elem->kind != LEK_SECTION)
+        continue;
+      Vector *list = elem->section.list;
+      int n = 0;
+      for (int j = 0; j < list->len; ++j) {
+        ElfSectionInfo *section = list->data[j];
+        MergedStrings *merged = section->progbits.merged;
+        if (merged == NULL && is_mergeable_section(section))
+          merged = split_merge_strings(section);
+        if (merged == NULL) {
+          list->data[n++] = section;
+          continue;
+        }
+        vec_push(merged_sections, section);
+        vec_push(section_strings, register_merge_strings(merged, &string_table, strings));
+        if (place == NULL) {
+          place = list;
+          place_index = n;
+        }
+      }
+      list->len = n;
+    }
+  }
+  if (merged_sections->len <= 0)
+    return;
+
+  // Find the strings which are the tail of others.
+  int count = strings->len;
+  MergeString **sorted = malloc_or_die(sizeof(*sorted) * count);
+  memcpy(sorted, strings->data, sizeof(*sorted) * count);
+  qsort(sorted, count, sizeof(*sorted), cmp_reversed_string);
+  MergeString *host = NULL;
+  for (int i = count; --i >= 0; ) {
+    MergeString *ms = sorted[i];
+    if (host != NULL && is_tail_string(host->str, ms->str))
+      ms->host = host;
+    else
+      host = ms;
+  }
+  free(sorted);
+
+  size_t size = 0;
+  for (int i = 0; i < count; ++i) {
+    MergeString *ms = strings->data[i];
+    if (ms->host == NULL) {
+      ms->offset = size;
+      size += ms->str->bytes + 1;
+    }
+  }
+  unsigned char *content = calloc_or_die(size);
+  for (int i = 0; i < count; ++i) {
+    MergeString *ms = strings->data[i];
+    if (ms->host == NULL)
+      memcpy(content + ms->offset, ms->str->chars, ms->str->bytes);
+    else
+      ms->offset = ms->host->offset + (ms->host->str->bytes - ms->str->bytes);
+  }
+
+  ElfSectionInfo *output = new_merged_section(".rodata.str1.1", content, size);
+  for (int i = 0; i < merged_sections->len; ++i) {
+    ElfSectionInfo *section = merged_sections->data[i];
+    MergedStrings *merged = section->progbits.merged;
+    MergeString **ss = section_strings->data[i];
+    merged->output = output;
+    for (int j = 0; j < merged->count; ++j) {
+      if (ss[j] != NULL)
+        merged->merged_offsets[j] = ss[j]->offset;
+    }
+    free(ss);
+  }
+  vec_insert(place, place_index, output);
+
+  for (int i = 0; i < count; ++i)
+    free(strings->data[i]);
+  free_vector(strings);
+  free_vector(merged_sections);
+  free_vector(section_strings);
+}
+
+// Identical code folding (--icf): Functions in their own sections (-ffunction-sections) which
+// have the same contents and refer to the same targets are folded into one, and the symbols in
+// the others are redirected to it. Functions whose address is taken (referred other than by
+// calls) are kept, because distinct functions must have distinct addresses.
+
+typedef struct IcfTarget {
+  const void *id;  // Section, or symbol for the ones not in a section. NULL for none.
+  struct IcfSection *icf;  // Target is also a candidate: Compared with its class.
+  Elf64_Sxword offset;
+} IcfTarget;
+
+typedef struct IcfSection {
+  ElfSectionInfo *section;
+  const unsigned char *content;
+  const Elf64_Rela *relas;
+  size_t rela_count;
+  IcfTarget *targets;
+  uint64_t hash;
+  int order;  // Order in the output: First one in a class is kept.
+  int cls, new_cls;
+  bool address_taken;
+} IcfSection;
+
+static bool is_call_rela(uint32_t type) {
+  switch (type) {
+#if XCC_TARGET_ARCH == XCC_ARCH_X64
+  case R_X86_64_PLT32:
+#elif XCC_TARGET_ARCH == XCC_ARCH_AARCH64
+  case R_AARCH64_CALL26:
+  case R_AARCH64_JUMP26:
+#elif XCC_TARGET_ARCH == XCC_ARCH_RISCV64
+  case R_RISCV_CALL:
+  case R_RISCV_JAL:
+  case R_RISCV_RVC_JUMP:
+  case R_RISCV_BRANCH:
+  case R_RISCV_RVC_BRANCH:
+  case R_RISCV_RELAX:
+#endif
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Where the relocation points to: Returns the section (or the symbol) and the offset in it.
+static const void *rela_target(LinkEditor *ld, ElfObj *elfobj, const Elf64_Rela *rela, Elf64_Sxword *poffset) {
+  const ElfSectionInfo *symhdrinfo = elfobj->symtab_section;
+  const Elf64_Sym *sym = &symhdrinfo->symtab.syms[ELF64_R_SYM(rela->r_info)];
+  const ElfSectionInfo *section = NULL;
+  Elf64_Sxword offset = rela->r_addend;
+  if (ELF64_R_SYM(rela->r_info) == 0) {
+    *poffset = offset;
+    return NULL;
+  }
+  switch (ELF64_ST_BIND(sym->st_info)) {
+  case STB_LOCAL:
+    if (ELF64_ST_TYPE(sym->st_info) == STT_SECTION) {
+      section = &elfobj->section_infos[ELF64_R_SYM(rela->r_info)];
+    } else if (sym->st_shndx != SHN_UNDEF && sym->st_shndx < SHN_LORESERVE) {
+      section = &elfobj->section_infos[sym->st_shndx];
+      offset += sym->st_value;
+    }
+    break;
+  case STB_GLOBAL:
+    {
+      const char *str = symhdrinfo->symtab.strtab->strtab.buf;
+      const Name *name = alloc_name(&str[sym->st_name], NULL, false);
+      ElfObj *defobj = table_get(ld->symbol_table, name);
+      if (defobj == NULL) {
+        *poffset = offset;
+        return table_get(ld->generated_symbol_table, name);
+      }
+      sym = elfobj_find_symbol(defobj, name);
+      if (sym->st_shndx < SHN_LORESERVE) {
+        section = &defobj->section_infos[sym->st_shndx];
+        offset += sym->st_value;
+      }
+    }
+    break;
+  default: break;
+  }
+  if (section == NULL) {
+    *poffset = offset;
+    return sym;
+  }
+  if (section->progbits.merged != NULL) {
+    // Same strings are the same target.
+    offset = merged_string_offset(section, offset);
+    section = section->progbits.merged->output;
+  }
+  *poffset = offset;
+  return section;
+}
+
+static int cmp_icf_by_section(const void *pa, const void *pb) {
+  uintptr_t a = (uintptr_t)(*(const IcfSection**)pa)->section;
+  uintptr_t b = (uintptr_t)(*(const IcfSection**)pb)->section;
+  return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static IcfSection *find_icf_section(IcfSection **sorted, int count, const void *section) {
+  int lo = 0, hi = count;
+  while (lo < hi) {
+    int m = (lo + hi) / 2;
+    uintptr_t p = (uintptr_t)sorted[m]->section;
+    if (p == (uintptr_t)section)
+      return sorted[m];
+    if (p < (uintptr_t)section)
+      lo = m + 1;
+    else
+      hi = m;
+  }
+  return NULL;
+}
+
+// Mark candidates which are referred other than by calls.
+static void icf_mark_address_taken(LinkEditor *ld, Vector *section_lists[SECTION_COUNT], IcfSection **sorted, int count) {
+  for (int secno = 0; secno < SECTION_COUNT; ++secno) {
+    Vector *seclist = section_lists[secno];
+    for (int i = 0; i < seclist->len; ++i) {
+      LinkElem *elem = seclist->data[i];
+      if (elem->kind != LEK_SECTION)
+        continue;
+      Vector *list = elem->section.list;
+      for (int j = 0; j < list->len; ++j) {
+        ElfSectionInfo *section = list->data[j];
+        const ElfSectionInfo *rela_info = section->progbits.rela;
+        if (rela_info == NULL || rela_info->shdr->sh_size <= 0)
+          continue;
+        const Elf64_Shdr *shdr = rela_info->shdr;
+        const Elf64_Rela *relas = elfobj_data(section->elfobj, shdr->sh_offset, shdr->sh_size,
+                                              _Alignof(Elf64_Rela), "read error");
+        for (size_t k = 0, n = shdr->sh_size / sizeof(Elf64_Rela); k < n; ++k) {
+          const Elf64_Rela *src = rela_symbol_source(relas, k);
+          if (is_call_rela(ELF64_R_TYPE(src->r_info)))
+            continue;
+          Elf64_Sxword offset;
+          const void *target = rela_target(ld, section->elfobj, src, &offset);
+          IcfSection *icf = find_icf_section(sorted, count, target);
+          if (icf != NULL)
+            icf->address_taken = true;
+        }
+        elfobj_free_data(section->elfobj, relas, shdr->sh_offset);
+      }
+    }
+  }
+}
+
+#define FNV_OFFSET  (0xcbf29ce484222325ULL)
+#define FNV_PRIME   (0x100000001b3ULL)
+
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t size) {
+  const unsigned char *p = data;
+  for (size_t i = 0; i < size; ++i)
+    hash = (hash ^ p[i]) * FNV_PRIME;
+  return hash;
+}
+
+static void icf_prepare(LinkEditor *ld, IcfSection *icf, IcfSection **sorted, int count) {
+  ElfSectionInfo *section = icf->section;
+  const Elf64_Shdr *shdr = section->shdr;
+  uint64_t hash = hash_bytes(FNV_OFFSET, &shdr->sh_size, sizeof(shdr->sh_size));
+  hash = hash_bytes(hash, &shdr->sh_addralign, sizeof(shdr->sh_addralign));
+  hash = hash_bytes(hash, icf->content, shdr->sh_size);
+
+  icf->targets = calloc_or_die(sizeof(*icf->targets) * (icf->rela_count + 1));
+  for (size_t i = 0; i < icf->rela_count; ++i) {
+    const Elf64_Rela *rela = &icf->relas[i];
+    IcfTarget *target = &icf->targets[i];
+    target->id = rela_target(ld, section->elfobj, rela, &target->offset);
+    target->icf = find_icf_section(sorted, count, target->id);
+    uint32_t type = ELF64_R_TYPE(rela->r_info);
+    hash = hash_bytes(hash, &rela->r_offset, sizeof(rela->r_offset));
+    hash = hash_bytes(hash, &type, sizeof(type));
+    hash = hash_bytes(hash, &target->offset, sizeof(target->offset));
+    if (target->icf == NULL)
+      hash = hash_bytes(hash, &target->id, sizeof(target->id));
+  }
+  icf->hash = hash;
+}
+
+// Compare except the classes of the target candidates.
+static int cmp_icf_content(const void *pa, const void *pb) {
+  const IcfSection *a = *(const IcfSection**)pa;
+  const IcfSection *b = *(const IcfSection**)pb;
+  if (a->hash != b->hash)
+    return a->hash < b->hash ? -1 : 1;
+  const Elf64_Shdr *sa = a->section->shdr, *sb = b->section->shdr;
+  if (sa->sh_size != sb->sh_size)
+    return sa->sh_size < sb->sh_size ? -1 : 1;
+  if (sa->sh_addralign != sb->sh_addralign)
+    return sa->sh_addralign < sb->sh_addralign ? -1 : 1;
+  if (a->rela_count != b->rela_count)
+    return a->rela_count < b->rela_count ? -1 : 1;
+  int d = memcmp(a->content, b->content, sa->sh_size);
+  if (d != 0)
+    return d;
+  for (size_t i = 0; i < a->rela_count; ++i) {
+    const Elf64_Rela *ra = &a->relas[i], *rb = &b->relas[i];
+    if (ra->r_offset != rb->r_offset)
+      return ra->r_offset < rb->r_offset ? -1 : 1;
+    if (ELF64_R_TYPE(ra->r_info) != ELF64_R_TYPE(rb->r_info))
+      return ELF64_R_TYPE(ra->r_info) < ELF64_R_TYPE(rb->r_info) ? -1 : 1;
+    const IcfTarget *ta = &a->targets[i], *tb = &b->targets[i];
+    if (ta->offset != tb->offset)
+      return ta->offset < tb->offset ? -1 : 1;
+    if ((ta->icf == NULL) != (tb->icf == NULL))
+      return ta->icf == NULL ? -1 : 1;
+    if (ta->icf == NULL && ta->id != tb->id)
+      return (uintptr_t)ta->id < (uintptr_t)tb->id ? -1 : 1;
+  }
+  return 0;
+}
+
+// Compare the class, and the classes of the target candidates.
+static int cmp_icf_class(const void *pa, const void *pb) {
+  const IcfSection *a = *(const IcfSection**)pa;
+  const IcfSection *b = *(const IcfSection**)pb;
+  if (a->cls != b->cls)
+    return a->cls < b->cls ? -1 : 1;
+  for (size_t i = 0; i < a->rela_count; ++i) {
+    const IcfSection *ia = a->targets[i].icf, *ib = b->targets[i].icf;
+    if (ia != NULL && ia->cls != ib->cls)
+      return ia->cls < ib->cls ? -1 : 1;
+  }
+  return 0;
+}
+
+// Put sections in the same class with `cmp`, and returns the number of classes.
+static int icf_classify(IcfSection **icfs, int count, int (*cmp)(const void*, const void*)) {
+  qsort(icfs, count, sizeof(*icfs), cmp);
+  int ncls = 0;
+  for (int i = 0; i < count; ++i) {
+    if (i > 0 && (*cmp)(&icfs[i - 1], &icfs[i]) != 0)
+      ++ncls;
+    icfs[i]->new_cls = ncls;
+  }
+  for (int i = 0; i < count; ++i)
+    icfs[i]->cls = icfs[i]->new_cls;
+  return count > 0 ? ncls + 1 : 0;
+}
+
+static void ld_fold_identical_code(LinkEditor *ld, Vector *section_lists[SECTION_COUNT], bool print) {
+  Vector *candidates = new_vector();  // <IcfSection*>
+  Vector *seclist = section_lists[SEC_TEXT];
+  for (int i = 0; i < seclist->len; ++i) {
+    LinkElem *elem = seclist->data[i];
+    if (elem->kind != LEK_SECTION || strcmp(elem->section.name, ".text") != 0)
+      continue;
+    Vector *list = elem->section.list;
+    for (int j = 0; j < list->len; ++j) {
+      ElfSectionInfo *section = list->data[j];
+      const Elf64_Shdr *shdr = section->shdr;
+      if (shdr->sh_type != SHT_PROGBITS || !(shdr->sh_flags & SHF_EXECINSTR))
+        continue;
+      IcfSection *icf = calloc_or_die(sizeof(*icf));
+      icf->section = section;
+      icf->order = candidates->len;
+      vec_push(candidates, icf);
+    }
+  }
+
+  int count = candidates->len;
+  IcfSection **sorted = malloc_or_die(sizeof(*sorted) * (count + 1));
+  memcpy(sorted, candidates->data, sizeof(*sorted) * count);
+  qsort(sorted, count, sizeof(*sorted), cmp_icf_by_section);
+  icf_mark_address_taken(ld, section_lists, sorted, count);
+
+  int n = 0;
+  for (int i = 0; i < count; ++i) {
+    IcfSection *icf = candidates->data[i];
+    if (icf->address_taken) {
+      free(icf);
+      continue;
+    }
+    const Elf64_Shdr *shdr = icf->section->shdr;
+    icf->content = elfobj_data(icf->section->elfobj, shdr->sh_offset, shdr->sh_size, 1, "read error");
+    const ElfSectionInfo *rela_info = icf->section->progbits.rela;
+    if (rela_info != NULL && rela_info->shdr->sh_size > 0) {
+      const Elf64_Shdr *rshdr = rela_info->shdr;
+      icf->relas = elfobj_data(icf->section->elfobj, rshdr->sh_offset, rshdr->sh_size,
+                               _Alignof(Elf64_Rela), "read error");
+      icf->rela_count = rshdr->sh_size / sizeof(Elf64_Rela);
+    }
+    candidates->data[n++] = icf;
+  }
+  candidates->len = count = n;
+  memcpy(sorted, candidates->data, sizeof(*sorted) * count);
+  qsort(sorted, count, sizeof(*sorted), cmp_icf_by_section);
+  for (int i = 0; i < count; ++i)
+    icf_prepare(ld, candidates->data[i], sorted, count);
+
+  // Split the classes until they settle: Sections are identical if their targets are.
+  IcfSection **icfs = sorted;
+  memcpy(icfs, candidates->data, sizeof(*icfs) * count);
+  int ncls = icf_classify(icfs, count, cmp_icf_content);
+  for (;;) {
+    int n = icf_classify(icfs, count, cmp_icf_class);
+    if (n == ncls)
+      break;
+    ncls = n;
+  }
+
+  // Keep the first one in each class.
+  IcfSection **keepers = calloc_or_die(sizeof(*keepers) * (ncls + 1));
+  size_t saved = 0;
+  int folded_count = 0;
+  for (int i = 0; i < count; ++i) {
+    IcfSection *icf = candidates->data[i];
+    IcfSection *keeper = keepers[icf->cls];
+    if (keeper == NULL) {
+      keepers[icf->cls] = icf;
+      continue;
+    }
+    icf->section->progbits.folded = keeper->section;
+    saved += icf->section->shdr->sh_size;
+    ++folded_count;
+    if (print) {
+      fprintf(stderr, "ICF: folding %s into %s\n", section_name(icf->section),
+              section_name(keeper->section));
+    }
+  }
+  if (print)
+    fprintf(stderr, "ICF: %d sections folded, %zu bytes saved\n", folded_count, saved);
+
+  for (int i = 0; i < seclist->len; ++i) {
+    LinkElem *elem = seclist->data[i];
+    if (elem->kind != LEK_SECTION)
+      continue;
+    Vector *list = elem->section.list;
+    int n = 0;
+    for (int j = 0; j < list->len; ++j) {
+      ElfSectionInfo *section = list->data[j];
+      if (section->progbits.folded == NULL)
+        list->data[n++] = section;
+    }
+    list->len = n;
+  }
+
+  for (int i = 0; i < count; ++i) {
+    IcfSection *icf = candidates->data[i];
+    ElfObj *elfobj = icf->section->elfobj;
+    elfobj_free_data(elfobj, icf->content, icf->section->shdr->sh_offset);
+    if (icf->relas != NULL)
+      elfobj_free_data(elfobj, icf->relas, icf->section->progbits.rela->shdr->sh_offset);
+    free(icf->targets);
+    free(icf);
+  }
+  free(keepers);
+  free(sorted);
+  free_vector(candidates);
+}
+
+// --gc-sections: Mark sections reachable from the entry and the kept sections
+// by following relocations, and drop the others on collection.
+
+static const char *kKeepSectionNames[] = {
+  ".init_array", ".fini_array", ".preinit_array", ".xcc_prof",
+};
+
+static void gc_mark_section(Vector *stack, ElfSectionInfo *section) {
+  if (!section->progbits.live) {
+    section->progbits.live = true;
+    vec_push(stack, section);
+  }
+}
+
+// Only the referred strings are kept in the merged section.
+static void gc_mark_string(ElfSectionInfo *section, Elf64_Xword offset) {
+  if (!is_mergeable_section(section))
+    return;
+  MergedStrings *merged = section->progbits.merged;
+  if (merged == NULL && (merged = split_merge_strings(section)) == NULL)
+    return;
+  if (merged->live == NULL)
+    merged->live = calloc_or_die(sizeof(*merged->live) * merged->count);
+  merged->live[merged_string_index(merged, offset)] = true;
+}
+
+static void gc_mark_symbol(LinkEditor *ld, Vector *stack, const Name *name) {
+  ElfObj *elfobj = table_get(ld->symbol_table, name);
+  if (elfobj == NULL)
+    return;  // Generated by the linker.
+  Elf64_Sym *sym = elfobj_find_symbol(elfobj, name);
+  if (sym != NULL && sym->st_shndx < SHN_LORESERVE) {
+    gc_mark_string(&elfobj->section_infos[sym->st_shndx], sym->st_value);
+    gc_mark_section(stack, &elfobj->section_infos[sym->st_shndx]);
+  }
+}
+
+static void gc_mark_roots_elfobj(ElfObj *elfobj, Vector *stack) {
+  const char *strbuf = elfobj->section_infos[elfobj->ehdr.e_shstrndx].strtab.buf;
+  for (int i = 0; i < elfobj->prog_sections->len; ++i) {
+    ElfSectionInfo *section = elfobj->prog_sections->data[i];
+    const char *s = &strbuf[section->shdr->sh_name];
+    for (size_t j = 0; j < ARRAY_SIZE(kKeepSectionNames); ++j) {
+      if (match_section_name(s, kKeepSectionNames[j])) {
+        gc_mark_section(stack, section);
+        break;
+      }
+    }
+  }
+}
+
+static void gc_trace_section(LinkEditor *ld, ElfSectionInfo *section, Vector *stack) {
+  ElfSectionInfo *rela_info = section->progbits.rela;
+  if (rela_info == NULL)
+    return;
+  ElfObj *elfobj = section->elfobj;
+  const Elf64_Shdr *shdr = rela_info->shdr;
+  const Elf64_Rela *relas = elfobj_data(elfobj, shdr->sh_offset, shdr->sh_size,
+                                        _Alignof(Elf64_Rela), "read error");
+  const ElfSectionInfo *symhdrinfo = &elfobj->section_infos[shdr->sh_link];
+  const char *str = symhdrinfo->symtab.strtab->strtab.buf;
+  for (size_t j = 0, n = shdr->sh_size / sizeof(Elf64_Rela); j < n; ++j) {
+    const Elf64_Rela *rela = &relas[j];
+    const Elf64_Sym *sym = &symhdrinfo->symtab.syms[ELF64_R_SYM(rela->r_info)];
+    switch (ELF64_ST_BIND(sym->st_info)) {
+    case STB_LOCAL:
+      if (ELF64_ST_TYPE(sym->st_info) == STT_SECTION) {
+        assert(ELF64_R_SYM(rela->r_info) < elfobj->ehdr.e_shnum);
+        ElfSectionInfo *target = &elfobj->section_infos[ELF64_R_SYM(rela->r_info)];
+        gc_mark_string(target, rela->r_addend);
+        gc_mark_section(stack, target);
+      } else if (sym->st_shndx != SHN_UNDEF && sym->st_shndx < SHN_LORESERVE) {
+        ElfSectionInfo *target = &elfobj->section_infos[sym->st_shndx];
+        gc_mark_string(target, sym->st_value);
+        gc_mark_section(stack, target);
+      }
+      break;
+    case STB_GLOBAL:
+      gc_mark_symbol(ld, stack, alloc_name(&str[sym->st_name], NULL, false));
+      break;
+    default: break;
+    }
+  }
+  elfobj_free_data(elfobj, relas, shdr->sh_offset);
+}
+
+static void ld_gc_sections(LinkEditor *ld, const Name *entry_name) {
+  Vector *stack = new_vector();  // <ElfSectionInfo*>
+  gc_mark_symbol(ld, stack, entry_name);
   for (int i = 0; i < ld->nfiles; ++i) {
     File *file = &ld->files[i];
     switch (file->kind) {
     case FK_ELFOBJ:
-      collect_sections_elfobj(ld, file->elfobj, name, seclist);
+      gc_mark_roots_elfobj(file->elfobj, stack);
       break;
     case FK_ARCHIVE:
-      collect_sections_archive(ld, file->archive, name, seclist);
+      FOREACH_FILE_ARCONTENT(file->archive, content, {
+        if (content->obj != NULL)
+          gc_mark_roots_elfobj(content->obj, stack);
+      });
       break;
     }
   }
+
+  while (stack->len > 0) {
+    ElfSectionInfo *section = vec_pop(stack);
+    gc_trace_section(ld, section, stack);
+  }
+  free_vector(stack);
+}
+
+// Sections which can grow in place on `--incremental` link.
+// Arrays walked from start to end symbols (.init_array, .xcc_prof, ...) must stay packed.
+static bool is_growable_section(const char *name) {
+  static const char *kGrowableSectionNames[] = {".text", ".rodata", ".data", ".bss"};
+  for (size_t i = 0; i < ARRAY_SIZE(kGrowableSectionNames); ++i) {
+    if (match_section_name(name, kGrowableSectionNames[i]))
+      return true;
+  }
+  return false;
 }
 
-static void ld_calc_address(SectionGroup section_groups[SECTION_COUNT], Vector *section_lists[SECTION_COUNT], uintptr_t start_address) {
+// Room for the section in the output: Incremental link leaves some padding after it.
+static size_t section_capacity(const ElfSectionInfo *section, bool incremental) {
+  size_t size = section->shdr->sh_size;
+  if (incremental && is_growable_section(section_name(section)))
+    size += ALIGN(size / 4, 16) + 64;
+  return size;
+}
+
+static void ld_calc_address(SectionGroup section_groups[SECTION_COUNT], Vector *section_lists[SECTION_COUNT], uintptr_t start_address, bool incremental) {
   uintptr_t address = start_address;
   for (int secno = 0; secno < SECTION_COUNT; ++secno) {
     Vector *v = section_lists[secno];
@@ -559,34 +1358,167 @@ static void ld_calc_address(SectionGroup section_groups[SECTION_COUNT], Vector *
             size_t align = shdr->sh_addralign;
             address = ALIGN(address, align);
             p->progbits.address = address;
-            size_t size = shdr->sh_size;
+            size_t size = section_capacity(p, incremental);
             address += size;
 
-            if (align > secgroup->align)
-              secgroup->align = align;
+            assert(align <= secgroup->align);
+
+            if (p->shdr->sh_type == SHT_NOBITS)
+              secgroup->bss_size += size;
+            else
+              secgroup->filesz = ALIGN(secgroup->filesz, align) + size;
+          }
+        }
+        break;
+      case LEK_SYMBOL:
+        elem->symbol.address = address;
+        break;
+      case LEK_ALIGN:
+        address = ALIGN(address, elem->align);
+        secgroup->filesz = ALIGN(secgroup->filesz, elem->align);
+        break;
+      }
+    }
+  }
+}
+
+// Output file image: Sections are copied directly into their final place, and relocated in place.
+typedef struct {
+  unsigned char *buf;
+  size_t size;
+  int fd;
+  bool mapped;  // `buf` is mapped to the file, otherwise allocated and written at last.
+} OutputImage;
+
+static void ld_place_section_groups(SectionGroup section_groups[SECTION_COUNT]) {
+  size_t offset = PROG_START;
+  for (int sec = 0; sec < SECTION_COUNT; ++sec) {
+    SectionGroup *secgroup = &section_groups[sec];
+    offset = ALIGN(offset, secgroup->align);
+    secgroup->file_offset = offset;
+    offset += secgroup->filesz;
+  }
+}
+
+static size_t calc_output_size(SectionGroup section_groups[SECTION_COUNT]) {
+  size_t size = PROG_START;
+  for (int sec = 0; sec < SECTION_COUNT; ++sec) {
+    const SectionGroup *secgroup = &section_groups[sec];
+    if (secgroup->filesz > 0)
+      size = secgroup->file_offset + secgroup->filesz;
+  }
+  return size;
+}
+
+static bool create_output_image(OutputImage *out, const char *ofn, size_t size) {
+  const int mod = S_IRUSR | S_IWUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;  // 0755
+  const int flag = O_RDWR | O_CREAT | O_TRUNC;
+  int fd = open(ofn, flag, mod);
+  if (fd < 0) {
+    perror("open failed");
+    return false;
+  }
 
-            if (p->shdr->sh_type == SHT_NOBITS)
-              secgroup->bss_size += size;
-          }
-        }
-        break;
-      case LEK_SYMBOL:
-        elem->symbol.address = address;
-        break;
-      case LEK_ALIGN:
-        address = ALIGN(address, elem->align);
+  out->size = size;
+  out->fd = fd;
+  out->mapped = false;
+  if (ftruncate(fd, size) == 0) {
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p != MAP_FAILED) {
+      out->buf = p;
+      out->mapped = true;
+      return true;
+    }
+  }
+  out->buf = calloc_or_die(size);
+  return true;
+}
+
+static bool close_output_image(OutputImage *out) {
+  bool result = true;
+  if (out->mapped) {
+    munmap(out->buf, out->size);
+  } else {
+    for (size_t written = 0; written < out->size; ) {
+      ssize_t n = write(out->fd, out->buf + written, out->size - written);
+      if (n <= 0) {
+        perror("write failed");
+        result = false;
         break;
       }
+      written += n;
+    }
+    free(out->buf);
+  }
+  close(out->fd);
+  return result;
+}
+
+typedef void (*SectionTaskFunc)(LinkEditor*, SectionTask*);
+
+#ifdef LD_USE_THREADS
+typedef struct {
+  LinkEditor *ld;
+  SectionTaskFunc func;
+  atomic_int next;
+} SectionTaskQueue;
+
+static void *section_task_worker(void *arg) {
+  SectionTaskQueue *queue = arg;
+  LinkEditor *ld = queue->ld;
+  Vector *tasks = ld->section_tasks;
+  for (;;) {
+    int i = atomic_fetch_add(&queue->next, 1);
+    if (i >= tasks->len)
+      break;
+    (*queue->func)(ld, tasks->data[i]);
+  }
+  return NULL;
+}
+#endif
+
+// Call `func` for every section task, on `ld->nthreads` threads.
+static void run_section_tasks(LinkEditor *ld, SectionTaskFunc func) {
+  Vector *tasks = ld->section_tasks;
+#ifdef LD_USE_THREADS
+  int nthreads = ld->nthreads < tasks->len ? ld->nthreads : tasks->len;
+  if (nthreads > 1) {
+    SectionTaskQueue queue = {.ld = ld, .func = func};
+    atomic_init(&queue.next, 0);
+    pthread_t *threads = malloc_or_die(sizeof(*threads) * (nthreads - 1));
+    int nstarted = 0;
+    for (; nstarted < nthreads - 1; ++nstarted) {
+      if (pthread_create(&threads[nstarted], NULL, section_task_worker, &queue) != 0)
+        break;  // Continue with the threads available.
     }
+    section_task_worker(&queue);
+    for (int i = 0; i < nstarted; ++i)
+      pthread_join(threads[i], NULL);
+    free(threads);
+    return;
   }
+#endif
+  for (int i = 0; i < tasks->len; ++i)
+    (*func)(ld, tasks->data[i]);
+}
+
+static void copy_section_content(LinkEditor *ld, SectionTask *task) {
+  UNUSED(ld);
+  ElfSectionInfo *p = task->section;
+  ElfObj *elfobj = p->elfobj;
+  if (elfobj->image != NULL)
+    memcpy(p->progbits.content, elfobj->image + p->shdr->sh_offset, p->shdr->sh_size);
 }
 
-static void ld_load_elf_objects(Vector *section_lists[SECTION_COUNT]) {
+// Assign the place in the output image for each section, and copy the contents.
+static void ld_load_elf_objects(LinkEditor *ld, Vector *section_lists[SECTION_COUNT], SectionGroup section_groups[SECTION_COUNT], OutputImage *out) {
   for (int secno = 0; secno < SECTION_COUNT; ++secno) {
     Vector *v = section_lists[secno];
     if (v->len <= 0)
       continue;
 
+    const SectionGroup *secgroup = &section_groups[secno];
+    unsigned char *group_top = out->buf + secgroup->file_offset;
     for (int i = 0; i < v->len; ++i) {
       LinkElem *elem = v->data[i];
       switch (elem->kind) {
@@ -605,9 +1537,19 @@ static void ld_load_elf_objects(Vector *section_lists[SECTION_COUNT]) {
                 Elf64_Xword size = shdr->sh_size;
                 assert(size > 0);
 
+                unsigned char *dst = group_top + (p->progbits.address - secgroup->start_address);
+                assert(dst + size <= out->buf + out->size);
+                p->progbits.content = dst;
+
                 ElfObj *elfobj = p->elfobj;
-                void *buf = read_or_die(elfobj->fp, NULL, shdr->sh_offset + elfobj->start_offset, size, "read error");
-                p->progbits.content = buf;
+                if (elfobj->image == NULL) {
+                  // Reading through FILE cannot be shared among threads.
+                  elfobj_read(elfobj, dst, shdr->sh_offset, size, "read error");
+                }
+
+                SectionTask *task = calloc_or_die(sizeof(*task));
+                task->section = p;
+                vec_push(ld->section_tasks, task);
               }
               break;
             default: break;
@@ -621,63 +1563,62 @@ static void ld_load_elf_objects(Vector *section_lists[SECTION_COUNT]) {
       }
     }
   }
-}
 
-static void output_section(FILE *fp, SectionGroup *secgroup) {
-  if (secgroup->ds == NULL)
-    return;
-  DataStorage *ds = secgroup->ds;
-  const void *buf = ds->buf;
-  fwrite(buf, ds->len, 1, fp);
+  run_section_tasks(ld, copy_section_content);
 }
 
-static bool output_exe(const char *ofn, uintptr_t entry_address, SectionGroup section_groups[SECTION_COUNT]) {
-  int phnum = section_groups[SEC_DATA].ds->len > 0 || section_groups[SEC_DATA].bss_size > 0 ? 2 : 1;
+static int ld_resolve_relas(LinkEditor *ld) {
+  Vector *tasks = ld->section_tasks;
+  for (int i = 0; i < tasks->len; ++i) {
+    SectionTask *task = tasks->data[i];
+    const ElfSectionInfo *rela_info = task->section->progbits.rela;
+    if (rela_info == NULL || rela_info->shdr->sh_size <= 0)
+      continue;
+    const Elf64_Shdr *shdr = rela_info->shdr;
+    task->relas = elfobj_data(task->section->elfobj, shdr->sh_offset, shdr->sh_size,
+                              _Alignof(Elf64_Rela), "read error");
+  }
 
-  FILE *fp;
-  if (ofn == NULL) {
-    fp = stdout;
-  } else {
-    const int mod = S_IRUSR | S_IWUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;  // 0755
-    const int flag = O_WRONLY | O_CREAT | O_TRUNC;
-    int fd = open(ofn, flag, mod);
-    if (fd < 0) {
-      perror("open failed");
-      return false;
+  run_section_tasks(ld, resolve_rela_section);
+
+  // Report in the order of the output, regardless of the threads.
+  int error_count = 0;
+  for (int i = 0; i < tasks->len; ++i) {
+    SectionTask *task = tasks->data[i];
+    if (task->relas != NULL) {
+      elfobj_free_data(task->section->elfobj, task->relas,
+                       task->section->progbits.rela->shdr->sh_offset);
+      task->relas = NULL;
+    }
+    if (task->error_count > 0) {
+      fprintf(stderr, "Unhandled rela type: %" PRIx32 "\n", task->error_type);
+      error_count += task->error_count;
     }
-    fp = fdopen(fd, "wb");
-    assert(fp != NULL);
   }
+  return error_count;
+}
 
-  size_t code_rodata_sz = section_groups[SEC_TEXT].ds->len;
+static void output_exe(OutputImage *out, uintptr_t entry_address, SectionGroup section_groups[SECTION_COUNT]) {
+  int phnum = section_groups[SEC_DATA].filesz > 0 || section_groups[SEC_DATA].bss_size > 0 ? 2 : 1;
+
+  size_t code_rodata_sz = section_groups[SEC_TEXT].filesz;
 #if XCC_TARGET_ARCH == XCC_ARCH_RISCV64
   const int flags = EF_RISCV_RVC | EF_RISCV_FLOAT_ABI_DOUBLE;
 #else
   const int flags = 0;
 #endif
-  out_elf_header(fp, entry_address, phnum, 0, flags, 0);
-  out_program_header(fp, 0, PROG_START, section_groups[SEC_TEXT].start_address, code_rodata_sz, code_rodata_sz);
+  Elf64_Ehdr *ehdr = (Elf64_Ehdr*)out->buf;
+  Elf64_Phdr *phdrs = (Elf64_Phdr*)(out->buf + sizeof(*ehdr));
+  assert(sizeof(*ehdr) + sizeof(*phdrs) * phnum <= PROG_START);
+  init_elf_header(ehdr, entry_address, phnum, 0, flags, 0);
+  init_program_header(&phdrs[0], 0, PROG_START, section_groups[SEC_TEXT].start_address, code_rodata_sz, code_rodata_sz);
   if (phnum > 1) {
-    size_t datamemsz = section_groups[SEC_DATA].ds->len + section_groups[SEC_DATA].bss_size;
+    size_t datamemsz = section_groups[SEC_DATA].filesz + section_groups[SEC_DATA].bss_size;
     uintptr_t offset = PROG_START + code_rodata_sz;
-    if (section_groups[SEC_DATA].ds->len > 0)
+    if (section_groups[SEC_DATA].filesz > 0)
       offset = ALIGN(offset, DATA_ALIGN);
-    out_program_header(fp, 1, offset, section_groups[SEC_DATA].start_address, section_groups[SEC_DATA].ds->len, datamemsz);
-  }
-
-  uintptr_t addr = PROG_START;
-  for (int sec = 0; sec < SECTION_COUNT; ++sec) {
-    addr = ALIGN(addr, section_groups[sec].align);
-    size_t size = section_groups[sec].ds->len;
-    if (size <= 0)
-      continue;
-    put_padding(fp, addr);
-    output_section(fp, &section_groups[sec]);
-    addr += size;
+    init_program_header(&phdrs[1], 1, offset, section_groups[SEC_DATA].start_address, section_groups[SEC_DATA].filesz, datamemsz);
   }
-  fclose(fp);
-
-  return true;
 }
 
 static void dump_map_elfobj(LinkEditor *ld, ElfObj *elfobj, File *file, ArContent *content, FILE *fp) {
@@ -686,6 +1627,9 @@ static void dump_map_elfobj(LinkEditor *ld, ElfObj *elfobj, File *file, ArConten
   for (int it = 0; (it = table_iterate(elfobj->symbol_table, it, &name, (void**)&sym)) != -1; ) {
     if (sym->st_shndx == SHN_UNDEF)
       continue;
+    if (ld->gc_sections && sym->st_shndx < SHN_LORESERVE &&
+        !elfobj->section_infos[sym->st_shndx].progbits.live)
+      continue;  // Removed.
 
     uintptr_t address = 0;
     switch (ELF64_ST_BIND(sym->st_info)) {
@@ -779,6 +1723,12 @@ typedef struct {
   const char *ofn;
   const char *entry;
   const char *outmapfn;
+  int threads;
+  bool gc_sections;
+  bool icf;
+  bool print_icf_sections;
+  bool incremental;
+  bool verbose;
 } Options;
 
 static Vector *parse_options(int argc, char *argv[], Options *opts) {
@@ -786,6 +1736,12 @@ static Vector *parse_options(int argc, char *argv[], Options *opts) {
     OPT_HELP = 128,
     OPT_VERSION,
     OPT_OUTMAP,
+    OPT_GC_SECTIONS,
+    OPT_ICF,
+    OPT_PRINT_ICF_SECTIONS,
+    OPT_THREADS,
+    OPT_INCREMENTAL,
+    OPT_VERBOSE,
 
     OPT_NO_PIE,
   };
@@ -796,7 +1752,14 @@ static Vector *parse_options(int argc, char *argv[], Options *opts) {
     {"l", required_argument},  // Library
     {"L", required_argument},  // Add library path
     {"Map", required_argument, OPT_OUTMAP},  // Output map file
+    {"f", required_argument},  // -ftime-report, -fmem-report
     {"-version", no_argument, 'V'},
+    {"-gc-sections", no_argument, OPT_GC_SECTIONS},  // Remove unreferenced sections
+    {"-icf", no_argument, OPT_ICF},  // Fold identical functions
+    {"-print-icf-sections", no_argument, OPT_PRINT_ICF_SECTIONS},
+    {"-threads", required_argument, OPT_THREADS},  // Number of threads to fill the output
+    {"-incremental", no_argument, OPT_INCREMENTAL},  // Patch changed objects into the last output
+    {"-verbose", no_argument, OPT_VERBOSE},  // Report the path taken by --incremental
 
     {"no-pie", no_argument, OPT_NO_PIE},
     {NULL},
@@ -842,6 +1805,37 @@ static Vector *parse_options(int argc, char *argv[], Options *opts) {
     case OPT_OUTMAP:
       opts->outmapfn = optarg;
       break;
+    case OPT_GC_SECTIONS:
+      opts->gc_sections = true;
+      break;
+    case OPT_ICF:
+      opts->icf = true;
+      break;
+    case OPT_PRINT_ICF_SECTIONS:
+      opts->print_icf_sections = true;
+      break;
+    case OPT_INCREMENTAL:
+      opts->incremental = true;
+      break;
+    case OPT_VERBOSE:
+      opts->verbose = true;
+      break;
+    case OPT_THREADS:
+      {
+        char *end;
+        long n = strtol(optarg, &end, 10);
+        if (*end != '\0' || n < 1) {
+          fprintf(stderr, "Illegal thread count: %s\n", optarg);
+          ++error_count;
+        } else {
+          opts->threads = n;
+        }
+      }
+      break;
+    case 'f':
+      if (!parse_report_option(optarg))
+        fprintf(stderr, "Warning: unknown option: %s\n", argv[optind - 1]);
+      break;
     case OPT_NO_PIE:
       // Silently ignored.
       break;
@@ -886,6 +1880,11 @@ static const ElemData kDataSectionNames[] = {
   {.kind = LEK_SECTION, .section = {.name = ".fini_array"}},
   {.kind = LEK_SYMBOL, .symbol = {.name = "__fini_array_end"}},
 
+  {.kind = LEK_ALIGN, .align = 8},
+  {.kind = LEK_SYMBOL, .symbol = {.name = "__xcc_prof_start"}},
+  {.kind = LEK_SECTION, .section = {.name = ".xcc_prof"}},
+  {.kind = LEK_SYMBOL, .symbol = {.name = "__xcc_prof_end"}},
+
   {.kind = LEK_SECTION, .section = {.name = ".bss"}},
   {.kind = -1},
 };
@@ -944,10 +1943,9 @@ static void prepare_section_groups(Vector *section_lists[SECTION_COUNT], Section
     SectionGroup *secgroup = &section_groups[secno];
     secgroup->align = secno == SEC_DATA ? DATA_ALIGN : 1;
     secgroup->start_address = 0;
-    secgroup->ds = NULL;
+    secgroup->file_offset = 0;
+    secgroup->filesz = 0;
     secgroup->bss_size = 0;
-    secgroup->ds = calloc_or_die(sizeof(*secgroup->ds));
-    data_init(secgroup->ds);
 
     Vector *seclist = section_lists[secno];
     for (int i = 0; i < seclist->len; ++i) {
@@ -978,51 +1976,677 @@ static void prepare_section_groups(Vector *section_lists[SECTION_COUNT], Section
   }
 }
 
-static void collect_section_data(Vector *section_lists[SECTION_COUNT], SectionGroup section_groups[SECTION_COUNT]) {
+static bool is_collected_section(const char *name) {
   for (int secno = 0; secno < SECTION_COUNT; ++secno) {
-    Vector *v = section_lists[secno];
-    for (int i = 0; i < v->len; ++i) {
-      LinkElem *elem = v->data[i];
-      switch (elem->kind) {
-      case LEK_SECTION:
-        {
-          Vector *list = elem->section.list;
-          for (int j = 0; j < list->len; ++j) {
-            ElfSectionInfo *p = list->data[j];
-            add_elf_section(section_groups, p, secno);
-          }
-        }
+    for (const ElemData *p = kSectionNames[secno]; (int)p->kind >= 0; ++p) {
+      if (p->kind == LEK_SECTION && match_section_name(name, p->section.name))
+        return true;
+    }
+  }
+  return false;
+}
+
+// Incremental link
+//
+// `--incremental` saves the state of the link next to the output, and leaves padding after
+// growable sections. On the next link, if only object files are changed and their sections
+// still fit, they are patched into the output in place: Their sections are copied and
+// relocated again, and relocations in the other objects which refer to the global symbols
+// in them are applied again. Otherwise it falls back to the full link.
+//
+// State file is a text:
+//   xcc-ld-state <version>
+//   entry <name>
+//   output <stamp>
+//   files <count>, followed by lines:     <stamp> <path>
+//   symbols <count>, followed by lines:   <owner> <address> <name>
+//   sections <count>, followed by lines:  <owner> <shndx> <sh_type> <address> <size> <capacity> <name>
+//   relocs <count>, followed by lines:    <owner> <symbol> <type> <location> <pc> <addend>
+// `stamp` is `<size> <mtime> <mtime-nsec>` of the file, and `owner` is the index of the input
+// file (-1 for generated symbols). Relocations are kept only if they refer global symbols:
+// Others never change unless their owner is changed.
+
+#define INCREMENTAL_STATE_VERSION  (1)
+
+typedef struct {
+  int64_t size;
+  int64_t mtime;
+  int64_t mtime_nsec;
+} FileStamp;
+
+typedef struct {
+  int owner;
+  uintptr_t address;
+  const Name *name;
+} IncrementalSymbol;
+
+typedef struct {
+  int owner;
+  int shndx;
+  uint32_t sh_type;
+  uintptr_t address;
+  size_t size;
+  size_t capacity;
+  const char *name;
+} IncrementalSection;
+
+typedef struct {
+  int owner;
+  int symbol;  // Index of `symbols`.
+  uint32_t type;
+  uintptr_t location;
+  uintptr_t pc;
+  int64_t addend;
+} IncrementalReloc;
+
+typedef struct {
+  const char *entry;
+  FileStamp output;
+  int nfiles;
+  FileStamp *file_stamps;
+  const char **file_paths;
+  Vector *symbols;  // <IncrementalSymbol*>
+  Vector *sections;  // <IncrementalSection*>
+  IncrementalReloc *relocs;
+  int reloc_count;
+  int reloc_capacity;
+} IncrementalState;
+
+static char *incremental_state_path(const char *ofn) {
+  static const char kSuffix[] = ".ldstate";
+  size_t len = strlen(ofn);
+  char *path = malloc_or_die(len + sizeof(kSuffix));
+  memcpy(path, ofn, len);
+  memcpy(path + len, kSuffix, sizeof(kSuffix));
+  return path;
+}
+
+static bool get_file_stamp(const char *path, FileStamp *stamp) {
+  struct stat st;
+  if (stat(path, &st) != 0)
+    return false;
+  stamp->size = st.st_size;
+  stamp->mtime = st.st_mtime;
+#if defined(__APPLE__)
+  stamp->mtime_nsec = st.st_mtimespec.tv_nsec;
+#else
+  stamp->mtime_nsec = st.st_mtim.tv_nsec;
+#endif
+  return true;
+}
+
+static bool equal_file_stamp(const FileStamp *a, const FileStamp *b) {
+  return a->size == b->size && a->mtime == b->mtime && a->mtime_nsec == b->mtime_nsec;
+}
+
+static bool is_placed_section(const ElfSectionInfo *section) {
+  switch (section->shdr->sh_type) {
+  case SHT_PROGBITS:
+  case SHT_NOBITS:
+  case SHT_INIT_ARRAY:
+  case SHT_FINI_ARRAY:
+  case SHT_PREINIT_ARRAY:
+    return section->progbits.address != 0;
+  default:
+    return false;
+  }
+}
+
+// Objects loaded from the file: An archive gives its loaded members.
+static void file_elfobjs(File *file, Vector *elfobjs) {
+  switch (file->kind) {
+  case FK_ELFOBJ:
+    vec_push(elfobjs, file->elfobj);
+    break;
+  case FK_ARCHIVE:
+    FOREACH_FILE_ARCONTENT(file->archive, content, {
+      if (content->obj != NULL)
+        vec_push(elfobjs, content->obj);
+    });
+    break;
+  }
+}
+
+static void add_incremental_reloc(IncrementalState *state, const IncrementalReloc *reloc) {
+  if (state->reloc_count >= state->reloc_capacity) {
+    int capacity = state->reloc_capacity > 0 ? state->reloc_capacity * 2 : 1024;
+    state->relocs = realloc_or_die(state->relocs, sizeof(*state->relocs) * capacity);
+    state->reloc_capacity = capacity;
+  }
+  state->relocs[state->reloc_count++] = *reloc;
+}
+
+// Keep relocations in the object which refer global symbols.
+static void collect_incremental_relocs(IncrementalState *state, ElfObj *elfobj, int owner,
+                                       Table *symbol_indices) {
+  for (Elf64_Half sec = 0; sec < elfobj->ehdr.e_shnum; ++sec) {
+    const ElfSectionInfo *section = &elfobj->section_infos[sec];
+    if (!is_placed_section(section) || section->progbits.rela == NULL)
+      continue;
+    const Elf64_Shdr *shdr = section->progbits.rela->shdr;
+    const Elf64_Rela *relas = elfobj_data(elfobj, shdr->sh_offset, shdr->sh_size,
+                                          _Alignof(Elf64_Rela), "read error");
+    const ElfSectionInfo *symhdrinfo = &elfobj->section_infos[shdr->sh_link];
+    const char *str = symhdrinfo->symtab.strtab->strtab.buf;
+    for (size_t j = 0, n = shdr->sh_size / sizeof(Elf64_Rela); j < n; ++j) {
+      const Elf64_Rela *src = rela_symbol_source(relas, j);
+      const Elf64_Sym *sym = &symhdrinfo->symtab.syms[ELF64_R_SYM(src->r_info)];
+      if (ELF64_ST_BIND(sym->st_info) != STB_GLOBAL)
+        continue;
+      const Name *name = alloc_name(&str[sym->st_name], NULL, false);
+      void *index;
+      if (!table_try_get(symbol_indices, name, &index))
+        continue;
+      IncrementalReloc reloc = {
+        .owner = owner,
+        .symbol = (int)(intptr_t)index,
+        .type = ELF64_R_TYPE(relas[j].r_info),
+        .location = section->progbits.address + relas[j].r_offset,
+        .pc = section->progbits.address + src->r_offset,
+        .addend = src->r_addend,
+      };
+      add_incremental_reloc(state, &reloc);
+    }
+    elfobj_free_data(elfobj, relas, shdr->sh_offset);
+  }
+}
+
+static Table *make_symbol_indices(const IncrementalState *state) {
+  Table *symbol_indices = alloc_table();
+  Vector *symbols = state->symbols;
+  for (int i = 0; i < symbols->len; ++i) {
+    const IncrementalSymbol *symbol = symbols->data[i];
+    table_put(symbol_indices, symbol->name, (void*)(intptr_t)i);
+  }
+  return symbol_indices;
+}
+
+static IncrementalState *build_incremental_state(LinkEditor *ld, const char *entry) {
+  IncrementalState *state = calloc_or_die(sizeof(*state));
+  state->entry = entry;
+  state->nfiles = ld->nfiles;
+  state->file_stamps = calloc_or_die(sizeof(*state->file_stamps) * ld->nfiles);
+  state->file_paths = calloc_or_die(sizeof(*state->file_paths) * ld->nfiles);
+  state->symbols = new_vector();
+  state->sections = new_vector();
+
+  Vector *elfobjs = new_vector();
+  for (int i = 0; i < ld->nfiles; ++i) {
+    File *file = &ld->files[i];
+    state->file_paths[i] = file->filename;
+
+    elfobjs->len = 0;
+    file_elfobjs(file, elfobjs);
+    for (int k = 0; k < elfobjs->len; ++k) {
+      ElfObj *elfobj = elfobjs->data[k];
+      const Name *name;
+      for (int it = 0; (it = table_iterate(elfobj->symbol_table, it, &name, NULL)) != -1; ) {
+        if (table_get(ld->symbol_table, name) != elfobj)
+          continue;
+        IncrementalSymbol *symbol = malloc_or_die(sizeof(*symbol));
+        symbol->owner = i;
+        symbol->address = ld_symbol_address(ld, name);
+        symbol->name = name;
+        vec_push(state->symbols, symbol);
+      }
+
+      for (Elf64_Half sec = 0; sec < elfobj->ehdr.e_shnum; ++sec) {
+        const ElfSectionInfo *info = &elfobj->section_infos[sec];
+        if (!is_placed_section(info))
+          continue;
+        IncrementalSection *section = malloc_or_die(sizeof(*section));
+        section->owner = i;
+        section->shndx = sec;
+        section->sh_type = info->shdr->sh_type;
+        section->address = info->progbits.address;
+        section->size = info->shdr->sh_size;
+        section->capacity = section_capacity(info, true);
+        section->name = section_name(info);
+        vec_push(state->sections, section);
+      }
+    }
+  }
+  {
+    const Name *name;
+    LinkElem *elem;
+    for (int it = 0; (it = table_iterate(ld->generated_symbol_table, it, &name, (void**)&elem)) != -1; ) {
+      IncrementalSymbol *symbol = malloc_or_die(sizeof(*symbol));
+      symbol->owner = -1;
+      symbol->address = elem->symbol.address;
+      symbol->name = name;
+      vec_push(state->symbols, symbol);
+    }
+  }
+
+  Table *symbol_indices = make_symbol_indices(state);
+  for (int i = 0; i < ld->nfiles; ++i) {
+    elfobjs->len = 0;
+    file_elfobjs(&ld->files[i], elfobjs);
+    for (int k = 0; k < elfobjs->len; ++k)
+      collect_incremental_relocs(state, elfobjs->data[k], i, symbol_indices);
+  }
+  free_vector(elfobjs);
+  return state;
+}
+
+static void save_incremental_state(IncrementalState *state, const char *ofn) {
+  char *path = incremental_state_path(ofn);
+  bool ok = get_file_stamp(ofn, &state->output);
+  for (int i = 0; ok && i < state->nfiles; ++i)
+    ok = get_file_stamp(state->file_paths[i], &state->file_stamps[i]);
+  FILE *fp = ok ? fopen(path, "w") : NULL;
+  if (fp == NULL) {
+    remove(path);
+    free(path);
+    return;
+  }
+
+#define STAMP(s)  (long long)(s)->size, (long long)(s)->mtime, (long long)(s)->mtime_nsec
+  fprintf(fp, "xcc-ld-state %d\n", INCREMENTAL_STATE_VERSION);
+  fprintf(fp, "entry %s\n", state->entry);
+  fprintf(fp, "output %lld %lld %lld\n", STAMP(&state->output));
+  fprintf(fp, "files %d\n", state->nfiles);
+  for (int i = 0; i < state->nfiles; ++i)
+    fprintf(fp, "%lld %lld %lld %s\n", STAMP(&state->file_stamps[i]), state->file_paths[i]);
+#undef STAMP
+
+  Vector *symbols = state->symbols;
+  fprintf(fp, "symbols %d\n", symbols->len);
+  for (int i = 0; i < symbols->len; ++i) {
+    const IncrementalSymbol *symbol = symbols->data[i];
+    fprintf(fp, "%d %lld %.*s\n", symbol->owner, (long long)symbol->address, NAMES(symbol->name));
+  }
+
+  Vector *sections = state->sections;
+  fprintf(fp, "sections %d\n", sections->len);
+  for (int i = 0; i < sections->len; ++i) {
+    const IncrementalSection *section = sections->data[i];
+    fprintf(fp, "%d %d %d %lld %lld %lld %s\n", section->owner, section->shndx,
+            (int)section->sh_type, (long long)section->address, (long long)section->size,
+            (long long)section->capacity, section->name);
+  }
+
+  fprintf(fp, "relocs %d\n", state->reloc_count);
+  for (int i = 0; i < state->reloc_count; ++i) {
+    const IncrementalReloc *reloc = &state->relocs[i];
+    fprintf(fp, "%d %d %d %lld %lld %lld\n", reloc->owner, reloc->symbol, (int)reloc->type,
+            (long long)reloc->location, (long long)reloc->pc, (long long)reloc->addend);
+  }
+
+  if (fclose(fp) != 0)
+    remove(path);
+  free(path);
+}
+
+// Reads integers from the line: Returns NULL if malformed.
+static char *parse_state_ints(char *p, int64_t *values, int count) {
+  for (int i = 0; i < count; ++i) {
+    char *q;
+    values[i] = strtoll(p, &q, 10);
+    if (q == p || (*q != ' ' && *q != '\0'))
+      return NULL;
+    p = *q == ' ' ? q + 1 : q;
+  }
+  return p;
+}
+
+static char *read_state_line(FILE *fp, char **line, size_t *capa) {
+  ssize_t len = getline(line, capa, fp);
+  if (len <= 0)
+    return NULL;
+  if ((*line)[len - 1] == '\n')
+    (*line)[len - 1] = '\0';
+  return *line;
+}
+
+// Reads a header line `<key> <value>` and returns the value.
+static char *read_state_header(FILE *fp, char **line, size_t *capa, const char *key) {
+  char *p = read_state_line(fp, line, capa);
+  size_t len = strlen(key);
+  if (p == NULL || strncmp(p, key, len) != 0 || p[len] != ' ')
+    return NULL;
+  return p + len + 1;
+}
+
+static bool read_state_count(FILE *fp, char **line, size_t *capa, const char *key, int *count) {
+  char *p = read_state_header(fp, line, capa, key);
+  int64_t value;
+  if (p == NULL || (p = parse_state_ints(p, &value, 1)) == NULL || *p != '\0' || value < 0)
+    return false;
+  *count = value;
+  return true;
+}
+
+static IncrementalState *load_incremental_state(const char *ofn) {
+  char *path = incremental_state_path(ofn);
+  FILE *fp = fopen(path, "r");
+  free(path);
+  if (fp == NULL)
+    return NULL;
+
+  IncrementalState *state = calloc_or_die(sizeof(*state));
+  state->symbols = new_vector();
+  state->sections = new_vector();
+  char *line = NULL;
+  size_t capa = 0;
+  char *p;
+  int64_t v[6];
+  int count;
+  bool ok = false;
+  do {
+    if ((p = read_state_header(fp, &line, &capa, "xcc-ld-state")) == NULL ||
+        (p = parse_state_ints(p, v, 1)) == NULL || v[0] != INCREMENTAL_STATE_VERSION)
+      break;
+    if ((p = read_state_header(fp, &line, &capa, "entry")) == NULL)
+      break;
+    state->entry = strdup(p);
+    if ((p = read_state_header(fp, &line, &capa, "output")) == NULL ||
+        parse_state_ints(p, v, 3) == NULL)
+      break;
+    state->output = (FileStamp){.size = v[0], .mtime = v[1], .mtime_nsec = v[2]};
+
+    if (!read_state_count(fp, &line, &capa, "files", &state->nfiles))
+      break;
+    state->file_stamps = calloc_or_die(sizeof(*state->file_stamps) * state->nfiles);
+    state->file_paths = calloc_or_die(sizeof(*state->file_paths) * state->nfiles);
+    int i;
+    for (i = 0; i < state->nfiles; ++i) {
+      if ((p = read_state_line(fp, &line, &capa)) == NULL || (p = parse_state_ints(p, v, 3)) == NULL)
         break;
-      case LEK_SYMBOL:
+      state->file_stamps[i] = (FileStamp){.size = v[0], .mtime = v[1], .mtime_nsec = v[2]};
+      state->file_paths[i] = strdup(p);
+    }
+    if (i < state->nfiles)
+      break;
+
+    if (!read_state_count(fp, &line, &capa, "symbols", &count))
+      break;
+    for (i = 0; i < count; ++i) {
+      if ((p = read_state_line(fp, &line, &capa)) == NULL || (p = parse_state_ints(p, v, 2)) == NULL ||
+          *p == '\0')
         break;
-      case LEK_ALIGN:
-        {
-          SectionGroup *secgroup = &section_groups[secno];
-          data_align(secgroup->ds, elem->align);
-        }
+      IncrementalSymbol *symbol = malloc_or_die(sizeof(*symbol));
+      symbol->owner = v[0];
+      symbol->address = v[1];
+      symbol->name = alloc_name(p, NULL, true);
+      vec_push(state->symbols, symbol);
+    }
+    if (i < count)
+      break;
+
+    if (!read_state_count(fp, &line, &capa, "sections", &count))
+      break;
+    for (i = 0; i < count; ++i) {
+      if ((p = read_state_line(fp, &line, &capa)) == NULL || (p = parse_state_ints(p, v, 6)) == NULL)
         break;
-      }
+      IncrementalSection *section = malloc_or_die(sizeof(*section));
+      section->owner = v[0];
+      section->shndx = v[1];
+      section->sh_type = v[2];
+      section->address = v[3];
+      section->size = v[4];
+      section->capacity = v[5];
+      section->name = strdup(p);
+      vec_push(state->sections, section);
+    }
+    if (i < count)
+      break;
+
+    if (!read_state_count(fp, &line, &capa, "relocs", &count))
+      break;
+    for (i = 0; i < count; ++i) {
+      if ((p = read_state_line(fp, &line, &capa)) == NULL || (p = parse_state_ints(p, v, 6)) == NULL ||
+          *p != '\0' || v[1] < 0 || v[1] >= state->symbols->len)
+        break;
+      IncrementalReloc reloc = {
+        .owner = v[0],
+        .symbol = v[1],
+        .type = v[2],
+        .location = v[3],
+        .pc = v[4],
+        .addend = v[5],
+      };
+      add_incremental_reloc(state, &reloc);
+    }
+    if (i < count)
+      break;
+    ok = true;
+  } while (0);
+  free(line);
+  fclose(fp);
+  return ok ? state : NULL;
+}
+
+// Check whether the changed object can replace the previous one in place:
+// It must define the same global symbols, refer only known symbols,
+// and have the same sections which fit in their places.
+static bool check_incremental_object(IncrementalState *state, Table *symbol_indices, ElfObj *elfobj, int owner) {
+  const char *str = elfobj->symtab_section->symtab.strtab->strtab.buf;
+  int defined_count = 0;
+  const Name *name;
+  Elf64_Sym *sym;
+  for (int it = 0; (it = table_iterate(elfobj->symbol_table, it, &name, (void**)&sym)) != -1; ) {
+    if (ELF64_ST_TYPE(sym->st_info) == STT_SECTION || str[sym->st_name] == '\0')
+      continue;
+    void *index;
+    if (!table_try_get(symbol_indices, name, &index))
+      return false;
+    if (sym->st_shndx != SHN_UNDEF) {
+      const IncrementalSymbol *symbol = state->symbols->data[(intptr_t)index];
+      if (symbol->owner != owner || sym->st_shndx >= SHN_LORESERVE)
+        return false;
+      ++defined_count;
+    }
+  }
+  for (int i = 0; i < state->symbols->len; ++i) {
+    const IncrementalSymbol *symbol = state->symbols->data[i];
+    if (symbol->owner == owner)
+      --defined_count;
+  }
+  if (defined_count != 0)
+    return false;
+
+  int placed_count = 0;
+  for (int i = 0; i < state->sections->len; ++i) {
+    const IncrementalSection *section = state->sections->data[i];
+    if (section->owner != owner)
+      continue;
+    if (section->shndx >= elfobj->ehdr.e_shnum)
+      return false;
+    const ElfSectionInfo *info = &elfobj->section_infos[section->shndx];
+    const Elf64_Shdr *shdr = info->shdr;
+    if (shdr->sh_type != section->sh_type || strcmp(section_name(info), section->name) != 0 ||
+        shdr->sh_size <= 0 || section->address % (shdr->sh_addralign > 0 ? shdr->sh_addralign : 1) != 0)
+      return false;
+    if (is_growable_section(section->name) ? shdr->sh_size > section->capacity
+                                           : shdr->sh_size != section->size)
+      return false;
+    ++placed_count;
+  }
+  // New section which is not placed yet.
+  for (int i = 0; i < elfobj->prog_sections->len; ++i) {
+    const ElfSectionInfo *section = elfobj->prog_sections->data[i];
+    if (is_collected_section(section_name(section)))
+      --placed_count;
+  }
+  return placed_count == 0;
+}
+
+#define FILE_OFFSET(address)  ((address) - (LOAD_ADDRESS - PROG_START))
+
+// Returns 0 on success, 1 on error, or -1 to fall back to the full link.
+static int incremental_link(Vector *sources, const Options *opts) {
+  IncrementalState *state = load_incremental_state(opts->ofn);
+  FileStamp output_stamp;
+  if (state == NULL || strcmp(state->entry, opts->entry) != 0 || state->nfiles != sources->len ||
+      !get_file_stamp(opts->ofn, &output_stamp) || !equal_file_stamp(&output_stamp, &state->output))
+    return -1;
+
+  int nfiles = sources->len;
+  bool *changed = calloc_or_die(sizeof(*changed) * nfiles);
+  int changed_count = 0;
+  for (int i = 0; i < nfiles; ++i) {
+    const char *path = sources->data[i];
+    FileStamp stamp;
+    if (strcmp(path, state->file_paths[i]) != 0 || !get_file_stamp(path, &stamp))
+      return -1;
+    if (strcasecmp(get_ext(path), "a") == 0 && is_thin_archive(path))
+      return -1;  // Members of a thin archive are not stamped.
+    if (!equal_file_stamp(&stamp, &state->file_stamps[i])) {
+      if (strcasecmp(get_ext(path), "o") != 0)
+        return -1;  // Archive members might be added or removed.
+      changed[i] = true;
+      ++changed_count;
+    }
+  }
+  if (changed_count == 0) {
+    if (opts->verbose)
+      fprintf(stderr, "Incremental: up to date\n");
+    return 0;
+  }
+
+  report_phase_begin("parse");
+  LinkEditor *ld = malloc_or_die(sizeof(*ld));
+  ld_init(ld, nfiles);
+  ld->nthreads = opts->threads;
+  Table *symbol_indices = make_symbol_indices(state);
+  bool ok = true;
+  for (int i = 0; i < nfiles && ok; ++i) {
+    if (!changed[i])
+      continue;
+    ld_load(ld, i, sources->data[i]);
+    ElfObj *elfobj = ld->files[i].elfobj;
+    ok = elfobj != NULL && elfobj->image != NULL &&
+        check_incremental_object(state, symbol_indices, elfobj, i);
+  }
+  report_phase_end();
+  if (!ok)
+    return -1;
+
+  int fd = open(opts->ofn, O_RDWR);
+  void *mapped = fd >= 0 ? mmap(NULL, state->output.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                         : MAP_FAILED;
+  if (mapped == MAP_FAILED) {
+    if (fd >= 0)
+      close(fd);
+    return -1;
+  }
+  OutputImage out = {.buf = mapped, .size = state->output.size, .fd = fd, .mapped = true};
+
+  // Put sections of the changed objects in their previous places.
+  report_phase_begin("layout");
+  for (int i = 0; i < state->sections->len; ++i) {
+    IncrementalSection *section = state->sections->data[i];
+    if (!changed[section->owner])
+      continue;
+    ElfObj *elfobj = ld->files[section->owner].elfobj;
+    ElfSectionInfo *info = &elfobj->section_infos[section->shndx];
+    info->progbits.address = section->address;
+    section->size = info->shdr->sh_size;
+    if (section->sh_type == SHT_NOBITS)
+      continue;
+    unsigned char *dst = out.buf + FILE_OFFSET(section->address);
+    assert(dst + section->capacity <= out.buf + out.size);
+    memset(dst, 0, section->capacity);
+    info->progbits.content = dst;
+
+    SectionTask *task = calloc_or_die(sizeof(*task));
+    task->section = info;
+    vec_push(ld->section_tasks, task);
+  }
+
+  // Symbols are resolved with the state, as generated ones.
+  bool *moved = calloc_or_die(sizeof(*moved) * state->symbols->len);
+  for (int i = 0; i < state->symbols->len; ++i) {
+    IncrementalSymbol *symbol = state->symbols->data[i];
+    if (symbol->owner >= 0 && changed[symbol->owner]) {
+      ElfObj *elfobj = ld->files[symbol->owner].elfobj;
+      const Elf64_Sym *sym = elfobj_find_symbol(elfobj, symbol->name);
+      assert(sym != NULL);
+      uintptr_t address = elfobj->section_infos[sym->st_shndx].progbits.address + sym->st_value;
+      moved[i] = address != symbol->address;
+      symbol->address = address;
     }
+    LinkElem *elem = new_link_elem(LEK_SYMBOL);
+    elem->symbol.address = symbol->address;
+    table_put(ld->generated_symbol_table, symbol->name, elem);
+  }
+  report_phase_end();
+
+  report_phase_begin("relocate");
+  run_section_tasks(ld, copy_section_content);
+  int error_count = ld_resolve_relas(ld);
+
+  // Apply relocations in the unchanged objects again, if they refer moved symbols.
+  int reloc_count = 0;
+  for (int i = 0; i < state->reloc_count; ++i) {
+    IncrementalReloc *reloc = &state->relocs[i];
+    if (changed[reloc->owner])
+      continue;
+    state->relocs[reloc_count++] = *reloc;
+    if (!moved[reloc->symbol])
+      continue;
+    const IncrementalSymbol *symbol = state->symbols->data[reloc->symbol];
+    if (!apply_rela(reloc->type, out.buf + FILE_OFFSET(reloc->location),
+                    symbol->address + reloc->addend, reloc->pc))
+      ++error_count;
+  }
+  state->reloc_count = reloc_count;
+  for (int i = 0; i < nfiles; ++i) {
+    if (changed[i])
+      collect_incremental_relocs(state, ld->files[i].elfobj, i, symbol_indices);
   }
+  report_phase_end();
+
+  report_phase_begin("emit");
+  const Name *entry_name = alloc_name(opts->entry, NULL, false);
+  uintptr_t entry_address = ld_symbol_address(ld, entry_name);
+  assert(entry_address != (uintptr_t)-1);
+  ((Elf64_Ehdr*)out.buf)->e_entry = entry_address;
+  bool result = close_output_image(&out);
+  report_phase_end();
+  if (error_count > 0 || !result) {
+    // Output is broken: Next link must be the full one.
+    unlink(opts->ofn);
+    return 1;
+  }
+
+  save_incremental_state(state, opts->ofn);
+  if (opts->verbose)
+    fprintf(stderr, "Incremental: patched %d of %d files\n", changed_count, nfiles);
+  return 0;
 }
 
 static int do_link(Vector *sources, const Options *opts) {
+  if (opts->incremental) {
+    int result = opts->outmapfn == NULL ? incremental_link(sources, opts) : -1;
+    if (result >= 0)
+      return result;
+    if (opts->verbose)
+      fprintf(stderr, "Incremental: full link\n");
+  }
+
   LinkEditor *ld = malloc_or_die(sizeof(*ld));
   ld_init(ld, sources->len);
+  ld->nthreads = opts->threads;
+  report_phase_begin("parse");
   for (int i = 0; i < sources->len; ++i) {
     char *src = sources->data[i];
     ld_load(ld, i, src);
   }
+  report_phase_end();
 
   const Name *entry_name = alloc_name(opts->entry, NULL, false);
   Table unresolved;
   table_init(&unresolved);
-  table_put(&unresolved, entry_name, (void*)entry_name);
+  add_unresolved(ld, &unresolved, entry_name);
 
   Vector *section_lists[SECTION_COUNT];  // <LinkElem*>
   prepare_section_lists(ld, section_lists);
 
+  report_phase_begin("resolve");
   ld_resolve_symbols(ld, &unresolved);
+  report_phase_end();
   if (unresolved.count > 0) {
     fprintf(stderr, "Unresolved: #%d\n", unresolved.count);
     const Name *name;
@@ -1032,27 +2656,50 @@ static int do_link(Vector *sources, const Options *opts) {
     return 1;
   }
 
+  report_phase_begin("layout");
+  if (opts->gc_sections) {
+    ld->gc_sections = true;
+    ld_gc_sections(ld, entry_name);
+  }
   collect_sections(ld, section_lists);
+  if (!opts->incremental)
+    ld_merge_strings(section_lists);
+  if (opts->icf)
+    ld_fold_identical_code(ld, section_lists, opts->print_icf_sections);
 
   SectionGroup section_groups[SECTION_COUNT];
   prepare_section_groups(section_lists, section_groups);
 
-  ld_calc_address(section_groups, section_lists, LOAD_ADDRESS);
-  ld_load_elf_objects(section_lists);
+  ld_calc_address(section_groups, section_lists, LOAD_ADDRESS, opts->incremental);
+  ld_place_section_groups(section_groups);
 
-  int error_count = ld_resolve_relas(ld);
-  if (error_count > 0)
+  OutputImage out;
+  if (!create_output_image(&out, opts->ofn, calc_output_size(section_groups)))
     return 1;
+  ld_load_elf_objects(ld, section_lists, section_groups, &out);
+  report_phase_end();
 
-  collect_section_data(section_lists, section_groups);
+  report_phase_begin("relocate");
+  int error_count = ld_resolve_relas(ld);
+  report_phase_end();
+  if (error_count > 0) {
+    close_output_image(&out);
+    unlink(opts->ofn);
+    return 1;
+  }
 
+  report_phase_begin("emit");
   uintptr_t entry_address = ld_symbol_address(ld, entry_name);
   assert(entry_address != (uintptr_t)-1);
 
-  bool result = output_exe(opts->ofn, entry_address, section_groups);
+  output_exe(&out, entry_address, section_groups);
+  bool result = close_output_image(&out);
 
   if (opts->outmapfn != NULL && result)
     result = output_map_file(ld, opts->outmapfn, entry_address, entry_name);
+  if (opts->incremental && result)
+    save_incremental_state(build_incremental_state(ld, opts->entry), opts->ofn);
+  report_phase_end();
   return result ? 0 : 1;
 }
 
@@ -1061,6 +2708,12 @@ int main(int argc, char *argv[]) {
     .ofn = NULL,
     .entry = kDefaultEntryName,
     .outmapfn = NULL,
+    .threads = 1,
+    .gc_sections = false,
+    .icf = false,
+    .print_icf_sections = false,
+    .incremental = false,
+    .verbose = false,
   };
   Vector *sources = parse_options(argc, argv, &opts);
 
@@ -1069,6 +2722,13 @@ int main(int argc, char *argv[]) {
 
   if (opts.ofn == NULL)
     opts.ofn = "a.out";
+  if (opts.incremental && (opts.gc_sections || opts.icf)) {
+    fprintf(stderr, "Warning: --incremental is ignored with %s\n",
+            opts.gc_sections ? "--gc-sections" : "--icf");
+    opts.incremental = false;
+  }
 
-  return do_link(sources, &opts);
+  int result = do_link(sources, &opts);
+  dump_report("ld");
+  return result;
 }
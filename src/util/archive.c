@@ -1,6 +1,7 @@
 #include "archive.h"
 
 #include <assert.h>
+#include <libgen.h>  // dirname
 #include <stdlib.h>  // strtoul
 #include <string.h>
 
@@ -9,24 +10,18 @@
 
 #include "util.h"
 
+#define THINMAG  "!<thin>\n"  // Same length as ARMAG.
+
 // 4bytes big endian
-static uint32_t read4be(FILE *fp) {
-  unsigned char buf[4];
-  read_or_die(fp, buf, -1, sizeof(buf), "read4be");
-  return (buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | buf[3];
+static uint32_t get4be(const unsigned char *p) {
+  return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
 }
 
-static uint32_t *read_file_offsets(FILE *fp, uint32_t symbol_count) {
-  uint32_t *file_offsets = malloc_or_die(sizeof(*file_offsets) * symbol_count);
-  read_or_die(fp, file_offsets, -1, sizeof(*file_offsets) * symbol_count, "Offsets");
-  // Convert big endian to machine endian.
-  uint32_t *p = file_offsets;
-  for (uint32_t i = 0; i < symbol_count; ++i) {
-    unsigned char *q = (unsigned char*)p;
-    uint32_t offset = (q[0] << 24) | (q[1] << 16) | (q[2] << 8) | q[3];
-    *p++ = offset;
-  }
-  return file_offsets;
+static size_t member_size(const struct ar_hdr *hdr) {
+  char sizestr[sizeof(hdr->ar_size) + 1];
+  memcpy(sizestr, hdr->ar_size, sizeof(hdr->ar_size));
+  sizestr[sizeof(hdr->ar_size)] = '\0';
+  return strtoul(sizestr, NULL, 10);
 }
 
 static int compare_uint32(const void *a, const void *b) {
@@ -78,98 +73,195 @@ static ArContent *allocate_contents_buffer(const uint32_t *file_offsets, uint32_
   return contents;
 }
 
-Archive *load_archive(const char *filename) {
+// Symbol index (`/` member): count, member header offsets, and names (all big endian).
+static void parse_symbol_index(Archive *ar, const unsigned char *buf, size_t size) {
+  if (size < 4)
+    error("Illegal symbol index");
+  uint32_t symbol_count = get4be(buf);
+  if (symbol_count == 0)
+    return;
+  if ((size - 4) / 4 < symbol_count)
+    error("Illegal symbol index");
+
+  uint32_t *file_offsets = malloc_or_die(sizeof(*file_offsets) * symbol_count);
+  for (uint32_t i = 0; i < symbol_count; ++i)
+    file_offsets[i] = get4be(&buf[4 + i * 4]);
+  size_t content_count;
+  ArContent *contents = allocate_contents_buffer(file_offsets, symbol_count, &content_count);
+
+  ArSymbol *symbols = malloc_or_die(sizeof(*symbols) * symbol_count);
+  ar->symbol_count = symbol_count;
+  ar->symbols = symbols;
+  for (uint32_t i = 0; i < symbol_count; ++i) {
+    ArSymbol *symbol = &symbols[i];
+    uint32_t value = file_offsets[i];
+    ArContent *p = bsearch(&value, contents, content_count, sizeof(*contents), compare_uint32);
+    assert(p != NULL);
+    uint32_t index = p - contents;
+    symbol->content = &contents[index];
+  }
+  free(file_offsets);
+
+  const char *strtab = (const char*)&buf[4 + symbol_count * 4];
+  const char *end = (const char*)&buf[size];
+  const char *p = strtab;
+  for (uint32_t i = 0; i < symbol_count; ++i) {
+    const char *q = memchr(p, '\0', end - p);
+    if (q == NULL)
+      error("Illegal strtab");
+
+    ArSymbol *symbol = &symbols[i];
+    const Name *name = alloc_name(p, q, false);
+    table_put(&ar->symbol_table, name, symbol);
+
+    p = q + 1;
+  }
+}
+
+static FILE *open_archive(const char *filename, bool *pthin) {
   FILE *fp;
   if (!is_file(filename) || (fp = fopen(filename, "rb")) == NULL)
     return NULL;
 
+  char mag[SARMAG];
+  read_or_die(fp, mag, -1, sizeof(mag), "Magic");
+  if (memcmp(mag, THINMAG, sizeof(mag)) == 0)
+    *pthin = true;
+  else if (memcmp(mag, ARMAG, sizeof(mag)) == 0)
+    *pthin = false;
+  else
+    error("Magic expected");
+  return fp;
+}
+
+bool is_thin_archive(const char *filename) {
+  bool thin = false;
+  FILE *fp = open_archive(filename, &thin);
+  if (fp != NULL)
+    fclose(fp);
+  return thin;
+}
+
+Archive *load_archive(const char *filename) {
+  bool thin;
+  FILE *fp = open_archive(filename, &thin);
+  if (fp == NULL)
+    return NULL;
+
   Archive *ar = calloc_or_die(sizeof(*ar));
   ar->fp = fp;
+  ar->image = NULL;
+  ar->filename = filename;
   ar->symbol_count = 0;
   ar->symbols = NULL;
   table_init(&ar->symbol_table);
   ar->contents = new_vector();
+  ar->long_names = NULL;
+  ar->long_names_size = 0;
+  ar->thin = thin;
 
-  char mag[SARMAG];
-  read_or_die(fp, mag, -1, sizeof(mag), "Magic");
-  if (memcmp(mag, ARMAG, sizeof(mag)) != 0)
-    error("Magic expected");
-
-  struct ar_hdr ghdr;
-  read_or_die(fp, &ghdr, -1, sizeof(ghdr), "Global header");
-  if (memcmp(ghdr.ar_fmag, ARFMAG, sizeof(ghdr.ar_fmag)) != 0)
-    error("FMagic expected");
-
-  uint32_t symbol_count = read4be(fp);
-  ar->symbol_count = symbol_count;
-  if (symbol_count > 0) {
-    uint32_t *file_offsets = read_file_offsets(fp, symbol_count);
-    size_t content_count;
-    ArContent *contents = allocate_contents_buffer(file_offsets, symbol_count, &content_count);
-
-    ArSymbol *symbols = malloc_or_die(sizeof(*symbols) * symbol_count);
-    ar->symbols = symbols;
-    for (uint32_t i = 0; i < symbol_count; ++i) {
-      ArSymbol *symbol = &symbols[i];
-      uint32_t value = file_offsets[i];
-      ArContent *p = bsearch(&value, contents, content_count, sizeof(*contents), compare_uint32);
-      assert(p != NULL);
-      uint32_t index = p - contents;
-      symbol->content = &contents[index];
-    }
+  // Special members precede objects: Symbol index (`/`) and long name table (`//`).
+  long offset = SARMAG;
+  for (;;) {
+    struct ar_hdr hdr;
+    if (fread(&hdr, sizeof(hdr), 1, fp) != 1)
+      break;  // No object.
+    if (memcmp(hdr.ar_fmag, ARFMAG, sizeof(hdr.ar_fmag)) != 0)
+      error("FMagic expected");
 
-    size_t pos = ftell(fp);
-    assert(pos < contents[0].file_offset);
-    size_t strtablen = contents[0].file_offset - pos;
-    char *strtab = malloc_or_die(strtablen);  // Buffer pointer is not kept.
-    read_or_die(fp, strtab, -1, strtablen, "Strtab");
-    char *p = strtab;
-    for (uint32_t i = 0; i < symbol_count; ++i) {
-      char *q = memchr(p, '\0', &strtab[strtablen] - p);
-      if (q == NULL)
-        error("Illegal strtab");
-
-      ArSymbol *symbol = &symbols[i];
-      const Name *name = alloc_name(p, q, false);
-      table_put(&ar->symbol_table, name, symbol);
-
-      p = q + 1;
+    size_t size = member_size(&hdr);
+    if (memcmp(hdr.ar_name, "/ ", 2) == 0) {
+      // Buffer is kept: Symbol names refer it.
+      unsigned char *buf = read_or_die(fp, NULL, -1, size, "Symbol index");
+      parse_symbol_index(ar, buf, size);
+    } else if (memcmp(hdr.ar_name, "// ", 3) == 0) {
+      ar->long_names = read_or_die(fp, NULL, -1, size, "Long names");
+      ar->long_names_size = size;
+    } else {
+      break;
     }
-
-    free(file_offsets);
+    offset += sizeof(hdr) + ALIGN(size, 2);
+    fseek(fp, offset, SEEK_SET);
   }
+  ar->members_offset = offset;
   return ar;
 }
 
-void *load_archive_content(Archive *ar, ArSymbol *symbol,
-                           void *(*load)(FILE*, const char*, size_t)) {
-  ArContent *content = symbol->content;
-  if (content->obj != NULL)
-    return content->obj;
+// Member name is `name/` for a short one, or `/offset` into the long name table.
+static const char *member_name(Archive *ar, const struct ar_hdr *hdr) {
+  const char *name = hdr->ar_name;
+  size_t len;
+  if (name[0] == '/' && name[1] >= '0' && name[1] <= '9') {
+    char offsetstr[sizeof(hdr->ar_name)];
+    memcpy(offsetstr, &name[1], sizeof(offsetstr) - 1);
+    offsetstr[sizeof(offsetstr) - 1] = '\0';
+    size_t offset = strtoul(offsetstr, NULL, 10);
+    if (offset >= ar->long_names_size)
+      error("Illegal long name: %s", ar->filename);
+    name = &ar->long_names[offset];
+    const char *p = memchr(name, '\n', ar->long_names_size - offset);
+    len = (p != NULL ? p : &ar->long_names[ar->long_names_size]) - name;
+  } else {
+    const char *p = memchr(name, '/', sizeof(hdr->ar_name));
+    len = (p != NULL ? p : &name[sizeof(hdr->ar_name)]) - name;
+  }
+  if (len > 0 && name[len - 1] == '/')
+    --len;
 
-  fseek(ar->fp, content->file_offset, SEEK_SET);
+  char *buf = malloc_or_die(len + 1);
+  memcpy(buf, name, len);
+  buf[len] = '\0';
+  if (ar->thin && !is_fullpath(buf)) {
+    // Relative to the directory of the archive.
+    char *path = JOIN_PATHS(dirname(strdup(ar->filename)), buf);
+    free(buf);
+    buf = path;
+  }
+  return buf;
+}
 
+static void *load_member(Archive *ar, ArContent *content,
+                         void *(*load)(Archive*, size_t, const char*, size_t)) {
   struct ar_hdr hdr;
-  read_or_die(ar->fp, &hdr, -1, sizeof(hdr), "hdr");
+  read_or_die(ar->fp, &hdr, content->file_offset, sizeof(hdr), "hdr");
   if (memcmp(hdr.ar_fmag, ARFMAG, sizeof(hdr.ar_fmag)) != 0)
     error("Malformed archive");
 
-  memcpy(content->name, hdr.ar_name, sizeof(hdr.ar_name));
-  char *p = memchr(content->name, '/', sizeof(hdr.ar_name));
-  if (p != NULL)
-    *p = '\0';
-
-  char sizestr[sizeof(hdr.ar_size) + 1];
-  memcpy(sizestr, hdr.ar_size, sizeof(hdr.ar_size));
-  sizestr[sizeof(hdr.ar_size)] = '\0';
-  content->size = strtoul(sizestr, NULL, 10);
+  content->name = member_name(ar, &hdr);
+  content->size = member_size(&hdr);
 
-  void *obj = (*load)(ar->fp, content->name, content->size);
+  size_t offset = ar->thin ? 0 : content->file_offset + sizeof(hdr);
+  void *obj = (*load)(ar, offset, content->name, content->size);
   if (obj == NULL) {
-    error("Failed to extract .o: %.*s", (int)sizeof(content->name), content->name);
+    error("Failed to extract .o: %s", content->name);
   }
   content->obj = obj;
-  vec_push(ar->contents, content);
+  return obj;
+}
+
+void *load_archive_content(Archive *ar, ArSymbol *symbol,
+                           void *(*load)(Archive*, size_t, const char*, size_t)) {
+  ArContent *content = symbol->content;
+  if (content->obj != NULL)
+    return content->obj;
 
+  void *obj = load_member(ar, content, load);
+  vec_push(ar->contents, content);
   return obj;
 }
+
+Vector *load_archive_members(Archive *ar, void *(*load)(Archive*, size_t, const char*, size_t)) {
+  Vector *members = new_vector();
+  fseek(ar->fp, 0, SEEK_END);
+  long file_size = ftell(ar->fp);
+  for (long offset = ar->members_offset; offset + (long)sizeof(struct ar_hdr) <= file_size; ) {
+    ArContent *content = calloc_or_die(sizeof(*content));
+    content->file_offset = offset;
+    load_member(ar, content, load);
+    vec_push(members, content);
+    offset += sizeof(struct ar_hdr);
+    if (!ar->thin)
+      offset += ALIGN(content->size, 2);
+  }
+  return members;
+}
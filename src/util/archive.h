@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 
@@ -11,24 +12,35 @@ typedef struct {
   void *obj;
   size_t size;
   uint32_t file_offset;
-  char name[16];
+  const char *name;  // Path of the member file for a thin archive.
 } ArContent;
 
 typedef struct {
   ArContent *content;
 } ArSymbol;
 
-typedef struct {
+typedef struct Archive {
   FILE *fp;
+  const unsigned char *image;  // Whole file mapped by the user if not NULL.
+  const char *filename;
   uint32_t symbol_count;
   ArSymbol *symbols;
   Table symbol_table;
   Vector *contents;  // <ArContent*>
+  const char *long_names;  // Content of `//` member, or NULL.
+  size_t long_names_size;
+  uint32_t members_offset;  // File offset of the first member header.
+  bool thin;  // Members are not stored, but referred by path.
 } Archive;
 
 Archive *load_archive(const char *filename);
+bool is_thin_archive(const char *filename);
+// `load` is called with the file offset, name and size of the member.
+// For a thin archive, the name is the path of the member file and the offset is 0.
 void *load_archive_content(Archive *ar, ArSymbol *symbol,
-                           void *(*load)(FILE*, const char*, size_t));
+                           void *(*load)(Archive*, size_t, const char*, size_t));
+// Load all members in file order, regardless of the symbol index.
+Vector *load_archive_members(Archive *ar, void *(*load)(Archive*, size_t, const char*, size_t));
 
 #define FOREACH_FILE_ARCONTENT(ar, content, body) \
   {Vector *contents = (ar)->contents; \
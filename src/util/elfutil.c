@@ -2,8 +2,9 @@
 #include "elfutil.h"
 
 #ifndef ELF_NOT_SUPPORTED
-void out_elf_header(FILE *fp, uintptr_t entry, int phnum, int shnum, int flags, uintptr_t shoff) {
-  Elf64_Ehdr ehdr = {
+void init_elf_header(Elf64_Ehdr *ehdr, uintptr_t entry, int phnum, int shnum, int flags,
+                     uintptr_t shoff) {
+  *ehdr = (Elf64_Ehdr){
     .e_ident     = { ELFMAG0, ELFMAG1, ELFMAG2 ,ELFMAG3,
                      ELFCLASS64, ELFDATA2LSB, EV_CURRENT, ELFOSABI_SYSV },
     .e_type      = phnum > 0 ? ET_EXEC : ET_REL,
@@ -20,18 +21,22 @@ void out_elf_header(FILE *fp, uintptr_t entry, int phnum, int shnum, int flags,
     .e_shnum     = shnum,
     .e_shstrndx  = shnum > 0 ? shnum - 1 : SHN_UNDEF,  // Assumes shstrndx is at last.
   };
+}
 
+void out_elf_header(FILE *fp, uintptr_t entry, int phnum, int shnum, int flags, uintptr_t shoff) {
+  Elf64_Ehdr ehdr;
+  init_elf_header(&ehdr, entry, phnum, shnum, flags, shoff);
   fwrite(&ehdr, sizeof(Elf64_Ehdr), 1, fp);
 }
 
-void out_program_header(FILE *fp, int sec, uintptr_t offset, uintptr_t vaddr, size_t filesz,
-                        size_t memsz) {
+void init_program_header(Elf64_Phdr *phdr, int sec, uintptr_t offset, uintptr_t vaddr,
+                         size_t filesz, size_t memsz) {
   static const int kFlags[] = {
     PF_R | PF_X,  // code
     PF_R | PF_W,  // rwdata
   };
 
-  Elf64_Phdr phdr = {
+  *phdr = (Elf64_Phdr){
     .p_type   = PT_LOAD,
     .p_offset = offset,
     .p_vaddr  = vaddr,
@@ -41,7 +46,32 @@ void out_program_header(FILE *fp, int sec, uintptr_t offset, uintptr_t vaddr, si
     .p_flags  = kFlags[sec],
     .p_align  = 0x1000,
   };
+}
 
+void out_program_header(FILE *fp, int sec, uintptr_t offset, uintptr_t vaddr, size_t filesz,
+                        size_t memsz) {
+  Elf64_Phdr phdr;
+  init_program_header(&phdr, sec, offset, vaddr, filesz, memsz);
   fwrite(&phdr, sizeof(Elf64_Phdr), 1, fp);
 }
+
+// Returns the header of the symbol table section in the object image, or NULL.
+const Elf64_Shdr *find_elf_symtab(const unsigned char *image, size_t size) {
+  if (size < sizeof(Elf64_Ehdr))
+    return NULL;
+  const Elf64_Ehdr *ehdr = (const Elf64_Ehdr*)image;
+  if (ehdr->e_ident[0] != ELFMAG0 || ehdr->e_ident[1] != ELFMAG1 ||
+      ehdr->e_ident[2] != ELFMAG2 || ehdr->e_ident[3] != ELFMAG3 ||
+      ehdr->e_ident[4] != ELFCLASS64 || ehdr->e_shentsize != sizeof(Elf64_Shdr) ||
+      ehdr->e_shoff > size || (size - ehdr->e_shoff) / sizeof(Elf64_Shdr) < ehdr->e_shnum)
+    return NULL;
+  const Elf64_Shdr *shdrs = (const Elf64_Shdr*)(image + ehdr->e_shoff);
+  for (int i = 0; i < ehdr->e_shnum; ++i) {
+    const Elf64_Shdr *shdr = &shdrs[i];
+    if (shdr->sh_type == SHT_SYMTAB && shdr->sh_link < ehdr->e_shnum &&
+        shdr->sh_offset <= size && size - shdr->sh_offset >= shdr->sh_size)
+      return shdr;
+  }
+  return NULL;
+}
 #endif  // !ELF_NOT_SUPPORTED
@@ -10,6 +10,11 @@
 #include <elf.h>
 #endif
 
+void init_elf_header(Elf64_Ehdr *ehdr, uintptr_t entry, int phnum, int shnum, int flags,
+                     uintptr_t shoff);
+void init_program_header(Elf64_Phdr *phdr, int sec, uintptr_t offset, uintptr_t vaddr,
+                         size_t filesz, size_t memsz);
 void out_elf_header(FILE *fp, uintptr_t entry, int phnum, int shnum, int flags, uintptr_t shoff);
 void out_program_header(FILE *fp, int sec, uintptr_t offset, uintptr_t vaddr, size_t filesz,
                         size_t memsz);
+const Elf64_Shdr *find_elf_symtab(const unsigned char *image, size_t size);
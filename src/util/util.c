@@ -7,6 +7,7 @@
 #include <stdlib.h>  // malloc
 #include <string.h>  // strcmp
 #include <sys/stat.h>
+#include <time.h>  // clock_gettime
 
 #include "../version.h"
 #include "table.h"
@@ -67,7 +68,12 @@ void *read_or_die(FILE *fp, void *buf, long offset, size_t size, const char *msg
   return buf;
 }
 
+// Allocation statistics for `-fmem-report`.
+static size_t total_alloc_count, total_alloc_bytes;
+
 void *malloc_or_die(size_t size) {
+  ++total_alloc_count;
+  total_alloc_bytes += size;
   void *p = malloc(size);
   if (p == NULL) {
     fprintf(stderr, "memory overflow\n");
@@ -77,6 +83,8 @@ void *malloc_or_die(size_t size) {
 }
 
 void *calloc_or_die(size_t size) {
+  ++total_alloc_count;
+  total_alloc_bytes += size;
   void *p = calloc(1, size);
   if (p == NULL) {
     fprintf(stderr, "memory overflow\n");
@@ -86,6 +94,8 @@ void *calloc_or_die(size_t size) {
 }
 
 void *realloc_or_die(void *ptr, size_t size) {
+  ++total_alloc_count;
+  total_alloc_bytes += size;
   void *p = realloc(ptr, size);
   if (p == NULL) {
     fprintf(stderr, "memory overflow\n");
@@ -348,6 +358,156 @@ int64_t wrap_value(int64_t value, int size, bool is_unsigned) {
   return value;
 }
 
+// Phase report
+
+#define MAX_REPORT_PHASES     (16)
+#define MAX_REPORT_DEPTH      (8)
+#define REPORT_TOP_FUNCTIONS  (10)
+
+typedef struct {
+  const char *name;
+  int count;
+  double wall, cpu;
+  size_t alloc_count, alloc_bytes;
+} PhaseStat;
+
+typedef struct {
+  PhaseStat *stat;
+  double wall, cpu;
+  size_t alloc_count, alloc_bytes;
+} PhaseFrame;
+
+typedef struct {
+  const Name *name;
+  double seconds;
+} FunctionStat;
+
+bool time_report;
+bool mem_report;
+
+static PhaseStat phase_stats[MAX_REPORT_PHASES];
+static int phase_stat_count;
+static PhaseFrame phase_stack[MAX_REPORT_DEPTH];
+static int phase_depth;
+static Vector *function_stats;  // <FunctionStat*>
+
+bool parse_report_option(const char *arg) {
+  if (strcmp(arg, "time-report") == 0) {
+    time_report = true;
+    return true;
+  }
+  if (strcmp(arg, "mem-report") == 0) {
+    mem_report = true;
+    return true;
+  }
+  return false;
+}
+
+static double get_clock(int clk_id) {
+  struct timespec ts;
+  if (clock_gettime(clk_id, &ts) != 0)
+    return 0;
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+double report_clock(void) {
+  return get_clock(CLOCK_MONOTONIC);
+}
+
+void report_phase_begin(const char *phase) {
+  if (!time_report && !mem_report)
+    return;
+
+  PhaseStat *stat = NULL;
+  for (int i = 0; i < phase_stat_count; ++i) {
+    if (strcmp(phase_stats[i].name, phase) == 0) {
+      stat = &phase_stats[i];
+      break;
+    }
+  }
+  if (stat == NULL) {
+    assert(phase_stat_count < MAX_REPORT_PHASES);
+    stat = &phase_stats[phase_stat_count++];
+    stat->name = phase;
+  }
+
+  assert(phase_depth < MAX_REPORT_DEPTH);
+  PhaseFrame *frame = &phase_stack[phase_depth++];
+  frame->stat = stat;
+  frame->wall = get_clock(CLOCK_MONOTONIC);
+  frame->cpu = get_clock(CLOCK_PROCESS_CPUTIME_ID);
+  frame->alloc_count = total_alloc_count;
+  frame->alloc_bytes = total_alloc_bytes;
+}
+
+void report_phase_end(void) {
+  if (!time_report && !mem_report)
+    return;
+
+  assert(phase_depth > 0);
+  PhaseFrame *frame = &phase_stack[--phase_depth];
+  PhaseStat *stat = frame->stat;
+  stat->count += 1;
+  stat->wall += get_clock(CLOCK_MONOTONIC) - frame->wall;
+  stat->cpu += get_clock(CLOCK_PROCESS_CPUTIME_ID) - frame->cpu;
+  stat->alloc_count += total_alloc_count - frame->alloc_count;
+  stat->alloc_bytes += total_alloc_bytes - frame->alloc_bytes;
+}
+
+void report_function(const Name *name, double seconds) {
+  if (!time_report)
+    return;
+  if (function_stats == NULL)
+    function_stats = new_vector();
+  FunctionStat *fs = malloc_or_die(sizeof(*fs));
+  fs->name = name;
+  fs->seconds = seconds;
+  vec_push(function_stats, fs);
+}
+
+static int compare_function_stat(const void *pa, const void *pb) {
+  const FunctionStat *a = *(const FunctionStat**)pa;
+  const FunctionStat *b = *(const FunctionStat**)pb;
+  return a->seconds < b->seconds ? 1 : a->seconds > b->seconds ? -1 : 0;
+}
+
+// {"tool":"cc1","phases":[{"name":"parse","count":1,"wall":0.1,"cpu":0.1,"allocs":1,"alloc_bytes":8},...],
+//  "functions":[{"name":"main","time":0.01},...]}
+void dump_report(const char *tool) {
+  if (!time_report && !mem_report)
+    return;
+
+  FILE *fp = stderr;
+  fprintf(fp, "{\"tool\":\"%s\",\"phases\":[", tool);
+  for (int i = 0; i < phase_stat_count; ++i) {
+    PhaseStat *stat = &phase_stats[i];
+    fprintf(fp, "%s{\"name\":\"%s\",\"count\":%d", i > 0 ? "," : "", stat->name, stat->count);
+    if (time_report)
+      fprintf(fp, ",\"wall\":%.6f,\"cpu\":%.6f", stat->wall, stat->cpu);
+    if (mem_report)
+      fprintf(fp, ",\"allocs\":%zu,\"alloc_bytes\":%zu", stat->alloc_count, stat->alloc_bytes);
+    fputc('}', fp);
+  }
+  fputc(']', fp);
+  if (mem_report)
+    fprintf(fp, ",\"total_allocs\":%zu,\"total_alloc_bytes\":%zu", total_alloc_count,
+            total_alloc_bytes);
+
+  if (time_report && function_stats != NULL) {
+    qsort(function_stats->data, function_stats->len, sizeof(*function_stats->data),
+          compare_function_stat);
+    fprintf(fp, ",\"functions\":[");
+    int n = MIN(function_stats->len, REPORT_TOP_FUNCTIONS);
+    for (int i = 0; i < n; ++i) {
+      FunctionStat *fs = function_stats->data[i];
+      fprintf(fp, "%s{\"name\":\"%.*s\",\"time\":%.6f}", i > 0 ? "," : "", NAMES(fs->name),
+              fs->seconds);
+    }
+    fputc(']', fp);
+  }
+  fprintf(fp, "}\n");
+}
+
 // Container
 
 Vector *new_vector(void) {
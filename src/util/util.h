@@ -57,6 +57,19 @@ const char *block_comment_start(const char *p);
 const char *block_comment_end(const char *p);
 int64_t wrap_value(int64_t value, int size, bool is_unsigned);
 
+// Phase report: -ftime-report, -fmem-report
+//   Printed to stderr as a JSON line at exit.
+
+extern bool time_report;
+extern bool mem_report;
+
+bool parse_report_option(const char *arg);  // `time-report` or `mem-report`
+void report_phase_begin(const char *phase);
+void report_phase_end(void);
+double report_clock(void);  // Wall time in seconds.
+void report_function(const Name *name, double seconds);
+void dump_report(const char *tool);
+
 // Container
 
 typedef struct Vector {
@@ -0,0 +1,429 @@
+// Coalesce wasm locals
+//
+// Every variable which is not `&` taken gets its own wasm local in `gen_wasm`,
+// so large functions (and inlined ones) declare many locals.
+// After the code of a function is generated, decode it, compute liveness of locals
+// on the control flow given by blocks and branches, and let locals of the same
+// value type share an index if their live ranges don't overlap.
+
+#include "../config.h"
+#include "wcc.h"
+
+#include <assert.h>
+#include <stdlib.h>  // free
+#include <string.h>
+
+#include "util.h"
+#include "wasm.h"
+#include "wasm_obj.h"
+
+#define NONE  ((uint32_t)-1)
+
+// Instructions which matter for liveness: local accesses and control flow.
+typedef struct {
+  uint32_t *targets;  // Branch: opener nodes of the destination labels (NONE=function).
+  uint32_t target_count;
+  uint32_t local;     // Local access: local index (except parameters).
+  uint32_t offset;    // Local access: offset of the index in the code.
+  uint32_t match;     // Opener: `end` node. else/catch: opener node.
+  uint32_t alt;       // if: `else` node. try: first catch node. catch: next catch node.
+  uint32_t try_node;  // Innermost try whose body contains this node (try: its parent).
+  unsigned char op;
+  unsigned char size;  // Local access: byte size of the index.
+} Node;
+
+typedef struct {
+  Node *nodes;
+  uint32_t count, capacity;
+  uint32_t local_count;  // Except parameters.
+  int words;             // Per bitset.
+  uint64_t *live_in;     // [count][words]
+} Func;
+
+static Node *add_node(Func *f, unsigned char op) {
+  if (f->count >= f->capacity) {
+    f->capacity = f->capacity > 0 ? f->capacity * 2 : 64;
+    f->nodes = realloc_or_die(f->nodes, sizeof(*f->nodes) * f->capacity);
+  }
+  Node *node = &f->nodes[f->count++];
+  memset(node, 0, sizeof(*node));
+  node->op = op;
+  node->match = node->alt = node->try_node = NONE;
+  return node;
+}
+
+// Decode instructions and build nodes. Returns false for unknown instruction (inline asm).
+static bool decode(Func *f, unsigned char *start, unsigned char *end, uint32_t param_count) {
+  // Control stack: opener node index, and innermost try on entering.
+  uint32_t *stack = malloc_or_die(sizeof(*stack) * 2 * 16);
+  int depth = 0, stack_capacity = 16;
+  stack[0] = NONE;  // Function body.
+  stack[1] = NONE;
+  depth = 1;
+  uint32_t cur_try = NONE;
+
+  bool ok = true;
+  for (unsigned char *p = start; p < end && ok; ) {
+    WasmInst inst;
+    if (!decode_inst(&p, end, &inst)) {
+      ok = false;
+      break;
+    }
+    unsigned char op = inst.op;
+    switch (op) {
+    case OP_UNREACHABLE: case OP_RETURN: case OP_RETURN_CALL: case OP_RETURN_CALL_INDIRECT:
+      add_node(f, op);
+      break;
+    case OP_BLOCK: case OP_LOOP: case OP_IF: case OP_TRY:
+      {
+        if (depth >= stack_capacity) {
+          stack_capacity *= 2;
+          stack = realloc_or_die(stack, sizeof(*stack) * 2 * stack_capacity);
+        }
+        uint32_t index = f->count;
+        Node *node = add_node(f, op);
+        if (op == OP_TRY) {
+          node->try_node = cur_try;
+          stack[depth * 2 + 1] = cur_try;
+          cur_try = index;
+        } else {
+          stack[depth * 2 + 1] = cur_try;
+        }
+        stack[depth * 2] = index;
+        ++depth;
+      }
+      break;
+    case OP_ELSE: case OP_CATCH: case OP_CATCH_ALL:
+      {
+        uint32_t opener = depth > 1 ? stack[(depth - 1) * 2] : NONE;
+        if (opener == NONE || f->nodes[opener].op != (op == OP_ELSE ? OP_IF : OP_TRY)) {
+          ok = false;
+          break;
+        }
+        uint32_t index = f->count;
+        Node *node = add_node(f, op);
+        node->match = opener;
+        if (op == OP_ELSE) {
+          f->nodes[opener].alt = index;
+        } else {
+          // Chain catch clauses, and leave the try body.
+          uint32_t *pnext = &f->nodes[opener].alt;
+          while (*pnext != NONE)
+            pnext = &f->nodes[*pnext].alt;
+          *pnext = index;
+          cur_try = stack[(depth - 1) * 2 + 1];
+        }
+      }
+      break;
+    case OP_END:
+      {
+        uint32_t index = f->count;
+        add_node(f, op);
+        --depth;
+        if (depth <= 0) {
+          if (p != end)
+            ok = false;
+          break;
+        }
+        f->nodes[stack[depth * 2]].match = index;
+        cur_try = stack[depth * 2 + 1];
+      }
+      break;
+    case OP_BR: case OP_BR_IF: case OP_BR_TABLE:
+      {
+        // Labels are re-read for br_table, which has the count as `value`.
+        unsigned char *q = inst.imm;
+        uint32_t count = op == OP_BR_TABLE ? read_uleb(&q, end) + 1 : 1;
+        uint32_t *targets = malloc_or_die(sizeof(*targets) * count);
+        for (uint32_t i = 0; i < count && ok; ++i) {
+          uint32_t label = read_uleb(&q, end);
+          if (label >= (uint32_t)depth)
+            ok = false;
+          else
+            targets[i] = stack[(depth - 1 - label) * 2];
+        }
+        if (!ok) {
+          free(targets);
+          break;
+        }
+        Node *node = add_node(f, op);
+        node->targets = targets;
+        node->target_count = count;
+      }
+      break;
+    case OP_THROW: case OP_RETHROW:
+      add_node(f, op)->try_node = cur_try;
+      break;
+    case OP_CALL: case OP_CALL_INDIRECT:
+      if (cur_try != NONE)
+        add_node(f, op)->try_node = cur_try;
+      break;
+    case OP_LOCAL_GET: case OP_LOCAL_SET: case OP_LOCAL_TEE:
+      {
+        uint32_t local = inst.value;
+        if (local < param_count)
+          break;
+        local -= param_count;
+        if (local >= f->local_count) {
+          ok = false;
+          break;
+        }
+        Node *node = add_node(f, op);
+        node->local = local;
+        node->offset = inst.imm - start;
+        node->size = p - inst.imm;
+      }
+      break;
+    default: break;
+    }
+  }
+  free(stack);
+  return ok && depth == 0;
+}
+
+// Call `proc` for each successor of the node.
+#define FOREACH_SUCC(f, i, succ, proc)  do { \
+    Node *node_ = &(f)->nodes[i]; \
+    uint32_t next_ = (i) + 1 < (f)->count ? (i) + 1 : NONE; \
+    switch (node_->op) { \
+    case OP_UNREACHABLE: case OP_RETURN: case OP_THROW: case OP_RETHROW: \
+    case OP_RETURN_CALL: case OP_RETURN_CALL_INDIRECT: \
+      next_ = NONE; \
+      break; \
+    case OP_IF: \
+      { \
+        uint32_t succ = node_->alt != NONE ? node_->alt + 1 : node_->match; \
+        proc; \
+      } \
+      break; \
+    case OP_ELSE: case OP_CATCH: case OP_CATCH_ALL: \
+      next_ = (f)->nodes[node_->match].match; \
+      break; \
+    case OP_BR: case OP_BR_IF: case OP_BR_TABLE: \
+      if (node_->op != OP_BR_IF) \
+        next_ = NONE; \
+      for (uint32_t k_ = 0; k_ < node_->target_count; ++k_) { \
+        uint32_t t_ = node_->targets[k_]; \
+        if (t_ == NONE) \
+          continue; \
+        uint32_t succ = (f)->nodes[t_].op == OP_LOOP ? t_ : (f)->nodes[t_].match; \
+        proc; \
+      } \
+      break; \
+    default: break; \
+    } \
+    if (next_ != NONE) { \
+      uint32_t succ = next_; \
+      proc; \
+    } \
+    /* Exception thrown in try body goes to its catch clauses, and outer ones. */ \
+    for (uint32_t t_ = node_->op == OP_TRY ? NONE : node_->try_node; t_ != NONE; \
+         t_ = (f)->nodes[t_].try_node) { \
+      for (uint32_t c_ = (f)->nodes[t_].alt; c_ != NONE; c_ = (f)->nodes[c_].alt) { \
+        uint32_t succ = c_ + 1; \
+        proc; \
+      } \
+    } \
+  } while (0)
+
+static void compute_live_out(Func *f, uint32_t i, uint64_t *out) {
+  int words = f->words;
+  memset(out, 0, sizeof(*out) * words);
+  FOREACH_SUCC(f, i, succ, {
+    const uint64_t *in = &f->live_in[succ * words];
+    for (int w = 0; w < words; ++w)
+      out[w] |= in[w];
+  });
+}
+
+static void compute_liveness(Func *f) {
+  int words = f->words;
+  f->live_in = calloc_or_die(sizeof(*f->live_in) * words * f->count);
+  uint64_t *out = malloc_or_die(sizeof(*out) * words);
+  for (bool changed = true; changed; ) {
+    changed = false;
+    for (uint32_t i = f->count; i-- > 0; ) {
+      compute_live_out(f, i, out);
+      Node *node = &f->nodes[i];
+      switch (node->op) {
+      case OP_LOCAL_GET:
+        out[node->local / 64] |= 1ULL << (node->local % 64);
+        break;
+      case OP_LOCAL_SET: case OP_LOCAL_TEE:
+        out[node->local / 64] &= ~(1ULL << (node->local % 64));
+        break;
+      default: break;
+      }
+      uint64_t *in = &f->live_in[i * words];
+      if (memcmp(in, out, sizeof(*out) * words) != 0) {
+        memcpy(in, out, sizeof(*out) * words);
+        changed = true;
+      }
+    }
+  }
+  free(out);
+}
+
+// Rewrite local indices and the declaration, and shift relocations behind them.
+static void rewrite(Func *f, DataStorage *code, size_t body_start, const uint32_t *new_indices,
+                    const unsigned char *group_types, const uint32_t *group_counts,
+                    int group_count, uint32_t param_count, Vector *reloc_code) {
+  DataStorage ds;
+  data_init(&ds);
+  data_reserve(&ds, code->len);
+  data_uleb128(&ds, -1, group_count);
+  for (int i = 0; i < group_count; ++i) {
+    data_uleb128(&ds, -1, group_counts[i]);
+    data_push(&ds, group_types[i]);
+  }
+
+  sort_relocs(reloc_code);
+  int r = 0;
+  ssize_t shift = ds.len - body_start;
+  size_t pos = body_start;
+  for (uint32_t i = 0; i < f->count; ++i) {
+    Node *node = &f->nodes[i];
+    if (node->op != OP_LOCAL_GET && node->op != OP_LOCAL_SET && node->op != OP_LOCAL_TEE)
+      continue;
+    size_t offset = body_start + node->offset;
+    for (; r < reloc_code->len; ++r) {
+      RelocInfo *reloc = reloc_code->data[r];
+      if (reloc->offset >= offset)
+        break;
+      reloc->offset += shift;
+    }
+    data_append(&ds, code->buf + pos, offset - pos);
+    size_t before = ds.len;
+    data_uleb128(&ds, -1, new_indices[node->local] + param_count);
+    shift += (ssize_t)(ds.len - before) - node->size;
+    pos = offset + node->size;
+  }
+  for (; r < reloc_code->len; ++r) {
+    RelocInfo *reloc = reloc_code->data[r];
+    reloc->offset += shift;
+  }
+  data_append(&ds, code->buf + pos, code->len - pos);
+
+  data_release(code);
+  *code = ds;
+}
+
+void coalesce_locals(DataStorage *code, uint32_t param_count, Vector *reloc_code) {
+  // Local declaration: groups of (count, type).
+  unsigned char *p = code->buf, *end = code->buf + code->len;
+  uint32_t group_count = read_uleb(&p, end);
+  if (group_count == 0)
+    return;
+  unsigned char group_types[4];
+  uint32_t group_counts[4];
+  if (group_count > ARRAY_SIZE(group_types))
+    return;
+  uint32_t local_count = 0;
+  for (uint32_t i = 0; i < group_count; ++i) {
+    group_counts[i] = read_uleb(&p, end);
+    group_types[i] = *p++;
+    local_count += group_counts[i];
+  }
+  size_t body_start = p - code->buf;
+  if (local_count == 0)
+    return;
+
+  Func func = {.local_count = local_count, .words = (local_count + 63) / 64};
+  Func *f = &func;
+  if (!decode(f, p, end, param_count) || f->count == 0) {
+    for (uint32_t i = 0; i < f->count; ++i)
+      free(f->nodes[i].targets);
+    free(f->nodes);
+    return;
+  }
+  compute_liveness(f);
+
+  int words = f->words;
+  uint8_t *groups = malloc_or_die(local_count);
+  for (uint32_t i = 0, j = 0; i < group_count; ++i) {
+    for (uint32_t k = 0; k < group_counts[i]; ++k)
+      groups[j++] = i;
+  }
+
+  // Interference: A local interferes with the ones live after its assignment.
+  // Locals live at the entry rely on their initial value (zero), so they keep their own.
+  uint64_t *interfere = calloc_or_die(sizeof(*interfere) * words * local_count);
+  {
+    uint64_t *out = malloc_or_die(sizeof(*out) * words);
+    for (uint32_t i = 0; i < f->count; ++i) {
+      Node *node = &f->nodes[i];
+      if (node->op != OP_LOCAL_SET && node->op != OP_LOCAL_TEE)
+        continue;
+      compute_live_out(f, i, out);
+      uint32_t x = node->local;
+      for (int w = 0; w < words; ++w)
+        interfere[x * words + w] |= out[w];
+    }
+    free(out);
+
+    const uint64_t *entry = &f->live_in[0];
+    for (uint32_t x = 0; x < local_count; ++x) {
+      if (entry[x / 64] & (1ULL << (x % 64))) {
+        for (int w = 0; w < words; ++w)
+          interfere[x * words + w] = ~0ULL;
+      }
+    }
+    // Make it symmetric.
+    for (uint32_t x = 0; x < local_count; ++x) {
+      for (uint32_t y = 0; y < local_count; ++y) {
+        if (interfere[x * words + y / 64] & (1ULL << (y % 64)))
+          interfere[y * words + x / 64] |= 1ULL << (x % 64);
+      }
+    }
+  }
+
+  // Greedy coloring in index order, within each value type.
+  uint32_t *colors = malloc_or_die(sizeof(*colors) * local_count);
+  uint32_t new_counts[4] = {0, 0, 0, 0};
+  bool *used = malloc_or_die(sizeof(*used) * (local_count + 1));
+  for (uint32_t x = 0; x < local_count; ++x) {
+    memset(used, 0, sizeof(*used) * (local_count + 1));
+    for (uint32_t y = 0; y < x; ++y) {
+      if (groups[y] == groups[x] && (interfere[x * words + y / 64] & (1ULL << (y % 64))))
+        used[colors[y]] = true;
+    }
+    uint32_t c = 0;
+    while (used[c])
+      ++c;
+    colors[x] = c;
+    if (c >= new_counts[groups[x]])
+      new_counts[groups[x]] = c + 1;
+  }
+
+  uint32_t new_total = 0;
+  for (uint32_t i = 0; i < group_count; ++i)
+    new_total += new_counts[i];
+  if (new_total < local_count) {
+    uint32_t bases[4];
+    int new_group_count = 0;
+    unsigned char new_types[4];
+    uint32_t base = 0;
+    for (uint32_t i = 0; i < group_count; ++i) {
+      bases[i] = base;
+      base += new_counts[i];
+      if (new_counts[i] > 0) {
+        new_types[new_group_count] = group_types[i];
+        new_counts[new_group_count] = new_counts[i];
+        ++new_group_count;
+      }
+    }
+    for (uint32_t x = 0; x < local_count; ++x)
+      colors[x] += bases[groups[x]];
+    rewrite(f, code, body_start, colors, new_types, new_counts, new_group_count, param_count,
+            reloc_code);
+  }
+
+  free(used);
+  free(colors);
+  free(interfere);
+  free(groups);
+  free(f->live_in);
+  for (uint32_t i = 0; i < f->count; ++i)
+    free(f->nodes[i].targets);
+  free(f->nodes);
+}
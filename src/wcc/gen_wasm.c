@@ -33,6 +33,7 @@
 #define ADD_F64(x)     do { double d = (x); add_code((unsigned char*)&d, sizeof(d)); } while (0)
 
 static void gen_lval(Expr *expr);
+static uint32_t gen_lval_ofs(Expr *expr);
 
 void add_code(const unsigned char *buf, size_t size) {
   data_append(CODE, buf, size);
@@ -57,10 +58,16 @@ struct VReg {
 
 static void gen_stmt(Stmt *stmt, bool is_last);
 static void gen_stmts(Vector *stmts, bool is_last);
+static bool is_simd_funcall(Expr *expr);
+static void gen_simd(Expr *expr);
+static void gen_v128_store(uint32_t offset);
+
+bool tail_call;
 
 static int cur_depth;
 static int break_depth;
 static int continue_depth;
+static int try_depth;
 
 static unsigned char get_func_ret_wtype(const Type *rettype) {
   return rettype->kind == TY_VOID ? WT_VOID
@@ -68,51 +75,54 @@ static unsigned char get_func_ret_wtype(const Type *rettype) {
                                   : WT_I32;  // Pointer.
 }
 
-static void gen_load(const Type *type) {
+// `offset` is put into memarg: Effective address is (base + offset).
+static void gen_load(const Type *type, uint32_t offset) {
   switch (type->kind) {
   case TY_FIXNUM:
   case TY_PTR:
     {
       bool u = !is_fixnum(type->kind) || type->fixnum.is_unsigned;
       switch (type_size(type)) {
-      case 1:  ADD_CODE(u ? OP_I32_LOAD8_U : OP_I32_LOAD8_S, 0, 0); break;
-      case 2:  ADD_CODE(u ? OP_I32_LOAD16_U : OP_I32_LOAD16_S, 1, 0); break;
-      case 4:  ADD_CODE(OP_I32_LOAD, 2, 0); break;
-      case 8:  ADD_CODE(OP_I64_LOAD, 3, 0); break;
+      case 1:  ADD_CODE(u ? OP_I32_LOAD8_U : OP_I32_LOAD8_S, 0); break;
+      case 2:  ADD_CODE(u ? OP_I32_LOAD16_U : OP_I32_LOAD16_S, 1); break;
+      case 4:  ADD_CODE(OP_I32_LOAD, 2); break;
+      case 8:  ADD_CODE(OP_I64_LOAD, 3); break;
       default: assert(false);
       }
     }
     break;
   case TY_FLONUM:
     if (type->flonum.kind < FL_DOUBLE)
-      ADD_CODE(OP_F32_LOAD, 2, 0);
+      ADD_CODE(OP_F32_LOAD, 2);
     else
-      ADD_CODE(OP_F64_LOAD, 3, 0);
+      ADD_CODE(OP_F64_LOAD, 3);
     break;
   default: assert(false); break;
   }
+  ADD_ULEB128(offset);
 }
 
-static void gen_store(const Type *type) {
+static void gen_store(const Type *type, uint32_t offset) {
   switch (type->kind) {
   case TY_FIXNUM:
   case TY_PTR:
     switch (type_size(type)) {
-    case 1:  ADD_CODE(OP_I32_STORE8, 0, 0); break;
-    case 2:  ADD_CODE(OP_I32_STORE16, 1, 0); break;
-    case 4:  ADD_CODE(OP_I32_STORE, 2, 0); break;
-    case 8:  ADD_CODE(OP_I64_STORE, 3, 0); break;
+    case 1:  ADD_CODE(OP_I32_STORE8, 0); break;
+    case 2:  ADD_CODE(OP_I32_STORE16, 1); break;
+    case 4:  ADD_CODE(OP_I32_STORE, 2); break;
+    case 8:  ADD_CODE(OP_I64_STORE, 3); break;
     default: assert(false); break;
     }
     break;
   case TY_FLONUM:
     if (type->flonum.kind < FL_DOUBLE)
-      ADD_CODE(OP_F32_STORE, 2, 0);
+      ADD_CODE(OP_F32_STORE, 2);
     else
-      ADD_CODE(OP_F64_STORE, 3, 0);
+      ADD_CODE(OP_F64_STORE, 3);
     break;
   default: assert(false); break;
   }
+  ADD_ULEB128(offset);
 }
 
 static void gen_arith(enum ExprKind kind, const Type *type) {
@@ -265,10 +275,11 @@ static void gen_ternary(Expr *expr, bool needval) {
   --cur_depth;
 }
 
-static void gen_funcall_by_name(const Name *funcname) {
+// `op`: call or return_call
+static void gen_funcall_by_name(const Name *funcname, unsigned char op) {
   FuncInfo *info = table_get(&func_info_table, funcname);
   assert(info != NULL);
-  ADD_CODE(OP_CALL);
+  ADD_CODE(op);
   FuncExtra *extra = curfunc->extra;
   DataStorage *code = extra->code;
   RelocInfo *ri = calloc_or_die(sizeof(*ri));
@@ -281,7 +292,25 @@ static void gen_funcall_by_name(const Name *funcname) {
   ADD_VARUINT32(info->index);
 }
 
-static void gen_funcall(Expr *expr) {
+// Local variable which receives non-primitive return value of `funcall`.
+static Expr *get_funcall_result(Expr *funcall) {
+  assert(curfunc != NULL);
+  FuncExtra *extra = curfunc->extra;
+  assert(extra != NULL);
+  assert(extra->funcall_results != NULL);
+  VarInfo *varinfo = NULL;
+  for (int i = 0; i < extra->funcall_results->len; i += 2) {
+    if (extra->funcall_results->data[i] == funcall) {
+      varinfo = extra->funcall_results->data[i + 1];
+      break;
+    }
+  }
+  assert(varinfo != NULL);
+  return new_expr_variable(varinfo->name, varinfo->type, NULL, curfunc->scopes->data[0]);
+}
+
+// `tail`: Emit `return_call` instead of `call`, the caller must check `can_tail_call`.
+static void gen_funcall(Expr *expr, bool tail) {
   Expr *func = expr->funcall.func;
   if (func->kind == EX_VAR && is_global_scope(func->var.scope)) {
     void *proc = table_get(&builtin_function_table, func->var.name);
@@ -330,23 +359,8 @@ static void gen_funcall(Expr *expr) {
   }
 
   bool ret_param = functype->func.ret->kind != TY_VOID && !is_prim_type(functype->func.ret);
-  if (ret_param) {
-    assert(curfunc != NULL);
-    FuncExtra *extra = curfunc->extra;
-    assert(extra != NULL);
-    assert(extra->funcall_results != NULL);
-    VarInfo *varinfo = NULL;
-    for (int i = 0; i < extra->funcall_results->len; i += 2) {
-      if (extra->funcall_results->data[i] == expr) {
-        varinfo = extra->funcall_results->data[i + 1];
-        break;
-      }
-    }
-    assert(varinfo != NULL);
-    // &ret_buf
-    Expr *e = new_expr_variable(varinfo->name, varinfo->type, NULL, curfunc->scopes->data[0]);
-    gen_lval(e);
-  }
+  if (ret_param)
+    gen_lval(get_funcall_result(expr));  // &ret_buf
 
   int sarg_offset = 0;
   int vaarg_offset = 0;
@@ -380,19 +394,13 @@ static void gen_funcall(Expr *expr) {
       assert(!is_stack_param(arg->type));
       // *(global.sp + sarg_siz + vaarg_offset) = arg
       int offset = sarg_siz + vaarg_offset;
-      if (offset != 0) {
-        gen_expr(new_expr_bop(EX_ADD, &tySize, NULL, spvar,
-                              new_expr_fixlit(&tySize, NULL, offset)),
-                 true);
-      } else {
-        gen_expr(spvar, true);
-      }
+      gen_expr(spvar, true);
       const Type *t = arg->type;
       assert(!(t->kind == TY_FIXNUM && t->fixnum.kind < FX_INT));
       vaarg_offset += type_size(t);
 
       gen_expr(arg, true);
-      gen_store(t);
+      gen_store(t, offset);
     }
   }
   if (functype->func.vaargs) {
@@ -405,12 +413,12 @@ static void gen_funcall(Expr *expr) {
   }
 
   if (func->type->kind == TY_FUNC && func->kind == EX_VAR) {
-    gen_funcall_by_name(func->var.name);
+    gen_funcall_by_name(func->var.name, tail ? OP_RETURN_CALL : OP_CALL);
   } else {
     gen_expr(func, true);
     int index = get_func_type_index(functype);
     assert(index >= 0);
-    ADD_CODE(OP_CALL_INDIRECT);
+    ADD_CODE(tail ? OP_RETURN_CALL_INDIRECT : OP_CALL_INDIRECT);
     FuncExtra *extra = curfunc->extra;
     DataStorage *code = extra->code;
     RelocInfo *ri = calloc_or_die(sizeof(*ri));
@@ -432,7 +440,25 @@ static void gen_funcall(Expr *expr) {
   }
 }
 
-static void gen_bpofs(int32_t offset) {
+// Add constant `offset` to the address on the stack.
+static void gen_add_offset(int32_t offset) {
+  if (offset != 0) {
+    ADD_CODE(OP_I32_CONST);
+    ADD_LEB128(offset);
+    ADD_CODE(OP_I32_ADD);
+  }
+}
+
+// Memarg offset is unsigned, but keep it within int32 to be materialized with `i32.const`.
+static uint32_t fold_offset(uint32_t offset, Fixnum add) {
+  if (add >= 0 && add <= (Fixnum)(INT32_MAX - offset))
+    return offset + add;
+  // Cannot fold: Apply it to the base (with wrap around).
+  gen_add_offset((int32_t)(offset + (uint32_t)add));
+  return 0;
+}
+
+static uint32_t gen_bp(int32_t offset) {
   FuncInfo *finfo = table_get(&func_info_table, curfunc->name);
   assert(finfo != NULL && finfo->bpname != NULL);
   const Name *bpname = finfo->bpname;
@@ -442,12 +468,11 @@ static void gen_bpofs(int32_t offset) {
   assert(bpvarinfo->local.vreg != NULL);
   ADD_CODE(OP_LOCAL_GET);
   ADD_ULEB128(bpvarinfo->local.vreg->prim.local_index);
+  return fold_offset(0, offset);
+}
 
-  if (offset != 0) {
-    ADD_CODE(OP_I32_CONST);
-    ADD_LEB128(offset);
-    ADD_CODE(OP_I32_ADD);
-  }
+static void gen_bpofs(int32_t offset) {
+  gen_add_offset(gen_bp(offset));
 }
 
 static void gen_clear_local_var(const VarInfo *varinfo) {
@@ -464,7 +489,11 @@ static void gen_clear_local_var(const VarInfo *varinfo) {
   ADD_CODE(OP_EXTENSION, OPEX_MEMORY_FILL, 0);
 }
 
-static void gen_ref_sub(Expr *expr) {
+static uint32_t gen_address(Expr *expr);
+
+// Generate reference of `expr` as base address and return constant offset from it,
+// so that it can be folded into memarg of load/store.
+static uint32_t gen_ref_ofs(Expr *expr) {
   switch (expr->kind) {
   case EX_VAR:
     {
@@ -503,23 +532,17 @@ static void gen_ref_sub(Expr *expr) {
         }
       } else {
         VReg *vreg = varinfo->local.vreg;
-        gen_bpofs(vreg->non_prim.offset);
+        return gen_bp(vreg->non_prim.offset);
       }
     }
-    return;
+    return 0;
   case EX_DEREF:
-    gen_expr(expr->unary.sub, true);
-    return;
+    return gen_address(expr->unary.sub);
   case EX_MEMBER:
     {
-      gen_expr(expr->member.target, true);
+      uint32_t offset = gen_address(expr->member.target);
       const MemberInfo *minfo = expr->member.info;
-      if (minfo->offset == 0)
-        return;
-      ADD_CODE(OP_I32_CONST);
-      ADD_LEB128(minfo->offset);
-      ADD_CODE(OP_I32_ADD);
-      return;
+      return fold_offset(offset, minfo->offset);
     }
   case EX_COMPLIT:
     {
@@ -528,15 +551,58 @@ static void gen_ref_sub(Expr *expr) {
       assert(varinfo != NULL);
       gen_clear_local_var(varinfo);
       gen_stmts(expr->complit.inits, false);
-      gen_lval(var);
+      return gen_lval_ofs(var);
     }
-    return;
   default: assert(false); break;
   }
+  return 0;
+}
+
+static void gen_ref_sub(Expr *expr) {
+  gen_add_offset(gen_ref_ofs(expr));
+}
+
+static uint32_t gen_lval_ofs(Expr *expr) {
+  return gen_ref_ofs(reduce_refer(expr));
 }
 
 static void gen_lval(Expr *expr) {
-  gen_ref_sub(reduce_refer(expr));
+  gen_add_offset(gen_lval_ofs(expr));
+}
+
+// Generate pointer value of `expr` as base address and constant offset:
+// `ptr + constant` is split.
+static uint32_t gen_address(Expr *expr) {
+  switch (expr->kind) {
+  case EX_ADD:
+    if (expr->type->kind == TY_PTR) {
+      Expr *lhs = expr->bop.lhs, *rhs = expr->bop.rhs;
+      if (lhs->kind == EX_FIXNUM) {
+        Expr *tmp = lhs;
+        lhs = rhs;
+        rhs = tmp;
+      }
+      if (rhs->kind == EX_FIXNUM && rhs->fixnum >= 0)
+        return fold_offset(gen_address(lhs), rhs->fixnum);
+    }
+    break;
+  case EX_REF:
+    return gen_ref_ofs(expr->unary.sub);
+  case EX_CAST:
+    if (expr->type->kind == TY_PTR && expr->unary.sub->type->kind == TY_PTR)
+      return gen_address(expr->unary.sub);
+    break;
+  case EX_VAR:
+    switch (expr->type->kind) {
+    case TY_ARRAY: case TY_STRUCT:  // Same as `gen_var`.
+      return gen_lval_ofs(expr);
+    default: break;
+    }
+    break;
+  default: break;
+  }
+  gen_expr(expr, true);
+  return 0;
 }
 
 static void gen_var(Expr *expr, bool needval) {
@@ -552,8 +618,8 @@ static void gen_var(Expr *expr, bool needval) {
       const VarInfo *varinfo = scope_find(expr->var.scope, expr->var.name, &scope);
       assert(varinfo != NULL && scope == expr->var.scope);
       if ((varinfo->storage & VS_REF_TAKEN) || is_global_datsec_var(varinfo, scope)) {
-        gen_lval(expr);
-        gen_load(expr->type);
+        uint32_t offset = gen_lval_ofs(expr);
+        gen_load(expr->type, offset);
       } else if (!is_global_scope(scope) && is_local_storage(varinfo)) {
         VReg *vreg = varinfo->local.vreg;
         assert(vreg != NULL);
@@ -831,12 +897,22 @@ static void gen_assign_sub(Expr *lhs, Expr *rhs) {
         break;
       }
     }
-    gen_lval(lhs);
-    gen_expr(rhs, true);
-    gen_store(lhs->type);
+    {
+      uint32_t offset = gen_lval_ofs(lhs);
+      gen_expr(rhs, true);
+      gen_store(lhs->type, offset);
+    }
     break;
   case TY_STRUCT:
     {
+      if (is_simd_funcall(rhs)) {
+        // Store v128 directly, without a temporary buffer.
+        uint32_t offset = gen_lval_ofs(lhs);
+        gen_simd(rhs);
+        gen_v128_store(offset);
+        break;
+      }
+
       size_t size = type_size(lhs->type);
       if (size > 0) {
         gen_lval(lhs);
@@ -884,19 +960,24 @@ static void gen_ref(Expr *expr, bool needval) {
 }
 
 static void gen_deref(Expr *expr, bool needval) {
-  gen_expr(expr->unary.sub, needval);
-  if (needval) {
+  if (!needval) {
+    gen_expr(expr->unary.sub, false);
+  } else {
     switch (expr->type->kind) {
     case TY_FIXNUM:
     case TY_PTR:
     case TY_FLONUM:
-      gen_load(expr->type);
+      {
+        uint32_t offset = gen_address(expr->unary.sub);
+        gen_load(expr->type, offset);
+      }
       break;
 
     case TY_ARRAY:
     case TY_STRUCT:
     case TY_FUNC:
       // array, struct and func values are handled as a pointer.
+      gen_expr(expr->unary.sub, true);
       break;
 
     case TY_VOID: assert(false); break;
@@ -918,17 +999,19 @@ static void gen_member(Expr *expr, bool needval) {
     }
 #endif
 
-    gen_lval(expr);
+    uint32_t offset = gen_lval_ofs(expr);
     if (is_prim_type(expr->type))
-      gen_load(expr->type);
+      gen_load(expr->type, offset);
+    else
+      gen_add_offset(offset);
   } else {
     gen_expr(expr->member.target, false);
   }
 }
 
 static void gen_funcall_expr(Expr *expr, bool needval) {
-  gen_funcall(expr);
-  if (!needval && is_prim_type(expr->type))
+  gen_funcall(expr, false);
+  if (!needval && expr->type->kind != TY_VOID)  // Non-primitive value is returned as a pointer.
     ADD_CODE(OP_DROP);
 }
 
@@ -1339,14 +1422,82 @@ static void gen_block(Stmt *stmt, bool is_last) {
     curscope = bak_curscope;
 }
 
+// Whether `return expr` can be done with `return_call`:
+// There must be nothing to do after the call in the current function,
+// i.e. no stack frame to release, no stack arguments, and not in a `try` block.
+static bool can_tail_call(Expr *expr) {
+  if (!tail_call || expr->kind != EX_FUNCALL || !is_prim_type(expr->type) || try_depth > 0)
+    return false;
+
+  FuncInfo *finfo = table_get(&func_info_table, curfunc->name);
+  assert(finfo != NULL);
+  if (finfo->bpname != NULL || finfo->flag & FF_INLINING)
+    return false;
+
+  Expr *func = expr->funcall.func;
+  if (func->kind == EX_VAR && is_global_scope(func->var.scope) &&
+      table_get(&builtin_function_table, func->var.name) != NULL)
+    return false;
+
+  Type *functype = get_callee_type(func->type);
+  assert(functype != NULL);
+  if (get_func_ret_wtype(functype->func.ret) != get_func_ret_wtype(curfunc->type->func.ret))
+    return false;
+
+  Vector *args = expr->funcall.args;
+  int param_count = functype->func.params != NULL ? functype->func.params->len : 0;
+  if (functype->func.vaargs && args->len > param_count)
+    return false;
+  for (int i = 0; i < param_count; ++i) {
+    Expr *arg = args->data[i];
+    if (is_stack_param(arg->type))
+      return false;
+  }
+  return true;
+}
+
+// Whether the returned value has a call in tail position: itself, or in a branch of `?:`.
+static bool has_tail_call(Expr *expr) {
+  if (expr->kind == EX_TERNARY)
+    return is_prim_type(expr->type) &&
+           (has_tail_call(expr->ternary.tval) || has_tail_call(expr->ternary.fval));
+  return can_tail_call(expr);
+}
+
+// Generate the returned value, with `return_call` for the calls in tail position.
+static void gen_tail_expr(Expr *expr) {
+  if (expr->kind == EX_TERNARY) {
+    gen_cond(expr->ternary.cond, true, true);
+    ADD_CODE(OP_IF, get_func_ret_wtype(curfunc->type->func.ret));
+    ++cur_depth;
+    gen_tail_expr(expr->ternary.tval);
+    ADD_CODE(OP_ELSE);
+    gen_tail_expr(expr->ternary.fval);
+    ADD_CODE(OP_END);
+    --cur_depth;
+  } else if (can_tail_call(expr)) {
+    gen_funcall(expr, true);
+  } else {
+    gen_expr(expr, true);
+  }
+}
+
 static void gen_return(Stmt *stmt, bool is_last) {
   assert(curfunc != NULL);
+  if (stmt->return_.val != NULL && can_tail_call(stmt->return_.val)) {
+    gen_funcall(stmt->return_.val, true);
+    return;
+  }
+
   if (stmt->return_.val != NULL) {
     Expr *val = stmt->return_.val;
     const Type *rettype = val->type;
     assert(rettype->kind != TY_VOID);
     if (is_prim_type(rettype)) {
-      gen_expr(val, true);
+      if (has_tail_call(val))
+        gen_tail_expr(val);
+      else
+        gen_expr(val, true);
     } else {
       FuncInfo *finfo = table_get(&func_info_table, curfunc->name);
       assert(finfo != NULL);
@@ -1476,7 +1627,8 @@ static void gen_stmts(Vector *stmts, bool is_last) {
   }
 }
 
-static uint32_t allocate_local_variables(Function *func, DataStorage *data) {
+static uint32_t allocate_local_variables(Function *func, DataStorage *data,
+                                         uint32_t *pwasm_param_count) {
   const Type *functype = func->type;
   unsigned int ret_param = functype->func.ret->kind != TY_VOID && !is_prim_type(functype->func.ret) ? 1 : 0;
   unsigned int param_count = functype->func.params != NULL ? functype->func.params->len : 0;
@@ -1554,6 +1706,7 @@ static uint32_t allocate_local_variables(Function *func, DataStorage *data) {
     local_indices[i] = i == 0 ? ret_param + variadic + pparam_count
                               : local_indices[i - 1] + local_counts[i - 1];
   }
+  *pwasm_param_count = ret_param + variadic + pparam_count;
 
   uint32_t frame_offset = 0;
   unsigned int param_no = ret_param;
@@ -1619,7 +1772,8 @@ static void gen_defun(Function *func) {
   assert(extra != NULL);
   extra->code = code;
   func->extra = extra;
-  uint32_t frame_size = allocate_local_variables(func, code);
+  uint32_t param_count;
+  uint32_t frame_size = allocate_local_variables(func, code, &param_count);
 
   // Prologue
 
@@ -1661,10 +1815,10 @@ static void gen_defun(Function *func) {
       if (!(varinfo->storage & VS_REF_TAKEN) || is_stack_param(varinfo->type))
         continue;
       VReg *vreg = varinfo->local.vreg;
-      gen_bpofs(vreg->non_prim.offset);
+      uint32_t offset = gen_bp(vreg->non_prim.offset);
       ADD_CODE(OP_LOCAL_GET);
       ADD_ULEB128(vreg->param_index);
-      gen_store(varinfo->type);
+      gen_store(varinfo->type, offset);
     }
   }
 
@@ -1700,6 +1854,9 @@ static void gen_defun(Function *func) {
 
   ADD_CODE(OP_END);
 
+  peephole_optimize(code, extra->reloc_code);
+  coalesce_locals(code, param_count, extra->reloc_code);
+
   size_t before = code->len;
   data_uleb128(code, 0, code->len);  // Insert code size at the top.
   extra->offset = code->len - before;
@@ -1822,7 +1979,9 @@ static void gen_builtin_try_catch_longjmp(Expr *expr, enum BuiltinFunctionPhase
       ADD_CODE(OP_TRY, WT_VOID); {
         Expr *try_block_expr = args->data[2];
         assert(try_block_expr->kind == EX_BLOCK);
+        ++try_depth;
         gen_stmt(try_block_expr->block, false);
+        --try_depth;
         ADD_CODE(OP_BR, 2);
       } ADD_CODE(OP_CATCH); {
         TagInfo *ti = register_longjmp_tag();
@@ -2027,6 +2186,649 @@ static void gen_builtin_memory_grow(Expr *expr, enum BuiltinFunctionPhase phase)
   ADD_CODE(OP_MEMORY_GROW, 0x00);
 }
 
+// Atomics
+
+enum AtomicKind {
+  AK_LOAD,
+  AK_STORE,
+  AK_RMW,      // Read-modify-write: Returns old value.
+  AK_CMPXCHG,
+  AK_FENCE,
+};
+
+typedef struct {
+  const char *name;
+  enum AtomicKind kind;
+  unsigned char op;  // Base opcode of the group.
+  bool op_fetch;     // `__atomic_OP_fetch`: Returns new value.
+} AtomicBuiltin;
+
+static const AtomicBuiltin kAtomicBuiltins[] = {
+  {"__atomic_load_n", AK_LOAD, OPATOMIC_LOAD, false},
+  {"__atomic_store_n", AK_STORE, OPATOMIC_STORE, false},
+  {"__atomic_exchange_n", AK_RMW, OPATOMIC_RMW_XCHG, false},
+  {"__atomic_compare_exchange_n", AK_CMPXCHG, OPATOMIC_RMW_CMPXCHG, false},
+  {"__atomic_fetch_add", AK_RMW, OPATOMIC_RMW_ADD, false},
+  {"__atomic_fetch_sub", AK_RMW, OPATOMIC_RMW_SUB, false},
+  {"__atomic_fetch_and", AK_RMW, OPATOMIC_RMW_AND, false},
+  {"__atomic_fetch_or", AK_RMW, OPATOMIC_RMW_OR, false},
+  {"__atomic_fetch_xor", AK_RMW, OPATOMIC_RMW_XOR, false},
+  {"__atomic_add_fetch", AK_RMW, OPATOMIC_RMW_ADD, true},
+  {"__atomic_sub_fetch", AK_RMW, OPATOMIC_RMW_SUB, true},
+  {"__atomic_and_fetch", AK_RMW, OPATOMIC_RMW_AND, true},
+  {"__atomic_or_fetch", AK_RMW, OPATOMIC_RMW_OR, true},
+  {"__atomic_xor_fetch", AK_RMW, OPATOMIC_RMW_XOR, true},
+  {"__atomic_thread_fence", AK_FENCE, OPATOMIC_FENCE, false},
+};
+
+static Table atomic_builtin_table;  // <AtomicBuiltin*>
+
+static bool is_atomic_type(const Type *type, const AtomicBuiltin *atomic) {
+  switch (type->kind) {
+  case TY_FIXNUM:
+    switch (type_size(type)) {
+    case 1: case 2: case 4: case 8: return true;
+    default: return false;
+    }
+  case TY_PTR:
+    return atomic->kind != AK_RMW || atomic->op == OPATOMIC_RMW_XCHG;
+  default:
+    return false;
+  }
+}
+
+static enum ExprKind atomic_fetch_bop(unsigned char op) {
+  switch (op) {
+  default: assert(false);  // Fallthrough to suppress warning.
+  case OPATOMIC_RMW_ADD: return EX_ADD;
+  case OPATOMIC_RMW_SUB: return EX_SUB;
+  case OPATOMIC_RMW_AND: return EX_BITAND;
+  case OPATOMIC_RMW_OR:  return EX_BITOR;
+  case OPATOMIC_RMW_XOR: return EX_BITXOR;
+  }
+}
+
+// Memory orders are ignored: Wasm atomic instructions are sequentially consistent.
+static Expr *proc_builtin_atomic(const Token *ident) {
+  static const int kArgCounts[] = {
+    [AK_LOAD] = 2, [AK_STORE] = 3, [AK_RMW] = 3, [AK_CMPXCHG] = 6, [AK_FENCE] = 1,
+  };
+
+  const AtomicBuiltin *atomic = table_get(&atomic_builtin_table, ident->ident);
+  assert(atomic != NULL);
+  consume(TK_LPAR, "`(' expected");
+
+  Token *token;
+  Vector *args = parse_args(&token);
+  if (args->len != kArgCounts[atomic->kind]) {
+    parse_error(PE_FATAL, token, "%d arguments expected", kArgCounts[atomic->kind]);
+    return NULL;
+  }
+
+  // Call to the builtin itself, which emits the instruction:
+  //   load: (p), store: (p, v), rmw: (p, v), cmpxchg: (p, expected, desired)
+  Vector *params = new_vector();
+  Vector *fargs = new_vector();
+  Type *type = &tyVoid;
+  Expr *ptr = NULL;
+  if (atomic->kind != AK_FENCE) {
+    ptr = args->data[0];
+    if (ptr->type->kind != TY_PTR || !is_atomic_type(ptr->type->pa.ptrof, atomic)) {
+      parse_error(PE_FATAL, ptr->token, "pointer to integer expected");
+      return NULL;
+    }
+    type = ptr->type->pa.ptrof;
+    vec_push(params, ptr->type);
+    vec_push(fargs, ptr);
+  }
+
+  Expr *tmp = NULL, *expected = NULL;
+  Expr *pre = NULL;
+  switch (atomic->kind) {
+  case AK_LOAD:
+  case AK_FENCE:
+    break;
+  case AK_STORE:
+  case AK_RMW:
+    {
+      Expr *value = make_cast(type, token, args->data[1], false);
+      if (atomic->op_fetch) {
+        // (tmp = value, fetch(p, tmp) OP tmp)
+        tmp = alloc_tmp_var(curscope, type);
+        pre = new_expr_bop(EX_ASSIGN, &tyVoid, token, tmp, value);
+        value = tmp;
+      }
+      vec_push(params, type);
+      vec_push(fargs, value);
+    }
+    break;
+  case AK_CMPXCHG:
+    {
+      // (e = expected, r = cmpxchg(p, *e, desired), r == *e ? true : (*e = r, false))
+      Expr *e = args->data[1];
+      if (e->type->kind != TY_PTR || !same_type_without_qualifier(e->type->pa.ptrof, type, true))
+        parse_error(PE_NOFATAL, e->token, "pointer to same type expected");
+      expected = alloc_tmp_var(curscope, e->type);
+      pre = new_expr_bop(EX_ASSIGN, &tyVoid, token, expected, e);
+      vec_push(params, type);
+      vec_push(fargs, new_expr_deref(token, expected));
+      vec_push(params, type);
+      vec_push(fargs, make_cast(type, token, args->data[2], false));
+    }
+    break;
+  }
+
+  Type *rettype = atomic->kind == AK_STORE || atomic->kind == AK_FENCE ? &tyVoid : type;
+  Expr *func = new_expr_variable(ident->ident, new_func_type(rettype, params, false), ident,
+                                 global_scope);
+  Expr *result = new_expr_funcall(ident, func, fargs);
+  if (atomic->op_fetch) {
+    result = make_cast(type, token, new_expr_int_bop(atomic_fetch_bop(atomic->op), token, result,
+                                                     tmp),
+                       false);
+  } else if (atomic->kind == AK_CMPXCHG) {
+    Expr *r = alloc_tmp_var(curscope, type);
+    Expr *assign = new_expr_bop(EX_ASSIGN, &tyVoid, token, r, result);
+    Expr *update = new_expr_bop(
+        EX_COMMA, &tyBool, token,
+        new_expr_bop(EX_ASSIGN, &tyVoid, token, new_expr_deref(token, expected), r),
+        new_expr_fixlit(&tyBool, token, false));
+    Expr *cond = new_expr_cmp(EX_EQ, token, r, new_expr_deref(token, expected));
+    result = new_expr_bop(EX_COMMA, &tyBool, token, assign,
+                          new_expr_ternary(token, cond, new_expr_fixlit(&tyBool, token, true),
+                                           update, &tyBool));
+  }
+  if (pre != NULL)
+    result = new_expr_bop(EX_COMMA, result->type, token, pre, result);
+  return result;
+}
+
+// Variants in each group: i32, i64, i32 8bit and i32 16bit.
+static void gen_atomic_op(unsigned char op, const Type *type, uint32_t offset) {
+  size_t size = type_size(type);
+  int variant = size == 4 ? 0 : size == 8 ? 1 : size == 1 ? 2 : 3;
+  int align = size == 1 ? 0 : size == 2 ? 1 : size == 4 ? 2 : 3;  // Must be natural.
+  ADD_CODE(OP_ATOMIC);
+  ADD_ULEB128(op + variant);
+  ADD_ULEB128(align);
+  ADD_ULEB128(offset);
+}
+
+static void gen_builtin_atomic(Expr *expr, enum BuiltinFunctionPhase phase) {
+  if (phase != BFP_GEN)
+    return;
+
+  assert(expr->kind == EX_FUNCALL);
+  const AtomicBuiltin *atomic = table_get(&atomic_builtin_table, expr->funcall.func->var.name);
+  assert(atomic != NULL);
+  if (atomic->kind == AK_FENCE) {
+    ADD_CODE(OP_ATOMIC, OPATOMIC_FENCE, 0x00);
+    return;
+  }
+
+  Vector *args = expr->funcall.args;
+  Expr *ptr = args->data[0];
+  const Type *type = ptr->type->pa.ptrof;
+  uint32_t offset = gen_address(ptr);
+  for (int i = 1; i < args->len; ++i)
+    gen_expr(args->data[i], true);
+  gen_atomic_op(atomic->op, type, offset);
+
+  // Narrow results are zero extended.
+  if (atomic->kind != AK_STORE && type->kind == TY_FIXNUM && !type->fixnum.is_unsigned) {
+    switch (type_size(type)) {
+    case 1: ADD_CODE(OP_I32_EXTEND8_S); break;
+    case 2: ADD_CODE(OP_I32_EXTEND16_S); break;
+    default: break;
+    }
+  }
+}
+
+static void gen_builtin_atomic_wait32(Expr *expr, enum BuiltinFunctionPhase phase) {
+  if (phase != BFP_GEN)
+    return;
+
+  assert(expr->kind == EX_FUNCALL);
+  Vector *args = expr->funcall.args;
+  assert(args->len == 3);
+  uint32_t offset = gen_address(args->data[0]);
+  gen_expr(args->data[1], true);
+  gen_expr(args->data[2], true);
+  ADD_CODE(OP_ATOMIC, OPATOMIC_WAIT32, 2);  // align
+  ADD_ULEB128(offset);
+}
+
+static void gen_builtin_atomic_notify(Expr *expr, enum BuiltinFunctionPhase phase) {
+  if (phase != BFP_GEN)
+    return;
+
+  assert(expr->kind == EX_FUNCALL);
+  Vector *args = expr->funcall.args;
+  assert(args->len == 2);
+  uint32_t offset = gen_address(args->data[0]);
+  gen_expr(args->data[1], true);
+  ADD_CODE(OP_ATOMIC, OPATOMIC_NOTIFY, 2);  // align
+  ADD_ULEB128(offset);
+}
+
+// SIMD128
+
+enum SimdKind {
+  SK_OP,       // Operands are pushed as they are.
+  SK_MEM,      // First operand is address: offset is folded into memarg.
+  SK_LANE,     // Second operand is constant lane index.
+  SK_SHUFFLE,  // Two vectors followed by 16 constant lane indices.
+  SK_MAKE,     // Lane values: splat and replace_lane, or v128.const.
+};
+
+typedef struct {
+  const char *name;
+  enum SimdKind kind;
+  uint16_t op;
+  uint16_t op2;  // SK_LANE: lane count, SK_MAKE: replace_lane.
+} SimdBuiltin;
+
+static const SimdBuiltin kSimdBuiltins[] = {
+  {"wasm_v128_load", SK_MEM, OPSIMD_V128_LOAD, 0},
+  {"wasm_v128_store", SK_MEM, OPSIMD_V128_STORE, 0},
+  {"wasm_v128_load8_splat", SK_MEM, 0x07, 0},
+  {"wasm_v128_load16_splat", SK_MEM, 0x08, 0},
+  {"wasm_v128_load32_splat", SK_MEM, 0x09, 0},
+  {"wasm_v128_load64_splat", SK_MEM, 0x0a, 0},
+  {"wasm_i16x8_load8x8", SK_MEM, 0x01, 0},
+  {"wasm_u16x8_load8x8", SK_MEM, 0x02, 0},
+  {"wasm_i32x4_load16x4", SK_MEM, 0x03, 0},
+  {"wasm_u32x4_load16x4", SK_MEM, 0x04, 0},
+  {"wasm_i64x2_load32x2", SK_MEM, 0x05, 0},
+  {"wasm_u64x2_load32x2", SK_MEM, 0x06, 0},
+  {"wasm_v128_load32_zero", SK_MEM, 0x5c, 0},
+  {"wasm_v128_load64_zero", SK_MEM, 0x5d, 0},
+
+  {"wasm_i8x16_make", SK_MAKE, 0x0f, 0x17},
+  {"wasm_i16x8_make", SK_MAKE, 0x10, 0x1a},
+  {"wasm_i32x4_make", SK_MAKE, 0x11, 0x1c},
+  {"wasm_i64x2_make", SK_MAKE, 0x12, 0x1e},
+  {"wasm_f32x4_make", SK_MAKE, 0x13, 0x20},
+  {"wasm_f64x2_make", SK_MAKE, 0x14, 0x22},
+
+  {"wasm_i8x16_splat", SK_OP, 0x0f, 0},
+  {"wasm_u8x16_splat", SK_OP, 0x0f, 0},
+  {"wasm_i16x8_splat", SK_OP, 0x10, 0},
+  {"wasm_u16x8_splat", SK_OP, 0x10, 0},
+  {"wasm_i32x4_splat", SK_OP, 0x11, 0},
+  {"wasm_u32x4_splat", SK_OP, 0x11, 0},
+  {"wasm_i64x2_splat", SK_OP, 0x12, 0},
+  {"wasm_u64x2_splat", SK_OP, 0x12, 0},
+  {"wasm_f32x4_splat", SK_OP, 0x13, 0},
+  {"wasm_f64x2_splat", SK_OP, 0x14, 0},
+
+  {"wasm_i8x16_extract_lane", SK_LANE, 0x15, 16},
+  {"wasm_u8x16_extract_lane", SK_LANE, 0x16, 16},
+  {"wasm_i16x8_extract_lane", SK_LANE, 0x18, 8},
+  {"wasm_u16x8_extract_lane", SK_LANE, 0x19, 8},
+  {"wasm_i32x4_extract_lane", SK_LANE, 0x1b, 4},
+  {"wasm_u32x4_extract_lane", SK_LANE, 0x1b, 4},
+  {"wasm_i64x2_extract_lane", SK_LANE, 0x1d, 2},
+  {"wasm_u64x2_extract_lane", SK_LANE, 0x1d, 2},
+  {"wasm_f32x4_extract_lane", SK_LANE, 0x1f, 4},
+  {"wasm_f64x2_extract_lane", SK_LANE, 0x21, 2},
+  {"wasm_i8x16_replace_lane", SK_LANE, 0x17, 16},
+  {"wasm_u8x16_replace_lane", SK_LANE, 0x17, 16},
+  {"wasm_i16x8_replace_lane", SK_LANE, 0x1a, 8},
+  {"wasm_u16x8_replace_lane", SK_LANE, 0x1a, 8},
+  {"wasm_i32x4_replace_lane", SK_LANE, 0x1c, 4},
+  {"wasm_u32x4_replace_lane", SK_LANE, 0x1c, 4},
+  {"wasm_i64x2_replace_lane", SK_LANE, 0x1e, 2},
+  {"wasm_u64x2_replace_lane", SK_LANE, 0x1e, 2},
+  {"wasm_f32x4_replace_lane", SK_LANE, 0x20, 4},
+  {"wasm_f64x2_replace_lane", SK_LANE, 0x22, 2},
+
+  {"wasm_i8x16_shuffle", SK_SHUFFLE, OPSIMD_I8X16_SHUFFLE, 0},
+  {"wasm_i8x16_swizzle", SK_OP, 0x0e, 0},
+
+  {"wasm_v128_not", SK_OP, 0x4d, 0},
+  {"wasm_v128_and", SK_OP, 0x4e, 0},
+  {"wasm_v128_andnot", SK_OP, 0x4f, 0},
+  {"wasm_v128_or", SK_OP, 0x50, 0},
+  {"wasm_v128_xor", SK_OP, 0x51, 0},
+  {"wasm_v128_bitselect", SK_OP, 0x52, 0},
+  {"wasm_v128_any_true", SK_OP, 0x53, 0},
+
+  {"wasm_i8x16_eq", SK_OP, 0x23, 0},
+  {"wasm_i8x16_ne", SK_OP, 0x24, 0},
+  {"wasm_i8x16_lt", SK_OP, 0x25, 0},
+  {"wasm_u8x16_lt", SK_OP, 0x26, 0},
+  {"wasm_i8x16_gt", SK_OP, 0x27, 0},
+  {"wasm_u8x16_gt", SK_OP, 0x28, 0},
+  {"wasm_i8x16_le", SK_OP, 0x29, 0},
+  {"wasm_u8x16_le", SK_OP, 0x2a, 0},
+  {"wasm_i8x16_ge", SK_OP, 0x2b, 0},
+  {"wasm_u8x16_ge", SK_OP, 0x2c, 0},
+  {"wasm_i8x16_abs", SK_OP, 0x60, 0},
+  {"wasm_i8x16_neg", SK_OP, 0x61, 0},
+  {"wasm_i8x16_all_true", SK_OP, 0x63, 0},
+  {"wasm_i8x16_bitmask", SK_OP, 0x64, 0},
+  {"wasm_i8x16_narrow_i16x8", SK_OP, 0x65, 0},
+  {"wasm_u8x16_narrow_i16x8", SK_OP, 0x66, 0},
+  {"wasm_i8x16_shl", SK_OP, 0x6b, 0},
+  {"wasm_i8x16_shr", SK_OP, 0x6c, 0},
+  {"wasm_u8x16_shr", SK_OP, 0x6d, 0},
+  {"wasm_i8x16_add", SK_OP, 0x6e, 0},
+  {"wasm_i8x16_add_sat", SK_OP, 0x6f, 0},
+  {"wasm_u8x16_add_sat", SK_OP, 0x70, 0},
+  {"wasm_i8x16_sub", SK_OP, 0x71, 0},
+  {"wasm_i8x16_sub_sat", SK_OP, 0x72, 0},
+  {"wasm_u8x16_sub_sat", SK_OP, 0x73, 0},
+  {"wasm_i8x16_min", SK_OP, 0x76, 0},
+  {"wasm_u8x16_min", SK_OP, 0x77, 0},
+  {"wasm_i8x16_max", SK_OP, 0x78, 0},
+  {"wasm_u8x16_max", SK_OP, 0x79, 0},
+  {"wasm_u8x16_avgr", SK_OP, 0x7b, 0},
+
+  {"wasm_i16x8_eq", SK_OP, 0x2d, 0},
+  {"wasm_i16x8_ne", SK_OP, 0x2e, 0},
+  {"wasm_i16x8_lt", SK_OP, 0x2f, 0},
+  {"wasm_u16x8_lt", SK_OP, 0x30, 0},
+  {"wasm_i16x8_gt", SK_OP, 0x31, 0},
+  {"wasm_u16x8_gt", SK_OP, 0x32, 0},
+  {"wasm_i16x8_le", SK_OP, 0x33, 0},
+  {"wasm_u16x8_le", SK_OP, 0x34, 0},
+  {"wasm_i16x8_ge", SK_OP, 0x35, 0},
+  {"wasm_u16x8_ge", SK_OP, 0x36, 0},
+  {"wasm_i16x8_abs", SK_OP, 0x80, 0},
+  {"wasm_i16x8_neg", SK_OP, 0x81, 0},
+  {"wasm_i16x8_all_true", SK_OP, 0x83, 0},
+  {"wasm_i16x8_bitmask", SK_OP, 0x84, 0},
+  {"wasm_i16x8_narrow_i32x4", SK_OP, 0x85, 0},
+  {"wasm_u16x8_narrow_i32x4", SK_OP, 0x86, 0},
+  {"wasm_i16x8_extend_low_i8x16", SK_OP, 0x87, 0},
+  {"wasm_i16x8_extend_high_i8x16", SK_OP, 0x88, 0},
+  {"wasm_u16x8_extend_low_u8x16", SK_OP, 0x89, 0},
+  {"wasm_u16x8_extend_high_u8x16", SK_OP, 0x8a, 0},
+  {"wasm_i16x8_shl", SK_OP, 0x8b, 0},
+  {"wasm_i16x8_shr", SK_OP, 0x8c, 0},
+  {"wasm_u16x8_shr", SK_OP, 0x8d, 0},
+  {"wasm_i16x8_add", SK_OP, 0x8e, 0},
+  {"wasm_i16x8_add_sat", SK_OP, 0x8f, 0},
+  {"wasm_u16x8_add_sat", SK_OP, 0x90, 0},
+  {"wasm_i16x8_sub", SK_OP, 0x91, 0},
+  {"wasm_i16x8_sub_sat", SK_OP, 0x92, 0},
+  {"wasm_u16x8_sub_sat", SK_OP, 0x93, 0},
+  {"wasm_i16x8_mul", SK_OP, 0x95, 0},
+  {"wasm_i16x8_min", SK_OP, 0x96, 0},
+  {"wasm_u16x8_min", SK_OP, 0x97, 0},
+  {"wasm_i16x8_max", SK_OP, 0x98, 0},
+  {"wasm_u16x8_max", SK_OP, 0x99, 0},
+  {"wasm_u16x8_avgr", SK_OP, 0x9b, 0},
+
+  {"wasm_i32x4_eq", SK_OP, 0x37, 0},
+  {"wasm_i32x4_ne", SK_OP, 0x38, 0},
+  {"wasm_i32x4_lt", SK_OP, 0x39, 0},
+  {"wasm_u32x4_lt", SK_OP, 0x3a, 0},
+  {"wasm_i32x4_gt", SK_OP, 0x3b, 0},
+  {"wasm_u32x4_gt", SK_OP, 0x3c, 0},
+  {"wasm_i32x4_le", SK_OP, 0x3d, 0},
+  {"wasm_u32x4_le", SK_OP, 0x3e, 0},
+  {"wasm_i32x4_ge", SK_OP, 0x3f, 0},
+  {"wasm_u32x4_ge", SK_OP, 0x40, 0},
+  {"wasm_i32x4_abs", SK_OP, 0xa0, 0},
+  {"wasm_i32x4_neg", SK_OP, 0xa1, 0},
+  {"wasm_i32x4_all_true", SK_OP, 0xa3, 0},
+  {"wasm_i32x4_bitmask", SK_OP, 0xa4, 0},
+  {"wasm_i32x4_extend_low_i16x8", SK_OP, 0xa7, 0},
+  {"wasm_i32x4_extend_high_i16x8", SK_OP, 0xa8, 0},
+  {"wasm_u32x4_extend_low_u16x8", SK_OP, 0xa9, 0},
+  {"wasm_u32x4_extend_high_u16x8", SK_OP, 0xaa, 0},
+  {"wasm_i32x4_shl", SK_OP, 0xab, 0},
+  {"wasm_i32x4_shr", SK_OP, 0xac, 0},
+  {"wasm_u32x4_shr", SK_OP, 0xad, 0},
+  {"wasm_i32x4_add", SK_OP, 0xae, 0},
+  {"wasm_i32x4_sub", SK_OP, 0xb1, 0},
+  {"wasm_i32x4_mul", SK_OP, 0xb5, 0},
+  {"wasm_i32x4_min", SK_OP, 0xb6, 0},
+  {"wasm_u32x4_min", SK_OP, 0xb7, 0},
+  {"wasm_i32x4_max", SK_OP, 0xb8, 0},
+  {"wasm_u32x4_max", SK_OP, 0xb9, 0},
+  {"wasm_i32x4_dot_i16x8", SK_OP, 0xba, 0},
+  {"wasm_i32x4_trunc_sat_f32x4", SK_OP, 0xf8, 0},
+  {"wasm_u32x4_trunc_sat_f32x4", SK_OP, 0xf9, 0},
+
+  {"wasm_i64x2_eq", SK_OP, 0xd6, 0},
+  {"wasm_i64x2_ne", SK_OP, 0xd7, 0},
+  {"wasm_i64x2_lt", SK_OP, 0xd8, 0},
+  {"wasm_i64x2_gt", SK_OP, 0xd9, 0},
+  {"wasm_i64x2_le", SK_OP, 0xda, 0},
+  {"wasm_i64x2_ge", SK_OP, 0xdb, 0},
+  {"wasm_i64x2_abs", SK_OP, 0xc0, 0},
+  {"wasm_i64x2_neg", SK_OP, 0xc1, 0},
+  {"wasm_i64x2_all_true", SK_OP, 0xc3, 0},
+  {"wasm_i64x2_bitmask", SK_OP, 0xc4, 0},
+  {"wasm_i64x2_extend_low_i32x4", SK_OP, 0xc7, 0},
+  {"wasm_i64x2_extend_high_i32x4", SK_OP, 0xc8, 0},
+  {"wasm_u64x2_extend_low_u32x4", SK_OP, 0xc9, 0},
+  {"wasm_u64x2_extend_high_u32x4", SK_OP, 0xca, 0},
+  {"wasm_i64x2_shl", SK_OP, 0xcb, 0},
+  {"wasm_i64x2_shr", SK_OP, 0xcc, 0},
+  {"wasm_u64x2_shr", SK_OP, 0xcd, 0},
+  {"wasm_i64x2_add", SK_OP, 0xce, 0},
+  {"wasm_i64x2_sub", SK_OP, 0xd1, 0},
+  {"wasm_i64x2_mul", SK_OP, 0xd5, 0},
+
+  {"wasm_f32x4_eq", SK_OP, 0x41, 0},
+  {"wasm_f32x4_ne", SK_OP, 0x42, 0},
+  {"wasm_f32x4_lt", SK_OP, 0x43, 0},
+  {"wasm_f32x4_gt", SK_OP, 0x44, 0},
+  {"wasm_f32x4_le", SK_OP, 0x45, 0},
+  {"wasm_f32x4_ge", SK_OP, 0x46, 0},
+  {"wasm_f32x4_abs", SK_OP, 0xe0, 0},
+  {"wasm_f32x4_neg", SK_OP, 0xe1, 0},
+  {"wasm_f32x4_sqrt", SK_OP, 0xe3, 0},
+  {"wasm_f32x4_ceil", SK_OP, 0x67, 0},
+  {"wasm_f32x4_floor", SK_OP, 0x68, 0},
+  {"wasm_f32x4_trunc", SK_OP, 0x69, 0},
+  {"wasm_f32x4_nearest", SK_OP, 0x6a, 0},
+  {"wasm_f32x4_add", SK_OP, 0xe4, 0},
+  {"wasm_f32x4_sub", SK_OP, 0xe5, 0},
+  {"wasm_f32x4_mul", SK_OP, 0xe6, 0},
+  {"wasm_f32x4_div", SK_OP, 0xe7, 0},
+  {"wasm_f32x4_min", SK_OP, 0xe8, 0},
+  {"wasm_f32x4_max", SK_OP, 0xe9, 0},
+  {"wasm_f32x4_convert_i32x4", SK_OP, 0xfa, 0},
+  {"wasm_f32x4_convert_u32x4", SK_OP, 0xfb, 0},
+  {"wasm_f32x4_demote_f64x2_zero", SK_OP, 0x5e, 0},
+
+  {"wasm_f64x2_eq", SK_OP, 0x47, 0},
+  {"wasm_f64x2_ne", SK_OP, 0x48, 0},
+  {"wasm_f64x2_lt", SK_OP, 0x49, 0},
+  {"wasm_f64x2_gt", SK_OP, 0x4a, 0},
+  {"wasm_f64x2_le", SK_OP, 0x4b, 0},
+  {"wasm_f64x2_ge", SK_OP, 0x4c, 0},
+  {"wasm_f64x2_abs", SK_OP, 0xec, 0},
+  {"wasm_f64x2_neg", SK_OP, 0xed, 0},
+  {"wasm_f64x2_sqrt", SK_OP, 0xef, 0},
+  {"wasm_f64x2_ceil", SK_OP, 0x74, 0},
+  {"wasm_f64x2_floor", SK_OP, 0x75, 0},
+  {"wasm_f64x2_trunc", SK_OP, 0x7a, 0},
+  {"wasm_f64x2_nearest", SK_OP, 0x94, 0},
+  {"wasm_f64x2_add", SK_OP, 0xf0, 0},
+  {"wasm_f64x2_sub", SK_OP, 0xf1, 0},
+  {"wasm_f64x2_mul", SK_OP, 0xf2, 0},
+  {"wasm_f64x2_div", SK_OP, 0xf3, 0},
+  {"wasm_f64x2_min", SK_OP, 0xf4, 0},
+  {"wasm_f64x2_max", SK_OP, 0xf5, 0},
+  {"wasm_f64x2_convert_low_i32x4", SK_OP, 0xfe, 0},
+  {"wasm_f64x2_convert_low_u32x4", SK_OP, 0xff, 0},
+  {"wasm_f64x2_promote_low_f32x4", SK_OP, 0x5f, 0},
+};
+
+static Table simd_builtin_table;  // <SimdBuiltin*>
+
+static const SimdBuiltin *get_simd_builtin(Expr *expr) {
+  if (expr->kind != EX_FUNCALL)
+    return NULL;
+  Expr *func = expr->funcall.func;
+  if (func->kind != EX_VAR || !is_global_scope(func->var.scope))
+    return NULL;
+  return table_get(&simd_builtin_table, func->var.name);
+}
+
+static bool is_simd_funcall(Expr *expr) {
+  return get_simd_builtin(expr) != NULL;
+}
+
+static void gen_simd_op(uint32_t op) {
+  ADD_CODE(OP_SIMD);
+  ADD_ULEB128(op);
+}
+
+// Push v128 value of `expr` onto the stack: Nested intrinsic is generated in place,
+// otherwise the value is loaded from its memory.
+static void gen_v128(Expr *expr) {
+  if (is_simd_funcall(expr)) {
+    gen_simd(expr);
+    return;
+  }
+  uint32_t offset;
+  switch (expr->kind) {
+  case EX_VAR: case EX_DEREF: case EX_MEMBER:
+    offset = gen_lval_ofs(expr);
+    break;
+  default:
+    gen_expr(expr, true);
+    offset = 0;
+    break;
+  }
+  gen_simd_op(OPSIMD_V128_LOAD);
+  ADD_ULEB128(2);  // align
+  ADD_ULEB128(offset);
+}
+
+static void gen_v128_store(uint32_t offset) {
+  gen_simd_op(OPSIMD_V128_STORE);
+  ADD_ULEB128(2);  // align
+  ADD_ULEB128(offset);
+}
+
+static int get_simd_lane(Expr *expr, int count) {
+  if (expr->kind != EX_FIXNUM || expr->fixnum < 0 || expr->fixnum >= count) {
+    parse_error(PE_NOFATAL, expr->token, "lane index must be constant in [0, %d)", count);
+    return 0;
+  }
+  return expr->fixnum;
+}
+
+// Put lane values of `wasm_*_make` as little endian bytes, if all of them are constant.
+static bool get_simd_const(Vector *args, unsigned char bytes[16]) {
+  int size = 16 / args->len;
+  for (int i = 0; i < args->len; ++i) {
+    Expr *arg = args->data[i];
+    unsigned char *p = &bytes[i * size];
+    switch (arg->kind) {
+    case EX_FIXNUM:
+      for (int j = 0; j < size; ++j)
+        p[j] = (uint64_t)arg->fixnum >> (j * 8);
+      break;
+#ifndef __NO_FLONUM
+    case EX_FLONUM:
+      if (size == 4) {
+        float f = arg->flonum;
+        memcpy(p, &f, sizeof(f));
+      } else {
+        double d = arg->flonum;
+        memcpy(p, &d, sizeof(d));
+      }
+      break;
+#endif
+    default:
+      return false;
+    }
+  }
+  return true;
+}
+
+// Generate intrinsic call, and leave its value (v128 or scalar) on the stack.
+static void gen_simd(Expr *expr) {
+  const SimdBuiltin *simd = get_simd_builtin(expr);
+  assert(simd != NULL);
+  Vector *args = expr->funcall.args;
+  switch (simd->kind) {
+  case SK_OP:
+    for (int i = 0; i < args->len; ++i) {
+      Expr *arg = args->data[i];
+      if (arg->type->kind == TY_STRUCT)
+        gen_v128(arg);
+      else
+        gen_expr(arg, true);
+    }
+    gen_simd_op(simd->op);
+    break;
+  case SK_MEM:
+    {
+      uint32_t offset = gen_address(args->data[0]);
+      for (int i = 1; i < args->len; ++i)
+        gen_v128(args->data[i]);
+      gen_simd_op(simd->op);
+      ADD_ULEB128(0);  // align: Pointer is not known to be aligned.
+      ADD_ULEB128(offset);
+    }
+    break;
+  case SK_LANE:
+    {
+      gen_v128(args->data[0]);
+      int lane = get_simd_lane(args->data[1], simd->op2);
+      if (args->len > 2)
+        gen_expr(args->data[2], true);
+      gen_simd_op(simd->op);
+      ADD_CODE(lane);
+    }
+    break;
+  case SK_SHUFFLE:
+    {
+      gen_v128(args->data[0]);
+      gen_v128(args->data[1]);
+      gen_simd_op(simd->op);
+      for (int i = 2; i < args->len; ++i)
+        ADD_CODE(get_simd_lane(args->data[i], 32));
+    }
+    break;
+  case SK_MAKE:
+    {
+      unsigned char bytes[16];
+      if (get_simd_const(args, bytes)) {
+        gen_simd_op(OPSIMD_V128_CONST);
+        add_code(bytes, sizeof(bytes));
+        break;
+      }
+      gen_expr(args->data[0], true);
+      gen_simd_op(simd->op);
+      for (int i = 1; i < args->len; ++i) {
+        gen_expr(args->data[i], true);
+        gen_simd_op(simd->op2);
+        ADD_CODE(i);
+      }
+    }
+    break;
+  }
+}
+
+static void gen_builtin_simd(Expr *expr, enum BuiltinFunctionPhase phase) {
+  if (phase != BFP_GEN)
+    return;
+
+  assert(expr->kind == EX_FUNCALL);
+  if (expr->type->kind != TY_STRUCT) {
+    gen_simd(expr);
+    return;
+  }
+
+  // Store into the buffer for return value, and leave its address.
+  Expr *buf = get_funcall_result(expr);
+  uint32_t offset = gen_lval_ofs(buf);
+  gen_simd(expr);
+  gen_v128_store(offset);
+  gen_lval(buf);
+}
+
 void install_builtins(void) {
   // __builtin_va_list
   {
@@ -2107,4 +2909,48 @@ void install_builtins(void) {
 
     add_builtin_function("__builtin_try_catch_longjmp", type, &p_try_catch_longjmp, true);
   }
+
+  {
+    static BuiltinExprProc p_atomic = &proc_builtin_atomic;
+    static BuiltinFunctionProc p_gen_atomic = &gen_builtin_atomic;
+    // Actual type is determined on each call, by `proc_builtin_atomic`.
+    Type *type = new_func_type(&tyVoid, new_vector(), false);
+    for (size_t i = 0; i < ARRAY_SIZE(kAtomicBuiltins); ++i) {
+      const AtomicBuiltin *atomic = &kAtomicBuiltins[i];
+      add_builtin_expr_ident(atomic->name, &p_atomic);
+      add_builtin_function(atomic->name, type, &p_gen_atomic, true);
+      table_put(&atomic_builtin_table, alloc_name(atomic->name, NULL, false), (void*)atomic);
+    }
+  }
+  {
+    static BuiltinFunctionProc p_wait32 = &gen_builtin_atomic_wait32;
+    Type *rettype = &tyInt;
+    Vector *params = new_vector();
+    vec_push(params, ptrof(&tyInt));
+    vec_push(params, &tyInt);
+    vec_push(params, get_fixnum_type(FX_LLONG, false, 0));  // timeout (ns): negative for infinity.
+    Type *type = new_func_type(rettype, params, false);
+
+    add_builtin_function("__builtin_wasm_memory_atomic_wait32", type, &p_wait32, true);
+  }
+  {
+    static BuiltinFunctionProc p_notify = &gen_builtin_atomic_notify;
+    Type *rettype = &tyUnsignedInt;
+    Vector *params = new_vector();
+    vec_push(params, ptrof(&tyInt));
+    vec_push(params, &tyUnsignedInt);
+    Type *type = new_func_type(rettype, params, false);
+
+    add_builtin_function("__builtin_wasm_memory_atomic_notify", type, &p_notify, true);
+  }
+
+  {
+    // Declared in <wasm_simd128.h>.
+    static BuiltinFunctionProc p_simd = &gen_builtin_simd;
+    for (size_t i = 0; i < ARRAY_SIZE(kSimdBuiltins); ++i) {
+      const SimdBuiltin *simd = &kSimdBuiltins[i];
+      add_builtin_function(simd->name, NULL, &p_simd, false);
+      table_put(&simd_builtin_table, alloc_name(simd->name, NULL, false), (void*)simd);
+    }
+  }
 }
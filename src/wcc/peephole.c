@@ -0,0 +1,346 @@
+// Peephole optimization on wasm code
+//
+// `gen_wasm` emits code per expression node, which leaves patterns like
+// `local.set x; local.get x`, `i32.const 0; i32.add`, or `local.get x; drop`.
+// After the code of a function is generated, decode its instructions and
+// rewrite such sequences. Structured control flow guarantees that no branch
+// lands between two adjacent instructions, so they can be merged freely.
+// Instructions which have a relocation are kept as is.
+
+#include "../config.h"
+#include "wcc.h"
+
+#include <assert.h>
+#include <stdlib.h>  // free
+#include <string.h>
+
+#include "util.h"
+#include "wasm.h"
+#include "wasm_obj.h"
+
+#define NONE  ((uint32_t)-1)
+
+typedef struct {
+  int64_t value;    // Const: value. Local access: index.
+  uint32_t offset;  // Offset in the original code (NONE=synthesized).
+  uint32_t size;
+  unsigned char op;
+  bool fixed;       // Has relocation: must not be modified.
+} Insn;
+
+typedef struct {
+  Insn *insns;
+  int count, capacity;
+  bool changed;
+} Peephole;
+
+static Insn *push_insn(Peephole *pp, unsigned char op, int64_t value) {
+  if (pp->count >= pp->capacity) {
+    pp->capacity = pp->capacity > 0 ? pp->capacity * 2 : 64;
+    pp->insns = realloc_or_die(pp->insns, sizeof(*pp->insns) * pp->capacity);
+  }
+  Insn *insn = &pp->insns[pp->count++];
+  insn->value = value;
+  insn->offset = NONE;
+  insn->size = 0;
+  insn->op = op;
+  insn->fixed = false;
+  return insn;
+}
+
+static inline bool is_const(const Insn *insn) {
+  return (insn->op == OP_I32_CONST || insn->op == OP_I64_CONST) && !insn->fixed;
+}
+
+// Binary operator which has no effect with the constant on the right hand side.
+static bool is_identity(unsigned char op, int64_t value) {
+  switch (op) {
+  case OP_I32_ADD: case OP_I32_SUB: case OP_I32_OR: case OP_I32_XOR:
+  case OP_I32_SHL: case OP_I32_SHR_S: case OP_I32_SHR_U:
+  case OP_I64_ADD: case OP_I64_SUB: case OP_I64_OR: case OP_I64_XOR:
+  case OP_I64_SHL: case OP_I64_SHR_S: case OP_I64_SHR_U:
+    return value == 0;
+  case OP_I32_MUL: case OP_I64_MUL:
+    return value == 1;
+  case OP_I32_AND:
+    return (int32_t)value == -1;
+  case OP_I64_AND:
+    return value == -1;
+  default:
+    return false;
+  }
+}
+
+// Fold binary operator on constants. Division is left to trap at runtime.
+static bool fold_binop(unsigned char op, int64_t lhs, int64_t rhs, int64_t *presult) {
+  uint32_t a = lhs, b = rhs;
+  uint64_t x = lhs, y = rhs;
+  switch (op) {
+  case OP_I32_ADD:    *presult = (int32_t)(a + b); break;
+  case OP_I32_SUB:    *presult = (int32_t)(a - b); break;
+  case OP_I32_MUL:    *presult = (int32_t)(a * b); break;
+  case OP_I32_AND:    *presult = (int32_t)(a & b); break;
+  case OP_I32_OR:     *presult = (int32_t)(a | b); break;
+  case OP_I32_XOR:    *presult = (int32_t)(a ^ b); break;
+  case OP_I32_SHL:    *presult = (int32_t)(a << (b & 31)); break;
+  case OP_I32_SHR_S:  *presult = (int32_t)a >> (b & 31); break;
+  case OP_I32_SHR_U:  *presult = (int32_t)(a >> (b & 31)); break;
+  case OP_I64_ADD:    *presult = x + y; break;
+  case OP_I64_SUB:    *presult = x - y; break;
+  case OP_I64_MUL:    *presult = x * y; break;
+  case OP_I64_AND:    *presult = x & y; break;
+  case OP_I64_OR:     *presult = x | y; break;
+  case OP_I64_XOR:    *presult = x ^ y; break;
+  case OP_I64_SHL:    *presult = x << (y & 63); break;
+  case OP_I64_SHR_S:  *presult = (int64_t)x >> (y & 63); break;
+  case OP_I64_SHR_U:  *presult = x >> (y & 63); break;
+  default: return false;
+  }
+  return true;
+}
+
+// Reduce instructions at the tail, after one is added.
+static void reduce(Peephole *pp) {
+  for (;;) {
+    int n = pp->count;
+    Insn *last = &pp->insns[n - 1];
+    Insn *prev = n >= 2 ? &pp->insns[n - 2] : NULL;
+    if (prev == NULL || last->fixed || prev->fixed)
+      return;
+
+    switch (last->op) {
+    case OP_IF: case OP_BR_IF:
+      {
+        // Condition is tested against zero anyway.
+        Insn *prev2 = n >= 3 ? &pp->insns[n - 3] : NULL;
+        if (prev2 == NULL ||
+            !((prev->op == OP_I32_NE && is_const(prev2) && prev2->op == OP_I32_CONST &&
+               prev2->value == 0) ||  // i32.const 0; i32.ne; if => if
+              (prev->op == OP_I32_EQZ && prev2->op == OP_I32_EQZ && !prev2->fixed)))  // i32.eqz; i32.eqz; if => if
+          return;
+        Insn insn = *last;
+        pp->count -= 3;
+        *push_insn(pp, insn.op, insn.value) = insn;
+      }
+      break;
+    case OP_ELSE: case OP_END:
+      // br 0; end => end (unless the label is a loop)
+      if (prev->op == OP_BR && prev->value == 0 && (last->op == OP_ELSE || last->value != OP_LOOP)) {
+        Insn insn = *last;
+        pp->count -= 2;
+        *push_insn(pp, insn.op, insn.value) = insn;
+        break;
+      }
+      return;
+    case OP_I32_EQ: case OP_I64_EQ:
+      // i32.const 0; i32.eq => i32.eqz
+      if (is_const(prev) && prev->value == 0 && (prev->op == OP_I32_CONST) == (last->op == OP_I32_EQ)) {
+        unsigned char op = last->op == OP_I32_EQ ? OP_I32_EQZ : OP_I64_EQZ;
+        pp->count -= 2;
+        push_insn(pp, op, 0);
+        break;
+      }
+      return;
+    case OP_LOCAL_GET:
+      // local.set x; local.get x => local.tee x
+      if (prev->op == OP_LOCAL_SET && prev->value == last->value) {
+        pp->count -= 2;
+        push_insn(pp, OP_LOCAL_TEE, last->value);
+        break;
+      }
+      return;
+    case OP_DROP:
+      switch (prev->op) {
+      case OP_LOCAL_TEE:  // local.tee x; drop => local.set x
+        {
+          int64_t local = prev->value;
+          pp->count -= 2;
+          push_insn(pp, OP_LOCAL_SET, local);
+        }
+        break;
+      case OP_LOCAL_GET: case OP_GLOBAL_GET:
+      case OP_I32_CONST: case OP_I64_CONST: case OP_F32_CONST: case OP_F64_CONST:
+        pp->count -= 2;  // Value without side effect.
+        break;
+      default:
+        return;
+      }
+      break;
+    case OP_I32_EQZ: case OP_I64_EQZ:
+      if (is_const(prev) && (prev->op == OP_I32_CONST) == (last->op == OP_I32_EQZ)) {
+        int64_t value = prev->value == 0;
+        pp->count -= 2;
+        push_insn(pp, OP_I32_CONST, value);
+        break;
+      }
+      return;
+    case OP_I32_WRAP_I64:
+      if (is_const(prev) && prev->op == OP_I64_CONST) {
+        int64_t value = (int32_t)prev->value;
+        pp->count -= 2;
+        push_insn(pp, OP_I32_CONST, value);
+        break;
+      }
+      return;
+    case OP_I64_EXTEND_I32_S: case OP_I64_EXTEND_I32_U:
+      if (is_const(prev) && prev->op == OP_I32_CONST) {
+        int64_t value = last->op == OP_I64_EXTEND_I32_S ? (int64_t)(int32_t)prev->value
+                                                        : (int64_t)(uint32_t)prev->value;
+        pp->count -= 2;
+        push_insn(pp, OP_I64_CONST, value);
+        break;
+      }
+      return;
+    default:
+      {
+        unsigned char op = last->op;
+        bool i32 = op >= OP_I32_ADD && op <= OP_I32_SHR_U;
+        if (!(i32 || (op >= OP_I64_ADD && op <= OP_I64_SHR_U)) ||
+            !is_const(prev) || (prev->op == OP_I32_CONST) != i32)
+          return;
+        Insn *prev2 = n >= 3 ? &pp->insns[n - 3] : NULL;
+        int64_t value;
+        if (prev2 != NULL && prev2->op == prev->op && is_const(prev2) &&
+            fold_binop(op, prev2->value, prev->value, &value)) {
+          // const a; const b; op => const (a op b)
+          unsigned char const_op = prev->op;
+          pp->count -= 3;
+          push_insn(pp, const_op, value);
+        } else if (is_identity(op, prev->value)) {
+          // x; const 0; add => x
+          pp->count -= 2;
+        } else if ((op == OP_I32_ADD || op == OP_I32_SUB || op == OP_I64_ADD || op == OP_I64_SUB) &&
+                   prev2 != NULL && n >= 4 && !prev2->fixed &&
+                   (prev2->op == (i32 ? OP_I32_ADD : OP_I64_ADD) ||
+                    prev2->op == (i32 ? OP_I32_SUB : OP_I64_SUB)) &&
+                   is_const(&pp->insns[n - 4]) && pp->insns[n - 4].op == prev->op) {
+          // x; const a; add; const b; add => x; const (a + b); add
+          unsigned char add = i32 ? OP_I32_ADD : OP_I64_ADD;
+          int64_t a = pp->insns[n - 4].value, b = prev->value;
+          // Negate through unsigned: INT64_MIN wraps to itself, as the wasm arithmetic does.
+          if (prev2->op != add)
+            a = -(uint64_t)a;
+          if (op != add)
+            b = -(uint64_t)b;
+          fold_binop(add, a, b, &value);
+          unsigned char const_op = prev->op;
+          pp->count -= 4;
+          push_insn(pp, const_op, value);
+          push_insn(pp, add, 0);
+        } else {
+          return;
+        }
+      }
+      break;
+    }
+    pp->changed = true;
+    if (pp->count <= 0)
+      return;
+  }
+}
+
+// Decode instructions and reduce them on the fly. Returns false for unknown instruction (inline asm).
+static bool decode(Peephole *pp, unsigned char *code, size_t start, size_t end, Vector *reloc_code) {
+  // Opener of each block, to tell whether `br` goes forward.
+  unsigned char *openers = NULL;
+  int depth = 0, capacity = 0;
+  int r = 0;
+  bool ok = true;
+  for (unsigned char *p = code + start, *q = code + end; p < q; ) {
+    unsigned char *top = p;
+    WasmInst inst;
+    if (!(ok = decode_inst(&p, q, &inst)))
+      break;
+    int64_t value = 0;
+    switch (inst.op) {
+    case OP_END:
+      if (depth > 0)
+        value = openers[--depth];
+      break;
+    case OP_BLOCK: case OP_LOOP: case OP_IF: case OP_TRY:
+      if (depth >= capacity) {
+        capacity = capacity > 0 ? capacity * 2 : 16;
+        openers = realloc_or_die(openers, sizeof(*openers) * capacity);
+      }
+      openers[depth++] = inst.op;
+      break;
+    case OP_BR: case OP_BR_IF:
+    case OP_LOCAL_GET: case OP_LOCAL_SET: case OP_LOCAL_TEE:
+    case OP_I32_CONST: case OP_I64_CONST:
+      value = inst.value;
+      break;
+    default: break;
+    }
+
+    Insn *insn = push_insn(pp, inst.op, value);
+    insn->offset = top - code;
+    insn->size = p - top;
+    for (; r < reloc_code->len; ++r) {
+      RelocInfo *reloc = reloc_code->data[r];
+      if (reloc->offset >= insn->offset + insn->size)
+        break;
+      if (reloc->offset >= insn->offset)
+        insn->fixed = true;
+    }
+    reduce(pp);
+  }
+  free(openers);
+  return ok;
+}
+
+// Encode instructions, and move relocations onto the new offsets.
+static void encode(Peephole *pp, DataStorage *code, size_t body_start, Vector *reloc_code) {
+  DataStorage ds;
+  data_init(&ds);
+  data_reserve(&ds, code->len);
+  data_append(&ds, code->buf, body_start);
+
+  int r = 0;
+  for (int i = 0; i < pp->count; ++i) {
+    Insn *insn = &pp->insns[i];
+    if (insn->offset == NONE) {
+      data_push(&ds, insn->op);
+      switch (insn->op) {
+      case OP_LOCAL_GET: case OP_LOCAL_SET: case OP_LOCAL_TEE:
+        data_uleb128(&ds, -1, insn->value);
+        break;
+      case OP_I32_CONST: case OP_I64_CONST:
+        data_leb128(&ds, -1, insn->value);
+        break;
+      default: break;
+      }
+      continue;
+    }
+
+    for (; r < reloc_code->len; ++r) {
+      RelocInfo *reloc = reloc_code->data[r];
+      if (reloc->offset >= insn->offset + insn->size)
+        break;
+      assert(reloc->offset >= insn->offset);
+      reloc->offset = reloc->offset - insn->offset + ds.len;
+    }
+    data_append(&ds, code->buf + insn->offset, insn->size);
+  }
+  assert(r == reloc_code->len);
+
+  data_release(code);
+  *code = ds;
+}
+
+void peephole_optimize(DataStorage *code, Vector *reloc_code) {
+  // Skip local declaration: groups of (count, type).
+  unsigned char *p = code->buf, *end = code->buf + code->len;
+  for (uint32_t group_count = read_uleb(&p, end); group_count > 0; --group_count) {
+    read_uleb(&p, end);
+    ++p;
+  }
+  size_t body_start = p - code->buf;
+
+  sort_relocs(reloc_code);
+
+  Peephole peephole = {0};
+  Peephole *pp = &peephole;
+  if (decode(pp, code->buf, body_start, code->len, reloc_code) && pp->changed)
+    encode(pp, code, body_start, reloc_code);
+  free(pp->insns);
+}
@@ -50,6 +50,8 @@ typedef struct {
 #define OP_RETURN         (0x0f)
 #define OP_CALL           (0x10)
 #define OP_CALL_INDIRECT  (0x11)
+#define OP_RETURN_CALL    (0x12)
+#define OP_RETURN_CALL_INDIRECT  (0x13)
 #define OP_CATCH_ALL      (0x19)
 #define OP_DROP           (0x1a)
 #define OP_SELECT         (0x1b)
@@ -173,11 +175,37 @@ typedef struct {
 #define OP_F64_CONVERT_I64_S  (0xb9)  // f64 <- i64
 #define OP_F64_CONVERT_I64_U  (0xba)  // f64 <- i64
 #define OP_F64_PROMOTE_F32    (0xbb)  // f64 <- f32
+#define OP_I32_EXTEND8_S      (0xc0)  // i32 <- i8
+#define OP_I32_EXTEND16_S     (0xc1)  // i32 <- i16
 #define OP_EXTENSION      (0xfc)
+#define OP_SIMD           (0xfd)
+#define OP_ATOMIC         (0xfe)
 
+#define OPEX_MEMORY_INIT  (0x08)
+#define OPEX_DATA_DROP    (0x09)
 #define OPEX_MEMORY_COPY  (0x0a)
 #define OPEX_MEMORY_FILL  (0x0b)
 
+#define OPSIMD_V128_LOAD      (0x00)
+#define OPSIMD_V128_STORE     (0x0b)
+#define OPSIMD_V128_CONST     (0x0c)
+#define OPSIMD_I8X16_SHUFFLE  (0x0d)
+
+#define OPATOMIC_NOTIFY       (0x00)
+#define OPATOMIC_WAIT32       (0x01)
+#define OPATOMIC_WAIT64       (0x02)
+#define OPATOMIC_FENCE        (0x03)
+// Base of each group: Followed by i64, i32 8bit and i32 16bit variants.
+#define OPATOMIC_LOAD         (0x10)
+#define OPATOMIC_STORE        (0x17)
+#define OPATOMIC_RMW_ADD      (0x1e)
+#define OPATOMIC_RMW_SUB      (0x25)
+#define OPATOMIC_RMW_AND      (0x2c)
+#define OPATOMIC_RMW_OR       (0x33)
+#define OPATOMIC_RMW_XOR      (0x3a)
+#define OPATOMIC_RMW_XCHG     (0x41)
+#define OPATOMIC_RMW_CMPXCHG  (0x48)
+
 // Types
 #define WT_VOID           (0x40)
 #define WT_FUNC           (0x60)
@@ -188,3 +216,4 @@ typedef struct {
 #define WT_I32            (0x7f)
 
 #define MEMORY_PAGE_SIZE  65536
+#define MAX_MEMORY_PAGES  65536  // 4GiB
@@ -191,6 +191,7 @@ typedef struct DataSegmentForLink {
   unsigned char *content;
   uint32_t start;
   uint32_t size;
+  uint32_t p2align;
 } DataSegmentForLink;
 
 static void read_data_section(WasmObj *wasmobj, unsigned char *p) {
@@ -324,6 +325,7 @@ static void read_linking(WasmObj *wasmobj, unsigned char *p, unsigned char *end)
                 sym->func.type_index = func_type;
               }
 
+              sym->wasmobj = wasmobj;
               vec_push(wasmobj->linking.symtab, sym);
             }
             break;
@@ -348,6 +350,7 @@ static void read_linking(WasmObj *wasmobj, unsigned char *p, unsigned char *end)
               sym->data.offset = offset;
               sym->data.size = size;
               sym->data.address = 0;
+              sym->wasmobj = wasmobj;
               vec_push(wasmobj->linking.symtab, sym);
             }
             break;
@@ -365,6 +368,7 @@ static void read_linking(WasmObj *wasmobj, unsigned char *p, unsigned char *end)
               sym->flags = flags;
               sym->local_index = -1;  // Unused.
               sym->tag.typeindex = typeindex;
+              sym->wasmobj = wasmobj;
               vec_push(wasmobj->linking.symtab, sym);
             }
             break;
@@ -401,6 +405,8 @@ static void read_linking(WasmObj *wasmobj, unsigned char *p, unsigned char *end)
           }
           SymbolInfo *sym = symtab->data[index];
           sym->data.p2align = p2align;
+          if (i < wasmobj->data.count)
+            wasmobj->data.segments[i].p2align = p2align;
           ++index;
         }
       }
@@ -562,6 +568,12 @@ struct File {
   };
 };
 
+static void add_unresolved(WasmLinker *linker, const Name *name, SymbolInfo *sym) {
+  if (!table_try_get(&linker->unresolved, name, NULL))
+    vec_push(linker->unresolved_queue, name);
+  table_put(&linker->unresolved, name, sym);
+}
+
 static int resolve_symbols_wasmobj(WasmLinker *linker, WasmObj *wasmobj) {
   int err_count = 0;
   Vector *symtab = wasmobj->linking.symtab;
@@ -570,7 +582,7 @@ static int resolve_symbols_wasmobj(WasmLinker *linker, WasmObj *wasmobj) {
     if (sym->flags & WASM_SYM_UNDEFINED) {
       SymbolInfo *pre;
       if (!table_try_get(&linker->defined, sym->name, (void**)&pre) || pre == NULL) {
-        table_put(&linker->unresolved, sym->name, (void*)sym);
+        add_unresolved(linker, sym->name, sym);
       } else if (sym->kind != pre->kind) {
         fprintf(stderr, "different symbol type: %.*s\n", NAMES(sym->name));
         ++err_count;
@@ -594,33 +606,40 @@ static int resolve_symbols_wasmobj(WasmLinker *linker, WasmObj *wasmobj) {
   return err_count;
 }
 
-static void *load_wasmobj(FILE *fp, const char *name, size_t size) {
-  return read_wasm(fp, name, size);
+static void *load_wasmobj(Archive *ar, size_t offset, const char *name, size_t size) {
+  if (ar->thin) {
+    FILE *fp = fopen(name, "rb");
+    if (fp == NULL) {
+      fprintf(stderr, "cannot open: %s\n", name);
+      return NULL;
+    }
+    WasmObj *wasmobj = read_wasm(fp, name, size);
+    fclose(fp);
+    return wasmobj;
+  }
+  fseek(ar->fp, offset, SEEK_SET);
+  return read_wasm(ar->fp, name, size);
 }
 
+// Search the archive for names in the unresolved queue: Names queued by the files before it,
+// and by the members loaded in this loop.
 static int resolve_symbols_archive(WasmLinker *linker, Archive *ar) {
   Table *unresolved = &linker->unresolved;
-  Table *table = &ar->symbol_table;
-  for (;;) {
-    bool retry = false;
-    const Name *name;
-    for (int it = 0; (it = table_iterate(unresolved, it, &name, NULL)) != -1;) {
-      ArSymbol *symbol;
-      if (!table_try_get(table, name, (void**)&symbol))
-        continue;
-      table_delete(unresolved, name);
+  Vector *queue = linker->unresolved_queue;
+  int err_count = 0;
+  for (int pos = 0; pos < queue->len; ++pos) {
+    const Name *name = queue->data[pos];
+    ArSymbol *symbol;
+    if (!table_try_get(unresolved, name, NULL) ||
+        !table_try_get(&ar->symbol_table, name, (void**)&symbol))
+      continue;
+    table_delete(unresolved, name);
 
-      WasmObj *wasmobj = load_archive_content(ar, symbol, load_wasmobj);
-      if (wasmobj != NULL) {
-        resolve_symbols_wasmobj(linker, wasmobj);
-        retry = true;
-        break;
-      }
-    }
-    if (!retry)
-      break;
+    WasmObj *wasmobj = load_archive_content(ar, symbol, load_wasmobj);
+    if (wasmobj != NULL)
+      err_count += resolve_symbols_wasmobj(linker, wasmobj);
   }
-  return 0;
+  return err_count;
 }
 
 static bool resolve_symbols(WasmLinker *linker) {
@@ -641,7 +660,7 @@ static bool resolve_symbols(WasmLinker *linker) {
 
   // Enumerate unresolved: import
   const Name *wasi_module_name = alloc_name(WASI_MODULE_NAME, NULL, false);
-  uint32_t unresolved_func_count = 0;
+  const Name *wasi_threads_module_name = alloc_name(WASI_THREADS_MODULE_NAME, NULL, false);
   const Name *name;
   SymbolInfo *sym;
   for (int it = 0; (it = table_iterate(&linker->unresolved, it, &name, (void**)&sym)) != -1; ) {
@@ -653,10 +672,9 @@ static bool resolve_symbols(WasmLinker *linker) {
     switch (sym->kind) {
     default: assert(false); // Fallthrough to suppress warning.
     case SIK_SYMTAB_FUNCTION:
-      if (sym->module_name != NULL && equal_name(sym->module_name, wasi_module_name)) {
-        sym->combined_index = unresolved_func_count++;
+      if (sym->module_name != NULL && (equal_name(sym->module_name, wasi_module_name) ||
+                                       equal_name(sym->module_name, wasi_threads_module_name)))
         break;
-      }
 
       if (sym->module_name != NULL)
         fprintf(stderr, "Unresolved: %.*s.%.*s\n", NAMES(sym->module_name), NAMES(name));
@@ -667,7 +685,8 @@ static bool resolve_symbols(WasmLinker *linker) {
 
     case SIK_SYMTAB_DATA:
     case SIK_SYMTAB_GLOBAL:
-      if (equal_name(name, linker->sp_name) || equal_name(name, linker->curbrk_name)) {
+      if (equal_name(name, linker->sp_name) || equal_name(name, linker->curbrk_name) ||
+          equal_name(name, linker->tls_base_name)) {
         // TODO: Check type, etc.
         table_delete(&linker->unresolved, name);
         table_put(&linker->defined, name, (void*)sym);
@@ -680,16 +699,31 @@ static bool resolve_symbols(WasmLinker *linker) {
       break;
     }
   }
-  linker->unresolved_func_count = unresolved_func_count;
 
   return err_count == 0;
 }
 
+// Assign sequential indices to live items, and advance `*pcount`.
+static uint32_t *renumber_live(const bool *live, uint32_t count, uint32_t *pcount) {
+  uint32_t *indices = malloc_or_die(sizeof(*indices) * (count > 0 ? count : 1));
+  uint32_t index = *pcount;
+  for (uint32_t i = 0; i < count; ++i)
+    indices[i] = live[i] ? index++ : (uint32_t)-1;
+  *pcount = index;
+  return indices;
+}
+
 static void renumber_symbols_wasmobj(WasmObj *wasmobj, uint32_t *defined_count) {
   Vector *symtab = wasmobj->linking.symtab;
   uint32_t import_count[3];
   import_count[SIK_SYMTAB_FUNCTION] = wasmobj->import.functions->len;
   import_count[SIK_SYMTAB_DATA] = 0;
+  uint32_t *indices[] = {
+    [SIK_SYMTAB_FUNCTION] = renumber_live(wasmobj->live.functions, wasmobj->live.function_count,
+                                          &defined_count[SIK_SYMTAB_FUNCTION]),
+    [SIK_SYMTAB_DATA] = renumber_live(wasmobj->live.segments, wasmobj->data.count,
+                                      &defined_count[SIK_SYMTAB_DATA]),
+  };
   for (int j = 0; j < symtab->len; ++j) {
     SymbolInfo *sym = symtab->data[j];
     if (sym->flags & WASM_SYM_UNDEFINED)
@@ -698,7 +732,7 @@ static void renumber_symbols_wasmobj(WasmObj *wasmobj, uint32_t *defined_count)
     default: assert(false); // Fallthrough to suppress warning.
     case SIK_SYMTAB_FUNCTION:
     case SIK_SYMTAB_DATA:
-      sym->combined_index = sym->local_index + defined_count[sym->kind] - import_count[sym->kind];
+      sym->combined_index = indices[sym->kind][sym->local_index - import_count[sym->kind]];
       break;
     case SIK_SYMTAB_GLOBAL:
       // Handled differently (just below).
@@ -714,21 +748,24 @@ static void renumber_symbols_wasmobj(WasmObj *wasmobj, uint32_t *defined_count)
       break;
     }
   }
+  free(indices[SIK_SYMTAB_FUNCTION]);
+  free(indices[SIK_SYMTAB_DATA]);
+}
 
-  // Increment count_table according to defined counts.
-  static const int kSecTable[] = {SEC_FUNC, SEC_DATA};
-  for (size_t i = 0; i < ARRAY_SIZE(kSecTable); ++i) {
-    int secidx = kSecTable[i];
-    WasmSection *sec = find_section(wasmobj, secidx);
-    if (sec != NULL) {
-      unsigned char *p = sec->start;
-      uint32_t num = read_uleb128(p, &p);
-      defined_count[i] += num;
+static void renumber_symbols(WasmLinker *linker) {
+  // Imported functions.
+  {
+    const Name *name;
+    SymbolInfo *sym;
+    uint32_t index = 0;
+    for (int it = 0; (it = table_iterate(&linker->unresolved, it, &name, (void**)&sym)) != -1; ) {
+      if (sym->kind != SIK_SYMTAB_FUNCTION || !sym->live)
+        continue;
+      sym->combined_index = index++;
     }
+    linker->unresolved_func_count = index;
   }
-}
 
-static void renumber_symbols(WasmLinker *linker) {
   // Enumerate defined functions and data.
   uint32_t defined_count[] = {
     [SIK_SYMTAB_FUNCTION] = linker->unresolved_func_count,
@@ -747,6 +784,7 @@ static void renumber_symbols(WasmLinker *linker) {
       break;
     }
   }
+  linker->function_count = defined_count[SIK_SYMTAB_FUNCTION];
 
   // Globals.
   {
@@ -754,7 +792,7 @@ static void renumber_symbols(WasmLinker *linker) {
     SymbolInfo *sym;
     uint32_t index = 0;
     for (int it = 0; (it = table_iterate(&linker->defined, it, &name, (void**)&sym)) != -1; ) {
-      if (sym->kind != SIK_SYMTAB_GLOBAL)
+      if (sym->kind != SIK_SYMTAB_GLOBAL || !sym->live)
         continue;
       sym->combined_index = index++;
     }
@@ -792,10 +830,22 @@ static void renumber_func_types(WasmLinker *linker) {
 
 static uint32_t remap_data_address_wasmobj(WasmObj *wasmobj, uint32_t address) {
   address = ALIGN(address, 16);  // TODO:
+  const bool *live = wasmobj->live.segments;
+  bool all_live = true;
+  for (uint32_t j = 0; j < wasmobj->data.count; ++j)
+    all_live &= live[j];
+
   uint32_t max = address;
   for (uint32_t j = 0; j < wasmobj->data.count; ++j) {
     DataSegmentForLink *d = &wasmobj->data.segments[j];
-    d->start += address;
+    if (all_live) {
+      d->start += address;
+    } else {
+      // Pack live segments, to leave no hole for dropped ones.
+      if (!live[j])
+        continue;
+      d->start = ALIGN(max, 1U << d->p2align);
+    }
     uint32_t end = d->start + d->size;
     if (end > max)
       max = end;
@@ -834,7 +884,7 @@ static uint32_t remap_data_address(WasmLinker *linker, uint32_t address) {
 }
 
 static void renumber_indirect_functions_wasmobj(WasmLinker *linker, WasmObj *wasmobj) {
-  Table *indirect_functions = &linker->indirect_functions;
+  Vector *indirect_functions = linker->indirect_functions;
   uint32_t segnum = wasmobj->elem.count;
   ElemSegmentForLink *segments = wasmobj->elem.segments;
   for (uint32_t i = 0; i < segnum; ++i) {
@@ -864,7 +914,11 @@ static void renumber_indirect_functions_wasmobj(WasmLinker *linker, WasmObj *was
           }
         }
       }
-      table_put(indirect_functions, sym->name, sym);
+      // Local functions in different objects can have the same name.
+      if (sym->live && sym->func.indirect_index == 0) {
+        sym->func.indirect_index = INDIRECT_FUNCTION_TABLE_START_INDEX + indirect_functions->len;
+        vec_push(indirect_functions, sym);
+      }
     }
   }
 }
@@ -883,14 +937,6 @@ static void renumber_indirect_functions(WasmLinker *linker) {
       break;
     }
   }
-
-  Table *indirect_functions = &linker->indirect_functions;
-  const Name *name;
-  SymbolInfo *sym;
-  uint32_t index = INDIRECT_FUNCTION_TABLE_START_INDEX;
-  for (int it = 0; (it = table_iterate(indirect_functions, it, &name, (void**)&sym)) != -1; ) {
-    sym->func.indirect_index = index++;
-  }
 }
 
 static void put_varint32(unsigned char *p, int32_t x, RelocInfo *reloc) {
@@ -931,6 +977,14 @@ static void put_i32(unsigned char *p, int32_t x) {
   }
 }
 
+// Symbol which a reference is resolved to.
+static SymbolInfo *resolve_target(WasmLinker *linker, SymbolInfo *sym) {
+  SymbolInfo *target = sym;
+  if (!table_try_get(&linker->defined, sym->name, (void**)&target))
+    table_try_get(&linker->unresolved, sym->name, (void**)&target);
+  return target;
+}
+
 static void apply_relocation_wasmobj(WasmLinker *linker, WasmObj *wasmobj) {
   Vector *symtab = wasmobj->linking.symtab;
   for (int j = 0; j < 2; ++j) {
@@ -969,10 +1023,7 @@ static void apply_relocation_wasmobj(WasmLinker *linker, WasmObj *wasmobj) {
       // Symbol resolution.
       if (p->index >= (uint32_t)symtab->len)
         error("illegal index for reloc: %d", p->index);
-      SymbolInfo *sym = symtab->data[p->index];
-      SymbolInfo *target = sym;
-      if (!table_try_get(&linker->defined, sym->name, (void**)&target))
-        table_try_get(&linker->unresolved, sym->name, (void**)&target);
+      SymbolInfo *target = resolve_target(linker, symtab->data[p->index]);
 
       switch (p->type) {
       case R_WASM_FUNCTION_INDEX_LEB:
@@ -1015,6 +1066,336 @@ static void apply_relocation(WasmLinker *linker) {
   }
 }
 
+// Relocated LEBs are padded to 5 bytes in objects to be patched in place.
+// After relocation, re-encode them in minimal length and compact function bodies.
+
+static int put_uleb128(unsigned char *p, uint32_t x) {
+  int n = 0;
+  for (; x >= 0x80; x >>= 7)
+    p[n++] = (x & 0x7f) | 0x80;
+  p[n++] = x;
+  return n;
+}
+
+static int put_sleb128(unsigned char *p, int32_t x) {
+  int n = 0;
+  for (; x >= 0x40 || x < -0x40; x >>= 7)
+    p[n++] = (x & 0x7f) | 0x80;
+  p[n++] = x & 0x7f;
+  return n;
+}
+
+static int uleb128_size(uint32_t x) {
+  int n = 1;
+  for (; x >= 0x80; x >>= 7)
+    ++n;
+  return n;
+}
+
+static int sleb128_size(int32_t x) {
+  int n = 1;
+  for (; x >= 0x40 || x < -0x40; x >>= 7)
+    ++n;
+  return n;
+}
+
+static int compressed_reloc_size(const RelocInfo *reloc, unsigned char *p, unsigned char **next) {
+  switch (reloc->type) {
+  case R_WASM_FUNCTION_INDEX_LEB:
+  case R_WASM_GLOBAL_INDEX_LEB:
+  case R_WASM_TYPE_INDEX_LEB:
+  case R_WASM_TAG_INDEX_LEB:
+    return uleb128_size(read_uleb128(p, next));
+  case R_WASM_MEMORY_ADDR_LEB:  // Used for `i32.const`, too: Signed form is valid for both.
+  case R_WASM_TABLE_INDEX_SLEB:
+    return sleb128_size(read_uleb128(p, next));  // Non-negative, 5 bytes.
+  default:
+    return -1;  // Not a LEB.
+  }
+}
+
+static int compare_reloc_offset(const void *pa, const void *pb) {
+  const RelocInfo *a = pa, *b = pb;
+  return a->offset < b->offset ? -1 : a->offset > b->offset ? 1 : 0;
+}
+
+static void compress_relocations_wasmobj(WasmObj *wasmobj) {
+  uint32_t count = wasmobj->reloc[0].count;  // code
+  if (count == 0)
+    return;
+  RelocInfo *relocs = wasmobj->reloc[0].relocs;
+  qsort(relocs, count, sizeof(*relocs), compare_reloc_offset);
+
+  // Source and destination share the buffer: Destination never passes source.
+  WasmSection *sec = &wasmobj->sections[wasmobj->reloc[0].section_index];
+  unsigned char *start = sec->start, *src = start;
+  uint32_t num = read_uleb128(src, &src);
+  unsigned char *dst = src;
+  uint32_t k = 0;
+  for (uint32_t i = 0; i < num; ++i) {
+    uint32_t body_size = read_uleb128(src, &src);
+    unsigned char *body_end = src + body_size;
+
+    uint32_t end_reloc = k;
+    uint32_t shrink = 0;
+    for (; end_reloc < count && start + relocs[end_reloc].offset < body_end; ++end_reloc) {
+      unsigned char *p = start + relocs[end_reloc].offset, *next;
+      int size = compressed_reloc_size(&relocs[end_reloc], p, &next);
+      if (size >= 0)
+        shrink += (next - p) - size;
+    }
+    dst += put_uleb128(dst, body_size - shrink);
+
+    for (; k < end_reloc; ++k) {
+      RelocInfo *reloc = &relocs[k];
+      unsigned char *p = start + reloc->offset, *next;
+      if (compressed_reloc_size(reloc, p, &next) < 0)
+        continue;
+      size_t n = p - src;
+      memmove(dst, src, n);
+      dst += n;
+      uint32_t value = read_uleb128(p, &next);
+      dst += reloc->type == R_WASM_MEMORY_ADDR_LEB || reloc->type == R_WASM_TABLE_INDEX_SLEB
+                 ? put_sleb128(dst, value)
+                 : put_uleb128(dst, value);
+      src = next;
+    }
+    size_t n = body_end - src;
+    memmove(dst, src, n);
+    dst += n;
+    src = body_end;
+  }
+  assert(src == start + sec->size);
+  sec->size = dst - start;
+}
+
+static void compress_relocations(WasmLinker *linker) {
+  for (int i = 0; i < linker->files->len; ++i) {
+    File *file = linker->files->data[i];
+    switch (file->kind) {
+    case FK_WASMOBJ:
+      compress_relocations_wasmobj(file->wasmobj);
+      break;
+    case FK_ARCHIVE:
+      FOREACH_FILE_ARCONTENT(file->archive, content, {
+        compress_relocations_wasmobj(content->obj);
+      });
+      break;
+    }
+  }
+}
+
+// --gc-sections: Mark functions and data reachable from the exports by following
+// relocations in code and data, and drop the others on output.
+
+static void gc_mark_symbol(WasmLinker *linker, Vector *stack, SymbolInfo *sym) {
+  SymbolInfo *target = resolve_target(linker, sym);
+  if (target == NULL || target->live)
+    return;
+  target->live = true;
+  if (!(target->flags & WASM_SYM_UNDEFINED) &&
+      (target->kind == SIK_SYMTAB_FUNCTION || target->kind == SIK_SYMTAB_DATA))
+    vec_push(stack, target);
+}
+
+static void gc_trace_symbol(WasmLinker *linker, Vector *stack, SymbolInfo *sym) {
+  WasmObj *wasmobj = sym->wasmobj;
+  int j;
+  uint32_t start, end;
+  if (sym->kind == SIK_SYMTAB_FUNCTION) {
+    uint32_t index = sym->local_index - wasmobj->import.functions->len;
+    if (index >= wasmobj->live.function_count)
+      error("illegal function index: %.*s", NAMES(sym->name));
+    j = 0;
+    start = wasmobj->live.code_offsets[index];
+    end = wasmobj->live.code_offsets[index + 1];
+  } else {
+    if (sym->local_index >= wasmobj->data.count)
+      error("illegal index for data segment %.*s: %d\n", NAMES(sym->name), sym->local_index);
+    if (wasmobj->reloc[1].count == 0)
+      return;
+    DataSegmentForLink *d = &wasmobj->data.segments[sym->local_index];
+    WasmSection *sec = &wasmobj->sections[wasmobj->reloc[1].section_index];
+    j = 1;
+    start = d->content - sec->start;
+    end = start + d->size;
+  }
+
+  // Relocations are sorted by offset: Find the first one in the range.
+  RelocInfo *relocs = wasmobj->reloc[j].relocs;
+  uint32_t lo = 0, hi = wasmobj->reloc[j].count;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (relocs[mid].offset < start)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  Vector *symtab = wasmobj->linking.symtab;
+  for (uint32_t k = lo; k < wasmobj->reloc[j].count && relocs[k].offset < end; ++k) {
+    RelocInfo *p = &relocs[k];
+    if (p->type == R_WASM_TYPE_INDEX_LEB || p->type == R_WASM_TAG_INDEX_LEB)
+      continue;
+    if (p->index >= (uint32_t)symtab->len)
+      error("illegal index for reloc: %d", p->index);
+    gc_mark_symbol(linker, stack, symtab->data[p->index]);
+  }
+}
+
+static void gc_prepare_wasmobj(WasmObj *wasmobj) {
+  for (int j = 0; j < 2; ++j) {
+    if (wasmobj->reloc[j].count > 0)
+      qsort(wasmobj->reloc[j].relocs, wasmobj->reloc[j].count, sizeof(RelocInfo),
+            compare_reloc_offset);
+  }
+
+  WasmSection *sec = find_section(wasmobj, SEC_CODE);
+  if (sec == NULL)
+    return;
+  unsigned char *p = sec->start;
+  uint32_t num = read_uleb128(p, &p);
+  uint32_t *offsets = malloc_or_die(sizeof(*offsets) * (num + 1));
+  for (uint32_t i = 0; i < num; ++i) {
+    offsets[i] = p - sec->start;
+    uint32_t size = read_uleb128(p, &p);
+    p += size;
+  }
+  offsets[num] = p - sec->start;
+  wasmobj->live.code_offsets = offsets;
+  wasmobj->live.function_count = num;
+}
+
+static void gc_mark_roots_wasmobj(WasmLinker *linker, Vector *stack, WasmObj *wasmobj) {
+  Vector *symtab = wasmobj->linking.symtab;
+  for (int j = 0; j < symtab->len; ++j) {
+    SymbolInfo *sym = symtab->data[j];
+    if (!(sym->flags & WASM_SYM_UNDEFINED) && sym->flags & (WASM_SYM_EXPORTED | WASM_SYM_NO_STRIP))
+      gc_mark_symbol(linker, stack, sym);
+  }
+}
+
+static void gc_sections(WasmLinker *linker, Vector *exports) {
+  Vector *stack = new_vector();
+  for (int i = 0; i < linker->files->len; ++i) {
+    File *file = linker->files->data[i];
+    switch (file->kind) {
+    case FK_WASMOBJ:
+      gc_prepare_wasmobj(file->wasmobj);
+      gc_mark_roots_wasmobj(linker, stack, file->wasmobj);
+      break;
+    case FK_ARCHIVE:
+      FOREACH_FILE_ARCONTENT(file->archive, content, {
+        gc_prepare_wasmobj(content->obj);
+        gc_mark_roots_wasmobj(linker, stack, content->obj);
+      });
+      break;
+    }
+  }
+
+  for (int i = 0; i < exports->len; ++i) {
+    SymbolInfo *sym = table_get(&linker->defined, exports->data[i]);
+    if (sym != NULL)
+      gc_mark_symbol(linker, stack, sym);
+  }
+
+  while (stack->len > 0)
+    gc_trace_symbol(linker, stack, vec_pop(stack));
+  free_vector(stack);
+}
+
+static void mark_all_live_wasmobj(WasmObj *wasmobj) {
+  Vector *symtab = wasmobj->linking.symtab;
+  for (int j = 0; j < symtab->len; ++j) {
+    SymbolInfo *sym = symtab->data[j];
+    sym->live = true;
+  }
+}
+
+// Liveness of functions and data segments, from their symbols.
+// Ones without any symbol cannot be referenced, but are kept.
+static bool *collect_live(WasmObj *wasmobj, enum SymInfoKind kind, uint32_t count) {
+  bool *live = malloc_or_die(sizeof(*live) * (count > 0 ? count : 1));
+  for (uint32_t i = 0; i < count; ++i)
+    live[i] = true;
+
+  uint32_t base = kind == SIK_SYMTAB_FUNCTION ? wasmobj->import.functions->len : 0;
+  Vector *symtab = wasmobj->linking.symtab;
+  for (int k = 0; k < 2; ++k) {  // 0=dead, 1=live (prior)
+    for (int j = 0; j < symtab->len; ++j) {
+      SymbolInfo *sym = symtab->data[j];
+      if (sym->kind != kind || sym->flags & WASM_SYM_UNDEFINED || sym->live != (k == 1))
+        continue;
+      uint32_t index = sym->local_index - base;
+      if (index >= count)
+        error("illegal index: %.*s", NAMES(sym->name));
+      live[index] = k == 1;
+    }
+  }
+  return live;
+}
+
+static void collect_live_wasmobj(WasmObj *wasmobj) {
+  uint32_t function_count = 0;
+  WasmSection *sec = find_section(wasmobj, SEC_FUNC);
+  if (sec != NULL) {
+    unsigned char *p = sec->start;
+    function_count = read_uleb128(p, &p);
+  }
+  wasmobj->live.function_count = function_count;
+  wasmobj->live.functions = collect_live(wasmobj, SIK_SYMTAB_FUNCTION, function_count);
+  wasmobj->live.segments = collect_live(wasmobj, SIK_SYMTAB_DATA, wasmobj->data.count);
+}
+
+static void mark_live(WasmLinker *linker, Vector *exports) {
+  if (linker->gc_sections) {
+    gc_sections(linker, exports);
+  } else {
+    for (int i = 0; i < linker->files->len; ++i) {
+      File *file = linker->files->data[i];
+      switch (file->kind) {
+      case FK_WASMOBJ:
+        mark_all_live_wasmobj(file->wasmobj);
+        break;
+      case FK_ARCHIVE:
+        FOREACH_FILE_ARCONTENT(file->archive, content, {
+          mark_all_live_wasmobj(content->obj);
+        });
+        break;
+      }
+    }
+  }
+
+  for (int i = 0; i < linker->files->len; ++i) {
+    File *file = linker->files->data[i];
+    switch (file->kind) {
+    case FK_WASMOBJ:
+      collect_live_wasmobj(file->wasmobj);
+      break;
+    case FK_ARCHIVE:
+      FOREACH_FILE_ARCONTENT(file->archive, content, {
+        collect_live_wasmobj(content->obj);
+      });
+      break;
+    }
+  }
+}
+
+static void put_memory_limits(WasmLinker *linker, DataStorage *ds) {
+  uint32_t page_count = (linker->address_bottom + MEMORY_PAGE_SIZE - 1) / MEMORY_PAGE_SIZE;
+  if (page_count <= 0)
+    page_count = 1;
+  uint32_t max_pages = linker->max_memory_pages;
+  if (max_pages == 0) {
+    data_uleb128(ds, -1, 0);  // limits (no maximum page size)
+    data_uleb128(ds, -1, page_count);
+  } else {
+    data_uleb128(ds, -1, linker->shared_memory ? 0x03 : 0x01);  // limits: has maximum, (shared)
+    data_uleb128(ds, -1, page_count);
+    data_uleb128(ds, -1, max_pages);
+  }
+}
+
 static void out_import_section(WasmLinker *linker) {
   DataStorage imports_section;
   data_init(&imports_section);
@@ -1025,7 +1406,7 @@ static void out_import_section(WasmLinker *linker) {
   const Name *name;
   SymbolInfo *sym;
   for (int it = 0; (it = table_iterate(&linker->unresolved, it, &name, (void**)&sym)) != -1; ) {
-    if (sym->kind != SIK_SYMTAB_FUNCTION)
+    if (sym->kind != SIK_SYMTAB_FUNCTION || !sym->live)
       continue;
     const Name *modname = sym->module_name;
     assert(modname != NULL);
@@ -1038,6 +1419,17 @@ static void out_import_section(WasmLinker *linker) {
     ++imports_count;
   }
 
+  if (linker->shared_memory) {
+    // Shared memory must be given from the host, to pass it to other threads.
+    static const char kModuleName[] = "env";
+    static const char kName[] = "memory";
+    data_string(&imports_section, kModuleName, sizeof(kModuleName) - 1);  // import module name
+    data_string(&imports_section, kName, sizeof(kName) - 1);  // import name
+    data_push(&imports_section, IMPORT_MEMORY);  // import kind
+    put_memory_limits(linker, &imports_section);
+    ++imports_count;
+  }
+
   if (imports_count > 0) {
     data_close_chunk(&imports_section, imports_count);
     data_close_chunk(&imports_section, -1);
@@ -1049,10 +1441,12 @@ static void out_import_section(WasmLinker *linker) {
 
 static uint32_t out_function_section_wasmobj(WasmObj *wasmobj, DataStorage *functions_section) {
   Vector *symtab = wasmobj->linking.symtab;
+  uint32_t import_count = wasmobj->import.functions->len;
   uint32_t function_count = 0;
   for (int j = 0; j < symtab->len; ++j) {
     SymbolInfo *sym = symtab->data[j];
-    if (sym->kind != SIK_SYMTAB_FUNCTION || (sym->flags & WASM_SYM_UNDEFINED))
+    if (sym->kind != SIK_SYMTAB_FUNCTION || (sym->flags & WASM_SYM_UNDEFINED) ||
+        !wasmobj->live.functions[sym->local_index - import_count])
       continue;
     // assert(sym->combined_index == function_count + linker->unresolved_func_count);
     ++function_count;
@@ -1082,6 +1476,10 @@ static void out_function_section(WasmLinker *linker) {
       break;
     }
   }
+  if (linker->shared_memory) {  // __wasm_init_memory
+    data_uleb128(&functions_section, -1, linker->init_memory_type_index);
+    ++function_count;
+  }
 
   if (function_count > 0) {
     data_close_chunk(&functions_section, function_count);  // num functions
@@ -1093,8 +1491,8 @@ static void out_function_section(WasmLinker *linker) {
 }
 
 static void out_table_section(WasmLinker *linker) {
-  Table *indirect_functions = &linker->indirect_functions;
-  if (indirect_functions->count == 0)
+  Vector *indirect_functions = linker->indirect_functions;
+  if (indirect_functions->len == 0)
     return;
 
   DataStorage table_section;
@@ -1103,7 +1501,7 @@ static void out_table_section(WasmLinker *linker) {
   data_leb128(&table_section, -1, 1);  // num tables
   data_push(&table_section, WT_FUNCREF);
   data_push(&table_section, 0x00);  // limits: flags
-  data_leb128(&table_section, -1, INDIRECT_FUNCTION_TABLE_START_INDEX + indirect_functions->count);  // initial
+  data_leb128(&table_section, -1, INDIRECT_FUNCTION_TABLE_START_INDEX + indirect_functions->len);  // initial
   data_close_chunk(&table_section, -1);
 
   fputc(SEC_TABLE, linker->ofp);
@@ -1111,16 +1509,15 @@ static void out_table_section(WasmLinker *linker) {
 }
 
 static void out_memory_section(WasmLinker *linker) {
+  if (linker->shared_memory)  // Imported.
+    return;
+
   DataStorage memory_section;
   data_init(&memory_section);
   data_open_chunk(&memory_section);
   data_open_chunk(&memory_section);
   {
-    uint32_t page_count = (linker->address_bottom + MEMORY_PAGE_SIZE - 1) / MEMORY_PAGE_SIZE;
-    if (page_count <= 0)
-      page_count = 1;
-    data_uleb128(&memory_section, -1, 0);  // limits (no maximum page size)
-    data_uleb128(&memory_section, -1, page_count);
+    put_memory_limits(linker, &memory_section);
     data_close_chunk(&memory_section, 1);  // count
     data_close_chunk(&memory_section, -1);
   }
@@ -1139,7 +1536,7 @@ static void out_global_section(WasmLinker *linker) {
     const Name *name;
     SymbolInfo *sym;
     for (int it = 0; (it = table_iterate(&linker->defined, it, &name, (void**)&sym)) != -1; ) {
-      if (sym->kind != SIK_SYMTAB_GLOBAL)
+      if (sym->kind != SIK_SYMTAB_GLOBAL || !sym->live)
         continue;
       assert(sym->combined_index == globals_count);
 
@@ -1214,9 +1611,23 @@ static void out_export_section(WasmLinker *linker, Vector *exports) {
   fwrite(exports_section.buf, exports_section.len, 1, linker->ofp);
 }
 
+static void out_start_section(WasmLinker *linker) {
+  if (!linker->shared_memory)
+    return;
+
+  DataStorage start_section;
+  data_init(&start_section);
+  data_open_chunk(&start_section);
+  data_uleb128(&start_section, -1, linker->function_count);  // __wasm_init_memory
+  data_close_chunk(&start_section, -1);
+
+  fputc(SEC_START, linker->ofp);
+  fwrite(start_section.buf, start_section.len, 1, linker->ofp);
+}
+
 static void out_elems_section(WasmLinker *linker) {
-  Table *indirect_functions = &linker->indirect_functions;
-  if (indirect_functions->count == 0)
+  Vector *indirect_functions = linker->indirect_functions;
+  if (indirect_functions->len == 0)
     return;
 
   DataStorage elems_section;
@@ -1229,10 +1640,9 @@ static void out_elems_section(WasmLinker *linker) {
   data_push(&elems_section, OP_I32_CONST);
   data_leb128(&elems_section, -1, INDIRECT_FUNCTION_TABLE_START_INDEX);  // start index
   data_push(&elems_section, OP_END);
-  data_leb128(&elems_section, -1, indirect_functions->count);  // num elems
-  const Name *name;
-  SymbolInfo *sym;
-  for (int it = 0; (it = table_iterate(indirect_functions, it, &name, (void**)&sym)) != -1; ) {
+  data_leb128(&elems_section, -1, indirect_functions->len);  // num elems
+  for (int i = 0; i < indirect_functions->len; ++i) {
+    SymbolInfo *sym = indirect_functions->data[i];
     data_leb128(&elems_section, -1, sym->combined_index);  // elem function index
   }
   data_close_chunk(&elems_section, -1);
@@ -1247,11 +1657,96 @@ static uint32_t out_code_section_wasmobj(WasmObj *wasmobj, DataStorage *codesec)
     return 0;
   unsigned char *p = sec->start;
   uint32_t num = read_uleb128(p, &p);
-  data_append(codesec, p, sec->size - (p - sec->start));
-  return num;
+  const bool *live = wasmobj->live.functions;
+  uint32_t live_count = 0;
+  for (uint32_t i = 0; i < num; ++i)
+    live_count += live[i];
+  if (live_count == num) {
+    data_append(codesec, p, sec->size - (p - sec->start));
+    return num;
+  }
+
+  for (uint32_t i = 0; i < num; ++i) {
+    unsigned char *body = p;
+    uint32_t size = read_uleb128(p, &p);
+    p += size;
+    if (live[i])
+      data_append(codesec, body, p - body);
+  }
+  return live_count;
+}
+
+// Initialize passive data segments on the first instance only: Every thread
+// runs the start function, and others wait until the initialization is done.
+//   state: 0=not yet, 1=initializing, 2=done
+static void out_init_memory_code(WasmLinker *linker, DataStorage *codesec,
+                                 const DataStorage *inits) {
+  uint32_t flag = linker->init_memory_flag;
+  DataStorage body;
+  data_init(&body);
+  data_open_chunk(&body);
+  data_push(&body, 0);  // num local decls
+  data_push(&body, OP_BLOCK);
+  data_push(&body, WT_VOID);
+  {
+    // if (cmpxchg(flag, 0, 1) != 0) break
+    data_push(&body, OP_I32_CONST);
+    data_leb128(&body, -1, flag);
+    data_push(&body, OP_I32_CONST);
+    data_leb128(&body, -1, 0);
+    data_push(&body, OP_I32_CONST);
+    data_leb128(&body, -1, 1);
+    data_push(&body, OP_ATOMIC);
+    data_uleb128(&body, -1, OPATOMIC_RMW_CMPXCHG);
+    data_uleb128(&body, -1, 2);  // align
+    data_uleb128(&body, -1, 0);  // offset
+    data_push(&body, OP_BR_IF);
+    data_uleb128(&body, -1, 0);
+
+    data_append(&body, inits->buf, inits->len);
+
+    // flag = 2, and wake up all waiters.
+    data_push(&body, OP_I32_CONST);
+    data_leb128(&body, -1, flag);
+    data_push(&body, OP_I32_CONST);
+    data_leb128(&body, -1, 2);
+    data_push(&body, OP_ATOMIC);
+    data_uleb128(&body, -1, OPATOMIC_STORE);
+    data_uleb128(&body, -1, 2);  // align
+    data_uleb128(&body, -1, 0);  // offset
+    data_push(&body, OP_I32_CONST);
+    data_leb128(&body, -1, flag);
+    data_push(&body, OP_I32_CONST);
+    data_leb128(&body, -1, -1);  // count
+    data_push(&body, OP_ATOMIC);
+    data_uleb128(&body, -1, OPATOMIC_NOTIFY);
+    data_uleb128(&body, -1, 2);  // align
+    data_uleb128(&body, -1, 0);  // offset
+    data_push(&body, OP_DROP);
+    data_push(&body, OP_RETURN);
+  }
+  data_push(&body, OP_END);
+  // Wait while another instance is initializing.
+  data_push(&body, OP_I32_CONST);
+  data_leb128(&body, -1, flag);
+  data_push(&body, OP_I32_CONST);
+  data_leb128(&body, -1, 1);
+  data_push(&body, OP_I64_CONST);
+  data_leb128(&body, -1, -1);  // timeout: infinity
+  data_push(&body, OP_ATOMIC);
+  data_uleb128(&body, -1, OPATOMIC_WAIT32);
+  data_uleb128(&body, -1, 2);  // align
+  data_uleb128(&body, -1, 0);  // offset
+  data_push(&body, OP_DROP);
+  data_push(&body, OP_END);
+  data_close_chunk(&body, -1);
+
+  data_append(codesec, body.buf, body.len);
+  data_release(&body);
 }
 
-static void out_code_section(WasmLinker *linker) {
+// `inits`: Code to initialize memory, when shared.
+static void out_code_section(WasmLinker *linker, const DataStorage *inits) {
   DataStorage codesec;
   data_init(&codesec);
   data_open_chunk(&codesec);
@@ -1271,6 +1766,10 @@ static void out_code_section(WasmLinker *linker) {
       break;
     }
   }
+  if (linker->shared_memory) {
+    out_init_memory_code(linker, &codesec, inits);
+    ++code_count;
+  }
 
   data_close_chunk(&codesec, code_count);
   data_close_chunk(&codesec, -1);
@@ -1279,10 +1778,14 @@ static void out_code_section(WasmLinker *linker) {
   fwrite(codesec.buf, codesec.len, 1, linker->ofp);
 }
 
-static uint32_t out_data_section_wasmobj(WasmObj *wasmobj, DataStorage *datasec) {
+// Shared memory: Segments are passive, and `inits` receives code to copy them.
+static uint32_t out_data_section_wasmobj(WasmObj *wasmobj, DataStorage *datasec, uint32_t index,
+                                         DataStorage *inits) {
   DataSegmentForLink *segments = wasmobj->data.segments;
   uint32_t data_count = 0;
   for (uint32_t j = 0, count = wasmobj->data.count; j < count; ++j) {
+    if (!wasmobj->live.segments[j])
+      continue;
     DataSegmentForLink *segment = &segments[j];
     uint32_t size = segment->size;
     const unsigned char *content = segment->content;
@@ -1294,12 +1797,31 @@ static uint32_t out_data_section_wasmobj(WasmObj *wasmobj, DataStorage *datasec)
     if (non_zero_size == 0)  // BSS
       continue;
 
-    data_push(datasec, 0);  // flags
-    // Init (address).
     uint32_t address = segment->start;
-    data_push(datasec, OP_I32_CONST);
-    data_leb128(datasec, -1, address);
-    data_push(datasec, OP_END);
+    if (inits == NULL) {
+      data_push(datasec, 0);  // flags
+      // Init (address).
+      data_push(datasec, OP_I32_CONST);
+      data_leb128(datasec, -1, address);
+      data_push(datasec, OP_END);
+    } else {
+      data_push(datasec, 1);  // flags: passive
+
+      // memory.init(address, 0, size), data.drop
+      data_push(inits, OP_I32_CONST);
+      data_leb128(inits, -1, address);
+      data_push(inits, OP_I32_CONST);
+      data_leb128(inits, -1, 0);
+      data_push(inits, OP_I32_CONST);
+      data_leb128(inits, -1, non_zero_size);
+      data_push(inits, OP_EXTENSION);
+      data_uleb128(inits, -1, OPEX_MEMORY_INIT);
+      data_uleb128(inits, -1, index + data_count);
+      data_push(inits, 0x00);  // memory index
+      data_push(inits, OP_EXTENSION);
+      data_uleb128(inits, -1, OPEX_DATA_DROP);
+      data_uleb128(inits, -1, index + data_count);
+    }
     // Content
     data_uleb128(datasec, -1, non_zero_size);
     data_append(datasec, segment->content, non_zero_size);
@@ -1308,31 +1830,46 @@ static uint32_t out_data_section_wasmobj(WasmObj *wasmobj, DataStorage *datasec)
   return data_count;
 }
 
-static void out_data_section(WasmLinker *linker) {
-  DataStorage datasec;
-  data_init(&datasec);
-  data_open_chunk(&datasec);
-  data_open_chunk(&datasec);
+// Data section is made before code, because its segments are initialized by code
+// on shared memory.
+static uint32_t make_data_section(WasmLinker *linker, DataStorage *datasec, DataStorage *inits) {
+  data_init(datasec);
+  data_open_chunk(datasec);
+  data_open_chunk(datasec);
 
   uint32_t data_count = 0;
   for (int i = 0; i < linker->files->len; ++i) {
     File *file = linker->files->data[i];
     switch (file->kind) {
     case FK_WASMOBJ:
-      data_count += out_data_section_wasmobj(file->wasmobj, &datasec);
+      data_count += out_data_section_wasmobj(file->wasmobj, datasec, data_count, inits);
       break;
     case FK_ARCHIVE:
       FOREACH_FILE_ARCONTENT(file->archive, content, {
-        data_count += out_data_section_wasmobj(content->obj, &datasec);
+        data_count += out_data_section_wasmobj(content->obj, datasec, data_count, inits);
       });
       break;
     }
   }
-  data_close_chunk(&datasec, data_count);
-  data_close_chunk(&datasec, -1);
+  data_close_chunk(datasec, data_count);
+  data_close_chunk(datasec, -1);
+  return data_count;
+}
+
+static void out_data_count_section(WasmLinker *linker, uint32_t data_count) {
+  DataStorage data_count_section;
+  data_init(&data_count_section);
+  data_open_chunk(&data_count_section);
+  data_uleb128(&data_count_section, -1, data_count);
+  data_close_chunk(&data_count_section, -1);
+
+  fputc(SEC_DATA_COUNT, linker->ofp);
+  fwrite(data_count_section.buf, data_count_section.len, 1, linker->ofp);
+}
 
+static void out_data_section(WasmLinker *linker, const DataStorage *datasec) {
   fputc(SEC_DATA, linker->ofp);
-  fwrite(datasec.buf, datasec.len, 1, linker->ofp);
+  fwrite(datasec->buf, datasec->len, 1, linker->ofp);
 }
 
 //
@@ -1343,10 +1880,12 @@ void linker_init(WasmLinker *linker) {
 
   table_init(&linker->defined);
   table_init(&linker->unresolved);
-  table_init(&linker->indirect_functions);
+  linker->unresolved_queue = new_vector();
+  linker->indirect_functions = new_vector();
 
   linker->sp_name = alloc_name(SP_NAME, NULL, false);
   linker->curbrk_name = alloc_name(BREAK_ADDRESS_NAME, NULL, false);
+  linker->tls_base_name = alloc_name(TLS_BASE_NAME, NULL, false);
 }
 
 bool read_wasm_obj(WasmLinker *linker, const char *filename) {
@@ -1392,7 +1931,7 @@ static void verbose_symbols(WasmObj *wasmobj, enum SymInfoKind kind) {
   Vector *symtab = wasmobj->linking.symtab;
   for (int j = 0; j < symtab->len; ++j) {
     SymbolInfo *sym = symtab->data[j];
-    if (sym->flags & WASM_SYM_UNDEFINED || sym->kind != kind)
+    if (sym->flags & WASM_SYM_UNDEFINED || sym->kind != kind || !sym->live)
       continue;
     printf("%2d: %.*s\n", sym->combined_index, NAMES(sym->name));
   }
@@ -1401,19 +1940,35 @@ static void verbose_symbols(WasmObj *wasmobj, enum SymInfoKind kind) {
 bool link_wasm_objs(WasmLinker *linker, Vector *exports, uint32_t stack_size) {
   for (int i = 0; i < exports->len; ++i) {
     const Name *name = exports->data[i];
-    table_put(&linker->unresolved, name, NULL);
+    add_unresolved(linker, name, NULL);
   }
 
   if (!resolve_symbols(linker))
     return false;
+  mark_live(linker, exports);
 
   uint32_t data_end_address = remap_data_address(linker, stack_size);
   renumber_symbols(linker);
   renumber_func_types(linker);
   renumber_indirect_functions(linker);
   apply_relocation(linker);
+  if (linker->compress_relocations)
+    compress_relocations(linker);
 
   uint32_t address_bottom = ALIGN(data_end_address, 16);
+  if (linker->shared_memory) {
+    // State of `__wasm_init_memory`, in front of the heap.
+    linker->init_memory_flag = address_bottom;
+    address_bottom += 16;
+
+    static unsigned char kVoidFuncType[] = {0, 0};  // No params, no results.
+    linker->init_memory_type_index = getsert_func_type(kVoidFuncType, sizeof(kVoidFuncType), true);
+  }
+  if (linker->max_memory_pages > 0 &&
+      address_bottom > (uint64_t)linker->max_memory_pages * MEMORY_PAGE_SIZE) {
+    fprintf(stderr, "Data exceeds max memory size\n");
+    return false;
+  }
   linker->address_bottom = address_bottom;
   {
     SymbolInfo *spsym = table_get(&linker->defined, linker->sp_name);
@@ -1429,6 +1984,13 @@ bool link_wasm_objs(WasmLinker *linker, Vector *exports, uint32_t stack_size) {
         error("illegal symbol for break address: %.*s", NAMES(linker->curbrk_name));
       curbrksym->global.ivalue = address_bottom;
     }
+
+    SymbolInfo *tlssym = table_get(&linker->defined, linker->tls_base_name);
+    if (tlssym != NULL) {
+      if (tlssym->kind != SIK_SYMTAB_GLOBAL)
+        error("illegal symbol for thread local base: %.*s", NAMES(linker->tls_base_name));
+      tlssym->global.ivalue = 0;  // Main thread.
+    }
   }
 
   if (verbose) {
@@ -1439,7 +2001,7 @@ bool link_wasm_objs(WasmLinker *linker, Vector *exports, uint32_t stack_size) {
     uint32_t imports_count = 0;
     // Import.
     for (int it = 0; (it = table_iterate(&linker->unresolved, it, &name, (void**)&sym)) != -1; ) {
-      if (sym->kind != SIK_SYMTAB_FUNCTION)
+      if (sym->kind != SIK_SYMTAB_FUNCTION || !sym->live)
         continue;
       const Name *modname = sym->module_name;
       assert(modname != NULL);
@@ -1464,7 +2026,7 @@ bool link_wasm_objs(WasmLinker *linker, Vector *exports, uint32_t stack_size) {
 
     printf("### Globals\n");
     for (int it = 0; (it = table_iterate(&linker->defined, it, &name, (void**)&sym)) != -1; ) {
-      if (sym->kind != SIK_SYMTAB_GLOBAL)
+      if (sym->kind != SIK_SYMTAB_GLOBAL || !sym->live)
         continue;
       printf("%2d: %.*s\n", sym->combined_index, NAMES(sym->name));
     }
@@ -1528,14 +2090,26 @@ bool linker_emit_wasm(WasmLinker *linker, const char *ofn, Vector *exports) {
   // Exports.
   out_export_section(linker, exports);
 
+  // Start.
+  out_start_section(linker);
+
   // Elements.
   out_elems_section(linker);
 
+  DataStorage datasec, inits;
+  data_init(&inits);
+  uint32_t data_count = make_data_section(linker, &datasec,
+                                          linker->shared_memory ? &inits : NULL);
+
+  // Data count (must put earlier than Code section.)
+  if (linker->shared_memory)
+    out_data_count_section(linker, data_count);
+
   // Code.
-  out_code_section(linker);
+  out_code_section(linker, &inits);
 
   // Data.
-  out_data_section(linker);
+  out_data_section(linker, &datasec);
 
   fclose(ofp);
 
@@ -10,16 +10,29 @@ typedef struct File File;
 typedef struct Vector Vector;
 
 #define WASI_MODULE_NAME  "wasi_snapshot_preview1"
+#define WASI_THREADS_MODULE_NAME  "wasi"
 
 typedef struct {
   Vector *files;  // <File*>
   Table defined, unresolved;
-  Table indirect_functions;
+  Vector *unresolved_queue;  // <const Name*>, in the order of appearance
+  Vector *indirect_functions;  // <SymbolInfo*>
   uint32_t unresolved_func_count;
   uint32_t address_bottom;
+  uint32_t function_count;  // Including imported ones.
 
   const Name *sp_name;
   const Name *curbrk_name;
+  const Name *tls_base_name;
+
+  bool compress_relocations;  // Re-encode relocated LEBs in minimal length.
+  bool gc_sections;  // Drop functions and data unreachable from the exports.
+  // Import shared memory, and initialize it in the start function, for threads.
+  bool shared_memory;
+  uint32_t max_memory_pages;  // 0=unlimited (required for shared memory).
+
+  uint32_t init_memory_flag;  // Address of the state for `__wasm_init_memory`.
+  uint32_t init_memory_type_index;
 
   FILE *ofp;
 } WasmLinker;
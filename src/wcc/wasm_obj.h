@@ -6,6 +6,7 @@
 
 typedef struct Name Name;
 typedef struct Vector Vector;
+typedef struct WasmObj WasmObj;
 
 #define LINKING_VERSION   (2)
 
@@ -107,9 +108,11 @@ typedef struct {
   };
 
   uint32_t combined_index;
+  WasmObj *wasmobj;  // Object which the symbol belongs to.
+  bool live;
 } SymbolInfo;
 
-typedef struct WasmObj {
+struct WasmObj {
   unsigned char *buffer;
   size_t bufsiz;
 
@@ -138,4 +141,10 @@ typedef struct WasmObj {
     uint32_t section_index;
     uint32_t count;
   } reloc[2];  // 0=code, 1=data
-} WasmObj;
+  struct {
+    bool *functions;         // Defined functions (import excluded), by local index.
+    bool *segments;          // Data segments.
+    uint32_t function_count;
+    uint32_t *code_offsets;  // Function bodies in code section, for --gc-sections.
+  } live;
+};
@@ -10,6 +10,9 @@
 #include <strings.h>  // strcasecmp
 #include <sys/stat.h>
 #include <unistd.h>  // getcwd
+#if !defined(__WASM)
+#include <sys/wait.h>
+#endif
 
 #include "fe_misc.h"
 #include "lexer.h"
@@ -39,6 +42,12 @@ static void usage(FILE *fp) {
       "  -c                    Output object file\n"
       "  --entry-point=<name>  Specify entry point (Defulat: _start)\n"
       "  --stack-size=<size>   Output object file (Default: 8192)\n"
+      "  --compress-relocations  Shrink relocated indices and addresses in code\n"
+      "  --gc-sections         Remove unused functions and data\n"
+      "  -mtail-call           Use return_call for calls in tail position\n"
+      "  -j <n>                Compile sources on n processes (Default: 1)\n"
+      "  -pthread              Enable threads: shared memory and wasi-threads\n"
+      "  --max-memory=<size>   Maximum memory size in bytes (Default with -pthread: 256MiB)\n"
   );
 }
 
@@ -99,7 +108,10 @@ static void compile1(FILE *ifp, const char *filename, Vector *decls) {
   parse(decls);
 }
 
-static void preprocess_and_compile(FILE *ppout, const char *filename, Vector *toplevel) {
+// Preprocessed output is kept in memory (`open_memstream`), and read by the lexer
+// without going through the filesystem.
+static void preprocess_and_compile(FILE *ppout, char **ppbuf, size_t *ppsize,
+                                   const char *filename, Vector *toplevel) {
   // Preprocess.
   FILE *ifp;
   if (filename != NULL) {
@@ -110,28 +122,37 @@ static void preprocess_and_compile(FILE *ppout, const char *filename, Vector *to
     filename = "*stdin*";
   }
   fprintf(ppout, "# 1 \"%s\" 1\n", filename);
+  report_phase_begin("preprocess");
   preprocess(ifp, filename);
+  report_phase_end();
   if (ifp != stdin)
     fclose(ifp);
-  if (fseek(ppout, 0, SEEK_SET) != 0) {
-    error("fseek failed");
-  }
+  fclose(ppout);  // Fixes `*ppbuf` and `*ppsize`.
+
+  FILE *ppin = fmemopen(*ppbuf, *ppsize, "r");
+  if (ppin == NULL)
+    error("fmemopen failed");
 
   // Set lexer for compiler.
   init_lexer();
 
   // Compile.
-  FILE *ppin = ppout;
+  report_phase_begin("parse");
   compile1(ppin, "*", toplevel);
+  report_phase_end();
+  fclose(ppin);
+  free(*ppbuf);
+  *ppbuf = NULL;
   if (compile_error_count != 0)
     exit(1);
 }
 
-int compile_csource(const char *src, enum OutType out_type, const char *ofn, Vector *ld_cmd,
-                    const char *import_module_name) {
-  FILE *ppout = tmpfile();
+int compile_csource(const char *src, const char *ofn, const char *import_module_name) {
+  char *ppbuf = NULL;
+  size_t ppsize = 0;
+  FILE *ppout = open_memstream(&ppbuf, &ppsize);
   if (ppout == NULL)
-    error("cannot open temporary file");
+    error("open_memstream failed");
 
   init_preprocessor(ppout);
   define_macro("__ILP32__");
@@ -151,56 +172,105 @@ int compile_csource(const char *src, enum OutType out_type, const char *ofn, Vec
   define_macro("__SIZEOF_LONG__=4");
   define_macro("__SIZEOF_LONG_LONG__=8");
   define_macro("__SIZEOF_SIZE_T__=4");
+  // Memory orders for `__atomic_*` builtins.
+  define_macro("__ATOMIC_RELAXED=0");
+  define_macro("__ATOMIC_CONSUME=1");
+  define_macro("__ATOMIC_ACQUIRE=2");
+  define_macro("__ATOMIC_RELEASE=3");
+  define_macro("__ATOMIC_ACQ_REL=4");
+  define_macro("__ATOMIC_SEQ_CST=5");
 
   init_compiler();
 
   Vector *toplevel = new_vector();
 
-  preprocess_and_compile(ppout, src, toplevel);
-
-  fclose(ppout);
+  preprocess_and_compile(ppout, &ppbuf, &ppsize, src, toplevel);
 
+  report_phase_begin("traverse");
   traverse_ast(toplevel);
+  report_phase_end();
   if (compile_error_count != 0)
     return 1;
 
+  report_phase_begin("gen");
   gen(toplevel);
+  report_phase_end();
 
   if (compile_error_count != 0)
     return 1;
   if (error_warning && compile_warning_count != 0)
     return 2;
 
-  FILE *ofp;
-  const char *outfn = NULL;
-  if (out_type >= OutExecutable) {
-    char template[] = "/tmp/xcc-XXXXXX.o";
-    int obj_fd = mkstemps(template, 2);
-    if (obj_fd == -1) {
-      perror("Failed to open output file");
-      exit(1);
-    }
-    char *tmpfn = strdup(template);
-    ofp = fdopen(obj_fd, "wb");
-    outfn = tmpfn;
-    vec_push(&remove_on_exit, tmpfn);
-  } else {
-    outfn = ofn;
-    if (outfn == NULL) {
-      // char *src = sources->data[0];  // TODO:
-      outfn = src != NULL ? change_ext(basename((char*)src), "o") : "a.o";
-    }
-    ofp = fopen(outfn, "wb");
-  }
+  FILE *ofp = fopen(ofn, "wb");
   if (ofp == NULL) {
     error("Cannot open output file");
   } else {
+    report_phase_begin("emit_code");
     emit_wasm(ofp, import_module_name);
+    report_phase_end();
     assert(compile_error_count == 0);
     fclose(ofp);
   }
+  return 0;
+}
+
+static const char *new_tmp_obj_file(void) {
+  char template[] = "/tmp/xcc-XXXXXX.o";
+  int obj_fd = mkstemps(template, 2);
+  if (obj_fd == -1) {
+    perror("Failed to open output file");
+    exit(1);
+  }
+  close(obj_fd);
+  char *tmpfn = strdup(template);
+  vec_push(&remove_on_exit, tmpfn);
+  return tmpfn;
+}
 
-  vec_push(ld_cmd, outfn);
+#if !defined(__WASM)
+// Compiler keeps its states in globals: Compile each source in a forked
+// process instead, which starts from the same fresh state.
+static int compile_on_processes(Vector *srcs, Vector *outfns, const char *import_module_name,
+                                int jobs) {
+  int running = 0, failed = 0;
+  fflush(NULL);
+  for (int i = 0; running > 0 || (i < srcs->len && failed == 0);) {
+    if (i < srcs->len && failed == 0 && running < jobs) {
+      pid_t pid = fork();
+      if (pid < 0)
+        error("fork failed");
+      if (pid == 0) {
+        remove_on_exit.len = 0;  // Owned by the parent.
+        exit(compile_csource(srcs->data[i], outfns->data[i], import_module_name));
+      }
+      ++i;
+      ++running;
+      continue;
+    }
+
+    int status;
+    if (wait(&status) < 0)
+      error("wait failed");
+    --running;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      ++failed;
+  }
+  return failed > 0 ? 1 : 0;
+}
+#endif
+
+static int compile_sources(Vector *srcs, Vector *outfns, const char *import_module_name,
+                           int jobs) {
+#if !defined(__WASM)
+  if (jobs > 1 && srcs->len > 1)
+    return compile_on_processes(srcs, outfns, import_module_name, jobs);
+#else
+  UNUSED(jobs);
+#endif
+  for (int i = 0; i < srcs->len; ++i) {
+    if (compile_csource(srcs->data[i], outfns->data[i], import_module_name) != 0)
+      return 1;
+  }
   return 0;
 }
 
@@ -223,7 +293,12 @@ typedef struct {
   enum OutType out_type;
   enum SourceType src_type;
   uint32_t stack_size;
+  int jobs;
   bool nodefaultlibs, nostdlib, nostdinc;
+  bool compress_relocations;
+  bool gc_sections;
+  bool pthread;
+  uint32_t max_memory_pages;
 } Options;
 
 static void parse_options(int argc, char *argv[], Options *opts) {
@@ -234,6 +309,10 @@ static void parse_options(int argc, char *argv[], Options *opts) {
     OPT_VERBOSE,
     OPT_ENTRY_POINT,
     OPT_STACK_SIZE,
+    OPT_COMPRESS_RELOCATIONS,
+    OPT_GC_SECTIONS,
+    OPT_PTHREAD,
+    OPT_MAX_MEMORY,
     OPT_IMPORT_MODULE_NAME,
     OPT_NODEFAULTLIBS,
     OPT_NOSTDLIB,
@@ -261,6 +340,9 @@ static void parse_options(int argc, char *argv[], Options *opts) {
     {"x", required_argument},  // Specify code type
     {"e", required_argument},  // Export names
     {"W", required_argument, OPT_WARNING},
+    {"f", required_argument},  // -ftime-report, -fmem-report
+    {"m", required_argument},  // -mtail-call
+    {"j", required_argument},  // Number of processes to compile sources
     {"nodefaultlibs", no_argument, OPT_NODEFAULTLIBS},
     {"nostdlib", no_argument, OPT_NOSTDLIB},
     {"nostdinc", no_argument, OPT_NOSTDINC},
@@ -268,6 +350,10 @@ static void parse_options(int argc, char *argv[], Options *opts) {
     {"-verbose", no_argument, OPT_VERBOSE},
     {"-entry-point", required_argument, OPT_ENTRY_POINT},
     {"-stack-size", required_argument, OPT_STACK_SIZE},
+    {"-compress-relocations", no_argument, OPT_COMPRESS_RELOCATIONS},
+    {"-gc-sections", no_argument, OPT_GC_SECTIONS},
+    {"pthread", no_argument, OPT_PTHREAD},
+    {"-max-memory", required_argument, OPT_MAX_MEMORY},
     {"-help", no_argument, OPT_HELP},
     {"-version", no_argument, OPT_VERSION},
     {"dumpversion", no_argument, OPT_DUMP_VERSION},
@@ -369,6 +455,27 @@ static void parse_options(int argc, char *argv[], Options *opts) {
         // fprintf(stderr, "Warning: unknown option for -W: %s\n", optarg);
       }
       break;
+    case 'f':
+      parse_report_option(optarg);  // Others are silently ignored.
+      break;
+    case 'm':
+      if (strcmp(optarg, "tail-call") == 0 || strcmp(optarg, "no-tail-call") == 0) {
+        tail_call = *optarg != 'n';
+      } else {
+        fprintf(stderr, "Warning: unknown option: %s\n", argv[optind - 1]);
+      }
+      break;
+    case 'j':
+      {
+        char *end;
+        long n = strtol(optarg, &end, 10);
+        if (*end != '\0' || n < 1) {
+          fprintf(stderr, "Illegal job count: %s\n", optarg);
+          exit(1);
+        }
+        opts->jobs = n;
+      }
+      break;
     case OPT_NODEFAULTLIBS:
       opts->nodefaultlibs = true;
       break;
@@ -387,6 +494,25 @@ static void parse_options(int argc, char *argv[], Options *opts) {
         opts->stack_size = size;
       }
       break;
+    case OPT_COMPRESS_RELOCATIONS:
+      opts->compress_relocations = true;
+      break;
+    case OPT_GC_SECTIONS:
+      opts->gc_sections = true;
+      break;
+    case OPT_PTHREAD:
+      opts->pthread = true;
+      break;
+    case OPT_MAX_MEMORY:
+      {
+        unsigned long long size = strtoull(optarg, NULL, 0);
+        unsigned long long pages = (size + MEMORY_PAGE_SIZE - 1) / MEMORY_PAGE_SIZE;
+        if (pages <= 0 || pages > MAX_MEMORY_PAGES) {
+          error("max-memory must be in (0, 4GiB]");
+        }
+        opts->max_memory_pages = pages;
+      }
+      break;
     case OPT_IMPORT_MODULE_NAME:
       opts->import_module_name = optarg;
       break;
@@ -464,7 +590,17 @@ static int do_link(Vector *obj_files, Options *opts) {
   WasmLinker linker_body;
   WasmLinker *linker = &linker_body;
   linker_init(linker);
+  linker->compress_relocations = opts->compress_relocations;
+  linker->gc_sections = opts->gc_sections;
+  if (opts->pthread) {
+    linker->shared_memory = true;
+    linker->max_memory_pages = opts->max_memory_pages > 0 ? opts->max_memory_pages
+                                                          : DEFAULT_PTHREAD_MAX_MEMORY_PAGES;
+  } else {
+    linker->max_memory_pages = opts->max_memory_pages;
+  }
 
+  report_phase_begin("link");
   for (int i = 0; i < obj_files->len; ++i) {
     const char *objfn = obj_files->data[i];
     if (!read_wasm_obj(linker, objfn)) {
@@ -473,15 +609,17 @@ static int do_link(Vector *obj_files, Options *opts) {
     }
   }
 
-  if (!link_wasm_objs(linker, opts->exports, opts->stack_size) ||
-      !linker_emit_wasm(linker, outfn, opts->exports))
-    return 2;
-  return 0;
+  bool result = link_wasm_objs(linker, opts->exports, opts->stack_size) &&
+                linker_emit_wasm(linker, outfn, opts->exports);
+  report_phase_end();
+  return result ? 0 : 2;
 #endif
 }
 
 static int do_compile(Options *opts) {
   Vector *obj_files = new_vector();
+  Vector *csrcs = new_vector();
+  Vector *couts = new_vector();
 
   int error_count = 0;
   for (int i = 0; i < opts->sources->len; ++i) {
@@ -511,6 +649,8 @@ static int do_compile(Options *opts) {
         if (opts->out_type == OutObject)
           outfn = change_ext(basename(src), "o");
       }
+    } else if (outfn == NULL) {
+      outfn = "a.o";
     }
 
     enum SourceType st = opts->src_type;
@@ -526,11 +666,12 @@ static int do_compile(Options *opts) {
       fprintf(stderr, "Unknown source type: %s\n", src);
       return 1;  // exit
     case Clanguage:
-      {
-        int res = compile_csource(src, opts->out_type, outfn, obj_files, opts->import_module_name);
-        if (res != 0)
-          return 1;  // exit
-      }
+      // Compiled later, but keep the order of objects.
+      if (opts->out_type >= OutExecutable)
+        outfn = new_tmp_obj_file();
+      vec_push(csrcs, src);
+      vec_push(couts, (void*)outfn);
+      vec_push(obj_files, (void*)outfn);
       break;
     case ObjectFile:
     case ArchiveFile:
@@ -542,6 +683,9 @@ static int do_compile(Options *opts) {
   if (error_count > 0)
     return 1;
 
+  if (compile_sources(csrcs, couts, opts->import_module_name, opts->jobs) != 0)
+    return 1;
+
   if (opts->out_type < OutExecutable)
     return 0;
   return do_link(obj_files, opts);
@@ -569,9 +713,14 @@ int main(int argc, char *argv[]) {
     .out_type = OutExecutable,
     .src_type = UnknownSource,
     .stack_size = DEFAULT_STACK_SIZE,
+    .jobs = 1,
     .nodefaultlibs = false,
     .nostdlib = false,
     .nostdinc = false,
+    .compress_relocations = false,
+    .gc_sections = false,
+    .pthread = false,
+    .max_memory_pages = 0,
   };
   parse_options(argc, argv, &opts);
 
@@ -590,6 +739,10 @@ int main(int argc, char *argv[]) {
   }
   if (opts.entry_point != NULL && *opts.entry_point != '\0')
     vec_push(opts.exports, alloc_name(opts.entry_point, NULL, false));
+  if (opts.pthread && opts.out_type >= OutExecutable) {
+    // Called from the host on a new instance, for `pthread_create`.
+    vec_push(opts.exports, alloc_name("wasi_thread_start", NULL, false));
+  }
   if (opts.exports->len == 0 && opts.out_type >= OutExecutable) {
     error("no exports (require -e<xxx>)\n");
   }
@@ -607,5 +760,7 @@ int main(int argc, char *argv[]) {
 
   atexit(remove_tmp_files);
 
-  return do_compile(&opts);
+  int result = do_compile(&opts);
+  dump_report("wcc");
+  return result;
 }
@@ -18,6 +18,7 @@ typedef struct VarInfo VarInfo;
 typedef struct Vector Vector;
 
 #define DEFAULT_STACK_SIZE  (8 * 1024)
+#define DEFAULT_PTHREAD_MAX_MEMORY_PAGES  (4096)  // 256MiB: Shared memory requires maximum.
 
 #define I32_SIZE  (4)  //sizeof(int32_t)
 
@@ -83,6 +84,8 @@ inline int get_func_type_index(const Type *type)  { return getsert_func_type_ind
 void modify_ast_for_setjmp(int n);
 
 // gen_wasm
+extern bool tail_call;  // -mtail-call
+
 void gen(Vector *decls);
 void gen_expr(Expr *expr, bool needval);
 void gen_expr_stmt(Expr *expr);
@@ -100,6 +103,12 @@ void add_code(const unsigned char* buf, size_t size);
 
 void install_builtins(void);
 
+// peephole
+void peephole_optimize(DataStorage *code, Vector *reloc_code);
+
+// coalesce_locals
+void coalesce_locals(DataStorage *code, uint32_t param_count, Vector *reloc_code);
+
 // emit_wasm
 typedef struct {
   FILE *ofp;
@@ -127,6 +136,7 @@ enum OutType {
 
 extern const char SP_NAME[];
 extern const char BREAK_ADDRESS_NAME[];
+extern const char TLS_BASE_NAME[];
 
 extern bool verbose;
 extern Table func_info_table;
@@ -144,6 +154,19 @@ int getsert_func_type(unsigned char *buf, size_t size, bool reg);
 TagInfo *getsert_tag(const Name *name, int typeindex);
 
 void write_wasm_header(FILE *ofp);
+bool skip_simd_immediates(uint32_t op, unsigned char **pp);
+bool skip_atomic_immediates(uint32_t op, unsigned char **pp);
+
+typedef struct {
+  int64_t value;       // Label, block type, index (local, global, function, type, tag), or constant.
+  unsigned char *imm;  // Immediates, just after the opcode.
+  unsigned char op;
+} WasmInst;
+
+uint32_t read_uleb(unsigned char **pp, unsigned char *end);
+int64_t read_sleb(unsigned char **pp, unsigned char *end);
+bool decode_inst(unsigned char **pp, unsigned char *end, WasmInst *inst);
+void sort_relocs(Vector *reloc_code);  // <RelocInfo*> by offset
 
 typedef struct FuncExtra {
   Vector *funcall_results;  // [0]=Expr*, [1]=VarInfo*
@@ -1,7 +1,7 @@
 #include "wcc.h"
 
 #include <assert.h>
-#include <stdlib.h>  // realloc, free
+#include <stdlib.h>  // realloc, free, qsort
 #include <string.h>
 
 #include "ast.h"
@@ -10,9 +10,11 @@
 #include "util.h"
 #include "var.h"
 #include "wasm.h"
+#include "wasm_obj.h"
 
 const char SP_NAME[] = "__stack_pointer";  // Variable name for stack pointer (global).
 const char BREAK_ADDRESS_NAME[] = "__curbrk";
+const char TLS_BASE_NAME[] = "__tls_base";  // Thread local: pointer to the running thread.
 
 bool verbose;
 Table func_info_table;
@@ -97,6 +99,168 @@ Expr *get_sp_var(void) {
   return new_expr_variable(spname, info->varinfo->type, NULL, global_scope);
 }
 
+uint32_t read_uleb(unsigned char **pp, unsigned char *end) {
+  unsigned char *p = *pp;
+  uint32_t result = 0;
+  for (int shift = 0; p < end; shift += 7) {
+    unsigned char c = *p++;
+    if (shift < 32)
+      result |= (uint32_t)(c & 0x7f) << shift;
+    if (!(c & 0x80))
+      break;
+  }
+  *pp = p;
+  return result;
+}
+
+int64_t read_sleb(unsigned char **pp, unsigned char *end) {
+  unsigned char *p = *pp;
+  uint64_t result = 0;
+  int shift = 0;
+  unsigned char c = 0;
+  while (p < end) {
+    c = *p++;
+    if (shift < 64)
+      result |= (uint64_t)(c & 0x7f) << shift;
+    shift += 7;
+    if (!(c & 0x80))
+      break;
+  }
+  if (shift < 64 && (c & 0x40))
+    result |= ~(uint64_t)0 << shift;
+  *pp = p;
+  return result;
+}
+
+// Decode an instruction at `*pp` and advance over it, for the passes on generated code.
+// Returns false for unknown instruction (inline asm), or truncated one.
+bool decode_inst(unsigned char **pp, unsigned char *end, WasmInst *inst) {
+  unsigned char *p = *pp;
+  unsigned char op = *p++;
+  int64_t value = 0;
+  inst->op = op;
+  inst->imm = p;
+  bool ok = true;
+  switch (op) {
+  case OP_UNREACHABLE: case OP_NOP: case OP_RETURN: case OP_DROP: case OP_SELECT:
+  case OP_ELSE: case OP_CATCH_ALL: case OP_END:
+    break;
+  case OP_BLOCK: case OP_LOOP: case OP_IF: case OP_TRY:
+    value = read_sleb(&p, end);  // Block type.
+    break;
+  case OP_BR: case OP_BR_IF:  // Label.
+  case OP_CATCH: case OP_THROW: case OP_RETHROW:  // Tag, or label.
+  case OP_CALL: case OP_RETURN_CALL:
+  case OP_LOCAL_GET: case OP_LOCAL_SET: case OP_LOCAL_TEE: case OP_GLOBAL_GET: case OP_GLOBAL_SET:
+    value = read_uleb(&p, end);
+    break;
+  case OP_BR_TABLE:
+    value = read_uleb(&p, end);  // Label count, except the default one.
+    for (int64_t count = value + 1; count > 0 && p < end; --count)
+      read_uleb(&p, end);
+    break;
+  case OP_CALL_INDIRECT: case OP_RETURN_CALL_INDIRECT:
+    value = read_uleb(&p, end);  // Type index.
+    read_uleb(&p, end);  // Table index.
+    break;
+  case OP_MEMORY_SIZE: case OP_MEMORY_GROW:
+    ++p;  // Memory index.
+    break;
+  case OP_I32_CONST: case OP_I64_CONST:
+    value = read_sleb(&p, end);
+    break;
+  case OP_F32_CONST:
+    p += 4;
+    break;
+  case OP_F64_CONST:
+    p += 8;
+    break;
+  case OP_EXTENSION:
+    switch (read_uleb(&p, end)) {
+    case 0: case 1: case 2: case 3: case 4: case 5: case 6: case 7:  // trunc_sat
+      break;
+    case OPEX_MEMORY_COPY:
+      p += 2;
+      break;
+    case OPEX_MEMORY_FILL:
+      p += 1;
+      break;
+    default:
+      ok = false;
+      break;
+    }
+    break;
+  case OP_SIMD:
+    ok = skip_simd_immediates(read_uleb(&p, end), &p);
+    break;
+  case OP_ATOMIC:
+    ok = skip_atomic_immediates(read_uleb(&p, end), &p);
+    break;
+  default:
+    if (op >= OP_I32_LOAD && op <= 0x3e) {  // Load, store: memarg.
+      read_uleb(&p, end);
+      read_uleb(&p, end);
+    } else if (!(op >= OP_I32_EQZ && op <= 0xc4)) {  // Numeric instructions without immediate.
+      ok = false;
+    }
+    break;
+  }
+  if (!ok || p > end)
+    return false;
+  inst->value = value;
+  *pp = p;
+  return true;
+}
+
+static int compare_reloc_offset(const void *pa, const void *pb) {
+  const RelocInfo *a = *(const RelocInfo**)pa;
+  const RelocInfo *b = *(const RelocInfo**)pb;
+  return a->offset < b->offset ? -1 : a->offset > b->offset ? 1 : 0;
+}
+
+void sort_relocs(Vector *reloc_code) {
+  if (reloc_code->len > 1)
+    qsort(reloc_code->data, reloc_code->len, sizeof(*reloc_code->data), compare_reloc_offset);
+}
+
+// Skip immediates of SIMD instruction `op` (after the prefix), returns false for unknown one.
+bool skip_simd_immediates(uint32_t op, unsigned char **pp) {
+  unsigned char *p = *pp;
+  if (op <= 0x0b || op == 0x5c || op == 0x5d || (op >= 0x54 && op <= 0x5b)) {  // memarg
+    for (int i = 0; i < 2; ++i) {
+      while (*p++ & 0x80)
+        ;
+    }
+    if (op >= 0x54 && op <= 0x5b)  // load_lane, store_lane
+      ++p;
+  } else if (op == OPSIMD_V128_CONST || op == OPSIMD_I8X16_SHUFFLE) {
+    p += 16;
+  } else if (op >= 0x15 && op <= 0x22) {  // extract_lane, replace_lane
+    ++p;
+  } else if (op > 0xff) {
+    return false;
+  }
+  *pp = p;
+  return true;
+}
+
+// Skip immediates of atomic instruction `op` (after the prefix), returns false for unknown one.
+bool skip_atomic_immediates(uint32_t op, unsigned char **pp) {
+  unsigned char *p = *pp;
+  if (op == OPATOMIC_FENCE) {
+    ++p;
+  } else if (op <= OPATOMIC_WAIT64 || (op >= OPATOMIC_LOAD && op <= 0x4e)) {  // memarg
+    for (int i = 0; i < 2; ++i) {
+      while (*p++ & 0x80)
+        ;
+    }
+  } else {
+    return false;
+  }
+  *pp = p;
+  return true;
+}
+
 unsigned char to_wtype(const Type *type) {
   switch (type->kind) {
   case TY_FIXNUM: return type_size(type) <= I32_SIZE ? WT_I32 : WT_I64;
@@ -119,9 +283,10 @@ bool is_global_datsec_var(const VarInfo *varinfo, Scope *scope) {
   if (is_prim_type(varinfo->type) && !(varinfo->storage & VS_REF_TAKEN))
     return false;
 #else
-  // Special: Stack pointer and break address.
+  // Special: Stack pointer, break address and thread local base.
   if (equal_name(varinfo->name, alloc_name(SP_NAME, NULL, false)) ||
-      equal_name(varinfo->name, alloc_name(BREAK_ADDRESS_NAME, NULL, false)))
+      equal_name(varinfo->name, alloc_name(BREAK_ADDRESS_NAME, NULL, false)) ||
+      equal_name(varinfo->name, alloc_name(TLS_BASE_NAME, NULL, false)))
     return false;
 #endif
   return true;
@@ -439,6 +439,25 @@ static void parse_options(int argc, char *argv[], Options *opts) {
           fprintf(stderr, "extra argument required for '-fuse-ld");
         }
         opts->use_ld = true;
+      } else if (strncmp(optarg, "profile-", 8) == 0 || strcmp(optarg, "vectorize") == 0 ||
+                 strcmp(optarg, "no-vectorize") == 0 || strcmp(optarg, "function-sections") == 0 ||
+                 strcmp(optarg, "data-sections") == 0) {
+        vec_push(opts->cc1_cmd, "-f");
+        vec_push(opts->cc1_cmd, optarg);
+      } else if (strcmp(optarg, "time-report") == 0 || strcmp(optarg, "mem-report") == 0) {
+        // Each tool reports its own phases.
+        vec_push(opts->cpp_cmd, "-f");
+        vec_push(opts->cpp_cmd, optarg);
+        vec_push(opts->cc1_cmd, "-f");
+        vec_push(opts->cc1_cmd, optarg);
+#if !defined(USE_SYS_AS)
+        vec_push(opts->as_cmd, "-f");
+        vec_push(opts->as_cmd, optarg);
+#endif
+#if !defined(USE_SYS_LD)
+        vec_push(opts->ld_cmd, "-f");
+        vec_push(opts->ld_cmd, optarg);
+#endif
       } else {
         vec_push(opts->linker_options, argv[optind - 1]);
       }
@@ -480,6 +499,8 @@ static void parse_options(int argc, char *argv[], Options *opts) {
       break;
 
     case 'O':
+      vec_push(opts->cc1_cmd, argv[optind - 1]);
+      // Fallthrough
     case 'g':
     case OPT_ANSI:
     case OPT_STD:
@@ -0,0 +1,121 @@
+#!/bin/bash
+# Branch relaxation of the assembler: Check encoded displacements directly,
+# because a stale one might still land on a harmless instruction.
+
+source ./test_sub.sh
+
+AS=${AS:-../as}
+AOBJ=${AOBJ:-$(basename "$(mktemp -u)").o}
+
+read_le() {  # offset size
+  od -An -t u"$2" -j "$1" -N "$2" "$AOBJ" | tr -d ' '
+}
+
+read_hex16() {  # offset
+  od -An -t x2 -j "$1" -N 2 "$AOBJ" | tr -d ' '
+}
+
+# Offset of the first executable PROGBITS section (.text) in ELF64.
+text_offset() {
+  local shoff shentsize shnum
+  shoff=$(read_le 40 8)
+  shentsize=$(read_le 58 2)
+  shnum=$(read_le 60 2)
+  for ((i = 0; i < shnum; ++i)); do
+    local sh=$((shoff + i * shentsize))
+    if [[ $(read_le $((sh + 4)) 4) -eq 1 ]] && (( $(read_le $((sh + 8)) 8) & 4 )); then
+      read_le $((sh + 24)) 8
+      return
+    fi
+  done
+  echo -1
+}
+
+try_halfword() {
+  local title="$1"
+  local expected="$2"  # Halfword at the top of .text, in hex
+  local input="$3"
+
+  begin_test "$title"
+
+  echo "$input" | $AS -o "$AOBJ" || {
+    end_test 'Assemble failed'
+    return
+  }
+
+  local offset
+  offset=$(text_offset)
+  local actual
+  actual=$(read_hex16 "$offset")
+  local err=''
+  [[ "$actual" == "$expected" ]] || err="${expected} expected, but ${actual}"
+  end_test "$err"
+}
+
+test_riscv64() {
+  begin_test_suite "Relax riscv64"
+
+  # Forward `c.j` across branches whose sizes are settled by relaxation:
+  # Its displacement must be taken from the final layout (0x80).
+  try_halfword 'c.j over relaxed branches' 'a041' "
+top:
+  j forward
+  la a0, flag
+  lw a0, (a0)
+  beq a0, zero, bottom
+  ld a0, (s4)
+  mv a3, a0
+  ld a0, (s3)
+  mv a2, a0
+  la a0, msg1
+  mv a1, a0
+  la a0, out
+  ld a0, (a0)
+  addi a0, a0, 24
+  ld a0, (a0)
+  call fprintf
+  j bottom
+  li a0, 61
+  bne s7, a0, next
+next:
+  la a0, flag
+  lw a0, (a0)
+  beq a0, zero, bottom
+  ld a0, (s4)
+  mv a3, a0
+  ld a0, (s3)
+  mv a2, a0
+  la a0, msg2
+  mv a1, a0
+  la a0, out
+  ld a0, (a0)
+  addi a0, a0, 24
+  ld a0, (a0)
+  call fprintf
+  j bottom
+forward:
+  addi a0, s4, 16
+  mv s4, a0
+  ld a0, (s4)
+  bne a0, zero, top
+bottom:
+  ret
+"
+
+  end_test_suite
+}
+
+# Skip unless the assembler targets riscv64 (e_machine = EM_RISCV).
+echo '' | $AS -o "$AOBJ" > /dev/null 2>&1 && [[ $(read_le 18 2) -eq 243 ]] || {
+  rm -f "$AOBJ"
+  echo '  Relax riscv64: skip'
+  exit 0
+}
+
+test_riscv64
+
+rm -f "$AOBJ"
+
+if [[ $FAILED_SUITE_COUNT -ne 0 ]]; then
+  exit "$FAILED_SUITE_COUNT"
+fi
@@ -25,6 +25,36 @@ double mix_many_params(int n, int i1, double d1, int i2, double d2, int i3, doub
 
 #include "flotest.inc"
 
+void axpy(Number *y, const Number *x, Number a, int n) {
+  for (int i = 0; i < n; ++i)
+    y[i] += a * x[i];
+}
+
+void div_elems(Number *dst, const Number *x, const Number *y, int n) {
+  for (int i = 0; i < n; i++)
+    dst[i] = (x[i] - y[i]) / 2;
+}
+
+TEST(loop) {
+  begin_test_suite("loop");
+
+  Number x[23], y[23], z[23];
+  for (int i = 0; i < 23; ++i) {
+    x[i] = i;
+    y[i] = 1;
+  }
+  axpy(y, x, 2, 23);
+  EXPECT_NEAR(45, y[22]);
+  EXPECT_NEAR(3, y[1]);
+
+  div_elems(z, y, x, 23);
+  EXPECT_NEAR(11.5, z[22]);
+  EXPECT_NEAR(0.5, z[0]);
+
+  axpy(&y[1], y, 1, 22);  // Overlapped
+  EXPECT_NEAR(1 + 3 + 5 + 7, y[3]);
+} END_TEST()
+
 TEST(mix) {
 #ifndef USE_SINGLE
   begin_test_suite("mix");
@@ -52,6 +82,7 @@ int main(void) {
   return RUN_ALL_TESTS(
     test_number,
     test_nan,
+    test_loop,
     test_mix,
   );
 }
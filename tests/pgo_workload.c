@@ -0,0 +1,32 @@
+// Workload for profile guided optimization test.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int classify(int x) {
+  if (x % 97 == 0)
+    return -1;  // Rare path.
+  if (x & 1)
+    return 1;
+  return 2;
+}
+
+static double min(double a, double b) {
+  return a < b ? a : b;
+}
+
+int main(int argc, char *argv[]) {
+  int n = argc > 1 ? atoi(argv[1]) : 10000;
+  long sum = 0;
+  double d = 1e9;
+  for (int i = 0; i < n; ++i) {
+    switch (classify(i)) {
+    case -1:  sum -= i; break;
+    case 1:   sum += 3; break;
+    default:  sum += 1; break;
+    }
+    d = min(d, n - i);
+  }
+  printf("%ld %g\n", sum, d);
+  return 0;
+}
@@ -0,0 +1,183 @@
+#include <wasm_simd128.h>
+
+#include "./xtest.h"
+
+static v128_t add3(v128_t a, v128_t b, v128_t c) {
+  return wasm_i32x4_add(wasm_i32x4_add(a, b), c);
+}
+
+static void add_bytes(uint8_t *dst, const uint8_t *src, int n) {
+  int i = 0;
+  for (; i + 16 <= n; i += 16)
+    wasm_v128_store(&dst[i], wasm_u8x16_add_sat(wasm_v128_load(&dst[i]), wasm_v128_load(&src[i])));
+  for (; i < n; ++i) {
+    int x = dst[i] + src[i];
+    dst[i] = x < 255 ? x : 255;
+  }
+}
+
+TEST(make) {
+  v128_t a = wasm_i32x4_make(1, 2, 3, 4);
+  EXPECT_EQ(1, wasm_i32x4_extract_lane(a, 0));
+  EXPECT_EQ(4, wasm_i32x4_extract_lane(a, 3));
+  EXPECT_EQ(2, a.__v[1]);
+
+  int x = 10;
+  v128_t b = wasm_i32x4_make(x, x + 1, x + 2, x + 3);
+  EXPECT_EQ(13, wasm_i32x4_extract_lane(b, 3));
+
+  v128_t c = wasm_i8x16_make(-1, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  EXPECT_EQ(-1, wasm_i8x16_extract_lane(c, 0));
+  EXPECT_EQ(255, wasm_u8x16_extract_lane(c, 0));
+  EXPECT_EQ(15, wasm_i8x16_extract_lane(c, 15));
+
+  v128_t d = wasm_i64x2_make(-2, 0x123456789LL);
+  EXPECT_EQ(-2, wasm_i64x2_extract_lane(d, 0));
+  EXPECT_EQ(0x123456789LL, wasm_i64x2_extract_lane(d, 1));
+
+  v128_t e = wasm_u16x8_splat(0xffff);
+  EXPECT_EQ(0xffff, wasm_u16x8_extract_lane(e, 7));
+  EXPECT_EQ(-1, wasm_i16x8_extract_lane(e, 7));
+
+  v128_t f = wasm_i32x4_replace_lane(a, 2, 99);
+  EXPECT_EQ(99, wasm_i32x4_extract_lane(f, 2));
+  EXPECT_EQ(3, wasm_i32x4_extract_lane(a, 2));
+} END_TEST()
+
+TEST(arith) {
+  v128_t a = wasm_i32x4_make(1, 2, 3, 4);
+  v128_t b = wasm_i32x4_splat(10);
+  v128_t c = add3(a, b, wasm_i32x4_mul(a, a));
+  EXPECT_EQ(12, wasm_i32x4_extract_lane(c, 0));
+  EXPECT_EQ(30, wasm_i32x4_extract_lane(c, 3));
+
+  c = wasm_i32x4_sub(c, a);
+  EXPECT_EQ(26, wasm_i32x4_extract_lane(c, 3));
+  EXPECT_EQ(-4, wasm_i32x4_extract_lane(wasm_i32x4_neg(a), 3));
+  EXPECT_EQ(8, wasm_i32x4_extract_lane(wasm_i32x4_shl(a, 2), 1));
+  EXPECT_EQ(-1, wasm_i32x4_extract_lane(wasm_i32x4_shr(wasm_i32x4_splat(-4), 2), 0));
+  EXPECT_EQ(0x3fffffff, wasm_u32x4_extract_lane(wasm_u32x4_shr(wasm_i32x4_splat(-4), 2), 0));
+  EXPECT_EQ(4, wasm_i32x4_extract_lane(wasm_i32x4_max(a, wasm_i32x4_splat(-5)), 3));
+  EXPECT_EQ(-5, wasm_i32x4_extract_lane(wasm_i32x4_min(a, wasm_i32x4_splat(-5)), 3));
+  EXPECT_EQ(4, wasm_u32x4_extract_lane(wasm_u32x4_min(a, wasm_i32x4_splat(-5)), 3));
+
+  v128_t s = wasm_u8x16_add_sat(wasm_u8x16_splat(200), wasm_u8x16_splat(100));
+  EXPECT_EQ(255, wasm_u8x16_extract_lane(s, 5));
+  v128_t t = wasm_i16x8_mul(wasm_i16x8_splat(300), wasm_i16x8_splat(3));
+  EXPECT_EQ(900, wasm_i16x8_extract_lane(t, 2));
+
+  v128_t w = wasm_i16x8_extend_low_i8x16(wasm_i8x16_splat(-3));
+  EXPECT_EQ(-3, wasm_i16x8_extract_lane(w, 0));
+  v128_t n = wasm_u8x16_narrow_i16x8(wasm_i16x8_splat(300), wasm_i16x8_splat(-1));
+  EXPECT_EQ(255, wasm_u8x16_extract_lane(n, 0));
+  EXPECT_EQ(0, wasm_u8x16_extract_lane(n, 8));
+} END_TEST()
+
+TEST(compare) {
+  v128_t a = wasm_i32x4_make(1, 5, 3, 7);
+  v128_t b = wasm_i32x4_splat(4);
+  v128_t gt = wasm_i32x4_gt(a, b);
+  EXPECT_EQ(0, wasm_i32x4_extract_lane(gt, 0));
+  EXPECT_EQ(-1, wasm_i32x4_extract_lane(gt, 1));
+  EXPECT_EQ(0xa, wasm_i32x4_bitmask(gt));
+  EXPECT_TRUE(wasm_v128_any_true(gt));
+  EXPECT_FALSE(wasm_i32x4_all_true(gt));
+  EXPECT_TRUE(wasm_i32x4_all_true(wasm_i32x4_ne(a, b)));
+
+  v128_t sel = wasm_v128_bitselect(a, b, gt);
+  EXPECT_EQ(4, wasm_i32x4_extract_lane(sel, 0));
+  EXPECT_EQ(5, wasm_i32x4_extract_lane(sel, 1));
+  v128_t m = wasm_v128_andnot(a, wasm_i32x4_splat(1));
+  EXPECT_EQ(6, wasm_i32x4_extract_lane(m, 3));
+  EXPECT_EQ(-8, wasm_i32x4_extract_lane(wasm_v128_not(a), 3));
+  if (wasm_i32x4_extract_lane(wasm_v128_xor(a, a), 2) == 0)
+    EXPECT_EQ(7, wasm_i32x4_extract_lane(wasm_v128_or(a, wasm_v128_and(a, b)), 3));
+} END_TEST()
+
+TEST(shuffle) {
+  v128_t a = wasm_i32x4_make(0, 1, 2, 3);
+  v128_t b = wasm_i32x4_make(4, 5, 6, 7);
+  v128_t c = wasm_i8x16_shuffle(a, b, 12, 13, 14, 15, 16, 17, 18, 19, 0, 1, 2, 3, 28, 29, 30, 31);
+  EXPECT_EQ(3, wasm_i32x4_extract_lane(c, 0));
+  EXPECT_EQ(4, wasm_i32x4_extract_lane(c, 1));
+  EXPECT_EQ(0, wasm_i32x4_extract_lane(c, 2));
+  EXPECT_EQ(7, wasm_i32x4_extract_lane(c, 3));
+
+  v128_t bytes = wasm_i8x16_make(10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25);
+  v128_t idx = wasm_i8x16_make(15, 0, 1, 99, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+  v128_t d = wasm_i8x16_swizzle(bytes, idx);
+  EXPECT_EQ(25, wasm_i8x16_extract_lane(d, 0));
+  EXPECT_EQ(11, wasm_i8x16_extract_lane(d, 2));
+  EXPECT_EQ(0, wasm_i8x16_extract_lane(d, 3));
+} END_TEST()
+
+TEST(memory) {
+  int32_t buf[12];
+  for (int i = 0; i < 12; ++i)
+    buf[i] = i * 10;
+  v128_t a = wasm_v128_load(&buf[1]);
+  EXPECT_EQ(10, wasm_i32x4_extract_lane(a, 0));
+  EXPECT_EQ(40, wasm_i32x4_extract_lane(a, 3));
+  EXPECT_EQ(80, wasm_i32x4_extract_lane(wasm_v128_load(buf + 5), 3));
+  EXPECT_EQ(70, wasm_i32x4_extract_lane(wasm_v128_load32_splat(&buf[7]), 2));
+  EXPECT_EQ(0, wasm_i32x4_extract_lane(wasm_v128_load32_zero(&buf[7]), 2));
+
+  wasm_v128_store(&buf[8], wasm_i32x4_add(a, a));
+  EXPECT_EQ(20, buf[8]);
+  EXPECT_EQ(80, buf[11]);
+
+  uint8_t u8[8] = {1, 2, 3, 250, 5, 6, 7, 8};
+  EXPECT_EQ(250, wasm_u16x8_extract_lane(wasm_u16x8_load8x8(u8), 3));
+  EXPECT_EQ(-6, wasm_i16x8_extract_lane(wasm_i16x8_load8x8(u8), 3));
+
+  struct {
+    int pad;
+    v128_t v[2];
+  } s;
+  s.v[1] = wasm_i32x4_splat(7);
+  s.v[0] = s.v[1];
+  EXPECT_EQ(7, wasm_i32x4_extract_lane(s.v[0], 3));
+
+  uint8_t dst[37], src[37];
+  for (int i = 0; i < 37; ++i) {
+    dst[i] = i * 7;
+    src[i] = 100;
+  }
+  add_bytes(dst, src, 37);
+  EXPECT_EQ(100, dst[0]);
+  EXPECT_EQ(255, dst[30]);
+  EXPECT_EQ(135, dst[5]);
+  EXPECT_EQ(255, dst[36]);
+} END_TEST()
+
+TEST(float) {
+  v128_t a = wasm_f32x4_make(1.5f, -2.0f, 4.0f, 9.0f);
+  EXPECT_NEAR(3.0, wasm_f32x4_extract_lane(wasm_f32x4_sqrt(a), 3));
+  EXPECT_NEAR(2.0, wasm_f32x4_extract_lane(wasm_f32x4_abs(a), 1));
+  EXPECT_NEAR(2.25, wasm_f32x4_extract_lane(wasm_f32x4_mul(a, a), 0));
+  EXPECT_NEAR(-1.0, wasm_f32x4_extract_lane(wasm_f32x4_div(a, wasm_f32x4_splat(2.0f)), 1));
+  EXPECT_NEAR(1.0, wasm_f32x4_extract_lane(wasm_f32x4_floor(a), 0));
+  EXPECT_EQ(-2, wasm_i32x4_extract_lane(wasm_i32x4_trunc_sat_f32x4(a), 1));
+
+  float f = 0.5f;
+  v128_t b = wasm_f32x4_make(f, f * 2, f * 3, f * 4);
+  EXPECT_NEAR(2.0, wasm_f32x4_extract_lane(b, 3));
+  EXPECT_NEAR(2.0, wasm_f32x4_extract_lane(wasm_f32x4_add(a, b), 0));
+
+  v128_t d = wasm_f64x2_make(0.25, -8.0);
+  EXPECT_NEAR(-8.0, wasm_f64x2_extract_lane(wasm_f64x2_min(d, wasm_f64x2_splat(1.0)), 1));
+  EXPECT_NEAR(1.0, wasm_f64x2_extract_lane(wasm_f64x2_max(d, wasm_f64x2_splat(1.0)), 0));
+  EXPECT_NEAR(1.5, wasm_f64x2_extract_lane(wasm_f64x2_promote_low_f32x4(a), 0));
+  EXPECT_EQ(0x2, wasm_i64x2_bitmask(wasm_f64x2_lt(d, wasm_f64x2_splat(0.0))));
+} END_TEST()
+
+int main(void) {
+  return RUN_ALL_TESTS(
+    test_make,
+    test_arith,
+    test_compare,
+    test_shuffle,
+    test_memory,
+    test_float,
+  );
+}
@@ -0,0 +1,51 @@
+#include "./xtest.h"
+
+// Deep enough to overflow the stack without `return_call`.
+#define DEPTH  (10000000)
+
+static int is_odd(int n);
+
+static int is_even(int n) {
+  if (n == 0)
+    return 1;
+  return is_odd(n - 1);
+}
+
+static int is_odd(int n) {
+  if (n == 0)
+    return 0;
+  return is_even(n - 1);
+}
+
+static long long odd2(long long n);
+
+static long long even2(long long n) {
+  return n == 0 ? 1 : odd2(n - 1);
+}
+
+static long long odd2(long long n) {
+  return n == 0 ? 0 : n == 1 ? 1 : even2(n - 1);
+}
+
+static double sum_to(int n, double acc) {
+  return n <= 0 ? acc : sum_to(n - 1, acc + n);
+}
+
+TEST(tail_call) {
+  EXPECT_EQ(1, is_even(DEPTH));
+  EXPECT_EQ(1, is_odd(DEPTH + 1));
+} END_TEST()
+
+TEST(ternary) {
+  EXPECT_EQ(1, even2(DEPTH));
+  EXPECT_EQ(0, odd2(DEPTH));
+  EXPECT_EQ(1, odd2(DEPTH + 1));
+  EXPECT_TRUE(sum_to(DEPTH, 0) == (double)DEPTH * (DEPTH + 1) / 2);
+} END_TEST()
+
+int main(void) {
+  return RUN_ALL_TESTS(
+    test_tail_call,
+    test_ternary,
+  );
+}
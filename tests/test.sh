@@ -330,6 +330,55 @@ test_error_line() {
   end_test_suite
 }
 
+# Phase names in the report line of the tool.
+try_report_phases() {
+  local report="$1"
+  local tool="$2"
+  local expected="$3"
+  begin_test "$tool phases"
+  local names
+  names=$(echo "$report" | grep -F "{\"tool\":\"$tool\"" | sed 's/"functions":.*//' |
+            grep -o '"name":"[^"]*"' | cut -d'"' -f4 | tr '\n' ' ')
+  local err=''
+  [[ "$names" == "$expected " ]] || err="[${expected}] expected, but [${names}]"
+  end_test "$err"
+}
+
+test_report() {
+  begin_test_suite "Report"
+
+  # More functions than listed in the report.
+  local src='int main(void){return 0;}' i
+  for ((i = 0; i < 12; ++i)); do
+    src="$src int f$i(int x){return x + $i;}"
+  done
+  local report
+  report=$(echo "$src" | $XCC -ftime-report -fmem-report -o "$AOUT" -xc - 2>&1 > /dev/null)
+
+  begin_test 'time and memory report'
+  local err=''
+  [[ "$report" == *'{"tool":'*'"wall":'*'"allocs":'* ]] || err="report expected, but [${report}]"
+  end_test "$err"
+
+  if [[ "$report" == *'{"tool":"wcc"'* ]]; then
+    try_report_phases "$report" wcc 'lex preprocess parse traverse gen emit_code link'
+  else
+    try_report_phases "$report" cpp 'preprocess lex'
+    try_report_phases "$report" cc1 'parse lex gen optimize tweak_irs alloc_physical_registers emit_code'
+    try_report_phases "$report" as 'parse encode relax emit'
+    try_report_phases "$report" ld 'parse resolve layout relocate emit'
+
+    begin_test 'top functions'
+    local count
+    count=$(echo "$report" | grep -F '{"tool":"cc1"' | grep -o '"functions":.*' | grep -o '"name":' | wc -l)
+    err=''
+    [[ "$count" -eq 10 ]] || err="10 functions expected, but ${count}"
+    end_test "$err"
+  fi
+
+  end_test_suite
+}
+
 test_basic
 test_struct
 test_bitfield
@@ -337,6 +386,7 @@ test_initializer
 test_function
 test_error
 test_error_line
+test_report
 
 if [[ $FAILED_SUITE_COUNT -ne 0 ]]; then
   exit "$FAILED_SUITE_COUNT"
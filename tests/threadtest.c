@@ -0,0 +1,118 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "./xtest.h"
+
+TEST(atomic) {
+  atomic_int i = 10;
+  EXPECT_EQ(10, atomic_fetch_add(&i, 5));
+  EXPECT_EQ(15, atomic_load(&i));
+  EXPECT_EQ(15, atomic_fetch_sub(&i, 20));
+  EXPECT_EQ(-5, i);
+  EXPECT_EQ(-5, atomic_exchange(&i, 0x0f));
+  EXPECT_EQ(0x0f, atomic_fetch_and(&i, 0x3c));
+  EXPECT_EQ(0x0c, atomic_fetch_or(&i, 0x30));
+  EXPECT_EQ(0x3c, atomic_fetch_xor(&i, 0xff));
+  EXPECT_EQ(0xc3, i);
+  EXPECT_EQ(0xc4, __atomic_add_fetch(&i, 1, __ATOMIC_SEQ_CST));
+  EXPECT_EQ(0x04, __atomic_and_fetch(&i, 0x0f, __ATOMIC_SEQ_CST));
+
+  int expected = 3;
+  EXPECT_FALSE(atomic_compare_exchange_strong(&i, &expected, 100));
+  EXPECT_EQ(4, expected);
+  EXPECT_TRUE(atomic_compare_exchange_strong(&i, &expected, 100));
+  EXPECT_EQ(100, i);
+
+  signed char c = -1;
+  EXPECT_EQ(-1, atomic_fetch_add(&c, 2));
+  EXPECT_EQ(1, atomic_load(&c));
+  unsigned short us = 0xffff;
+  EXPECT_EQ(0xffff, atomic_exchange(&us, 1));
+  atomic_llong ll = 0x100000000LL;
+  EXPECT_EQ(0x100000001LL, __atomic_add_fetch(&ll, 1, __ATOMIC_SEQ_CST));
+
+  struct {
+    int pad;
+    atomic_int v;
+  } s = {1, 2};
+  atomic_store(&s.v, 7);
+  EXPECT_EQ(7, s.v);
+  atomic_thread_fence(memory_order_seq_cst);
+
+  atomic_flag flag = ATOMIC_FLAG_INIT;
+  EXPECT_FALSE(atomic_flag_test_and_set(&flag));
+  EXPECT_TRUE(atomic_flag_test_and_set(&flag));
+  atomic_flag_clear(&flag);
+  EXPECT_FALSE(atomic_flag_test_and_set(&flag));
+} END_TEST()
+
+#define THREAD_COUNT  (4)
+#define LOOP_COUNT  (10000)
+
+static atomic_int atomic_counter;
+static int locked_counter;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void *count_up(void *arg) {
+  for (int i = 0; i < LOOP_COUNT; ++i) {
+    atomic_fetch_add(&atomic_counter, 1);
+    pthread_mutex_lock(&mutex);
+    ++locked_counter;
+    pthread_mutex_unlock(&mutex);
+    if ((i & 255) == 0)
+      free(malloc(i + 1));
+  }
+  return (char*)arg + 1;
+}
+
+TEST(thread) {
+  pthread_t threads[THREAD_COUNT];
+  char buf[THREAD_COUNT];
+  for (int i = 0; i < THREAD_COUNT; ++i)
+    EXPECT_EQ(0, pthread_create(&threads[i], NULL, count_up, &buf[i]));
+  int ok = 0;
+  for (int i = 0; i < THREAD_COUNT; ++i) {
+    void *retval;
+    EXPECT_EQ(0, pthread_join(threads[i], &retval));
+    ok += retval == &buf[i] + 1;
+  }
+  EXPECT_EQ(THREAD_COUNT, ok);
+  EXPECT_EQ(THREAD_COUNT * LOOP_COUNT, atomic_counter);
+  EXPECT_EQ(THREAD_COUNT * LOOP_COUNT, locked_counter);
+} END_TEST()
+
+static void *self(void *arg) {
+  (void)arg;
+  return pthread_self();
+}
+
+TEST(attr) {
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  EXPECT_EQ(0, pthread_attr_setstacksize(&attr, 16 * 1024));
+  size_t size;
+  pthread_attr_getstacksize(&attr, &size);
+  EXPECT_EQ(16 * 1024, size);
+
+  pthread_t thread;
+  EXPECT_EQ(0, pthread_create(&thread, &attr, self, NULL));
+  pthread_attr_destroy(&attr);
+  void *retval;
+  pthread_join(thread, &retval);
+  EXPECT_TRUE(retval == thread);
+  EXPECT_FALSE(pthread_equal(pthread_self(), thread));
+  EXPECT_TRUE(pthread_equal(pthread_self(), pthread_self()));
+
+  EXPECT_EQ(0, pthread_mutex_trylock(&mutex));
+  EXPECT_TRUE(pthread_mutex_trylock(&mutex) != 0);
+  pthread_mutex_unlock(&mutex);
+} END_TEST()
+
+int main(void) {
+  return RUN_ALL_TESTS(
+    test_atomic,
+    test_thread,
+    test_attr,
+  );
+}
@@ -0,0 +1,394 @@
+#!/bin/bash
+# Compiler options and linker features which are checked on the built executable (or object).
+# Suites to run can be given as arguments (e.g. `gc_sections`), all by default.
+
+source ./test_sub.sh
+
+AOUT=${AOUT:-$(basename "$(mktemp -u)")}
+XCC=${XCC:-../xcc}
+XCC_AR=${XCC_AR:-../xcc-ar}
+# RUN_EXE=${RUN_EXE:-}
+SECTIONS_OPTION=${SECTIONS_OPTION-'-ffunction-sections -fdata-sections'}
+GC_OPTION=${GC_OPTION:-"$SECTIONS_OPTION -Wl,--gc-sections"}
+
+WORK_DIR=toolchain_test_work
+
+# Build with the command, run the result and compare its output.
+# Then `check` (if not empty) is called with its arguments and the build log appended,
+# and prints an error message if any.
+try_run() {
+  local title="$1"
+  local expected="$2"
+  local check="$3"
+  shift 3
+
+  begin_test "$title"
+
+  local log
+  log=$("$@" 2>&1) || {
+    end_test 'Build failed'
+    return
+  }
+
+  local actual
+  actual=$(${RUN_EXE} ./"$AOUT") > /dev/null 2>&1 || {
+    end_test 'Exec failed'
+    return
+  }
+
+  local err=''
+  if [[ "$actual" != "$expected" ]]; then
+    err="'${expected}' expected, but '${actual}'"
+  elif [[ -n "$check" ]]; then
+    err=$($check "$log")
+  fi
+  end_test "$err"
+}
+
+# Occurrence of the string in the executable.
+check_count() {
+  local str="$1"
+  local expected="$2"
+  local count
+  count=$(grep -o -a "$str" "$AOUT" | wc -l)
+  [[ "$count" -eq "$expected" ]] || echo "count of '${str}' ${expected} expected, but ${count}"
+}
+
+# Lines in the build log.
+check_log() {
+  local str="$1"
+  local expected="$2"
+  local log="$3"
+  local count
+  count=$(echo "$log" | grep -c -- "$str")
+  [[ "$count" -eq "$expected" ]] || echo "'${str}' ${expected} expected, but ${count}"
+}
+
+# Line number of the first line matching the pattern in the function body of the assembly.
+func_line() {
+  local asm="$1"
+  local fn="$2"
+  local pat="$3"
+  awk -v fn="$fn" -v pat="$pat" '$0 == fn ":" {f = 1; next} f && /\.type/ {exit} f && $0 ~ pat {print NR; exit}' "$asm"
+}
+
+test_pgo() {
+  begin_test_suite "PGO"
+
+  local prof=xcc.prof
+  local src="$WORK_DIR/pgo_workload.c"
+  local expected='-499740 1'
+  cp pgo_workload.c "$src"
+  rm -f "$prof"
+
+  try_run 'profile generate' "$expected" '' $XCC -o "$AOUT" -Werror -fprofile-generate "$src"
+
+  begin_test 'profile counters'
+  local count err=''
+  count=$(awk '$1 == "classify" {print $3}' "$prof" 2> /dev/null)
+  [[ "$count" == "10000" ]] || err="10000 expected, but ${count}"
+  end_test "$err"
+
+  try_run 'profile use' "$expected" '' $XCC -o "$AOUT" -Werror "-fprofile-use=$prof" "$src"
+
+  # The rare `return -1` of classify precedes the `x & 1` test in source order,
+  # and is moved after it with the profile (its branch condition is inverted).
+  begin_test 'block layout'
+  local rare='[$# ]-1([^0-9]|$)'
+  local odd='[$# ]1([^0-9]|$)'
+  local asm="$WORK_DIR/pgo_workload"
+  err=''
+  if ! $XCC -S -o "$asm.s" -Werror "$src" ||
+      ! $XCC -S -o "$asm.pgo.s" -Werror "-fprofile-use=$prof" "$src"; then
+    err='Compile failed'
+  elif [[ ! $(func_line "$asm.s" classify "$rare") -lt $(func_line "$asm.s" classify "$odd") ]]; then
+    err='rare block after the test without profile'
+  elif [[ ! $(func_line "$asm.pgo.s" classify "$rare") -gt $(func_line "$asm.pgo.s" classify "$odd") ]]; then
+    err='rare block not moved with profile'
+  fi
+  end_test "$err"
+
+  rm -f "$prof"
+
+  end_test_suite
+}
+
+test_gc_sections() {
+  begin_test_suite "GC sections"
+
+  local src="$WORK_DIR/gc_sections.c"
+  local marker='unreferenced-marker'
+  cat > "$src" <<EOS
+#include <stdio.h>
+static const char *unreferenced(void) { return "$marker"; }
+const char *unreferenced_global(void) { return unreferenced(); }
+static int used(int x) { return x * 2; }
+int main(void) { printf("used %d\n", used(21)); return 0; }
+EOS
+
+  try_run 'function sections' 'used 42' "check_count $marker 1" \
+      $XCC -o "$AOUT" -Werror $SECTIONS_OPTION "$src"
+  try_run 'gc sections' 'used 42' "check_count $marker 0" \
+      $XCC -o "$AOUT" -Werror $GC_OPTION "$src"
+
+  end_test_suite
+}
+
+test_merge_strings() {
+  begin_test_suite "Merge strings"
+
+  local src1="$WORK_DIR/merge_strings_1.c"
+  local src2="$WORK_DIR/merge_strings_2.c"
+  local marker='shared-marker'
+  cat > "$src1" <<EOS
+#include <stdio.h>
+#include <string.h>
+const char *sub(void);
+const char *tail(void);
+int main(void) {
+  const char *p = "$marker";
+  puts(p);
+  puts(sub());
+  puts(tail());
+  puts(tail() + 5);
+  printf("unused %d\n", strcmp(p, sub()));
+  return 0;
+}
+EOS
+  cat > "$src2" <<EOS
+const char *sub(void) { return "$marker"; }
+const char *tail(void) { return "tail-$marker"; }
+EOS
+
+  try_run 'merge' "$marker
+$marker
+tail-$marker
+$marker
+unused 0" "check_count $marker 1" $XCC -o "$AOUT" -Werror "$src1" "$src2"
+
+  end_test_suite
+}
+
+test_icf() {
+  begin_test_suite "ICF"
+
+  local src="$WORK_DIR/icf.c"
+  local expected='1 2 3 42 42 120 120 1'
+  cat > "$src" <<EOS
+#include <stdio.h>
+#include <stdlib.h>
+#define DEFINE_FUNCS(T) \\
+  static int cmp_##T(const void *a, const void *b) { \\
+    T x = *(const T*)a, y = *(const T*)b; \\
+    return x < y ? -1 : x > y ? 1 : 0; \\
+  } \\
+  int sum_##T(const T *p, int n) { int s = 0; for (int i = 0; i < n; ++i) s += p[i] * 3 + 1; return s; } \\
+  int twice_##T(const T *p, int n) { return sum_##T(p, n) * 2; }
+typedef int I1;
+typedef int I2;
+DEFINE_FUNCS(I1)
+DEFINE_FUNCS(I2)
+int fact1(int n) { return n <= 1 ? 1 : n * fact1(n - 1); }
+int fact2(int n) { return n <= 1 ? 1 : n * fact2(n - 1); }
+int main(void) {
+  int a[] = {3, 1, 2};
+  qsort(a, 3, sizeof(int), cmp_I1);
+  qsort(a, 3, sizeof(int), cmp_I2);
+  printf("%d %d %d %d %d %d %d %d\n", a[0], a[1], a[2], twice_I1(a, 3), twice_I2(a, 3),
+         fact1(5), fact2(5), cmp_I1 != cmp_I2);
+  return 0;
+}
+EOS
+
+  try_run 'no icf' "$expected" "check_log ICF:.folding 0" \
+      $XCC -o "$AOUT" -Werror -ffunction-sections -Wl,--print-icf-sections "$src"
+  # sum, twice and fact are folded, but cmp are kept: Their addresses are taken.
+  try_run 'icf' "$expected" "check_log ICF:.folding 3" \
+      $XCC -o "$AOUT" -Werror -ffunction-sections -Wl,--icf -Wl,--print-icf-sections "$src"
+
+  end_test_suite
+}
+
+test_incremental() {
+  begin_test_suite "Incremental link"
+
+  local main="$WORK_DIR/incremental_main"
+  local sub="$WORK_DIR/incremental_sub"
+  # `--verbose` reports whether the link is patched or full.
+  local link="$XCC -c -o $main.o -Werror $main.c && $XCC -c -o $sub.o -Werror $sub.c &&
+              $XCC -o $AOUT $main.o $sub.o -Wl,--incremental -Wl,--verbose"
+  rm -f "$AOUT.ldstate"
+
+  cat > "$main.c" <<EOS
+#include <stdio.h>
+extern const char *msg;
+int sub(int x);
+int counter;
+int main(void) { printf("%d %s %d\n", sub(41), msg, counter); return 0; }
+EOS
+  cat > "$sub.c" <<EOS
+extern int counter;
+const char *msg = "v1";
+int sub(int x) { ++counter; return x + 1; }
+EOS
+  try_run 'first' '42 v1 1' 'check_log Incremental:.full.link 1' bash -c "$link"
+
+  cat > "$sub.c" <<EOS
+extern int counter;
+const char *msg = "version2";
+static int twice(int x) { return x * 2; }
+int sub(int x) { counter += 5; for (int i = 0; i < 3; ++i) x = twice(x) - x; return x + 2; }
+EOS
+  try_run 'grow in place' '43 version2 5' 'check_log Incremental:.patched 1' bash -c "$link"
+
+  cat > "$sub.c" <<EOS
+extern int counter;
+const char *msg = "v3";
+int sub(int x) { return x - counter; }
+int added(void) { return 0; }
+EOS
+  try_run 'new symbol' '41 v3 0' 'check_log Incremental:.full.link 1' bash -c "$link"
+
+  # Data beyond the padding left after the old section.
+  cat > "$sub.c" <<EOS
+extern int counter;
+const char *msg = "v4";
+static int table[1024] = {1, 2, 3};
+int sub(int x) { return x + table[2] + table[1023]; }
+int added(void) { return 0; }
+EOS
+  try_run 'outgrow' '44 v4 0' 'check_log Incremental:.full.link 1' bash -c "$link"
+
+  rm -f "$AOUT.ldstate"
+
+  end_test_suite
+}
+
+# Bytes (hex, spaces ignored) in the dump.
+try_code() {
+  local title="$1"
+  local expected="${2// /}"
+  local code="$3"
+  begin_test "$title"
+  local err=''
+  [[ "$code" == *"$expected"* ]] || err="'${2}' not found"
+  end_test "$err"
+}
+
+# Wasm only: Function bodies (size, locals and code) in the object, rewritten by the peephole.
+test_peephole() {
+  begin_test_suite "Peephole"
+
+  local src="$WORK_DIR/peephole.c"
+  local obj="$WORK_DIR/peephole.o"
+  cat > "$src" <<EOS
+int tee_eqz(int x) { int y = x * 3; return y == 0; }
+int if_ne(int x) { if (x != 0) x = 5; return x; }
+int add_add(int x) { return x + 1 + 2; }
+EOS
+  begin_test 'compile'
+  local err=''
+  $XCC -c -o "$obj" -Werror "$src" > /dev/null 2>&1 || err='Compile failed'
+  end_test "$err"
+  local code
+  code=$(od -An -tx1 -v "$obj" | tr -d ' \n')
+
+  # local.set y; local.get y => local.tee y, i32.const 0; i32.eq => i32.eqz
+  try_code 'tee eqz' '0c 01 01 7f  20 00 41 03 6c 22 01 45 0b' "$code"
+  # i32.const 0; i32.ne; if => if
+  try_code 'if ne' '0d 00  20 00 04 40 41 05 21 00 0b 20 00 0b' "$code"
+  # x; i32.const 1; i32.add; i32.const 2; i32.add => x; i32.const 3; i32.add
+  try_code 'add add' '07 00  20 00 41 03 6a 0b' "$code"
+
+  end_test_suite
+}
+
+test_ar() {
+  begin_test_suite "Archiver"
+
+  local lib_dir="$WORK_DIR/lib"
+  local main="$WORK_DIR/main.c"
+  local short="$WORK_DIR/short"
+  local long="$WORK_DIR/a_very_long_member_name"
+  mkdir -p "$lib_dir"
+  cat > "$main" <<EOS
+#include <stdio.h>
+int short_func(void);
+int long_func(void);
+int main(void) {
+  printf("%d %d\n", short_func(), long_func());
+  return 0;
+}
+EOS
+  echo 'int short_func(void) { return 12; }' > "$short.c"
+  echo 'int long_func(void) { return 34; }' > "$long.c"
+  $XCC -c -o "$short.o" "$short.c"
+  $XCC -c -o "$long.o" "$long.c"
+
+  try_run 'regular' '12 34' '' bash -c \
+      "$XCC_AR rcs $lib_dir/libfoo.a $short.o $long.o && $XCC -o $AOUT $main $lib_dir/libfoo.a"
+  begin_test 'list'
+  local members err=''
+  members=$($XCC_AR t "$lib_dir/libfoo.a" | tr '\n' ' ')
+  [[ "$members" == 'short.o a_very_long_member_name.o ' ]] || err="unexpected members: ${members}"
+  end_test "$err"
+
+  # Thin archive refers objects relative from the archive, and is not affected by its content.
+  try_run 'thin' '12 34' '' bash -c \
+      "$XCC_AR rcsT $lib_dir/libthin.a $short.o $long.o && $XCC -o $AOUT $main $lib_dir/libthin.a"
+  begin_test 'thin member path'
+  err=''
+  members=$($XCC_AR t "$lib_dir/libthin.a" | tr '\n' ' ')
+  [[ "$members" == '../short.o ../a_very_long_member_name.o ' ]] || err="unexpected members: ${members}"
+  end_test "$err"
+
+  # Replace a member: Thin archive refers the updated object without rebuilding.
+  echo 'int short_func(void) { return 56; }' > "$short.c"
+  $XCC -c -o "$short.o" "$short.c"
+  try_run 'replace' '56 34' '' bash -c \
+      "$XCC_AR r $lib_dir/libfoo.a $short.o && $XCC -o $AOUT $main $lib_dir/libfoo.a"
+  try_run 'replace thin' '56 34' '' $XCC -o "$AOUT" "$main" "$lib_dir/libthin.a"
+
+  # An archive is searched only for the names referred by the files before it, even when some
+  # of its members are loaded: `a.o lib.a b.o` does not resolve b.o from lib.a.
+  local caller="$WORK_DIR/caller"
+  local callee="$WORK_DIR/callee"
+  cat > "$caller.c" <<EOS
+#include <stdio.h>
+int short_func(void);
+int callee(void);
+int main(void) {
+  printf("%d %d\n", short_func(), callee());
+  return 0;
+}
+EOS
+  echo 'int long_func(void); int callee(void) { return long_func(); }' > "$callee.c"
+  $XCC -c -o "$caller.o" "$caller.c"
+  $XCC -c -o "$callee.o" "$callee.c"
+  try_run 'archive after' '56 34' '' $XCC -o "$AOUT" "$caller.o" "$callee.o" "$lib_dir/libfoo.a"
+  begin_test 'archive between'
+  err=''
+  $XCC -o "$AOUT" "$caller.o" "$lib_dir/libfoo.a" "$callee.o" > /dev/null 2>&1 &&
+    err='Unresolved long_func expected, but linked'
+  end_test "$err"
+
+  end_test_suite
+}
+
+if [[ "$(uname)" == "Darwin" ]]; then
+  echo '  Toolchain: skip'
+  exit 0
+fi
+
+rm -rf "$WORK_DIR"
+mkdir -p "$WORK_DIR"
+
+for suite in ${@:-pgo gc_sections merge_strings icf incremental ar}; do
+  "test_$suite"
+done
+
+rm -rf "$WORK_DIR" "$AOUT"
+
+if [[ $FAILED_SUITE_COUNT -ne 0 ]]; then
+  exit "$FAILED_SUITE_COUNT"
+fi
@@ -113,6 +113,7 @@ TEST(all) {
   EXPECT("0 - x", -42, (x=42, 0-x));
   EXPECT("long", 123, 123L);
   { long long x = 9876543LL; EXPECT("long long", 9876543, x); }
+  { unsigned long long x = 1; EXPECT("wrap around", INT64_MIN, (long long)(x - INT64_MIN - 1)); }
   {
     long long x = 0;
     EXPECT_FALSE(x < -32768LL);       // 0xFFFFFFFFFFFF8000
@@ -897,6 +898,8 @@ int f27(void){return 27;}
 int f53(void){return 53;}
 void mul2p(int *p) {*p *= 2;}
 const char *retstr(void){ return "foo"; }
+void add_ints(int *dst, const int *src, int k, int n) { for (int i = 0; i < n; ++i) dst[i] = dst[i] + src[i] - k; }
+void add_longs(long *dst, const long *src, long n) { for (long i = 0; i < n; i++) dst[i] += src[i] + 7; }
 
 TEST(basic) {
   {
@@ -1026,6 +1029,35 @@ TEST(basic) {
     EXPECT("continue", 40, acc);
   }
 
+  {
+    int a[37], b[37];
+    for (int i = 0; i < 37; ++i) {
+      a[i] = i;
+      b[i] = i * 3;
+    }
+    add_ints(a, b, 5, 37);
+    int acc = 0;
+    for (int i = 0; i < 37; ++i)
+      acc += a[i];
+    EXPECT("vector loop", 36 * 37 / 2 * 4 - 5 * 37, acc);
+
+    add_ints(a, b, 0, 3);
+    EXPECT("vector loop short", 4 * 2 - 5 + 3 * 2, a[2]);
+
+    for (int i = 0; i < 37; ++i)
+      a[i] = 1;
+    add_ints(&a[1], a, 0, 36);  // Overlapped: Must be same as scalar loop.
+    EXPECT("vector loop overlap", 37, a[36]);
+
+    long la[19], lb[19];
+    for (int i = 0; i < 19; ++i) {
+      la[i] = -i;
+      lb[i] = i * 2;
+    }
+    add_longs(la, lb, 19);
+    EXPECT("vector loop long", 18 + 7, la[18]);
+  }
+
   {
     int x = 123;
     (void)x;
@@ -1204,6 +1236,8 @@ int oldstylefunc(int x) {
 typedef struct {int x, y;} FooStruct;
 
 int struct_arg(FooStruct foo, int k) { return foo.x * k + foo.y; }
+typedef struct {long a[20];} BigStruct;
+long big_struct_arg(int a, BigStruct s, int b, int c) { return a + s.a[0] + s.a[19] + b + c; }
 FooStruct return_struct(void) { FooStruct s = {.x = 12, .y = 34}; return s; }
 
 typedef struct {long x; long y;} LongStruct;
@@ -1295,6 +1329,27 @@ TEST(struct) {
     EXPECT("struct copy", 51, x.x);
   }
 
+  {
+    struct S37 {char a[37];} s37, t37;
+    struct S200 {long a[25];} s200, t200;
+    for (int i = 0; i < 37; ++i)
+      s37.a[i] = i;
+    for (int i = 0; i < 25; ++i)
+      s200.a[i] = i * 11;
+    t37 = s37;
+    t200 = s200;
+    EXPECT("block copy", 36 * 2 + 24 * 11 * 2, t37.a[36] + s37.a[36] + t200.a[24] + s200.a[24]);
+
+    struct S37 z37 = {{1}};
+    struct S200 z200 = {{2}};
+    int sum = 0;
+    for (int i = 1; i < 37; ++i)
+      sum += z37.a[i];
+    for (int i = 1; i < 25; ++i)
+      sum += z200.a[i];
+    EXPECT("block clear", 3, sum + z37.a[0] + z200.a[0]);
+  }
+
   {
     struct empty {};
     EXPECT("empty struct size", 0, sizeof(struct empty));
@@ -1323,6 +1378,12 @@ TEST(struct) {
     EXPECT("implicit cast to non-const", 246, struct_arg(bar, 3));
   }
 
+  {
+    BigStruct big = {{100}};
+    big.a[19] = 2000;
+    EXPECT("big struct arg between register args", 2123, big_struct_arg(3, big, 7, 13));
+  }
+
   {
     typedef struct { int x, y, z; } S;
     S a = {1, 2, 3}, b = {10, 20, 30};
@@ -4,6 +4,7 @@
 
 const fsPromises = require('fs').promises
 const { WASI } = require('wasi')
+const { Worker, isMainThread, workerData } = require('worker_threads')
 
 async function getRealpaths(map) {
   const promises = Object.keys(map).map(async key => {
@@ -22,6 +23,97 @@ async function getRealpaths(map) {
   return map
 }
 
+function readUleb128(bin, pos) {
+  let x = 0
+  for (let shift = 0; ; shift += 7) {
+    const b = bin[pos.p++]
+    x += (b & 0x7f) * 2 ** shift
+    if ((b & 0x80) === 0)
+      return x
+  }
+}
+
+// Limits of imported memory `env.memory` (built with `-pthread`), or null.
+function findImportedMemory(bin) {
+  const pos = {p: 8}
+  while (pos.p < bin.length) {
+    const id = bin[pos.p++]
+    const size = readUleb128(bin, pos)
+    const end = pos.p + size
+    if (id === 2) {  // Import section
+      const readName = () => {
+        const len = readUleb128(bin, pos)
+        pos.p += len
+        return bin.subarray(pos.p - len, pos.p).toString()
+      }
+      for (let n = readUleb128(bin, pos); n > 0; --n) {
+        const module = readName(), name = readName()
+        const kind = bin[pos.p++]
+        switch (kind) {
+        case 0:  readUleb128(bin, pos); break  // Function: type index
+        case 1:  pos.p += 1; // Table: reftype, limits
+        // Fallthrough
+        case 2:
+          {
+            const flags = readUleb128(bin, pos)
+            const initial = readUleb128(bin, pos)
+            const maximum = (flags & 1) ? readUleb128(bin, pos) : undefined
+            if (kind === 2 && module === 'env' && name === 'memory')
+              return {initial, maximum, shared: (flags & 2) !== 0}
+          }
+          break
+        case 3:  pos.p += 2; break  // Global: type, mutability
+        default: return null
+        }
+      }
+      return null
+    }
+    pos.p = end
+  }
+  return null
+}
+
+// wasi-threads: Run `wasi_thread_start` on a new instance in a worker.
+function createImportObject(wasi, wasmModule, memory, wasiOptions, tidCounter) {
+  const importObject = wasi.getImportObject?.call(wasi) ??
+      { wasi_snapshot_preview1: wasi.wasiImport }
+  if (memory != null) {
+    importObject.env = { memory }
+    importObject.wasi = {
+      'thread-spawn': (startArg) => {
+        const tid = Atomics.add(tidCounter, 0, 1) + 1
+        const worker = new Worker(__filename, {
+          workerData: { wasmModule, memory, wasiOptions, tidCounter, tid, startArg },
+        })
+        worker.unref()
+        return tid
+      },
+    }
+  }
+  return importObject
+}
+
+async function startThread() {
+  const { wasmModule, memory, wasiOptions, tidCounter, tid, startArg } = workerData
+  const wasi = new WASI(wasiOptions)
+  const importObject = createImportObject(wasi, wasmModule, memory, wasiOptions, tidCounter)
+  const instance = await WebAssembly.instantiate(wasmModule, importObject)
+  if (wasi.finalizeBindings != null)
+    wasi.finalizeBindings(instance, { memory })
+  else
+    wasi.initialize({ exports: { memory } })  // Bind the memory only, `_start` is not for threads.
+  instance.exports.wasi_thread_start(tid, startArg)
+}
+
+if (!isMainThread) {
+  // Main thread might be blocked in `memory.atomic.wait`, so report and stop here.
+  startThread().catch((e) => {
+    console.error(e)
+    process.kill(process.pid)
+  })
+  return
+}
+
 ;(async () => {
   const preopens = {}
   function handleDir(value) {
@@ -45,18 +137,26 @@ async function getRealpaths(map) {
   }
 
   const wasmFileName = program.args[0]
-  const wasi = new WASI({
+  const wasiOptions = {
     version: 'preview1',
     args: program.args,
     env: process.env,
     preopens: await getRealpaths(preopens),
-  })
+  }
+  const wasi = new WASI(wasiOptions)
 
   try {
     const wasmBin = await fsPromises.readFile(wasmFileName)
+    const limits = findImportedMemory(wasmBin)
+    if (limits != null) {
+      // Baseline compiler (Liftoff) of V8 in Node 20 returns wrong result
+      // from `memory.atomic.wait32` with values on the operand stack.
+      require('v8').setFlagsFromString('--no-liftoff')
+    }
     const wasmModule = await WebAssembly.compile(wasmBin)
-    const importObject = wasi.getImportObject?.call(wasi) ??
-        { wasi_snapshot_preview1: wasi.wasiImport }
+    const memory = limits != null ? new WebAssembly.Memory(limits) : null
+    const tidCounter = new Int32Array(new SharedArrayBuffer(4))
+    const importObject = createImportObject(wasi, wasmModule, memory, wasiOptions, tidCounter)
     const instance = await WebAssembly.instantiate(wasmModule, importObject)
     const result = wasi.start(instance)
     process.exit(result)